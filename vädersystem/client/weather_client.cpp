@@ -11,6 +11,10 @@
 #include <sstream>
 #include <cstring>
 #include <stdexcept>
+#include <cstdlib>
+#ifndef _WIN32
+#include <sys/un.h>
+#endif
 
 // Använd C++ namespace för att undvika namnkonflikter
 using namespace std;
@@ -22,6 +26,10 @@ constexpr const char *SERVER_ADRESS = "127.0.0.1";
 constexpr int SERVER_PORT = 8080;
 constexpr size_t BUFFER_STORLEK = 8192;
 
+// Är miljövariabeln satt ansluter klienten till serverns Unix-socket
+// (servern startad med --unix=SÖKVÄG) i stället för TCP
+constexpr const char *SOCKET_MILJOVARIABEL = "VADER_SOCKET";
+
 // ============================================================================
 // HJÄLPKLASS FÖR JSON-PARSING
 // ============================================================================
@@ -265,6 +273,67 @@ public:
         cout << "✓ Ansluten till server " << adress << ":" << port << "\n\n";
     }
 
+    /**
+     * Ansluter till väderserverns Unix-socket på samma maskin
+     *
+     * @param sokvag Sökväg till socketen (serverns --unix=SÖKVÄG)
+     *
+     * THROWS: runtime_error om anslutningen misslyckas eller om
+     *         plattformen saknar Unix-sockets
+     *
+     * Servern talar samma HTTP som över TCP, men utan handskakning och
+     * loopback-gränssnittet blir varje request billigare.
+     */
+    void anslutLokalt(const string &sokvag)
+    {
+#ifdef _WIN32
+        throw runtime_error("Unix-socket stöds inte på denna plattform: " + sokvag);
+#else
+        struct sockaddr_un server_addr;
+        if (sokvag.length() >= sizeof(server_addr.sun_path))
+        {
+            throw runtime_error("För lång sökväg till Unix-socket: " + sokvag);
+        }
+
+        socket_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (socket_fd == OGILTIG_SOCKET)
+        {
+            throw runtime_error("Kunde inte skapa socket");
+        }
+
+        memset(&server_addr, 0, sizeof(server_addr));
+        server_addr.sun_family = AF_UNIX;
+        memcpy(server_addr.sun_path, sokvag.c_str(), sokvag.length() + 1);
+
+        if (connect(socket_fd, (struct sockaddr *)&server_addr, sizeof(server_addr)) == SOCKET_FEL)
+        {
+            stang_socket(socket_fd);
+            throw runtime_error("Kunde inte ansluta till server via " + sokvag);
+        }
+
+        ansluten = true;
+        cout << "✓ Ansluten till server via " << sokvag << "\n\n";
+#endif
+    }
+
+    /**
+     * Ansluter via Unix-socket om VADER_SOCKET är satt, annars via TCP
+     *
+     * THROWS: runtime_error om anslutningen misslyckas
+     */
+    void anslutTillServer()
+    {
+        const char *sokvag = getenv(SOCKET_MILJOVARIABEL);
+        if (sokvag && *sokvag)
+        {
+            anslutLokalt(sokvag);
+        }
+        else
+        {
+            anslut(SERVER_ADRESS, SERVER_PORT);
+        }
+    }
+
     /**
      * Skickar HTTP GET-request och tar emot svar
      *
@@ -334,10 +403,14 @@ public:
  * - argv[1]: Stad (obligatorisk)
  * - argv[2]: Landskod (valfri, standard "SE")
  *
+ * MILJÖVARIABLER:
+ * - VADER_SOCKET: Sökväg till serverns Unix-socket (valfri, annars TCP)
+ *
  * EXEMPEL:
  * ./weather_client Stockholm SE
  * ./weather_client London GB
  * ./weather_client Paris FR
+ * VADER_SOCKET=/run/vader.sock ./weather_client Stockholm SE
  */
 int main(int argc, char *argv[])
 {
@@ -350,7 +423,7 @@ int main(int argc, char *argv[])
             string landskod = (argc > 2) ? argv[2] : "SE";
 
             NatverksKlient klient;
-            klient.anslut(SERVER_ADRESS, SERVER_PORT);
+            klient.anslutTillServer();
 
             string json_svar = klient.hamtaVader(stad, landskod);
             VaderData vader;
@@ -372,7 +445,15 @@ int main(int argc, char *argv[])
         cout << "╔═══════════════════════════════════════════════════════╗\n";
         cout << "║          INTERAKTIV VÄDERKLIENT                      ║\n";
         cout << "╚═══════════════════════════════════════════════════════╝\n\n";
-        cout << "💡 Ansluter till lokal väderserver på " << SERVER_ADRESS << ":" << SERVER_PORT << "\n";
+        const char *lokal_socket = getenv(SOCKET_MILJOVARIABEL);
+        if (lokal_socket && *lokal_socket)
+        {
+            cout << "💡 Ansluter till lokal väderserver via " << lokal_socket << "\n";
+        }
+        else
+        {
+            cout << "💡 Ansluter till lokal väderserver på " << SERVER_ADRESS << ":" << SERVER_PORT << "\n";
+        }
         cout << "💡 Servern hämtar data från OpenWeatherMap API\n\n";
 
         while (true)
@@ -415,7 +496,7 @@ int main(int argc, char *argv[])
             {
                 // Anslut och hämta väderdata
                 NatverksKlient klient;
-                klient.anslut(SERVER_ADRESS, SERVER_PORT);
+                klient.anslutTillServer();
 
                 cout << "\nHämtar väderdata för " << stad << ", " << landskod << "...\n";
                 string json_svar = klient.hamtaVader(stad, landskod);
@@ -0,0 +1,43 @@
+#ifndef ANTAGNING_H
+#define ANTAGNING_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Antagningskontroll vid överlast. I stället för att låta arbetskön och
+// listen-kön växa tills klienterna får timeout avvisas nya requests
+// direkt med ett färdigbyggt 503-svar (med Retry-After) när
+// - arbetskön är djupare än max_ko, eller
+// - senaste uppgiften fick vänta längre än max_kotid_ms i kön.
+// Dessutom får högst upstream_platser requests samtidigt gå vidare till
+// väder-API:t (cachemissar). Övriga arbetare är reserverade för requests
+// som kan besvaras från cachen, så cacheträffar fortsätter att gå snabbt
+// även när upstream är långsamt.
+
+// Räknare för antagningskontrollen
+typedef struct {
+    unsigned long long avvisade_ko;               // Avvisade för att kön var för djup
+    unsigned long long avvisade_kotid;            // Avvisade för att kötiden var för lång
+    unsigned long long avvisade_upstream;         // Cachemissar som avvisades (alla upstream-platser upptagna)
+    unsigned long long upstream_pagaende;         // Cachemissar som hämtas just nu
+} AntagningsStatistik;
+
+// Sätter gränserna. 0 stänger av respektive kontroll.
+// Ska anropas innan servern börjar ta emot requests.
+void konfigurera_antagning(size_t max_ko, unsigned max_kotid_ms, int upstream_platser);
+
+// Avgör om en ny request får köas, givet arbetsköns djup och hur länge
+// den senast uttagna uppgiften väntade. false = svara 503.
+bool antagning_slapp_in(size_t ko_djup, unsigned kotid_ms);
+
+// Reserverar en upstream-plats för en cachemiss. false = alla är upptagna
+// och requesten ska få 503. Lyckade anrop följs av antagning_slapp_upstream().
+bool antagning_borja_upstream(void);
+
+// Lämnar tillbaka en plats från antagning_borja_upstream()
+void antagning_slapp_upstream(void);
+
+// Kopierar räknarna till ut. Trådsäker.
+void hamta_antagnings_statistik(AntagningsStatistik* ut);
+
+#endif // ANTAGNING_H
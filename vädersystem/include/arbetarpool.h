@@ -0,0 +1,65 @@
+#ifndef ARBETARPOOL_H
+#define ARBETARPOOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include <stdint.h>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <semaphore.h>
+
+// Funktion som körs av en arbetartråd. scratch är trådens egen buffer
+// som återanvänds mellan uppgifter (ingen allokering per request).
+typedef void (*ArbetsFunktion)(void* argument, char* scratch, size_t scratch_storlek);
+
+// En uppgift i arbetskön
+typedef struct {
+    ArbetsFunktion funktion;                      // Vad som ska köras
+    void* argument;                               // Argument till funktionen
+    uint64_t koad_ms;                             // Monoton tid då uppgiften köades
+} ArbetsUppgift;
+
+// En plats i den låsfria ringbufferten (Vyukovs bounded MPMC-kö).
+// sekvens avgör om platsen är ledig för skrivare eller redo för läsare.
+typedef struct {
+    _Atomic size_t sekvens;
+    ArbetsUppgift uppgift;
+} KoPlats;
+
+// Trådpool med begränsad MPMC-kö mellan producenter (reaktorer) och arbetare
+typedef struct {
+    KoPlats* platser;                             // Ringbuffert, storlek = 2^n
+    size_t mask;                                  // Storlek - 1 för snabb modulo
+    _Alignas(64) _Atomic size_t skriv_position;   // Nästa plats för producenter
+    _Alignas(64) _Atomic size_t las_position;     // Nästa plats för arbetare
+    _Alignas(64) sem_t vantande;                  // Antal uppgifter i kön (väcker arbetare)
+    _Alignas(64) _Atomic unsigned kotid_ms;       // Hur länge senast uttagna uppgiften väntade
+    pthread_t* tradar;                            // Arbetartrådarna
+    char** scratch;                               // En scratch-buffer per arbetare
+    size_t scratch_storlek;                       // Storlek på varje scratch-buffer
+    int antal_tradar;                             // Antal arbetartrådar
+    atomic_bool stoppar;                          // True när poolen håller på att stängas
+} ArbetarPool;
+
+// Starta en pool med antal_tradar arbetare och en kö med plats för
+// minst ko_storlek uppgifter (avrundas uppåt till en tvåpotens)
+bool initiera_arbetarpool(ArbetarPool* pool, int antal_tradar,
+                          size_t ko_storlek, size_t scratch_storlek);
+
+// Lägg en uppgift i kön. Returnerar false om kön är full (blockerar aldrig).
+bool lagg_till_uppgift(ArbetarPool* pool, ArbetsFunktion funktion, void* argument);
+
+// Antal uppgifter som väntar i kön just nu (ungefärligt under trafik)
+size_t arbetarpool_kodjup(ArbetarPool* pool);
+
+// Millisekunder som den senast uttagna uppgiften väntade i kön
+unsigned arbetarpool_kotid_ms(ArbetarPool* pool);
+
+// Kör klart alla köade uppgifter, stoppa trådarna och frigör resurser
+void stang_arbetarpool(ArbetarPool* pool);
+
+#endif // __linux__
+
+#endif // ARBETARPOOL_H
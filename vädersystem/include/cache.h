@@ -2,7 +2,10 @@
 #define CACHE_H
 
 #include "vaderprotokoll.h"
+#include "komprimering.h"
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 // Initialisera cache-system (skapar katalog om den inte finns)
 bool initiera_cache(void);
@@ -20,6 +23,17 @@ bool las_prognos_fran_cache(const char* stad, const char* landskod, VaderPrognos
 // Skriv prognos till cache
 bool skriv_prognos_till_cache(const char* stad, const char* landskod, const VaderPrognos* data);
 
+// Skriv den komprimerade JSON-bodyn för en post ("vader" eller "prognos")
+// bredvid posten. deflate är strömmen från komprimera_post().
+bool skriv_komprimerad_till_cache(const char* stad, const char* landskod, const char* typ,
+                                  const KomprimeradPost* post, const uint8_t* deflate);
+
+// Läs den komprimerade bodyn för en post. Returnerar false om den saknas,
+// inte hör till data med tidsstampel eller inte ryms i deflate_storlek.
+bool las_komprimerad_fran_cache(const char* stad, const char* landskod, const char* typ,
+                                int64_t tidsstampel, KomprimeradPost* post,
+                                uint8_t* deflate, size_t deflate_storlek);
+
 // Rensa gamla cachefiler (äldre än CACHE_GILTIGHETSTID)
 void rensa_gammal_cache(void);
 
@@ -0,0 +1,47 @@
+#ifndef DNS_CACHE_H
+#define DNS_CACHE_H
+
+#include <stdbool.h>
+#include "natverks_abstraktion.h"
+
+// Cache för namnuppslagning av upstream-värdar. Uppslagningen görs med
+// getaddrinfo() och sparas i DNS_TTL_SEKUNDER. När en post blivit gammal
+// används den gamla adressen medan en bakgrundstråd slår upp namnet på
+// nytt, så en request väntar bara på DNS första gången en värd används.
+// Misslyckas en ny uppslagning behålls den senaste fungerande adressen.
+
+// En uppslagen adress (IPv4 eller IPv6), utan port
+typedef struct {
+    struct sockaddr_storage adress;
+    socklen_t langd;                              // Antal giltiga bytes i adress
+} DnsAdress;
+
+// Slår upp vard och fyller i adress. Returnerar true vid framgång.
+// Standard är getaddrinfo(); tester kan byta ut den mot en egen.
+typedef bool (*DnsUppslagning)(const char* vard, DnsAdress* adress);
+
+// Räknare för cachen
+typedef struct {
+    unsigned long long traffar;                   // Uppslagningar som besvarades från cachen
+    unsigned long long uppslagningar;             // Anrop till resolvern (första gången + uppdateringar)
+    unsigned long long misslyckade;               // Resolver-anrop som misslyckades
+} DnsStatistik;
+
+// Slår upp vard (från cachen om möjligt) och sätter port i adressen.
+// Returnerar false bara om värden aldrig har gått att slå upp.
+bool dns_sla_upp(const char* vard, int port, DnsAdress* adress);
+
+// Sätter hur länge en uppslagning gäller (sekunder, 0 = uppdatera vid varje användning)
+void dns_cache_satt_ttl(int sekunder);
+
+// Byter resolver (NULL = getaddrinfo). Ska anropas innan cachen används;
+// töm den med stang_dns_cache() först om gamla poster inte ska användas.
+void dns_cache_satt_uppslagning(DnsUppslagning uppslagning);
+
+// Kopierar räknarna till ut. Trådsäker.
+void hamta_dns_statistik(DnsStatistik* ut);
+
+// Stoppar bakgrundstråden och tömmer cachen
+void stang_dns_cache(void);
+
+#endif // DNS_CACHE_H
@@ -0,0 +1,54 @@
+#ifndef HTTP_KLIENT_H
+#define HTTP_KLIENT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// HTTP/1.1-klient för upstream-anrop (OpenWeatherMap) med en pool av
+// persistenta anslutningar per (värd, port). Svaren ramas in med
+// Content-Length eller chunked encoding, så anslutningen kan återanvändas
+// i stället för att läsas tills servern stänger.
+
+// Resultat av att tolka ett (eventuellt ofullständigt) HTTP-svar
+typedef enum {
+    HTTP_SVAR_OFULLSTANDIGT,                      // Mer data behövs
+    HTTP_SVAR_KOMPLETT,                           // Hela svaret finns i bufferten
+    HTTP_SVAR_FELAKTIGT                           // Ogiltig statusrad, längd eller chunk
+} HttpSvarStatus;
+
+// Inramning av ett HTTP-svar från upstream
+typedef struct {
+    int statuskod;                                // T.ex. 200, 404
+    size_t huvud_langd;                           // Statusrad + headers + tom rad
+    size_t total_langd;                           // Hela svaret (satt när det är komplett)
+    bool chunkad;                                 // Transfer-Encoding: chunked
+    bool tills_stangning;                         // Ingen längd - bodyn slutar när servern stänger
+    bool kan_ateranvandas;                        // Anslutningen kan användas för nästa request
+} HttpKlientSvar;
+
+// Räknare för anslutningspoolen
+typedef struct {
+    unsigned long long nya_anslutningar;          // TCP-anslutningar som öppnats
+    unsigned long long ateranvanda;               // Requests på en anslutning från poolen
+} HttpKlientStatistik;
+
+// Skickar GET path till host:port och lägger svarets body (nollterminerad,
+// chunked avkodad) i svar_buffer. Anslutningen lämnas tillbaka till poolen
+// om servern tillåter det. Returnerar true om ett komplett svar togs emot
+// (oavsett statuskod).
+bool http_klient_get(const char* host, int port, const char* path,
+                     char* svar_buffer, size_t buffer_storlek);
+
+// Tolkar de första langd bytes av ett HTTP-svar
+HttpSvarStatus tolka_http_svar(const char* data, size_t langd, HttpKlientSvar* svar);
+
+// Avkodar en komplett chunked body på plats. Returnerar bodyns nya längd.
+size_t avkoda_chunkad_kropp(char* kropp, size_t langd);
+
+// Kopierar poolens räknare till ut. Trådsäker.
+void hamta_http_klient_statistik(HttpKlientStatistik* ut);
+
+// Stänger alla vilande anslutningar i poolen
+void stang_http_klient_pool(void);
+
+#endif // HTTP_KLIENT_H
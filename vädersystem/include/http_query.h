@@ -0,0 +1,52 @@
+#ifndef HTTP_QUERY_H
+#define HTTP_QUERY_H
+
+#include "http_server.h"
+#include "konfiguration.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Query-strängen delas och avkodas (%XX och '+') en gång till en liten
+// tabell, som sedan slås upp i konstant tid. Namn och värden jämförs i
+// avkodad form, så "G%C3%B6teborg" och "Göteborg" blir samma cachenyckel.
+
+// Platser i uppslagstabellen (tvåpotens, minst dubbla antalet parametrar)
+#define QUERY_TABELL_STORLEK 32
+
+// En parameter. Strängarna ligger i HttpQuery::data och är nollterminerade.
+typedef struct {
+    const char* namn;
+    const char* varde;             // "" för en parameter utan '='
+    size_t varde_langd;            // strlen(varde)
+} QueryParameter;
+
+// Tolkad query-sträng. Ryms på stacken (ca 2,5 KB med standardvärdena).
+typedef struct {
+    QueryParameter parametrar[MAX_QUERY_PARAMETRAR];
+    int antal;
+    uint8_t tabell[QUERY_TABELL_STORLEK];   // Index + 1 i parametrar, 0 = tom plats
+    char data[MAX_QUERY_STORLEK];           // Avkodade namn och värden
+} HttpQuery;
+
+// Dela och avkoda query (utan '?'). Returnerar false om den är längre än
+// MAX_QUERY_STORLEK, har fler än MAX_QUERY_PARAMETRAR parametrar eller
+// innehåller %00. Finns ett namn flera gånger gäller det första.
+bool tolka_query(HttpVy query, HttpQuery* resultat);
+
+// Värdet för namn, eller NULL om parametern saknas
+const char* query_varde(const HttpQuery* query, const char* namn);
+
+// Kopiera värdet för namn till varde (avkortat och nollterminerat).
+// Returnerar false om parametern saknas.
+bool query_kopiera(const HttpQuery* query, const char* namn, char* varde, size_t varde_storlek);
+
+// Avkoda %XX och '+' i text till ut (nollterminerad, avkortad om ut är för
+// liten). Ogiltiga %-sekvenser behålls som de är. Returnerar avkodad längd.
+size_t query_avkoda(HttpVy text, char* ut, size_t ut_storlek);
+
+// Procentkoda text för en URL (allt utom A-Z a-z 0-9 - . _ ~).
+// Returnerar false om ut är för liten.
+bool query_koda(const char* text, char* ut, size_t ut_storlek);
+
+#endif // HTTP_QUERY_H
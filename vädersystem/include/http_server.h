@@ -2,7 +2,14 @@
 #define HTTP_SERVER_H
 
 #include "natverks_abstraktion.h"
+#include "konfiguration.h"
+#include "komprimering.h"
 #include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+#ifndef _WIN32
+#include <sys/uio.h>               // För struct iovec
+#endif
 
 // HTTP-metoder
 typedef enum {
@@ -11,23 +18,171 @@ typedef enum {
     HTTP_UNKNOWN
 } HttpMetod;
 
-// HTTP-request struktur
+// Vy in i mottagningsbufferten: pekare och längd, inget kopieras och
+// inget nollterminieras. Gäller bara så länge bufferten finns kvar.
+typedef struct {
+    const char* data;              // Första tecknet (pekar in i bufferten)
+    size_t langd;                  // Antal tecken
+} HttpVy;
+
+// Parsad HTTP-request som vyer in i den mottagna datan. Inga storleks-
+// gränser utöver bufferten (MAX_REQUEST_STORLEK).
+typedef struct {
+    HttpMetod metod;               // HTTP-metod (GET, POST)
+    HttpVy metod_text;             // Metoden som den skickades (ex: "GET")
+    HttpVy sokvag;                 // URL-sökväg (ex: "/weather")
+    HttpVy query;                  // Query-parametrar utan '?' (tom om de saknas)
+    HttpVy version;                // Ex: "HTTP/1.1" (tom i HTTP/0.9)
+    HttpVy headers;                // Alla headerrader, utan den tomma raden
+    HttpVy body;                   // Allt efter den tomma raden
+    bool hall_vid_liv;             // Klienten vill behålla anslutningen (keep-alive)
+} HttpRequestVy;
+
+// HTTP-request med kopierade fält (äldre API, se parsa_http_request)
 typedef struct {
     HttpMetod metod;               // HTTP-metod (GET, POST)
     char sokvag[256];              // URL-sökväg (ex: "/weather")
     char query[512];               // Query-parametrar (ex: "city=Stockholm&country=SE")
     char body[1024];               // Request body (för POST)
+    bool hall_vid_liv;             // Klienten vill behålla anslutningen (keep-alive)
 } HttpRequest;
 
-// Parsa HTTP-request från rå data
+// HTTP-svar i två delar: headers och body. Body byggs direkt i
+// hanterarens buffer och skickas därifrån med writev/sendmsg tillsammans
+// med headers, utan att kopieras in bakom dem.
+typedef struct {
+    char huvud[HTTP_HUVUD_STORLEK];  // Statusrad och headers, byggs av skapa_http_svar()
+    size_t huvud_langd;              // Antal bytes i huvud
+    const char* kropp;               // Body (pekar in i hanterarens buffer)
+    size_t kropp_langd;              // Antal bytes i body
+    bool hall_vid_liv;               // In: anslutningen får hållas öppen, ut: om den ska det
+} HttpSvar;
+
+// Resultat när en mottagningsbuffer söks igenom efter en komplett request
+typedef enum {
+    HTTP_RAM_OFULLSTANDIG,         // Mer data behövs
+    HTTP_RAM_KOMPLETT,             // request_langd bytes i början utgör en hel request
+    HTTP_RAM_FOR_STOR,             // Headers eller body större än MAX_REQUEST_STORLEK
+    HTTP_RAM_FELAKTIG,             // Ogiltig eller motstridig Content-Length
+    HTTP_RAM_EJ_STODD              // Transfer-Encoding (avkodas inte)
+} HttpRamStatus;
+
+// Mottagningsbuffer per anslutning. Växer vid behov upp till
+// MAX_REQUEST_STORLEK och kan rymma flera pipelinade requests.
+typedef struct {
+    char* data;                    // Mottagen data, alltid null-terminerad
+    size_t langd;                  // Antal mottagna bytes i data
+    size_t kapacitet;              // Allokerad storlek (exklusive nullterminator)
+    size_t sokt_till;              // Så långt headers redan genomsökts efter tom rad
+    size_t huvud_langd;            // Längd på headers inkl. tom rad (0 = ej hittad än)
+    size_t request_langd;          // Headers + body för första requesten (0 = okänd)
+} HttpMottagning;
+
+// Parsa HTTP-request i ett pass till vyer in i data (langd bytes, behöver
+// inte vara nollterminerad). Returnerar false för en ogiltig request-rad
+// eller okänd metod.
+bool parsa_http_request_vy(const char* data, size_t langd, HttpRequestVy* request);
+
+// Hämta värdet för en header (skiftlägesokänsligt namn, utan kolon).
+// Returnerar false om headern saknas.
+bool hamta_http_header(const HttpRequestVy* request, const char* namn, HttpVy* varde);
+
+// true om requestens If-None-Match är "*" eller innehåller etag (svag
+// jämförelse: W/"x" matchar "x"). etag anges med citattecken.
+bool http_etag_matchar(const HttpRequestVy* request, const char* etag);
+
+// Komprimering som klienten accepterar enligt Accept-Encoding (gzip före
+// deflate vid lika q-värde), eller KOMPRIMERING_INGEN
+Komprimering http_valj_komprimering(const HttpRequestVy* request);
+
+// Jämför en vy med en nollterminerad sträng (exakt, skiftlägeskänsligt)
+bool http_vy_lika(HttpVy vy, const char* text);
+
+// Parsa HTTP-request från en nollterminerad sträng och kopiera fälten till
+// request. Långa fält kortas av. Finns kvar för äldre kod och tester -
+// parsa_http_request_vy() kopierar ingenting.
 bool parsa_http_request(const char* rådata, HttpRequest* request);
 
-// Skapa HTTP-response med JSON-data
+// Allokera en tom mottagningsbuffer (BUFFER_STORLEK bytes till att börja med)
+bool initiera_http_mottagning(HttpMottagning* mottagning);
+
+// Frigör mottagningsbufferten
+void stang_http_mottagning(HttpMottagning* mottagning);
+
+// Ledigt utrymme att ta emot till. Bufferten växer om den är full;
+// returnerar NULL när MAX_REQUEST_STORLEK är nådd eller minnet tar slut.
+char* http_mottagning_ledigt(HttpMottagning* mottagning, size_t* ledigt);
+
+// Registrera att antal bytes har skrivits till utrymmet från http_mottagning_ledigt
+void http_mottagning_tillfor(HttpMottagning* mottagning, size_t antal);
+
+// Leta efter en komplett request (headers + Content-Length bytes body).
+// Fortsätter där förra sökningen slutade i stället för att börja om.
+HttpRamStatus hitta_http_request(HttpMottagning* mottagning);
+
+// Ta bort den kompletta requesten från början av bufferten
+void http_mottagning_konsumera(HttpMottagning* mottagning);
+
+// Skapa felsvar (Connection: close) för HTTP_RAM_FOR_STOR/FELAKTIG/EJ_STODD:
+// 431 för för stora headers, 413 för för stor body, 400 för ogiltig eller
+// motstridig Content-Length, 501 för Transfer-Encoding. Body skrivs till
+// kropp_buffer.
+void skapa_http_mottagningsfel(HttpSvar* svar, char* kropp_buffer, size_t kropp_storlek,
+                               const HttpMottagning* mottagning, HttpRamStatus status);
+
+// Fyll i svar med det förbyggda 503-svaret vid överlast (Retry-After,
+// Connection: close). Ingen formatering - bara en kopia av headers.
+void skapa_http_overlast(HttpSvar* svar);
+
+// Fyll i svar med det förbyggda 429-svaret till en klient som överskridit
+// sin gräns (Retry-After, Connection: close)
+void skapa_http_begransad(HttpSvar* svar);
+
+// Bygg svarsmallarna (statusrad och headers per statuskod och
+// Connection-läge). Anropas en gång vid start innan trådarna startar.
+// Returnerar false om en mall inte får plats i HTTP_HUVUD_STORLEK.
+bool initiera_http_svar(void);
+
+// Längden på ett datum i Date-headern, t.ex. "Sun, 06 Nov 1994 08:49:37 GMT"
+#define HTTP_DATUM_LANGD 29
+
+// Skriv tid som i Date-headern (HTTP_DATUM_LANGD tecken + '\0' till ut)
+void formatera_http_datum(time_t tid, char* ut);
+
+// Fyll i svar med statuskod och body (som inte kopieras). Headers kopieras
+// från statuskodens mall med Date (cachad per sekund och tråd) och
+// Content-Length; Connection-headern följer svar->hall_vid_liv.
+// 304 får ingen Content-Length.
+void skapa_http_svar(HttpSvar* svar, int statuskod, const char* kropp, size_t kropp_langd);
+
+// Lägg till en header ("namn: varde") sist i ett svar från skapa_http_svar().
+// Returnerar false om den inte får plats.
+bool lagg_till_http_header(HttpSvar* svar, const char* namn, const char* varde);
+
+#ifndef _WIN32
+// Beskriv det som återstår av svaret efter skickat bytes som en iovec-array.
+// Returnerar antal poster (0-2) i iov.
+int http_svar_iovec(const HttpSvar* svar, size_t skickat, struct iovec iov[2]);
+#endif
+
+// Skicka så mycket som möjligt av svaret (ett anrop per varv, headers och
+// body i samma systemanrop). *skickat är in/ut: bytes som redan skickats.
+// Returnerar false vid fel; en full socketbuffer (EAGAIN) är inget fel.
+bool skicka_http_svar(socket_t fd, const HttpSvar* svar, size_t* skickat);
+
+// Skapa HTTP-response med JSON-data (Connection: close) som en enda sträng
 void skapa_http_response(char* buffer, size_t buffer_storlek,
                          int statuskod, const char* json_data);
 
-// Hämta query-parameter värde (ex: "city" från "city=Stockholm&country=SE")
+// Hämta query-parameter värde (ex: "city" från "city=Stockholm&country=SE").
+// Namnet måste matcha helt och värdet avkodas (%XX och '+'). För flera
+// parametrar ur samma request, se tolka_query() i http_query.h.
 bool hamta_query_parameter(const char* query, const char* parameter_namn,
                            char* värde, size_t värde_storlek);
 
+// Som hamta_query_parameter men med query som vy (behöver inte vara
+// nollterminerad). Värdet kopieras och nollterminieras i värde.
+bool hamta_query_parameter_vy(HttpVy query, const char* parameter_namn,
+                              char* värde, size_t värde_storlek);
+
 #endif // HTTP_SERVER_H
@@ -0,0 +1,48 @@
+#ifndef HTTP_SKANNING_H
+#define HTTP_SKANNING_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Sökning efter HTTP:s strukturtecken (radslut, blanksteg, '?', ':') med
+// SIMD. Varje funktion finns i tre varianter - AVX2 (32 bytes per varv),
+// SSE2 (16 bytes per varv) och en skalär som bygger på libc:s memchr - och
+// den bästa som processorn klarar väljs av initiera_http_skanning(). Utan
+// initiering används den skalära.
+
+// Implementation som används
+typedef enum {
+    HTTP_SKANNING_SKALAR,          // memchr/memcmp, fungerar överallt
+    HTTP_SKANNING_SSE2,            // 16-bytes jämförelser och bitmasker (x86 med SSE2)
+    HTTP_SKANNING_AVX2             // 32-bytes jämförelser och bitmasker (x86 med AVX2)
+} HttpSkanningNiva;
+
+// Strukturtecken på en rad, som index från radens början. Det som saknas
+// får samma värde som radslut.
+typedef struct {
+    size_t radslut;                // Index för '\n' (langd om raden inte slutar)
+    size_t mellanslag[2];          // De två första blankstegen
+    size_t fragetecken;            // Första '?'
+    size_t kolon;                  // Första ':'
+} HttpRadSkanning;
+
+// Välj den snabbaste implementationen som processorn stöder. Anropas en
+// gång innan trådar startas. Returnerar vald nivå.
+HttpSkanningNiva initiera_http_skanning(void);
+
+// Tvinga en viss nivå (för tester och mätningar). Returnerar false, och
+// behåller nuvarande nivå, om processorn saknar stöd.
+bool satt_http_skanning(HttpSkanningNiva niva);
+
+// Nivån som används just nu, och dess namn ("avx2", "sse2", "skalär")
+HttpSkanningNiva http_skanning_niva(void);
+const char* http_skanning_namn(HttpSkanningNiva niva);
+
+// Index för första "\r\n\r\n" i data, eller langd om den saknas
+size_t http_hitta_huvudslut(const char* data, size_t langd);
+
+// Skanna en rad i ett pass: radslut, två första blanksteg, '?' och ':'
+// fram till och med radslutet
+void http_skanna_rad(const char* data, size_t langd, HttpRadSkanning* rad);
+
+#endif // HTTP_SKANNING_H
@@ -0,0 +1,84 @@
+#ifndef JSON_SKRIVARE_H
+#define JSON_SKRIVARE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "vaderprotokoll.h"
+
+// Serialisering av svar till JSON. Allt skrivs direkt till en buffert utan
+// snprintf: tal formateras för hand, strängar escapas (med SSE2 på x86) och
+// varje del räknas, så att det efteråt går att se exakt hur stor utdatan
+// hade blivit även när den inte fick plats.
+
+// En skrivare över en buffert. Med en fast buffert allokeras ingenting;
+// det som inte får plats skrivs inte, men räknas i behov. En växande
+// skrivare äger sin buffert och utökar den med realloc().
+typedef struct {
+    char* data;                    // Utdata (null-termineras av json_avsluta)
+    size_t langd;                  // Skrivna bytes
+    size_t kapacitet;              // Storlek på data, inklusive nullterminatorn
+    size_t behov;                  // Bytes som hela utdatan behöver
+    bool vaxande;                  // data är allokerad av skrivaren
+} JsonSkrivare;
+
+// Skriv till en befintlig buffert (utan allokering)
+void json_skrivare_fast(JsonSkrivare* skrivare, char* buffer, size_t storlek);
+
+// Skriv till en allokerad buffert som växer. Returnerar false om minnet
+// inte räcker. Frigörs med json_skrivare_frigor().
+bool json_skrivare_vaxande(JsonSkrivare* skrivare, size_t kapacitet);
+void json_skrivare_frigor(JsonSkrivare* skrivare);
+
+// true om allt som skrivits fick plats
+bool json_skrivare_ok(const JsonSkrivare* skrivare);
+
+// Null-terminera utdatan. Returnerar antal skrivna bytes.
+size_t json_avsluta(JsonSkrivare* skrivare);
+
+// Text som den är, utan escaping
+void json_skriv_ra(JsonSkrivare* skrivare, const char* text, size_t langd);
+
+// Sträng inom citattecken, escapad enligt RFC 8259
+void json_skriv_strang(JsonSkrivare* skrivare, const char* text);
+
+// Heltal
+void json_skriv_heltal(JsonSkrivare* skrivare, int64_t varde);
+
+// Decimaltal med ett fast antal decimaler (0-9), avrundat som printf("%.*f").
+// NaN och oändligheter skrivs som null.
+void json_skriv_decimal(JsonSkrivare* skrivare, double varde, int decimaler);
+
+// Hur väderobjekt skrivs (?format= och ?fields=)
+typedef struct {
+    bool kompakt;                  // Utan blanksteg, radbrytningar och indrag
+    uint32_t falt;                 // Fälten som skrivs, en bit per JSON_FALT_*
+} JsonFormat;
+
+// Fälten i ett väderobjekt, i den ordning de skrivs
+#define JSON_FALT_STAD           (1u << 0)
+#define JSON_FALT_LAND           (1u << 1)
+#define JSON_FALT_TEMPERATUR     (1u << 2)
+#define JSON_FALT_LUFTFUKTIGHET  (1u << 3)
+#define JSON_FALT_VINDHASTIGHET  (1u << 4)
+#define JSON_FALT_LUFTTRYCK      (1u << 5)
+#define JSON_FALT_BESKRIVNING    (1u << 6)
+#define JSON_FALT_IKON_ID        (1u << 7)
+#define JSON_FALT_TIDSSTAMPEL    (1u << 8)
+#define JSON_ALLA_FALT           0x1FFu
+
+// Tolka en kommaseparerad lista med fältnamn ("temperatur,lufttryck") till
+// en mask. Returnerar false om listan är tom eller har ett okänt namn.
+bool json_tolka_falt(const char* lista, uint32_t* falt);
+
+// true för standardformatet (indraget, alla fält)
+bool json_format_ar_standard(const JsonFormat* format);
+
+// Svarsbodies för /weather och /forecast (format NULL = standardformatet).
+// Returnerar antal bytes, eller 0 om bodyn inte får plats i json_buffer.
+size_t skapa_vader_json(const VaderData* data, const JsonFormat* format,
+                        char* json_buffer, size_t storlek);
+size_t skapa_prognos_json(const VaderPrognos* prognos, const JsonFormat* format,
+                          char* json_buffer, size_t storlek);
+
+#endif // JSON_SKRIVARE_H
@@ -0,0 +1,44 @@
+#ifndef KLIENTGRANS_H
+#define KLIENTGRANS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Begränsning av antal requests per klient-IP (token bucket). Varje
+// IP-adress har en hink med plats för `skur` tokens som fylls på med
+// `per_sekund` tokens per sekund; varje request kostar ett token. En
+// klient som har slut på tokens får ett förbyggt 429-svar innan requesten
+// ens parsas, så en enskild klient kan inte ta alla arbetare eller hela
+// API-kvoten.
+//
+// Hinkarna ligger i en låsfri tabell med fast storlek, uppdelad i
+// KLIENTGRANS_SKARVOR delar med KLIENTGRANS_PLATSER platser var. Reaktorer
+// och arbetare uppdaterar den med compare-and-swap utan lås. En plats
+// vars hink hunnit bli full igen går inte att skilja från en ny och kan
+// tas över av en annan adress.
+
+// Räknare för en klient-IP
+typedef struct {
+    uint32_t ip;                                  // IPv4-adress (nätverksordning)
+    unsigned long long tillatna;                  // Requests som släppts igenom
+    unsigned long long begransade;                // Requests som fått 429
+} KlientGransStatistik;
+
+// Sätter gränserna och tömmer tabellen. per_sekund = 0 stänger av
+// begränsningen. Ska anropas innan servern börjar ta emot requests.
+void konfigurera_klientgrans(int per_sekund, int skur);
+
+// Tar ett token ur hinken för ip (nätverksordning). false = slut på
+// tokens, svara 429. ip 0 (klienter via Unix-socketen, som inte har någon
+// adress) begränsas aldrig. Trådsäker och låsfri.
+bool klientgrans_tillat(uint32_t ip);
+
+// Kopierar räknarna för de klienter som gjort flest requests (högst
+// max_antal, flest först) till ut. Returnerar antal.
+int hamta_klientgrans_statistik(KlientGransStatistik* ut, int max_antal);
+
+// Antal requests som släpptes igenom utan begränsning för att tabellen
+// var full (många olika adresser)
+unsigned long long klientgrans_utan_plats(void);
+
+#endif // KLIENTGRANS_H
@@ -0,0 +1,58 @@
+#ifndef KOMPRIMERING_H
+#define KOMPRIMERING_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Komprimering av svar med deflate (RFC 1951), förpackat som gzip
+// (RFC 1952) eller zlib (RFC 1950, "Content-Encoding: deflate"). Svaren
+// komprimeras en gång när de läggs i cachen, så kodaren är enkel: LZ77
+// med hashkedjor och de fasta Huffman-koderna.
+
+typedef enum {
+    KOMPRIMERING_INGEN,            // identity
+    KOMPRIMERING_GZIP,
+    KOMPRIMERING_DEFLATE           // zlib-format, som i HTTP
+} Komprimering;
+
+// Största deflate-ström för n bytes indata (9 bitar per tecken + block)
+#define DEFLATE_MAX_STORLEK(n) ((n) + (n) / 8 + 16)
+
+// Plats som komprimering_packa() behöver före och efter deflate-strömmen
+#define KOMPRIMERING_HUVUD_RESERV 10   // gzip-huvud (zlib behöver 2)
+#define KOMPRIMERING_SVANS_RESERV 8    // CRC-32 + längd (zlib: Adler-32)
+
+// En komprimerad body: kontrollsummorna för båda förpackningarna räknas
+// när den komprimeras, så ett svar kan packas utan att läsa om datan
+typedef struct {
+    int64_t tidsstampel;           // Datan som bodyn byggdes från
+    uint32_t crc32;                // För gzip
+    uint32_t adler32;              // För zlib
+    uint32_t langd;                // Okomprimerad längd
+    uint32_t deflate_langd;        // Deflate-strömmens längd
+} KomprimeradPost;
+
+// Komprimera data till en rå deflate-ström. Returnerar strömmens längd,
+// eller 0 om ut är för liten eller minnet inte räcker.
+size_t deflate_komprimera(const void* data, size_t langd, uint8_t* ut, size_t ut_storlek);
+
+// Komprimera en body och fyll i post. Returnerar false om resultatet inte
+// blir mindre än originalet (då skickas bodyn som den är).
+bool komprimera_post(const void* data, size_t langd, int64_t tidsstampel,
+                     KomprimeradPost* post, uint8_t* ut, size_t ut_storlek);
+
+// Packa en deflate-ström som ligger på buffer + KOMPRIMERING_HUVUD_RESERV
+// som gzip eller zlib, på plats. Returnerar bodyns början i buffer och
+// sparar dess längd i *langd.
+const uint8_t* komprimering_packa(Komprimering komprimering, const KomprimeradPost* post,
+                                  uint8_t* buffer, size_t* langd);
+
+// Namnet i Content-Encoding ("gzip", "deflate")
+const char* komprimering_namn(Komprimering komprimering);
+
+// Kontrollsummor (börja med 0 respektive 1)
+uint32_t berakna_crc32(uint32_t crc, const void* data, size_t langd);
+uint32_t berakna_adler32(uint32_t adler, const void* data, size_t langd);
+
+#endif // KOMPRIMERING_H
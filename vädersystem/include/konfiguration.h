@@ -4,14 +4,47 @@
 // Server-konfiguration
 #define SERVER_PORT 8080                          // TCP-port för servern
 #define MAX_KLIENTER 32                           // Max samtidiga klienter
+#define LYSSNINGSKO_STORLEK 1024                  // Väntande anslutningar per lyssnande socket (listen-backlog)
 #define BUFFER_STORLEK 4096                       // Bufferstorlek för mottagning
+#define MAX_REQUEST_STORLEK 65536                 // Största tillåtna request (headers + body)
+#define SVAR_BUFFER_STORLEK 8192                  // Bufferstorlek för HTTP-svar
+#define HTTP_HUVUD_STORLEK 384                    // Plats för statusrad och headers i ett svar
+#define MAX_QUERY_STORLEK 2048                    // Längsta query-sträng som tolkas (avkodade namn och värden)
+#define MAX_QUERY_PARAMETRAR 16                   // Flest parametrar i en query-sträng
+#define MAX_VISAD_SOKVAG 256                      // Längsta del av en okänd sökväg som återges i 404-svar och logg
 #define TIMEOUT_SEKUNDER 30                       // Timeout för inaktiva klienter
+#define REQUEST_TIDSGRANS_SEKUNDER 10             // En påbörjad request måste bli komplett inom så här lång tid
+#define DRANERING_SEKUNDER 20                     // Tid som pågående requests får vid avstängning (SIGTERM)
+#define DRANERING_FORSTA_REQUEST_MS 1000          // Vid avstängning: tid för nya anslutningar att skicka sin första request
+#define OVERLAMNING_TIDSGRANS_SEKUNDER 5          // Längsta väntan på andra processen vid omstart utan avbrott
+#define TIMERHJUL_TICK_MS 10                      // Upplösning i reaktorernas timerhjul
+#define ANTAL_ARBETARTRADAR 8                     // Standardantal arbetartrådar i trådpoolen
+#define ARBETSKO_STORLEK 1024                     // Platser i kön mellan reaktor och arbetare
+#define ANTAGNING_MAX_KO 256                      // Väntande requests i arbetskön innan nya får 503
+#define ANTAGNING_MAX_KOTID_MS 500                // Kötid som räknas som överlast (nya får 503)
+#define ANTAGNING_CACHE_RESERV_PROCENT 25         // Andel arbetare som cachemissar inte får uppta
+#define ANTAGNING_RETRY_AFTER_SEKUNDER 1          // Retry-After i 503-svaret vid överlast
+#define KLIENTGRANS_PER_SEKUND 100                // Requests per sekund och klient-IP (0 = ingen gräns)
+#define KLIENTGRANS_SKUR 200                      // Requests i följd innan gränsen slår till
+#define KLIENTGRANS_RETRY_AFTER_SEKUNDER 1        // Retry-After i 429-svaret
+#define KLIENTGRANS_SKARVOR 16                    // Delar i tabellen med klient-IP:n
+#define KLIENTGRANS_PLATSER 256                   // Platser per del (klient-IP:n som följs samtidigt)
+#define KLIENTGRANS_SONDERINGAR 8                 // Platser som provas innan en adress släpps igenom obegränsad
+#define ANTAL_REAKTORER 1                         // Standardantal reaktortrådar (0 = en per kärna)
+#define MAX_REAKTORER 64                          // Övre gräns för antal reaktortrådar
+#define URING_KO_STORLEK 256                      // Platser i io_uring-ringens submission-kö
+#define URING_ANTAL_BUFFERTAR 256                 // Mottagningsbuffertar per reaktor (tvåpotens)
 
 // OpenWeatherMap API-konfiguration
 #define API_HOST "api.openweathermap.org"
 #define API_PORT 80
 #define API_ENDPOINT "/data/2.5/weather"
 #define API_FORECAST_ENDPOINT "/data/2.5/forecast"
+#define UPSTREAM_POOL_STORLEK 8                   // Max vilande upstream-anslutningar per (värd, port)
+#define UPSTREAM_TOMGANG_SEKUNDER 30              // Vilande upstream-anslutningar stängs efter så här länge
+#define UPSTREAM_TIDSGRANS_SEKUNDER 10            // Längsta tid för ett helt upstream-anrop (anslutning + svar)
+#define DNS_TTL_SEKUNDER 300                      // Hur länge en DNS-uppslagning av upstream-värden gäller
+#define DNS_OMFORSOK_SEKUNDER 5                   // Väntetid innan en misslyckad uppdatering görs om
 
 // Cache-konfiguration
 #define CACHE_KATALOG "./cache"                   // Katalog för cachefiler
@@ -21,6 +21,20 @@
     static inline int hamta_senaste_socket_fel(void) {
         return WSAGetLastError();
     }
+
+    static inline int satt_icke_blockerande(socket_t s) {
+        u_long ja = 1;
+        return ioctlsocket(s, FIONBIO, &ja);
+    }
+
+    // Högsta tid som blockerande send()/recv() väntar innan de ger fel
+    static inline int satt_socket_tidsgrans(socket_t s, long millisekunder) {
+        DWORD tidsgrans = (DWORD)millisekunder;
+        if (setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, (const char*)&tidsgrans, sizeof(tidsgrans)) != 0) {
+            return -1;
+        }
+        return setsockopt(s, SOL_SOCKET, SO_SNDTIMEO, (const char*)&tidsgrans, sizeof(tidsgrans));
+    }
 #else
     #include <sys/socket.h>
     #include <netinet/in.h>
@@ -28,6 +42,9 @@
     #include <netdb.h>
     #include <unistd.h>
     #include <errno.h>
+    #include <fcntl.h>
+    #include <sys/time.h>
+    #include <sys/select.h>
     
     typedef int socket_t;
     #define OGILTIG_SOCKET -1
@@ -44,6 +61,23 @@
     static inline int hamta_senaste_socket_fel(void) {
         return errno;
     }
+
+    static inline int satt_icke_blockerande(socket_t s) {
+        int flaggor = fcntl(s, F_GETFL, 0);
+        return (flaggor < 0) ? -1 : fcntl(s, F_SETFL, flaggor | O_NONBLOCK);
+    }
+
+    // Högsta tid som blockerande send()/recv() (och connect() på Linux)
+    // väntar innan de ger fel
+    static inline int satt_socket_tidsgrans(socket_t s, long millisekunder) {
+        struct timeval tidsgrans;
+        tidsgrans.tv_sec = millisekunder / 1000;
+        tidsgrans.tv_usec = (millisekunder % 1000) * 1000;
+        if (setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &tidsgrans, sizeof(tidsgrans)) != 0) {
+            return -1;
+        }
+        return setsockopt(s, SOL_SOCKET, SO_SNDTIMEO, &tidsgrans, sizeof(tidsgrans));
+    }
 #endif
 
 #endif // NATVERKS_ABSTRAKTION_H
@@ -0,0 +1,34 @@
+#ifndef OVERLAMNING_H
+#define OVERLAMNING_H
+
+#include "tcp_server.h"
+#include <stdbool.h>
+
+// Omstart utan avbrott. En ny serverprocess ansluter till den gamla via
+// en Unix-socket och får dess lyssnande sockets (SCM_RIGHTS) i stället för
+// att binda porten själv. Den gamla processen dränerar sedan som vid
+// SIGTERM. Socketarna stängs aldrig under bytet, så inga anslutningar
+// nekas - de som kommer under tiden väntar i den delade accept-kön.
+//
+// Samma sökväg anges vid varje start: finns en process där tas dess
+// sockets över, annars binds porten som vanligt. Därefter lyssnar
+// processen själv på sökvägen, redo för nästa omstart.
+
+// Hämtar lyssnande sockets från en process som lyssnar på sokvag och
+// fyller servrar (högst max_antal). TCP-socketarna måste vara bundna till
+// port; en lokal Unix-socket följer med som den är. Returnerar antal mottagna sockets, eller 0 om ingen process
+// svarade eller överlämningen misslyckades (bind då porten som vanligt).
+int ta_over_lyssnare(const char* sokvag, int port, TcpServer* servrar, int max_antal);
+
+// Börjar lyssna på sokvag i en egen tråd. När nästa process har tagit
+// över servrarnas sockets skickas SIGTERM till den anropande tråden, som
+// ska vara den som tar emot stoppsignalen (reaktor 0). Ingen överlämning
+// görs när *kors redan är false. Returnerar true om tråden startade.
+bool starta_overlamning(const char* sokvag, TcpServer* servrar, int antal,
+                        volatile bool* kors);
+
+// Stoppar tråden. Sökvägen tas bort om ingen ny process har tagit över
+// den. Anropas innan servrarna stängs.
+void stang_overlamning(void);
+
+#endif // OVERLAMNING_H
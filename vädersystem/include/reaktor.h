@@ -0,0 +1,96 @@
+#ifndef REAKTOR_H
+#define REAKTOR_H
+
+#include "tcp_server.h"
+#include "arbetarpool.h"
+#include "http_server.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdatomic.h>
+
+// Händelsedriven serverloop (epoll, edge-triggered) för Linux.
+// Alla klientsockets är icke-blockerande och varje anslutning drivs
+// av en liten tillståndsmaskin: LÄSER -> BEARBETAR -> SKRIVER -> STÄNGD.
+// Persistenta anslutningar (keep-alive) går från SKRIVER tillbaka till
+// LÄSER, och flera requests i samma buffer (pipelining) besvaras i ordning.
+
+// Anropas när en komplett HTTP-request har tagits emot.
+// Ska bygga bodyn i kropp_buffer och fylla i svar med skapa_http_svar();
+// reaktorn skickar sedan headers och body med ett scatter/gather-anrop.
+// svar->hall_vid_liv är true om reaktorn kan hålla anslutningen öppen;
+// hanteraren sätter den till false om svaret ska stänga anslutningen.
+// radata är requesten (radata_langd bytes, inte nollterminerad) och pekar
+// direkt in i anslutningens mottagningsbuffer.
+typedef void (*RequestHanterare)(const char* radata, size_t radata_langd, char* kropp_buffer,
+                                 size_t kropp_storlek, HttpSvar* svar,
+                                 void* kontext);
+
+// Tillstånd för en klientanslutning
+typedef enum {
+    ANSLUTNING_LASER,                             // Väntar på (resten av) en request
+    ANSLUTNING_BEARBETAR,                         // Request hanteras av en arbetartråd
+    ANSLUTNING_SKRIVER,                           // Svar håller på att skickas
+    ANSLUTNING_STANGD                             // Anslutningen ska stängas
+} AnslutningsTillstand;
+
+// Vilken tidsgräns som gäller för en anslutning just nu. Varje anslutning
+// har en timer i reaktorns timerhjul; den startas om bara när sorten byts
+// (eller efter aktivitet som ska förlänga den), så en klient som skickar
+// en byte i taget kan inte skjuta upp REQUEST_TIDSGRANS_SEKUNDER.
+typedef enum {
+    TIDSGRANS_INGEN,                              // Ingen (arbetare äger anslutningen), eller ska sättas om
+    TIDSGRANS_VILA,                               // Väntar på nästa request: TIMEOUT_SEKUNDER
+    TIDSGRANS_REQUEST,                            // Request påbörjad: REQUEST_TIDSGRANS_SEKUNDER från första byten
+    TIDSGRANS_SKRIVNING                           // Svar skickas: TIMEOUT_SEKUNDER sedan senaste framsteg
+} AnslutningsTidsgrans;
+
+// I/O-mekanism för reaktorerna
+typedef enum {
+    REAKTOR_IO_EPOLL,                             // epoll + icke-blockerande syscalls (standard)
+    REAKTOR_IO_URING                              // io_uring: accept/recv/send/close via ringen
+} ReaktorIo;
+
+// Inställningar för reaktorn
+typedef struct {
+    RequestHanterare hanterare;                   // Bygger HTTP-svar för en request
+    void* kontext;                                // Skickas vidare till hanteraren
+    ReaktorIo io;                                 // Vilken I/O-bakände reaktorerna använder
+    int dranering_sekunder;                       // Längsta tid för pågående requests vid avstängning
+#ifdef __linux__
+    ArbetarPool* pool;                            // Arbetartrådar, NULL = hantera i reaktorn
+#endif
+} ReaktorInstallningar;
+
+// Räknare per reaktor. Skrivs av reaktortråden och dess arbetare och läses
+// av statistik-endpointen, därav atomics. Varje post ligger på en egen
+// cache-rad så att reaktorerna inte delar rader med varandra.
+typedef struct {
+    _Alignas(64) _Atomic unsigned long long anslutningar;  // Accepterade anslutningar
+    _Atomic unsigned long long requests;          // Besvarade requests
+    _Atomic long oppna;                           // Öppna anslutningar just nu
+    _Atomic unsigned long long avbrutna;          // Requests som avbröts när dräneringstiden tog slut
+} ReaktorRaknare;
+
+// Ögonblicksbild av räknarna för en reaktortråd
+typedef struct {
+    unsigned long long anslutningar;              // Accepterade anslutningar totalt
+    unsigned long long requests;                  // Kompletta requests som bearbetats
+    long oppna;                                   // Anslutningar som är öppna just nu
+} ReaktorStatistik;
+
+// Kör en reaktor per server tills *kors blir false. Reaktor 0 körs i den
+// anropande tråden, övriga i egna trådar. Med flera reaktorer ska servrarna
+// vara skapade med initiera_tcp_server_delad() så att de delar porten.
+// När *kors blir false slutar reaktorerna ta emot anslutningar, stänger
+// vilande keep-alive-anslutningar och låter pågående requests bli klara
+// (med Connection: close) i högst dranering_sekunder innan resten stängs.
+// Servrarnas lyssnande sockets är då redan stängda.
+// Returnerar 0 vid normal avslutning, -1 vid fel
+int kor_reaktorer(TcpServer* servrar, int antal, const ReaktorInstallningar* installningar,
+                  volatile bool* kors);
+
+// Kopierar räknarna för de reaktorer som körs (högst max_antal) till ut.
+// Trådsäker. Returnerar antal reaktorer.
+int hamta_reaktor_statistik(ReaktorStatistik* ut, int max_antal);
+
+#endif // REAKTOR_H
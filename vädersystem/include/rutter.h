@@ -0,0 +1,66 @@
+#ifndef RUTTER_H
+#define RUTTER_H
+
+#include "http_server.h"
+#include "http_query.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Register över serverns endpoints. Rutterna listas i en statisk tabell
+// och läggs vid start i en perfekt hashtabell över (metod, sökväg): varje
+// rutt får en egen plats, så ett uppslag är en hash och en jämförelse
+// oavsett hur många endpoints som finns.
+
+#define MAX_RUTTER 32                    // Flest rutter i en tabell
+#define RUTT_TABELL_STORLEK 128          // Platser i hashtabellen (tvåpotens, minst 4 * MAX_RUTTER)
+#define RUTT_MAX_PARAMETRAR 4            // Flest obligatoriska query-parametrar per rutt
+
+// Det en hanterare får: requesten, dess tolkade query-sträng och var
+// svaret ska byggas
+typedef struct {
+    const HttpRequestVy* request;
+    const HttpQuery* query;              // Obligatoriska parametrar finns alltid
+    char* kropp_buffer;                  // Här byggs svarets body
+    size_t kropp_storlek;
+    HttpSvar* svar;                      // Fylls i med skapa_http_svar() m.fl.
+    void* kontext;                       // Serverns kontext (API-nyckeln)
+} RuttAnrop;
+
+typedef void (*RuttHanterare)(const RuttAnrop* anrop);
+
+// En endpoint
+typedef struct {
+    HttpMetod metod;
+    const char* sokvag;                  // T.ex. "/weather"
+    RuttHanterare hanterare;
+    const char* obligatoriska[RUTT_MAX_PARAMETRAR];   // Parametrar som måste finnas (resten NULL)
+    const char* parametrar;              // Beskrivning av parametrarna för API-dokumentationen (eller NULL)
+    const char* exempel;                 // Exempel-URL (eller NULL)
+    const char* beskrivning;
+} Rutt;
+
+// Perfekt hashtabell över en rutt-tabell
+typedef struct {
+    const Rutt* rutter;
+    int antal;
+    uint32_t fro;                        // Hashens startvärde, valt så att inga rutter krockar
+    uint8_t platser[RUTT_TABELL_STORLEK];   // Index + 1 i rutter, 0 = tom plats
+} RuttTabell;
+
+// Bygg hashtabellen. Returnerar false om rutterna är för många, om någon
+// (metod, sökväg) finns två gånger, eller om inget startvärde ger en
+// tabell utan krockar.
+bool bygg_ruttabell(RuttTabell* tabell, const Rutt* rutter, int antal);
+
+// Rutten för metod och sökväg, eller NULL
+const Rutt* hitta_rutt(const RuttTabell* tabell, HttpMetod metod, HttpVy sokvag);
+
+// Första obligatoriska parameter som saknas eller är tom i query, eller
+// NULL om alla har ett värde
+const char* saknad_parameter(const Rutt* rutt, const HttpQuery* query);
+
+// Metodens namn ("GET", "POST")
+const char* http_metod_namn(HttpMetod metod);
+
+#endif // RUTTER_H
@@ -0,0 +1,35 @@
+#ifndef SAMORDNING_H
+#define SAMORDNING_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Samordning av samtidiga upstream-hämtningar ("singleflight").
+// När flera trådar samtidigt missar cachen för samma (typ, stad, land)
+// gör bara den första - ledaren - själva hämtningen. Övriga väntar och
+// får en kopia av ledarens resultat i stället för att anropa API:et själva.
+
+// Utför själva hämtningen. Ska fylla i resultat och returnera true vid
+// framgång. kontext skickas vidare oförändrad från samordnad_hamtning().
+typedef bool (*HamtningsFunktion)(const char* stad, const char* landskod,
+                                  void* resultat, void* kontext);
+
+// Räknare för samordningen
+typedef struct {
+    unsigned long long hamtningar;                // Hämtningar som faktiskt kördes (ledare)
+    unsigned long long samordnade;                // Anrop som fick en annan tråds resultat
+    unsigned long long pagaende;                  // Hämtningar som pågår just nu
+} SamordningsStatistik;
+
+// Hämtar data för (typ, stad, landskod) med hamta(), eller väntar in en
+// hämtning som redan pågår för samma nyckel. resultat_storlek bytes
+// kopieras till resultat. Returnerar hämtningens returvärde.
+// typ skiljer endpoints åt (t.ex. "vader" och "prognos").
+bool samordnad_hamtning(const char* typ, const char* stad, const char* landskod,
+                        void* resultat, size_t resultat_storlek,
+                        HamtningsFunktion hamta, void* kontext);
+
+// Kopierar räknarna till ut. Trådsäker.
+void hamta_samordnings_statistik(SamordningsStatistik* ut);
+
+#endif // SAMORDNING_H
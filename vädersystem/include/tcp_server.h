@@ -3,19 +3,55 @@
 
 #include "natverks_abstraktion.h"
 #include <stdbool.h>
+#include <stdint.h>
 
-// Struktur för TCP-server
+// Största längd på en Unix-sockets sökväg (sun_path på Linux)
+#define UNIX_SOKVAG_STORLEK 108
+
+// Struktur för TCP-server. Samma struktur används för en lokal
+// Unix-socket (familj AF_UNIX) - resten av servern ser ingen skillnad.
 typedef struct {
     socket_t lyssnar_socket;                      // Socket för inkommande anslutningar
-    int port;                                     // Port att lyssna på
+    int familj;                                   // AF_INET eller AF_UNIX
+    int port;                                     // Port att lyssna på (0 för Unix-socket)
+    char sokvag[UNIX_SOKVAG_STORLEK];             // Unix-socketens sökväg (tom för TCP)
     bool kors;                                    // True om servern körs
+    bool icke_blockerande;                        // True om sockets används av reaktorn
 } TcpServer;
 
 // Initialisera TCP-server
 int initiera_tcp_server(TcpServer* server, int port);
 
-// Vänta på inkommande anslutningar (blockerande)
-socket_t acceptera_klient(TcpServer* server);
+// Initialisera TCP-server med SO_REUSEPORT så att flera sockets kan binda
+// samma port och kärnan fördelar nya anslutningar mellan dem
+int initiera_tcp_server_delad(TcpServer* server, int port);
+
+// Initialisera en lyssnande Unix-socket (AF_UNIX, stream) på sokvag, för
+// klienter på samma maskin. En kvarlämnad socketfil tas bort först.
+// Returnerar 0 vid framgång, -1 vid fel (alltid på Windows).
+int initiera_unix_server(TcpServer* server, const char* sokvag);
+
+// Ta över en socket som redan lyssnar, t.ex. ärvd från en tidigare
+// serverprocess. Port eller sökväg läses från socketen. Returnerar 0 vid
+// framgång, -1 om det inte är en lyssnande IPv4- eller Unix-socket.
+int initiera_tcp_server_fran_socket(TcpServer* server, socket_t lyssnar_socket);
+
+// Vänta på inkommande anslutningar (blockerande). Klientens IPv4-adress
+// (nätverksordning) sparas i klient_ip om den inte är NULL; klienter via
+// Unix-socket får 0, som klientgränsen inte begränsar.
+socket_t acceptera_klient(TcpServer* server, uint32_t* klient_ip);
+
+// Vänta högst millisekunder på en inkommande anslutning. Returnerar true
+// om en klient väntar, false vid tidsgräns, signal eller fel.
+bool vanta_pa_klient(TcpServer* server, int millisekunder);
+
+// Gör lyssnande socket och alla framtida klientsockets icke-blockerande
+int aktivera_icke_blockerande_lage(TcpServer* server);
+
+// Läs och kasta data som redan väntar på en klientsocket (blockerar aldrig).
+// Anropas före ett felsvar som följs av close(), så att oläst data inte
+// får kärnan att skicka RST innan klienten hunnit läsa svaret.
+void kasta_vantande_data(socket_t klient);
 
 // Stäng TCP-server
 void stang_tcp_server(TcpServer* server);
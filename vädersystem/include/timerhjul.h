@@ -0,0 +1,62 @@
+#ifndef TIMERHJUL_H
+#define TIMERHJUL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Hierarkiskt timerhjul för tidsgränser per anslutning. Tiden räknas i
+// tick om TIMERHJUL_TICK_MS. Nivå 0 har ett fack per tick, varje högre
+// nivå täcker TIMERHJUL_FACK gånger så lång tid per fack; när nivå 0 gått
+// ett varv flyttas nästa fack på nivå 1 ned, och så vidare. Att starta och
+// stoppa en timer är O(1) oavsett hur många som är aktiva.
+//
+// Ett hjul ägs av en enda tråd (reaktorn) och har inget eget lås.
+
+#define TIMERHJUL_NIVAER 4                        // 64^4 tick = ca 46 timmar med 10 ms tick
+#define TIMERHJUL_FACK 64                         // Fack per nivå (tvåpotens)
+
+typedef struct Timer Timer;
+
+// Anropas när en timer löper ut. Timern är redan stoppad och får startas
+// om, och funktionen får stoppa eller frigöra andra timers.
+typedef void (*TimerFunktion)(Timer* timer, void* data);
+
+// En timer bäddas in i ägarens struktur (t.ex. en anslutning) - hjulet
+// allokerar inget själv
+struct Timer {
+    Timer* nasta;                                 // Nästa timer i samma fack
+    Timer** forra;                                // Pekaren som pekar på timern (NULL = inte aktiv)
+    uint64_t utgang;                              // Tick då timern löper ut
+    TimerFunktion funktion;
+    void* data;
+};
+
+typedef struct {
+    Timer* fack[TIMERHJUL_NIVAER][TIMERHJUL_FACK];
+    uint64_t tick;                                // Nästa tick som ska behandlas
+    size_t antal;                                 // Antal aktiva timers
+} TimerHjul;
+
+// Nollställer hjulet; nu_ms är aktuell monoton tid i millisekunder
+void initiera_timerhjul(TimerHjul* hjul, uint64_t nu_ms);
+
+// Förbereder en timer som inte är aktiv
+void initiera_timer(Timer* timer, TimerFunktion funktion, void* data);
+
+// Startar (eller flyttar) en timer så att den löper ut vid utgang_ms
+void starta_timer(TimerHjul* hjul, Timer* timer, uint64_t utgang_ms);
+
+// Stoppar en timer. Ofarligt om den inte är aktiv.
+void stoppa_timer(TimerHjul* hjul, Timer* timer);
+
+// true om timern väntar på att löpa ut
+bool timer_aktiv(const Timer* timer);
+
+// Kör alla timers som löpt ut fram till nu_ms. Returnerar antal.
+int kor_timerhjul(TimerHjul* hjul, uint64_t nu_ms);
+
+// Millisekunder tills kor_timerhjul() kan ha något att göra, högst max_ms
+int timerhjul_vantetid(const TimerHjul* hjul, uint64_t nu_ms, int max_ms);
+
+#endif // TIMERHJUL_H
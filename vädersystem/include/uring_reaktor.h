@@ -0,0 +1,41 @@
+#ifndef URING_REAKTOR_H
+#define URING_REAKTOR_H
+
+#include "reaktor.h"
+#include <stdbool.h>
+
+// io_uring-bakände för reaktorn (Linux 6.1+). Samma tillståndsmaskin som
+// epoll-reaktorn men all socket-I/O köas i ringen: multishot accept,
+// recv ur en registrerad buffertring och send länkad till close.
+// Anropas bara från kor_reaktorer() i reaktor.c.
+
+typedef struct UringReaktor UringReaktor;
+
+// Kontrollerar att kärnan stödjer de io_uring-funktioner bakänden behöver
+bool uring_stods(void);
+
+#ifdef __linux__
+
+// Skapar en reaktor med egen ring och buffertring för en lyssnande server.
+// Ringen aktiveras först av den tråd som sedan kör kor_uring_reaktor().
+UringReaktor* skapa_uring_reaktor(TcpServer* server, const ReaktorInstallningar* installningar,
+                                  ReaktorRaknare* raknare, volatile bool* kors);
+
+// Kör reaktorns loop tills *kors blir false (kan vara trådstart).
+// Anslutningarna lämnas öppna åt dranera_uring_reaktor().
+void* kor_uring_reaktor(void* reaktor);
+
+// Slutar ta emot anslutningar, låter pågående requests bli klara i högst
+// dranering_sekunder och stänger sedan allt. Anropas i reaktorns tråd
+// efter kor_uring_reaktor().
+void dranera_uring_reaktor(UringReaktor* reaktor);
+
+// Väcker en reaktor som väntar i ringen så att den ser att *kors ändrats
+void vack_uring_reaktor(UringReaktor* reaktor);
+
+// Frigör reaktorn efter att loopen har avslutats
+void forstor_uring_reaktor(UringReaktor* reaktor);
+
+#endif // __linux__
+
+#endif // URING_REAKTOR_H
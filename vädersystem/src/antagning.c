@@ -0,0 +1,86 @@
+#include "antagning.h"        // Antagningskontrollens API
+#include <stdatomic.h>        // Gränser och räknare delas av alla reaktorer och arbetare
+
+// Gränser - skrivs en gång vid start, läses av alla trådar
+static size_t max_ko = 0;
+static unsigned max_kotid_ms = 0;
+static int upstream_platser = 0;
+
+// Räknare - läses av statistik-endpointen utan lås
+static _Atomic unsigned long long avvisade_ko = 0;
+static _Atomic unsigned long long avvisade_kotid = 0;
+static _Atomic unsigned long long avvisade_upstream = 0;
+static _Atomic int upstream_upptagna = 0;
+
+/**
+ * Sätter antagningskontrollens gränser
+ *
+ * @param ko - Största tillåtna djup på arbetskön (0 = ingen gräns)
+ * @param kotid_ms - Längsta tillåtna kötid i millisekunder (0 = ingen gräns)
+ * @param platser - Samtidiga upstream-hämtningar (0 = ingen gräns)
+ */
+void konfigurera_antagning(size_t ko, unsigned kotid_ms, int platser) {
+    max_ko = ko;
+    max_kotid_ms = kotid_ms;
+    upstream_platser = platser;
+}
+
+/**
+ * Avgör om en ny request får läggas i arbetskön
+ *
+ * @param ko_djup - Antal uppgifter som väntar i kön just nu
+ * @param kotid_ms - Hur länge den senast uttagna uppgiften väntade
+ * @return true om requesten får köas, false om den ska få 503
+ *
+ * Kötiden är ett mått på hur långt efter arbetarna ligger och reagerar
+ * innan kön hunnit bli djup (t.ex. när alla arbetare väntar på ett
+ * långsamt API). Den gäller bara när något faktiskt väntar - med tom kö
+ * släpps allt in, så ett gammalt mätvärde kan inte stänga ute trafik när
+ * arbetarna har hunnit ikapp.
+ */
+bool antagning_slapp_in(size_t ko_djup, unsigned kotid_ms) {
+    if (max_ko > 0 && ko_djup >= max_ko) {
+        atomic_fetch_add_explicit(&avvisade_ko, 1, memory_order_relaxed);
+        return false;
+    }
+    if (max_kotid_ms > 0 && ko_djup > 0 && kotid_ms >= max_kotid_ms) {
+        atomic_fetch_add_explicit(&avvisade_kotid, 1, memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Reserverar en upstream-plats för en cachemiss
+ *
+ * @return true om en plats fanns, false om alla är upptagna
+ */
+bool antagning_borja_upstream(void) {
+    int upptagna = atomic_fetch_add_explicit(&upstream_upptagna, 1, memory_order_relaxed);
+    if (upstream_platser > 0 && upptagna >= upstream_platser) {
+        atomic_fetch_sub_explicit(&upstream_upptagna, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&avvisade_upstream, 1, memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Lämnar tillbaka en upstream-plats
+ */
+void antagning_slapp_upstream(void) {
+    atomic_fetch_sub_explicit(&upstream_upptagna, 1, memory_order_relaxed);
+}
+
+/**
+ * Kopierar antagningskontrollens räknare
+ *
+ * @param ut - Här sparas räknarna
+ */
+void hamta_antagnings_statistik(AntagningsStatistik* ut) {
+    ut->avvisade_ko = atomic_load_explicit(&avvisade_ko, memory_order_relaxed);
+    ut->avvisade_kotid = atomic_load_explicit(&avvisade_kotid, memory_order_relaxed);
+    ut->avvisade_upstream = atomic_load_explicit(&avvisade_upstream, memory_order_relaxed);
+    int upptagna = atomic_load_explicit(&upstream_upptagna, memory_order_relaxed);
+    ut->upstream_pagaende = upptagna > 0 ? (unsigned long long)upptagna : 0;
+}
@@ -0,0 +1,289 @@
+#define _POSIX_C_SOURCE 200809L  // För pthread_sigmask
+#include "arbetarpool.h"     // Trådpoolens API och datastrukturer
+#include "loggning.h"         // För loggning av fel
+#include <stdlib.h>           // För malloc, calloc, free
+#include <stdint.h>           // För intptr_t, uint64_t
+#include <signal.h>           // För pthread_sigmask
+#include <sched.h>            // För sched_yield
+#include <time.h>             // För clock_gettime till kötiden
+
+#ifdef __linux__
+
+/**
+ * Hämtar monoton tid i millisekunder
+ *
+ * @return Millisekunder från en godtycklig fast startpunkt
+ */
+static uint64_t monoton_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+/**
+ * Försöker ta ut en uppgift ur kön utan att blockera
+ *
+ * @param pool - Poolen att läsa från
+ * @param uppgift - Här sparas uppgiften om en fanns
+ * @return true om en uppgift togs ut, false om ingen var redo
+ *
+ * Vyukovs algoritm: varje plats har ett sekvensnummer. När sekvens ==
+ * position + 1 har en producent publicerat en uppgift där, och läsaren
+ * tar platsen genom compare-and-swap på las_position.
+ */
+static bool ta_uppgift(ArbetarPool* pool, ArbetsUppgift* uppgift) {
+    size_t position = atomic_load_explicit(&pool->las_position, memory_order_relaxed);
+    for (;;) {
+        KoPlats* plats = &pool->platser[position & pool->mask];
+        size_t sekvens = atomic_load_explicit(&plats->sekvens, memory_order_acquire);
+        intptr_t skillnad = (intptr_t)sekvens - (intptr_t)(position + 1);
+
+        if (skillnad == 0) {
+            if (atomic_compare_exchange_weak_explicit(&pool->las_position, &position,
+                                                      position + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                *uppgift = plats->uppgift;
+                // Markera platsen som ledig för producenten ett varv senare
+                atomic_store_explicit(&plats->sekvens, position + pool->mask + 1,
+                                      memory_order_release);
+                return true;
+            }
+        } else if (skillnad < 0) {
+            return false;  // Platsen är inte publicerad än
+        } else {
+            position = atomic_load_explicit(&pool->las_position, memory_order_relaxed);
+        }
+    }
+}
+
+// Startargument till en arbetartråd
+typedef struct {
+    ArbetarPool* pool;
+    int index;
+} ArbetarStart;
+
+/**
+ * Huvudloop för en arbetartråd
+ *
+ * @param argument - ArbetarStart med pool och trådens index
+ *
+ * Tråden sover på semaforen tills en uppgift finns. Varje semaforsignal
+ * motsvarar exakt en publicerad uppgift, så efter sem_wait() finns alltid
+ * en uppgift att hämta - den kan bara tillfälligt ligga bakom en plats som
+ * en annan producent inte hunnit publicera, därav sched_yield().
+ */
+static void* arbetar_loop(void* argument) {
+    ArbetarStart* start = (ArbetarStart*)argument;
+    ArbetarPool* pool = start->pool;
+    char* scratch = pool->scratch[start->index];
+    free(start);
+
+    for (;;) {
+        while (sem_wait(&pool->vantande) != 0) {
+            // EINTR - försök igen
+        }
+
+        ArbetsUppgift uppgift;
+        bool fick_uppgift;
+        while (!(fick_uppgift = ta_uppgift(pool, &uppgift))) {
+            if (atomic_load(&pool->stoppar)) {
+                break;
+            }
+            sched_yield();
+        }
+
+        if (fick_uppgift) {
+            // Kötiden läses av antagningskontrollen i reaktorerna
+            uint64_t vantat = monoton_ms() - uppgift.koad_ms;
+            atomic_store_explicit(&pool->kotid_ms,
+                                  vantat > UINT32_MAX ? UINT32_MAX : (unsigned)vantat,
+                                  memory_order_relaxed);
+            uppgift.funktion(uppgift.argument, scratch, pool->scratch_storlek);
+        } else if (atomic_load(&pool->stoppar)) {
+            return NULL;  // Stoppsignal och kön är tom
+        }
+    }
+}
+
+/**
+ * Initierar en trådpool
+ *
+ * @param pool - Pekare till poolen som ska initieras
+ * @param antal_tradar - Antal arbetartrådar (minst 1)
+ * @param ko_storlek - Minsta antal platser i kön
+ * @param scratch_storlek - Storlek på varje arbetares scratch-buffer
+ * @return true vid framgång, false vid fel
+ *
+ * Arbetartrådarna blockerar alla signaler så att SIGINT/SIGTERM alltid
+ * levereras till huvudtråden och väcker dess epoll_wait() direkt.
+ */
+bool initiera_arbetarpool(ArbetarPool* pool, int antal_tradar,
+                          size_t ko_storlek, size_t scratch_storlek) {
+    if (antal_tradar < 1) {
+        antal_tradar = 1;
+    }
+
+    // Avrunda köstorleken uppåt till en tvåpotens så att modulo blir en mask
+    size_t storlek = 2;
+    while (storlek < ko_storlek) {
+        storlek <<= 1;
+    }
+
+    pool->platser = calloc(storlek, sizeof(KoPlats));
+    pool->tradar = calloc((size_t)antal_tradar, sizeof(pthread_t));
+    pool->scratch = calloc((size_t)antal_tradar, sizeof(char*));
+    if (!pool->platser || !pool->tradar || !pool->scratch) {
+        LOGG_FEL("Minnesallokering misslyckades för trådpool");
+        free(pool->platser);
+        free(pool->tradar);
+        free(pool->scratch);
+        return false;
+    }
+
+    for (size_t i = 0; i < storlek; i++) {
+        atomic_init(&pool->platser[i].sekvens, i);
+    }
+    pool->mask = storlek - 1;
+    atomic_init(&pool->skriv_position, 0);
+    atomic_init(&pool->las_position, 0);
+    atomic_init(&pool->stoppar, false);
+    atomic_init(&pool->kotid_ms, 0);
+    pool->scratch_storlek = scratch_storlek;
+    pool->antal_tradar = 0;
+    sem_init(&pool->vantande, 0, 0);
+
+    // Blockera signaler medan trådarna skapas - de ärver signalmasken
+    sigset_t alla, gammal;
+    sigfillset(&alla);
+    pthread_sigmask(SIG_BLOCK, &alla, &gammal);
+
+    for (int i = 0; i < antal_tradar; i++) {
+        pool->scratch[i] = malloc(scratch_storlek);
+        ArbetarStart* start = malloc(sizeof(ArbetarStart));
+        if (!pool->scratch[i] || !start) {
+            free(pool->scratch[i]);
+            free(start);
+            LOGG_FEL("Minnesallokering misslyckades för arbetare %d", i);
+            break;
+        }
+        start->pool = pool;
+        start->index = i;
+        if (pthread_create(&pool->tradar[i], NULL, arbetar_loop, start) != 0) {
+            free(pool->scratch[i]);
+            free(start);
+            LOGG_FEL("Kunde inte skapa arbetartråd %d", i);
+            break;
+        }
+        pool->antal_tradar++;
+    }
+
+    pthread_sigmask(SIG_SETMASK, &gammal, NULL);
+
+    if (pool->antal_tradar == 0) {
+        stang_arbetarpool(pool);
+        return false;
+    }
+
+    LOGG_INFO("Trådpool startad: %d arbetare, kö med %zu platser",
+              pool->antal_tradar, storlek);
+    return true;
+}
+
+/**
+ * Lägger till en uppgift i kön
+ *
+ * @param pool - Poolen
+ * @param funktion - Funktion som ska köras av en arbetare
+ * @param argument - Argument till funktionen
+ * @return true om uppgiften köades, false om kön var full
+ *
+ * Producentsidan av Vyukovs algoritm: reservera en plats med CAS på
+ * skriv_position, skriv uppgiften och publicera genom att sätta sekvens.
+ */
+bool lagg_till_uppgift(ArbetarPool* pool, ArbetsFunktion funktion, void* argument) {
+    size_t position = atomic_load_explicit(&pool->skriv_position, memory_order_relaxed);
+    KoPlats* plats;
+    for (;;) {
+        plats = &pool->platser[position & pool->mask];
+        size_t sekvens = atomic_load_explicit(&plats->sekvens, memory_order_acquire);
+        intptr_t skillnad = (intptr_t)sekvens - (intptr_t)position;
+
+        if (skillnad == 0) {
+            if (atomic_compare_exchange_weak_explicit(&pool->skriv_position, &position,
+                                                      position + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                break;
+            }
+        } else if (skillnad < 0) {
+            return false;  // Kön är full
+        } else {
+            position = atomic_load_explicit(&pool->skriv_position, memory_order_relaxed);
+        }
+    }
+
+    plats->uppgift.funktion = funktion;
+    plats->uppgift.argument = argument;
+    plats->uppgift.koad_ms = monoton_ms();
+    atomic_store_explicit(&plats->sekvens, position + 1, memory_order_release);
+
+    sem_post(&pool->vantande);  // Väck en sovande arbetare
+    return true;
+}
+
+/**
+ * Räknar uppgifterna som väntar i kön
+ *
+ * @param pool - Poolen
+ * @return Antal reserverade platser som ingen arbetare tagit ut än
+ *
+ * Positionerna läses var för sig utan lås, så värdet kan vara något
+ * inaktuellt när producenter och arbetare är aktiva samtidigt.
+ */
+size_t arbetarpool_kodjup(ArbetarPool* pool) {
+    size_t las = atomic_load_explicit(&pool->las_position, memory_order_relaxed);
+    size_t skriv = atomic_load_explicit(&pool->skriv_position, memory_order_relaxed);
+    return skriv > las ? skriv - las : 0;
+}
+
+/**
+ * Hämtar senast uppmätta kötid
+ *
+ * @param pool - Poolen
+ * @return Millisekunder som den senast uttagna uppgiften väntade
+ */
+unsigned arbetarpool_kotid_ms(ArbetarPool* pool) {
+    return atomic_load_explicit(&pool->kotid_ms, memory_order_relaxed);
+}
+
+/**
+ * Stänger trådpoolen
+ *
+ * @param pool - Poolen som ska stängas
+ *
+ * Redan köade uppgifter körs klart innan trådarna avslutas.
+ */
+void stang_arbetarpool(ArbetarPool* pool) {
+    atomic_store(&pool->stoppar, true);
+    for (int i = 0; i < pool->antal_tradar; i++) {
+        sem_post(&pool->vantande);  // En extra signal per tråd väcker alla
+    }
+    for (int i = 0; i < pool->antal_tradar; i++) {
+        pthread_join(pool->tradar[i], NULL);
+    }
+    for (int i = 0; i < pool->antal_tradar; i++) {
+        free(pool->scratch[i]);
+    }
+
+    sem_destroy(&pool->vantande);
+    free(pool->platser);
+    free(pool->tradar);
+    free(pool->scratch);
+    pool->platser = NULL;
+    pool->tradar = NULL;
+    pool->scratch = NULL;
+    pool->antal_tradar = 0;
+}
+
+#endif // __linux__
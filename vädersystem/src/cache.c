@@ -2,8 +2,10 @@
 #include "loggning.h"       // För att logga debug-meddelanden och varningar
 #include "konfiguration.h"  // För CACHE_KATALOG och CACHE_GILTIGHETSTID
 #include <stdio.h>          // För filhantering: fopen, fread, fwrite, fclose
-#include <string.h>         // För strängfunktioner: strcmp
+#include <string.h>         // För strängfunktioner: strcmp, memcpy
+#include <stdlib.h>         // För malloc och free
 #include <time.h>           // För tidshantering: time(), tidsstämplar
+#include <stdatomic.h>      // För unika namn på temporära cachefiler
 
 #ifdef _WIN32
     #include <direct.h>     // Windows-specifik: för _mkdir
@@ -37,6 +39,49 @@ static void skapa_cache_filnamn(const char* stad, const char* landskod,
              CACHE_KATALOG, stad, landskod, typ);
 }
 
+/**
+ * Hjälpfunktion: Skriver en cachepost atomiskt
+ *
+ * @param filnamn - Slutligt filnamn för cache-filen
+ * @param data - Data som ska skrivas
+ * @param storlek - Antal bytes i data
+ * @return true om skrivningen lyckades, false vid fel
+ *
+ * Data skrivs först till en temporär fil som sedan döps om till det riktiga
+ * namnet. rename() är atomiskt, så en arbetartråd som samtidigt läser samma
+ * stad ser antingen den gamla eller den nya posten - aldrig en halvskriven fil.
+ */
+static bool skriv_cache_fil(const char* filnamn, const void* data, size_t storlek) {
+    // Unikt temporärt namn per skrivning så att samtidiga skrivare inte krockar
+    static _Atomic unsigned int raknare = 0;
+    char tmp_namn[300];
+    snprintf(tmp_namn, sizeof(tmp_namn), "%s.%u.tmp", filnamn, atomic_fetch_add(&raknare, 1));
+
+    FILE* fil = fopen(tmp_namn, "wb");
+    if (!fil) {
+        LOGG_VARNING("Kunde inte öppna cache-fil för skrivning: %s", tmp_namn);
+        return false;
+    }
+
+    size_t skrivet = fwrite(data, storlek, 1, fil);
+    if (fclose(fil) != 0 || skrivet != 1) {
+        // Kunde inte skriva hela strukturen - disken kan vara full
+        LOGG_VARNING("Kunde inte skriva till cache-fil: %s", filnamn);
+        remove(tmp_namn);
+        return false;
+    }
+
+#ifdef _WIN32
+    remove(filnamn);  // rename() på Windows skriver inte över befintliga filer
+#endif
+    if (rename(tmp_namn, filnamn) != 0) {
+        LOGG_VARNING("Kunde inte byta namn på cache-fil: %s", tmp_namn);
+        remove(tmp_namn);
+        return false;
+    }
+    return true;
+}
+
 /**
  * Initierar cache-systemet genom att skapa cache-katalogen
  *
@@ -120,7 +165,7 @@ bool las_fran_cache(const char* stad, const char* landskod, VaderData* resultat)
     }
 
     // Cache är giltig! Logga framgång och hur färsk datan är
-    LOGG_INFO("Cache hit: %s (ålder: %ld sekunder)",
+    LOGG_DEBUG("Cache hit: %s (ålder: %ld sekunder)",
               filnamn, (long)(nu - resultat->tidsstampel));
     return true;
 }
@@ -142,22 +187,9 @@ bool skriv_till_cache(const char* stad, const char* landskod, const VaderData* d
     char filnamn[256];
     skapa_cache_filnamn(stad, landskod, "vader", filnamn, sizeof(filnamn));
 
-    // Öppna filen för binärskrivning ("wb" = write binary)
-    // Om filen redan finns skrivs den över med ny data
-    FILE* fil = fopen(filnamn, "wb");
-    if (!fil) {
-        LOGG_VARNING("Kunde inte öppna cache-fil för skrivning: %s", filnamn);
-        return false;
-    }
-
-    // Skriv hela VaderData-strukturen direkt till filen
-    // fwrite returnerar antal element som skrevs (ska vara 1)
-    size_t skrivet = fwrite(data, sizeof(VaderData), 1, fil);
-    fclose(fil);  // Stäng filen direkt efter skrivning
-
-    if (skrivet != 1) {
-        // Kunde inte skriva hela strukturen - disken kan vara full
-        LOGG_VARNING("Kunde inte skriva till cache-fil: %s", filnamn);
+    // Skriv hela VaderData-strukturen atomiskt (temporär fil + rename)
+    // Om filen redan finns ersätts den med ny data
+    if (!skriv_cache_fil(filnamn, data, sizeof(VaderData))) {
         return false;
     }
 
@@ -211,7 +243,7 @@ bool las_prognos_fran_cache(const char* stad, const char* landskod, VaderPrognos
         }
     }
 
-    LOGG_INFO("Cache hit: %s", filnamn);
+    LOGG_DEBUG("Cache hit: %s", filnamn);
     return true;
 }
 
@@ -232,24 +264,87 @@ bool skriv_prognos_till_cache(const char* stad, const char* landskod,
     char filnamn[256];
     skapa_cache_filnamn(stad, landskod, "prognos", filnamn, sizeof(filnamn));
 
-    // Öppna filen för binärskrivning
-    FILE* fil = fopen(filnamn, "wb");
-    if (!fil) {
-        LOGG_VARNING("Kunde inte öppna cache-fil för skrivning: %s", filnamn);
+    // Skriv hela VaderPrognos-strukturen atomiskt
+    if (!skriv_cache_fil(filnamn, data, sizeof(VaderPrognos))) {
         return false;
     }
 
-    // Skriv hela VaderPrognos-strukturen till filen
-    size_t skrivet = fwrite(data, sizeof(VaderPrognos), 1, fil);
-    fclose(fil);
+    LOGG_DEBUG("Cachade prognos: %s", filnamn);
+    return true;
+}
 
-    if (skrivet != 1) {
-        LOGG_VARNING("Kunde inte skriva till cache-fil: %s", filnamn);
+/**
+ * Skriver en komprimerad JSON-body till cache
+ *
+ * @param stad - Stadens namn
+ * @param landskod - Landskod
+ * @param typ - "vader" eller "prognos"
+ * @param post - Kontrollsummor och längder från komprimera_post()
+ * @param deflate - Deflate-strömmen (post->deflate_langd bytes)
+ * @return true om skrivningen lyckades
+ *
+ * Filen ("Stockholm_SE_vader_deflate.cache") innehåller posten följd av
+ * strömmen och skrivs atomiskt som de andra cachefilerna. Den rensas av
+ * rensa_gammal_cache() som dem.
+ */
+bool skriv_komprimerad_till_cache(const char* stad, const char* landskod, const char* typ,
+                                  const KomprimeradPost* post, const uint8_t* deflate) {
+    char filtyp[32];
+    char filnamn[256];
+    snprintf(filtyp, sizeof(filtyp), "%s_deflate", typ);
+    skapa_cache_filnamn(stad, landskod, filtyp, filnamn, sizeof(filnamn));
+
+    // Post och ström i ett stycke, så att filen skrivs med en fwrite()
+    size_t storlek = sizeof(KomprimeradPost) + post->deflate_langd;
+    uint8_t* data = malloc(storlek);
+    if (!data) {
         return false;
     }
+    memcpy(data, post, sizeof(KomprimeradPost));
+    memcpy(data + sizeof(KomprimeradPost), deflate, post->deflate_langd);
+    bool ok = skriv_cache_fil(filnamn, data, storlek);
+    free(data);
+
+    if (ok) {
+        LOGG_DEBUG("Cachade komprimerad body: %s (%u -> %u bytes)",
+                   filnamn, post->langd, post->deflate_langd);
+    }
+    return ok;
+}
 
-    LOGG_DEBUG("Cachade prognos: %s", filnamn);
-    return true;
+/**
+ * Läser en komprimerad JSON-body från cache
+ *
+ * @param stad - Stadens namn
+ * @param landskod - Landskod
+ * @param typ - "vader" eller "prognos"
+ * @param tidsstampel - Tidsstämpeln i den cachade datan som ska besvaras
+ * @param post - Fylls i
+ * @param deflate - Här läses strömmen in
+ * @param deflate_storlek - Storlek på deflate
+ * @return false om filen saknas, är från en annan hämtning eller inte ryms
+ *
+ * Tidsstämpeln jämförs så att en komprimerad body aldrig skickas för
+ * annan data än den okomprimerade (och dess ETag) skulle ha beskrivit.
+ */
+bool las_komprimerad_fran_cache(const char* stad, const char* landskod, const char* typ,
+                                int64_t tidsstampel, KomprimeradPost* post,
+                                uint8_t* deflate, size_t deflate_storlek) {
+    char filtyp[32];
+    char filnamn[256];
+    snprintf(filtyp, sizeof(filtyp), "%s_deflate", typ);
+    skapa_cache_filnamn(stad, landskod, filtyp, filnamn, sizeof(filnamn));
+
+    FILE* fil = fopen(filnamn, "rb");
+    if (!fil) {
+        return false;
+    }
+    bool ok = fread(post, sizeof(KomprimeradPost), 1, fil) == 1 &&
+              post->tidsstampel == tidsstampel &&
+              post->deflate_langd <= deflate_storlek &&
+              fread(deflate, 1, post->deflate_langd, fil) == post->deflate_langd;
+    fclose(fil);
+    return ok;
 }
 
 /**
@@ -0,0 +1,391 @@
+#define _POSIX_C_SOURCE 200809L  // För getaddrinfo, clock_gettime och pthread_sigmask
+#include "dns_cache.h"        // Egna funktioner för namnuppslagning
+#include "loggning.h"         // För att logga misslyckade uppslagningar
+#include "konfiguration.h"    // För DNS_TTL_SEKUNDER och DNS_OMFORSOK_SEKUNDER
+#include <stdlib.h>           // För calloc, free
+#include <string.h>           // För strcmp, memcpy, memset
+#include <stdio.h>            // För snprintf
+#include <stdatomic.h>        // För räknarna och TTL:en
+#include <time.h>             // För clock_gettime
+
+#ifndef _WIN32
+#include <pthread.h>          // För lås, villkorsvariabel och bakgrundstråden
+#include <signal.h>           // För att blockera signaler i bakgrundstråden
+
+static pthread_mutex_t dns_las = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t uppdatering_signal = PTHREAD_COND_INITIALIZER;
+static pthread_t uppdaterare;
+static bool uppdaterare_startad = false;
+static bool uppdaterare_stoppa = false;
+#define LAS_DNS() pthread_mutex_lock(&dns_las)
+#define LAS_UPP_DNS() pthread_mutex_unlock(&dns_las)
+#else
+// Windows-servern hanterar en klient i taget - inget att låsa, och
+// gamla poster uppdateras direkt i stället för i en bakgrundstråd
+#define LAS_DNS() ((void)0)
+#define LAS_UPP_DNS() ((void)0)
+#endif
+
+// En uppslagen värd. Posterna lever tills stang_dns_cache() anropas
+// (i praktiken en per API-värd).
+typedef struct DnsPost {
+    char vard[128];
+    DnsAdress adress;                             // Senaste fungerande adress
+    bool har_adress;                              // false tills första lyckade uppslagningen
+    long long giltig_till;                        // Monoton tid (ms) när posten blir gammal
+    bool uppdateras;                              // Köad för eller under uppdatering
+    bool koad;                                    // Väntar på att bakgrundstråden tar den
+    struct DnsPost* nasta;
+} DnsPost;
+
+static DnsPost* poster = NULL;
+
+static _Atomic int ttl_sekunder = DNS_TTL_SEKUNDER;
+
+static _Atomic unsigned long long antal_traffar = 0;
+static _Atomic unsigned long long antal_uppslagningar = 0;
+static _Atomic unsigned long long antal_misslyckade = 0;
+
+/**
+ * Slår upp ett värdnamn med getaddrinfo()
+ *
+ * @param vard - Värdnamn eller IP-adress
+ * @param adress - Här sparas den första adressen i svaret
+ * @return true om namnet gick att slå upp
+ *
+ * Till skillnad från gethostbyname() är getaddrinfo() trådsäker och
+ * hanterar både IPv4 och IPv6.
+ */
+static bool sla_upp_med_getaddrinfo(const char* vard, DnsAdress* adress) {
+    struct addrinfo tips;
+    memset(&tips, 0, sizeof(tips));
+    tips.ai_family = AF_UNSPEC;        // IPv4 eller IPv6, det som finns
+    tips.ai_socktype = SOCK_STREAM;    // Bara en post per adress, inte en per protokoll
+
+    struct addrinfo* resultat = NULL;
+    int fel = getaddrinfo(vard, NULL, &tips, &resultat);
+    if (fel != 0 || !resultat) {
+        LOGG_VARNING("DNS-uppslagning av %s misslyckades: %s", vard, gai_strerror(fel));
+        return false;
+    }
+
+    memset(adress, 0, sizeof(*adress));
+    memcpy(&adress->adress, resultat->ai_addr, (size_t)resultat->ai_addrlen);
+    adress->langd = (socklen_t)resultat->ai_addrlen;
+    freeaddrinfo(resultat);
+    return true;
+}
+
+static DnsUppslagning uppslagning = sla_upp_med_getaddrinfo;
+
+/**
+ * Hämtar monoton tid i millisekunder
+ *
+ * @return Millisekunder sedan en godtycklig fast tidpunkt
+ */
+static long long monoton_ms(void) {
+#ifdef _WIN32
+    return (long long)GetTickCount64();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+#endif
+}
+
+/**
+ * Letar upp posten för en värd
+ *
+ * @param vard - Värdnamn
+ * @return Posten, eller NULL om värden inte har slagits upp
+ *
+ * Anroparen måste hålla dns_las.
+ */
+static DnsPost* hitta_post(const char* vard) {
+    for (DnsPost* post = poster; post; post = post->nasta) {
+        if (strcmp(post->vard, vard) == 0) {
+            return post;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Sparar resultatet av en uppslagning
+ *
+ * @param vard - Värdnamn
+ * @param lyckades - Om uppslagningen lyckades
+ * @param ny - Den nya adressen (används bara om lyckades)
+ * @param ut - Här sparas postens adress efteråt, om den har någon
+ * @return true om posten har en adress (ny eller senast fungerande)
+ *
+ * Anroparen måste hålla dns_las. Ett misslyckande behåller den gamla
+ * adressen men försöker igen efter DNS_OMFORSOK_SEKUNDER i stället för
+ * att vänta en hel TTL.
+ */
+static bool spara_uppslagning(const char* vard, bool lyckades, const DnsAdress* ny,
+                              DnsAdress* ut) {
+    DnsPost* post = hitta_post(vard);
+    if (!post) {
+        post = calloc(1, sizeof(DnsPost));
+        if (!post) {
+            LOGG_FEL("Minnesallokering misslyckades för DNS-cache");
+            if (lyckades && ut) {
+                *ut = *ny;  // Adressen kan användas även om den inte cachas
+            }
+            return lyckades;
+        }
+        snprintf(post->vard, sizeof(post->vard), "%s", vard);
+        post->nasta = poster;
+        poster = post;
+    }
+
+    int ttl = atomic_load_explicit(&ttl_sekunder, memory_order_relaxed);
+    if (lyckades) {
+        post->adress = *ny;
+        post->har_adress = true;
+        post->giltig_till = monoton_ms() + (long long)ttl * 1000;
+    } else {
+        int omforsok = ttl < DNS_OMFORSOK_SEKUNDER ? ttl : DNS_OMFORSOK_SEKUNDER;
+        post->giltig_till = monoton_ms() + (long long)omforsok * 1000;
+        if (post->har_adress) {
+            LOGG_VARNING("Använder senast kända adress för %s", vard);
+        }
+    }
+    post->uppdateras = false;
+
+    if (post->har_adress && ut) {
+        *ut = post->adress;
+    }
+    return post->har_adress;
+}
+
+/**
+ * Anropar resolvern och räknar anropet
+ *
+ * @param vard - Värdnamn
+ * @param adress - Här sparas adressen
+ * @return true om uppslagningen lyckades
+ *
+ * Anropas utan att dns_las hålls - en långsam DNS-server ska inte
+ * stoppa uppslagningar som kan besvaras från cachen.
+ */
+static bool anropa_resolver(const char* vard, DnsAdress* adress) {
+    atomic_fetch_add_explicit(&antal_uppslagningar, 1, memory_order_relaxed);
+    bool lyckades = uppslagning(vard, adress);
+    if (!lyckades) {
+        atomic_fetch_add_explicit(&antal_misslyckade, 1, memory_order_relaxed);
+    }
+    return lyckades;
+}
+
+#ifndef _WIN32
+/**
+ * Bakgrundstrådens huvudloop
+ *
+ * @param argument - Används inte
+ * @return NULL
+ *
+ * Väntar på köade poster och slår upp dem en i taget. Under tiden
+ * fortsätter anropare att använda postens gamla adress.
+ */
+static void* uppdaterare_loop(void* argument) {
+    (void)argument;
+
+    LAS_DNS();
+    while (!uppdaterare_stoppa) {
+        DnsPost* post = poster;
+        while (post && !post->koad) {
+            post = post->nasta;
+        }
+        if (!post) {
+            pthread_cond_wait(&uppdatering_signal, &dns_las);
+            continue;
+        }
+        post->koad = false;
+
+        // Posten frigörs bara av stang_dns_cache() efter att tråden stoppats,
+        // men namnet kopieras ändå så att uppslagningen inte läser posten olåst
+        char vard[sizeof(post->vard)];
+        memcpy(vard, post->vard, sizeof(vard));
+        LAS_UPP_DNS();
+
+        DnsAdress ny;
+        bool lyckades = anropa_resolver(vard, &ny);
+        LOGG_DEBUG("DNS-uppdatering av %s %s", vard, lyckades ? "klar" : "misslyckades");
+
+        LAS_DNS();
+        spara_uppslagning(vard, lyckades, &ny, NULL);
+    }
+    LAS_UPP_DNS();
+    return NULL;
+}
+
+/**
+ * Startar bakgrundstråden om den inte redan körs
+ *
+ * @return true om tråden körs
+ *
+ * Anroparen måste hålla dns_las. Tråden startas först när en post
+ * blir gammal, så program som bara slår upp en gång slipper den.
+ */
+static bool starta_uppdaterare(void) {
+    if (uppdaterare_startad) {
+        return true;
+    }
+
+    // Signaler (Ctrl+C) ska hanteras av huvudtråden
+    sigset_t alla, gammal;
+    sigfillset(&alla);
+    pthread_sigmask(SIG_BLOCK, &alla, &gammal);
+    uppdaterare_stoppa = false;
+    uppdaterare_startad = pthread_create(&uppdaterare, NULL, uppdaterare_loop, NULL) == 0;
+    pthread_sigmask(SIG_SETMASK, &gammal, NULL);
+
+    if (!uppdaterare_startad) {
+        LOGG_VARNING("Kunde inte starta DNS-uppdateringstråd, uppdaterar synkront");
+    }
+    return uppdaterare_startad;
+}
+#endif
+
+/**
+ * Sätter porten i en adress
+ *
+ * @param adress - Adressen
+ * @param port - Portnummer i host byte order
+ */
+static void satt_port(DnsAdress* adress, int port) {
+    if (adress->adress.ss_family == AF_INET6) {
+        ((struct sockaddr_in6*)&adress->adress)->sin6_port = htons((uint16_t)port);
+    } else {
+        ((struct sockaddr_in*)&adress->adress)->sin_port = htons((uint16_t)port);
+    }
+}
+
+/**
+ * Slår upp en värd, från cachen om möjligt
+ *
+ * @param vard - Värdnamn (t.ex. "api.openweathermap.org")
+ * @param port - Port som ska sättas i adressen
+ * @param adress - Här sparas adressen
+ * @return true om en adress finns, false om värden aldrig gått att slå upp
+ *
+ * En giltig post besvaras direkt. En gammal post besvaras också direkt
+ * med sin gamla adress, men köas samtidigt för uppdatering i
+ * bakgrundstråden. Bara första uppslagningen av en värd (eller en värd
+ * som aldrig lyckats) väntar på resolvern.
+ */
+bool dns_sla_upp(const char* vard, int port, DnsAdress* adress) {
+    bool synkront = false;
+
+    LAS_DNS();
+    DnsPost* post = hitta_post(vard);
+    if (post && post->har_adress) {
+        *adress = post->adress;
+        if (!post->uppdateras && monoton_ms() >= post->giltig_till) {
+            post->uppdateras = true;
+#ifndef _WIN32
+            if (starta_uppdaterare()) {
+                post->koad = true;
+                pthread_cond_signal(&uppdatering_signal);
+            } else {
+                synkront = true;
+            }
+#else
+            synkront = true;
+#endif
+        }
+        LAS_UPP_DNS();
+
+        atomic_fetch_add_explicit(&antal_traffar, 1, memory_order_relaxed);
+        if (synkront) {
+            // Ingen bakgrundstråd - uppdatera nu, men behåll adressen om det misslyckas
+            DnsAdress ny;
+            bool lyckades = anropa_resolver(vard, &ny);
+            LAS_DNS();
+            spara_uppslagning(vard, lyckades, &ny, adress);
+            LAS_UPP_DNS();
+        }
+        satt_port(adress, port);
+        return true;
+    }
+    LAS_UPP_DNS();
+
+    // Ingen adress än - slå upp direkt. Två trådar kan hamna här samtidigt
+    // för samma värd; båda slår då upp och den sista vinner, vilket är ofarligt.
+    DnsAdress ny;
+    bool lyckades = anropa_resolver(vard, &ny);
+
+    LAS_DNS();
+    bool har_adress = spara_uppslagning(vard, lyckades, &ny, adress);
+    LAS_UPP_DNS();
+
+    if (har_adress) {
+        satt_port(adress, port);
+    }
+    return har_adress;
+}
+
+/**
+ * Sätter hur länge en uppslagning gäller
+ *
+ * @param sekunder - TTL i sekunder (0 = uppdatera vid varje användning)
+ *
+ * Påverkar poster som slås upp efter anropet.
+ */
+void dns_cache_satt_ttl(int sekunder) {
+    atomic_store_explicit(&ttl_sekunder, sekunder < 0 ? 0 : sekunder, memory_order_relaxed);
+}
+
+/**
+ * Byter resolver
+ *
+ * @param ny_uppslagning - Ny resolver, eller NULL för getaddrinfo()
+ */
+void dns_cache_satt_uppslagning(DnsUppslagning ny_uppslagning) {
+    LAS_DNS();
+    uppslagning = ny_uppslagning ? ny_uppslagning : sla_upp_med_getaddrinfo;
+    LAS_UPP_DNS();
+}
+
+/**
+ * Kopierar cachens räknare
+ *
+ * @param ut - Här sparas räknarna
+ */
+void hamta_dns_statistik(DnsStatistik* ut) {
+    ut->traffar = atomic_load_explicit(&antal_traffar, memory_order_relaxed);
+    ut->uppslagningar = atomic_load_explicit(&antal_uppslagningar, memory_order_relaxed);
+    ut->misslyckade = atomic_load_explicit(&antal_misslyckade, memory_order_relaxed);
+}
+
+/**
+ * Stoppar bakgrundstråden och frigör alla poster
+ *
+ * Anropas vid avstängning när inga arbetartrådar längre gör anrop.
+ * En uppslagning som pågår i bakgrundstråden får bli klar först.
+ */
+void stang_dns_cache(void) {
+#ifndef _WIN32
+    LAS_DNS();
+    bool startad = uppdaterare_startad;
+    uppdaterare_stoppa = true;
+    pthread_cond_broadcast(&uppdatering_signal);
+    LAS_UPP_DNS();
+    if (startad) {
+        pthread_join(uppdaterare, NULL);
+    }
+#endif
+
+    LAS_DNS();
+#ifndef _WIN32
+    uppdaterare_startad = false;
+#endif
+    while (poster) {
+        DnsPost* post = poster;
+        poster = post->nasta;
+        free(post);
+    }
+    LAS_UPP_DNS();
+}
@@ -0,0 +1,694 @@
+#define _POSIX_C_SOURCE 200809L     // För clock_gettime
+#include "http_klient.h"            // Egna funktioner för upstream-HTTP
+#include "loggning.h"                // För att logga anslutningar och fel
+#include "konfiguration.h"           // För UPSTREAM_POOL_STORLEK, UPSTREAM_TOMGANG_SEKUNDER och UPSTREAM_TIDSGRANS_SEKUNDER
+#include "natverks_abstraktion.h"    // För plattformsoberoende nätverksfunktioner
+#include "dns_cache.h"              // För cachad uppslagning av värdnamn
+#include <string.h>                  // För strängfunktioner: strcmp, memcpy, memmove, memset
+#include <stdlib.h>                  // För malloc, free
+#include <stdio.h>                   // För snprintf
+#include <ctype.h>                   // För tolower och isxdigit
+#include <time.h>                    // För time() vid tomgångsgräns och clock_gettime för tidsgränsen
+#include <stdatomic.h>               // För poolens räknare
+
+#ifndef _WIN32
+#include <pthread.h>                 // För mutex runt poolen
+
+// Skyddar listan med pooler och de vilande anslutningarna i dem
+static pthread_mutex_t pool_las = PTHREAD_MUTEX_INITIALIZER;
+#define LAS_POOL() pthread_mutex_lock(&pool_las)
+#define LAS_UPP_POOL() pthread_mutex_unlock(&pool_las)
+#else
+// Windows-servern hanterar en klient i taget - inget att låsa
+#define LAS_POOL() ((void)0)
+#define LAS_UPP_POOL() ((void)0)
+#endif
+
+// En vilande anslutning i poolen
+typedef struct {
+    socket_t sock;                                // Ansluten socket utan pågående request
+    time_t senast_anvand;                         // När svaret på förra requesten var klart
+} VilandeAnslutning;
+
+// Vilande anslutningar till en (värd, port). Poolerna skapas vid första
+// användning och lever så länge processen körs (i praktiken en per API-värd).
+typedef struct UpstreamPool {
+    char vard[128];
+    int port;
+    VilandeAnslutning vilande[UPSTREAM_POOL_STORLEK];
+    int antal;                                    // Antal vilande anslutningar
+    struct UpstreamPool* nasta;
+} UpstreamPool;
+
+static UpstreamPool* pooler = NULL;
+
+// Rimlighetsgräns för längder i svar (Content-Length och chunkstorlek)
+#define MAX_SVAR_LANGD ((size_t)64 * 1024 * 1024)
+
+static _Atomic unsigned long long antal_nya = 0;
+static _Atomic unsigned long long antal_ateranvanda = 0;
+
+// ============================================================================
+// INRAMNING AV SVAR
+// ============================================================================
+
+/**
+ * Jämför ett headernamn utan hänsyn till skiftläge
+ *
+ * @param rad - Början på headerraden
+ * @param rad_langd - Radens längd (utan \r\n)
+ * @param namn - Headerns namn med gemener, utan kolon
+ * @return Pekare till värdet (efter kolon och blanksteg), eller NULL om
+ *         raden inte är headern
+ */
+static const char* header_varde(const char* rad, size_t rad_langd, const char* namn) {
+    size_t namn_langd = strlen(namn);
+    if (rad_langd <= namn_langd || rad[namn_langd] != ':') {
+        return NULL;
+    }
+    for (size_t i = 0; i < namn_langd; i++) {
+        if (tolower((unsigned char)rad[i]) != namn[i]) {
+            return NULL;
+        }
+    }
+    const char* varde = rad + namn_langd + 1;
+    while (varde < rad + rad_langd && (*varde == ' ' || *varde == '\t')) {
+        varde++;
+    }
+    return varde;
+}
+
+/**
+ * Söker efter ett ord (utan hänsyn till skiftläge) i ett headervärde
+ *
+ * @param varde - Headervärdet
+ * @param langd - Antal tecken i värdet
+ * @param ord - Ordet med gemener (t.ex. "chunked", "close")
+ * @return true om ordet förekommer i värdet
+ */
+static bool varde_innehaller(const char* varde, size_t langd, const char* ord) {
+    size_t ord_langd = strlen(ord);
+    for (size_t i = 0; i + ord_langd <= langd; i++) {
+        size_t j = 0;
+        while (j < ord_langd && tolower((unsigned char)varde[i + j]) == ord[j]) {
+            j++;
+        }
+        if (j == ord_langd) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Letar upp nästa radslut (\r\n)
+ *
+ * @param data - Var sökningen börjar
+ * @param slut - Första byte efter bufferten
+ * @return Pekare till '\r', eller NULL om inget radslut finns
+ */
+static const char* hitta_radslut(const char* data, const char* slut) {
+    for (const char* p = data; p + 1 < slut; p++) {
+        if (p[0] == '\r' && p[1] == '\n') {
+            return p;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Läser chunkstorleken i början av en chunk-rad
+ *
+ * @param rad - Radens början
+ * @param radslut - Radens '\r'
+ * @param storlek - Här sparas storleken
+ * @return true om raden börjar med ett giltigt hexadecimalt tal
+ *
+ * Chunk-extensions (";namn=värde") efter talet ignoreras.
+ */
+static bool las_chunkstorlek(const char* rad, const char* radslut, size_t* storlek) {
+    size_t varde = 0;
+    const char* p = rad;
+    while (p < radslut && isxdigit((unsigned char)*p)) {
+        if (varde > MAX_SVAR_LANGD) {
+            return false;  // Orimligt stor chunk
+        }
+        int siffra = isdigit((unsigned char)*p) ? *p - '0'
+                                                : tolower((unsigned char)*p) - 'a' + 10;
+        varde = varde * 16 + (size_t)siffra;
+        p++;
+    }
+    if (p == rad || (p < radslut && *p != ';' && *p != ' ' && *p != '\t')) {
+        return false;
+    }
+    *storlek = varde;
+    return true;
+}
+
+/**
+ * Tolkar ett HTTP-svar som tagits emot helt eller delvis
+ *
+ * @param data - Mottagna bytes
+ * @param langd - Antal mottagna bytes
+ * @param svar - Fylls i med statuskod och inramning
+ * @return HTTP_SVAR_KOMPLETT när hela svaret finns (svar->total_langd satt),
+ *         HTTP_SVAR_OFULLSTANDIGT om mer data behövs, HTTP_SVAR_FELAKTIGT
+ *         om svaret inte går att rama in
+ *
+ * Bodyns längd avgörs i RFC 9112:s ordning: svar utan body (1xx, 204, 304),
+ * Transfer-Encoding: chunked, Content-Length, annars tills servern stänger.
+ * Funktionen har inget eget tillstånd och kan anropas igen efter varje recv().
+ */
+HttpSvarStatus tolka_http_svar(const char* data, size_t langd, HttpKlientSvar* svar) {
+    memset(svar, 0, sizeof(*svar));
+    const char* slut = data + langd;
+
+    // Statusrad: "HTTP/1.x NNN ..."
+    const char* statusrad_slut = hitta_radslut(data, slut);
+    if (!statusrad_slut) {
+        return HTTP_SVAR_OFULLSTANDIGT;
+    }
+    if (statusrad_slut - data < 12 || strncmp(data, "HTTP/1.", 7) != 0 || data[8] != ' ' ||
+        !isdigit((unsigned char)data[9]) || !isdigit((unsigned char)data[10]) ||
+        !isdigit((unsigned char)data[11])) {
+        return HTTP_SVAR_FELAKTIGT;
+    }
+    svar->statuskod = (data[9] - '0') * 100 + (data[10] - '0') * 10 + (data[11] - '0');
+    svar->kan_ateranvandas = data[7] == '1';  // HTTP/1.1 är persistent som standard
+
+    // Headers fram till den tomma raden
+    long long content_length = -1;
+    const char* rad = statusrad_slut + 2;
+    for (;;) {
+        const char* radslut = hitta_radslut(rad, slut);
+        if (!radslut) {
+            return HTTP_SVAR_OFULLSTANDIGT;
+        }
+        if (radslut == rad) {
+            break;  // Tom rad - headers slut
+        }
+        size_t rad_langd = (size_t)(radslut - rad);
+        const char* varde;
+        if ((varde = header_varde(rad, rad_langd, "content-length"))) {
+            long long tal = 0;
+            const char* p = varde;
+            while (p < radslut && isdigit((unsigned char)*p)) {
+                tal = tal * 10 + (*p - '0');
+                if (tal > (long long)MAX_SVAR_LANGD) {
+                    return HTTP_SVAR_FELAKTIGT;
+                }
+                p++;
+            }
+            if (p == varde || (content_length >= 0 && content_length != tal)) {
+                return HTTP_SVAR_FELAKTIGT;
+            }
+            content_length = tal;
+        } else if ((varde = header_varde(rad, rad_langd, "transfer-encoding"))) {
+            svar->chunkad = varde_innehaller(varde, (size_t)(radslut - varde), "chunked");
+        } else if ((varde = header_varde(rad, rad_langd, "connection"))) {
+            size_t varde_langd = (size_t)(radslut - varde);
+            if (varde_innehaller(varde, varde_langd, "close")) {
+                svar->kan_ateranvandas = false;
+            } else if (varde_innehaller(varde, varde_langd, "keep-alive")) {
+                svar->kan_ateranvandas = true;  // HTTP/1.0 med keep-alive
+            }
+        }
+        rad = radslut + 2;
+    }
+    svar->huvud_langd = (size_t)(rad + 2 - data);
+
+    // Svar som aldrig har body
+    if ((svar->statuskod >= 100 && svar->statuskod < 200) ||
+        svar->statuskod == 204 || svar->statuskod == 304) {
+        svar->total_langd = svar->huvud_langd;
+        return HTTP_SVAR_KOMPLETT;
+    }
+
+    if (svar->chunkad) {
+        // Gå igenom chunkarna: storlek\r\n data\r\n ... 0\r\n [trailers] \r\n
+        const char* pos = data + svar->huvud_langd;
+        for (;;) {
+            const char* radslut = hitta_radslut(pos, slut);
+            if (!radslut) {
+                return HTTP_SVAR_OFULLSTANDIGT;
+            }
+            size_t storlek;
+            if (!las_chunkstorlek(pos, radslut, &storlek)) {
+                return HTTP_SVAR_FELAKTIGT;
+            }
+            pos = radslut + 2;
+
+            if (storlek == 0) {
+                // Sista chunken - hoppa över eventuella trailers till den tomma raden
+                for (;;) {
+                    radslut = hitta_radslut(pos, slut);
+                    if (!radslut) {
+                        return HTTP_SVAR_OFULLSTANDIGT;
+                    }
+                    bool tom = radslut == pos;
+                    pos = radslut + 2;
+                    if (tom) {
+                        svar->total_langd = (size_t)(pos - data);
+                        return HTTP_SVAR_KOMPLETT;
+                    }
+                }
+            }
+
+            if ((size_t)(slut - pos) < storlek + 2) {
+                return HTTP_SVAR_OFULLSTANDIGT;
+            }
+            if (pos[storlek] != '\r' || pos[storlek + 1] != '\n') {
+                return HTTP_SVAR_FELAKTIGT;
+            }
+            pos += storlek + 2;
+        }
+    }
+
+    if (content_length >= 0) {
+        svar->total_langd = svar->huvud_langd + (size_t)content_length;
+        return langd >= svar->total_langd ? HTTP_SVAR_KOMPLETT : HTTP_SVAR_OFULLSTANDIGT;
+    }
+
+    // Varken chunked eller Content-Length: bodyn slutar när servern stänger
+    svar->tills_stangning = true;
+    svar->kan_ateranvandas = false;
+    return HTTP_SVAR_OFULLSTANDIGT;
+}
+
+/**
+ * Avkodar en chunked body på plats
+ *
+ * @param kropp - Bodyn (det som följer efter headers), redan validerad av
+ *                tolka_http_svar()
+ * @param langd - Bodyns längd i kodad form
+ * @return Längden på den avkodade bodyn
+ *
+ * Avkodad data är alltid kortare än kodad, så skrivpositionen hamnar
+ * aldrig före läspositionen och memmove() räcker.
+ */
+size_t avkoda_chunkad_kropp(char* kropp, size_t langd) {
+    const char* slut = kropp + langd;
+    const char* las = kropp;
+    char* skriv = kropp;
+
+    for (;;) {
+        const char* radslut = hitta_radslut(las, slut);
+        size_t storlek;
+        if (!radslut || !las_chunkstorlek(las, radslut, &storlek) || storlek == 0) {
+            break;
+        }
+        las = radslut + 2;
+        if ((size_t)(slut - las) < storlek) {
+            break;
+        }
+        memmove(skriv, las, storlek);
+        skriv += storlek;
+        las += storlek + 2;  // Data + \r\n
+    }
+    return (size_t)(skriv - kropp);
+}
+
+// ============================================================================
+// ANSLUTNINGSPOOL
+// ============================================================================
+
+/**
+ * Hämtar (eller skapar) poolen för en (värd, port)
+ *
+ * @param host - Värdnamn
+ * @param port - Port
+ * @return Poolen, eller NULL om minnet tog slut
+ *
+ * Anroparen måste hålla pool_las.
+ */
+static UpstreamPool* hitta_pool(const char* host, int port) {
+    for (UpstreamPool* pool = pooler; pool; pool = pool->nasta) {
+        if (pool->port == port && strcmp(pool->vard, host) == 0) {
+            return pool;
+        }
+    }
+    UpstreamPool* pool = calloc(1, sizeof(UpstreamPool));
+    if (pool) {
+        snprintf(pool->vard, sizeof(pool->vard), "%s", host);
+        pool->port = port;
+        pool->nasta = pooler;
+        pooler = pool;
+    }
+    return pool;
+}
+
+/**
+ * Stänger anslutningar som legat oanvända längre än UPSTREAM_TOMGANG_SEKUNDER
+ *
+ * @param pool - Poolen
+ * @param nu - Aktuell tid
+ *
+ * Anroparen måste hålla pool_las. Servrar stänger själva vilande
+ * anslutningar efter en tid; att kasta dem i förväg gör att vi sällan
+ * skickar en request på en anslutning som redan är stängd.
+ */
+static void rensa_gamla(UpstreamPool* pool, time_t nu) {
+    int kvar = 0;
+    for (int i = 0; i < pool->antal; i++) {
+        if (nu - pool->vilande[i].senast_anvand > UPSTREAM_TOMGANG_SEKUNDER) {
+            stang_socket(pool->vilande[i].sock);
+        } else {
+            pool->vilande[kvar++] = pool->vilande[i];
+        }
+    }
+    pool->antal = kvar;
+}
+
+#ifndef _WIN32
+/**
+ * Kontrollerar att en vilande anslutning fortfarande är öppen
+ *
+ * @param sock - Socket från poolen
+ * @return true om anslutningen kan användas
+ *
+ * En vilande anslutning ska inte ha något att läsa. EOF betyder att
+ * servern har stängt den; oväntad data betyder att den är ur synk.
+ */
+static bool anslutning_lever(socket_t sock) {
+    char tecken;
+    ssize_t n = recv(sock, &tecken, 1, MSG_PEEK | MSG_DONTWAIT);
+    return n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+}
+#endif
+
+/**
+ * Hämtar monoton tid i millisekunder
+ *
+ * @return Millisekunder sedan en godtycklig fast tidpunkt
+ */
+static long long klocka_ms(void) {
+#ifdef _WIN32
+    return (long long)GetTickCount64();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+#endif
+}
+
+/**
+ * Begränsar hur länge nästa connect(), send() eller recv() får blockera
+ *
+ * @param sock - Socket
+ * @param deadline - Monoton tid (ms) då hela anropet ska vara klart
+ * @return false om tiden redan har gått ut
+ *
+ * Socketens tidsgräns sätts till den tid som återstår, så en långsam
+ * server kan inte förlänga anropet genom att skicka lite i taget.
+ */
+static bool satt_tidsgrans(socket_t sock, long long deadline) {
+    long long kvar = deadline - klocka_ms();
+    if (kvar <= 0) {
+        return false;
+    }
+    satt_socket_tidsgrans(sock, (long)kvar);
+    return true;
+}
+
+/**
+ * Öppnar en ny TCP-anslutning
+ *
+ * @param host - Värdnamn
+ * @param port - Port
+ * @param deadline - Monoton tid (ms) då hela upstream-anropet ska vara klart
+ * @return Ansluten socket, eller OGILTIG_SOCKET vid fel
+ */
+static socket_t anslut_till_vard(const char* host, int port, long long deadline) {
+    // Slå upp värdnamnet - normalt ett svar direkt från DNS-cachen
+    DnsAdress adress;
+    if (!dns_sla_upp(host, port, &adress)) {
+        LOGG_FEL("Kunde inte hitta värd: %s", host);
+        return OGILTIG_SOCKET;
+    }
+
+    // Skapa en socket för nätverkskommunikation i adressens familj
+    // (AF_INET eller AF_INET6), SOCK_STREAM = TCP-anslutning
+    socket_t sock = socket(adress.adress.ss_family, SOCK_STREAM, 0);
+    if (sock == OGILTIG_SOCKET) {
+        LOGG_FEL("Kunde inte skapa socket för HTTP-förfrågan");
+        return OGILTIG_SOCKET;
+    }
+
+    // Försök ansluta till servern
+    // connect() etablerar en TCP-anslutning till den angivna adressen
+    if (!satt_tidsgrans(sock, deadline) ||
+        connect(sock, (struct sockaddr*)&adress.adress, adress.langd) < 0) {
+        LOGG_FEL("Kunde inte ansluta till %s:%d", host, port);
+        stang_socket(sock);
+        return OGILTIG_SOCKET;
+    }
+
+    atomic_fetch_add_explicit(&antal_nya, 1, memory_order_relaxed);
+    LOGG_DEBUG("Ny upstream-anslutning till %s:%d", host, port);
+    return sock;
+}
+
+/**
+ * Tar en anslutning ur poolen eller öppnar en ny
+ *
+ * @param host - Värdnamn
+ * @param port - Port
+ * @param ateranvand - Sätts till true om anslutningen kom från poolen
+ * @param deadline - Monoton tid (ms) då hela upstream-anropet ska vara klart
+ * @return Ansluten socket, eller OGILTIG_SOCKET vid fel
+ *
+ * Den senast använda anslutningen tas först (LIFO) - den är minst trolig
+ * att ha stängts av servern.
+ */
+static socket_t hamta_anslutning(const char* host, int port, bool* ateranvand,
+                                 long long deadline) {
+    for (;;) {
+        socket_t sock = OGILTIG_SOCKET;
+
+        LAS_POOL();
+        UpstreamPool* pool = hitta_pool(host, port);
+        if (pool) {
+            rensa_gamla(pool, time(NULL));
+            if (pool->antal > 0) {
+                sock = pool->vilande[--pool->antal].sock;
+            }
+        }
+        LAS_UPP_POOL();
+
+        if (sock == OGILTIG_SOCKET) {
+            *ateranvand = false;
+            return anslut_till_vard(host, port, deadline);
+        }
+#ifndef _WIN32
+        if (!anslutning_lever(sock)) {
+            LOGG_DEBUG("Vilande upstream-anslutning var stängd, tar nästa");
+            stang_socket(sock);
+            continue;
+        }
+#endif
+        *ateranvand = true;
+        return sock;
+    }
+}
+
+/**
+ * Lämnar tillbaka en anslutning till poolen
+ *
+ * @param host - Värdnamn
+ * @param port - Port
+ * @param sock - Anslutning utan oläst data
+ *
+ * Är poolen full stängs anslutningen i stället.
+ */
+static void lamna_tillbaka(const char* host, int port, socket_t sock) {
+    time_t nu = time(NULL);
+
+    LAS_POOL();
+    UpstreamPool* pool = hitta_pool(host, port);
+    if (pool) {
+        rensa_gamla(pool, nu);
+        if (pool->antal < UPSTREAM_POOL_STORLEK) {
+            pool->vilande[pool->antal].sock = sock;
+            pool->vilande[pool->antal].senast_anvand = nu;
+            pool->antal++;
+            sock = OGILTIG_SOCKET;
+        }
+    }
+    LAS_UPP_POOL();
+
+    if (sock != OGILTIG_SOCKET) {
+        stang_socket(sock);
+    }
+}
+
+/**
+ * Skickar en hel buffer
+ *
+ * @param sock - Ansluten socket
+ * @param data - Data att skicka
+ * @param langd - Antal bytes
+ * @return true om allt skickades
+ */
+static bool skicka_allt(socket_t sock, const char* data, size_t langd) {
+    while (langd > 0) {
+#ifdef MSG_NOSIGNAL
+        // MSG_NOSIGNAL: en anslutning som servern stängt ska ge fel, inte SIGPIPE
+        int n = (int)send(sock, data, langd, MSG_NOSIGNAL);
+#else
+        int n = send(sock, data, (int)langd, 0);
+#endif
+        if (n <= 0) {
+            return false;
+        }
+        data += n;
+        langd -= (size_t)n;
+    }
+    return true;
+}
+
+/**
+ * Skickar en HTTP GET-förfrågan och tar emot svarets body
+ *
+ * @param host - Värdnamnet att ansluta till (t.ex. "api.openweathermap.org")
+ * @param port - Portnummer att ansluta till (vanligtvis 80 för HTTP)
+ * @param path - URL-sökväg inklusive query-parametrar
+ * @param svar_buffer - Buffert där bodyn ska lagras (nollterminerad)
+ * @param buffer_storlek - Storlek på svar-bufferten i bytes
+ * @return true om ett komplett svar togs emot, false vid fel
+ *
+ * Svaret läses tills det är komplett enligt Content-Length eller chunked
+ * encoding, inte tills servern stänger - då kan anslutningen gå tillbaka
+ * till poolen. Om en anslutning från poolen visar sig vara stängd (inget
+ * svar alls) görs ett nytt försök på en ny anslutning. Hela anropet,
+ * inklusive ett nytt försök, får ta högst UPSTREAM_TIDSGRANS_SEKUNDER.
+ */
+bool http_klient_get(const char* host, int port, const char* path,
+                     char* svar_buffer, size_t buffer_storlek) {
+    // Bygg HTTP GET-förfrågan enligt HTTP/1.1-protokollet. Utan
+    // "Connection: close" är anslutningen persistent som standard.
+    char forfragan[1024];
+    int forfragan_langd = snprintf(forfragan, sizeof(forfragan),
+                                   "GET %s HTTP/1.1\r\n"          // Förfrågansrad
+                                   "Host: %s\r\n"                  // Obligatorisk i HTTP/1.1
+                                   "\r\n",                         // Slut på headers
+                                   path, host);
+    if (forfragan_langd < 0 || (size_t)forfragan_langd >= sizeof(forfragan)) {
+        LOGG_FEL("Upstream-sökvägen är för lång");
+        return false;
+    }
+
+    long long deadline = klocka_ms() + (long long)UPSTREAM_TIDSGRANS_SEKUNDER * 1000;
+
+    for (int forsok = 0; forsok < 2; forsok++) {
+        bool ateranvand;
+        socket_t sock = hamta_anslutning(host, port, &ateranvand, deadline);
+        if (sock == OGILTIG_SOCKET) {
+            return false;
+        }
+        if (ateranvand) {
+            atomic_fetch_add_explicit(&antal_ateranvanda, 1, memory_order_relaxed);
+        }
+
+        if (!satt_tidsgrans(sock, deadline) ||
+            !skicka_allt(sock, forfragan, (size_t)forfragan_langd)) {
+            stang_socket(sock);
+            if (ateranvand && klocka_ms() < deadline) {
+                continue;  // Servern hade stängt anslutningen - försök med en ny
+            }
+            LOGG_FEL("Kunde inte skicka HTTP-förfrågan");
+            return false;
+        }
+
+        // Ta emot tills svaret är komplett enligt sin inramning
+        HttpKlientSvar svar;
+        memset(&svar, 0, sizeof(svar));
+        HttpSvarStatus status = HTTP_SVAR_OFULLSTANDIGT;
+        size_t mottaget = 0;
+        while (status == HTTP_SVAR_OFULLSTANDIGT) {
+            if (mottaget >= buffer_storlek - 1) {
+                LOGG_VARNING("Svaret från %s får inte plats i %zu bytes", host, buffer_storlek);
+                break;
+            }
+            if (!satt_tidsgrans(sock, deadline)) {
+                break;
+            }
+            int n = (int)recv(sock, svar_buffer + mottaget,
+                              (int)(buffer_storlek - mottaget - 1), 0);
+            if (n <= 0) {
+                if (n == 0 && svar.tills_stangning && mottaget > 0) {
+                    svar.total_langd = mottaget;  // Bodyn slutade när servern stängde
+                    status = HTTP_SVAR_KOMPLETT;
+                }
+                break;
+            }
+            mottaget += (size_t)n;
+            status = tolka_http_svar(svar_buffer, mottaget, &svar);
+        }
+
+        if (status != HTTP_SVAR_KOMPLETT) {
+            stang_socket(sock);
+            if (klocka_ms() >= deadline) {
+                LOGG_FEL("Inget komplett svar från %s:%d inom %d s", host, port,
+                         UPSTREAM_TIDSGRANS_SEKUNDER);
+                return false;
+            }
+            if (ateranvand && mottaget == 0) {
+                LOGG_DEBUG("Återanvänd upstream-anslutning stängdes, försöker igen");
+                continue;
+            }
+            LOGG_FEL("Ofullständigt eller felaktigt svar från %s:%d", host, port);
+            return false;
+        }
+
+        // Bara en anslutning utan oläst data kan användas för nästa request
+        if (svar.kan_ateranvandas && mottaget == svar.total_langd) {
+            lamna_tillbaka(host, port, sock);
+        } else {
+            stang_socket(sock);
+        }
+
+        if (svar.statuskod != 200) {
+            LOGG_DEBUG("Upstream svarade %d", svar.statuskod);
+        }
+
+        // Flytta bodyn till början av bufferten så att den kan parsas direkt
+        size_t kropp_langd = svar.total_langd - svar.huvud_langd;
+        memmove(svar_buffer, svar_buffer + svar.huvud_langd, kropp_langd);
+        if (svar.chunkad) {
+            kropp_langd = avkoda_chunkad_kropp(svar_buffer, kropp_langd);
+        }
+        svar_buffer[kropp_langd] = '\0';
+        return true;
+    }
+
+    LOGG_FEL("Kunde inte hämta %s från %s:%d", path, host, port);
+    return false;
+}
+
+/**
+ * Kopierar anslutningspoolens räknare
+ *
+ * @param ut - Här sparas räknarna
+ */
+void hamta_http_klient_statistik(HttpKlientStatistik* ut) {
+    ut->nya_anslutningar = atomic_load_explicit(&antal_nya, memory_order_relaxed);
+    ut->ateranvanda = atomic_load_explicit(&antal_ateranvanda, memory_order_relaxed);
+}
+
+/**
+ * Stänger alla vilande anslutningar och frigör poolerna
+ *
+ * Anropas vid avstängning när inga arbetartrådar längre gör anrop.
+ */
+void stang_http_klient_pool(void) {
+    LAS_POOL();
+    while (pooler) {
+        UpstreamPool* pool = pooler;
+        pooler = pool->nasta;
+        for (int i = 0; i < pool->antal; i++) {
+            stang_socket(pool->vilande[i].sock);
+        }
+        free(pool);
+    }
+    LAS_UPP_POOL();
+}
@@ -0,0 +1,266 @@
+#include "http_query.h"      // Egna deklarationer
+#include <string.h>          // För memcpy, memset, strcmp och strlen
+
+// ============================================================================
+// AVKODNING OCH KODNING
+// ============================================================================
+
+/**
+ * Värdet av en hexadecimal siffra
+ *
+ * @param tecken - '0'-'9', 'a'-'f' eller 'A'-'F'
+ * @return 0-15, eller -1 om tecknet inte är en hexsiffra
+ */
+static int hexvarde(char tecken) {
+    if (tecken >= '0' && tecken <= '9') return tecken - '0';
+    if (tecken >= 'a' && tecken <= 'f') return tecken - 'a' + 10;
+    if (tecken >= 'A' && tecken <= 'F') return tecken - 'A' + 10;
+    return -1;
+}
+
+/**
+ * Läser ett (avkodat) tecken ur kodad text
+ *
+ * @param text - Kodad text
+ * @param i - Position; flyttas fram förbi en %XX-sekvens
+ * @return Tecknet: '+' blir blanksteg, %XX blir byten XX och en ogiltig
+ *         %-sekvens lämnas som den är
+ */
+static inline char las_tecken(HttpVy text, size_t* i) {
+    char tecken = text.data[*i];
+    if (tecken == '+') {
+        return ' ';  // Formulärkodning: '+' betyder blanksteg
+    }
+    int hog, lag;
+    if (tecken == '%' && *i + 2 < text.langd &&
+        (hog = hexvarde(text.data[*i + 1])) >= 0 && (lag = hexvarde(text.data[*i + 2])) >= 0) {
+        *i += 2;
+        return (char)(hog * 16 + lag);
+    }
+    return tecken;
+}
+
+/**
+ * Avkodar text till ut utan nollterminering
+ *
+ * @param text - Kodad text (namn eller värde ur query-strängen)
+ * @param ut - Mål
+ * @param ut_max - Högst så många bytes skrivs (resten av texten hoppas över)
+ * @return Avkodad längd
+ */
+static size_t avkoda(HttpVy text, char* ut, size_t ut_max) {
+    size_t n = 0;
+    for (size_t i = 0; i < text.langd && n < ut_max; i++) {
+        ut[n++] = las_tecken(text, &i);
+    }
+    return n;
+}
+
+/**
+ * Avkodar %XX och '+' till en nollterminerad sträng
+ *
+ * @param text - Kodad text
+ * @param ut - Mål (avkortas om den är för liten)
+ * @param ut_storlek - Storlek på ut
+ * @return Avkodad längd
+ */
+size_t query_avkoda(HttpVy text, char* ut, size_t ut_storlek) {
+    if (!ut || ut_storlek == 0) {
+        return 0;
+    }
+    size_t n = text.data ? avkoda(text, ut, ut_storlek - 1) : 0;
+    ut[n] = '\0';
+    return n;
+}
+
+/**
+ * Procentkodar text för en URL, t.ex. "Göteborg" -> "G%C3%B6teborg"
+ *
+ * @param text - Nollterminerad text
+ * @param ut - Mål
+ * @param ut_storlek - Storlek på ut
+ * @return false om ut är för liten
+ */
+bool query_koda(const char* text, char* ut, size_t ut_storlek) {
+    static const char HEX[] = "0123456789ABCDEF";
+    if (!text || !ut || ut_storlek == 0) {
+        return false;
+    }
+    size_t n = 0;
+    for (const unsigned char* p = (const unsigned char*)text; *p; p++) {
+        bool oreserverat = (*p >= 'A' && *p <= 'Z') || (*p >= 'a' && *p <= 'z') ||
+                           (*p >= '0' && *p <= '9') ||
+                           *p == '-' || *p == '.' || *p == '_' || *p == '~';
+        size_t behov = oreserverat ? 1 : 3;
+        if (n + behov >= ut_storlek) {
+            return false;
+        }
+        if (oreserverat) {
+            ut[n++] = (char)*p;
+        } else {
+            ut[n++] = '%';
+            ut[n++] = HEX[*p >> 4];
+            ut[n++] = HEX[*p & 0x0F];
+        }
+    }
+    ut[n] = '\0';
+    return true;
+}
+
+// ============================================================================
+// TABELL
+// ============================================================================
+
+// FNV-1a, räknas tecken för tecken medan namnet avkodas
+#define HASH_START 2166136261u
+#define HASHA_TECKEN(h, tecken) (((h) ^ (unsigned char)(tecken)) * 16777619u)
+
+/**
+ * FNV-1a över ett nollterminerat namn
+ */
+static uint32_t hasha(const char* namn) {
+    uint32_t h = HASH_START;
+    for (const char* p = namn; *p; p++) {
+        h = HASHA_TECKEN(h, *p);
+    }
+    return h;
+}
+
+/**
+ * Hittar namnets plats i tabellen: platsen där det ligger, eller den
+ * tomma plats där det skulle läggas
+ *
+ * @param query - Tabellen
+ * @param namn - Avkodat namn
+ * @param hash - hasha(namn)
+ * @return Index i query->tabell
+ */
+static size_t hitta_plats(const HttpQuery* query, const char* namn, uint32_t hash) {
+    size_t plats = hash & (QUERY_TABELL_STORLEK - 1);
+    // Tabellen är minst dubbelt så stor som antalet parametrar, så en tom
+    // plats finns alltid och sonderingen tar slut
+    while (query->tabell[plats] != 0 &&
+           strcmp(query->parametrar[query->tabell[plats] - 1].namn, namn) != 0) {
+        plats = (plats + 1) & (QUERY_TABELL_STORLEK - 1);
+    }
+    return plats;
+}
+
+/**
+ * Delar query-strängen i parametrar och avkodar dem
+ *
+ * @param query - Query-delen av URL:en utan '?' (behöver inte vara nollterminerad)
+ * @param resultat - Fylls i med parametrarna
+ * @return false om query-strängen är för lång, har för många parametrar
+ *         eller innehåller %00 (som skulle korta av strängarna)
+ *
+ * Tomma delar ("a=1&&b=2") hoppas över. Namn och värden avkodas in i
+ * resultat->data, så resultatet pekar inte in i mottagningsbufferten.
+ */
+bool tolka_query(HttpVy query, HttpQuery* resultat) {
+    _Static_assert(QUERY_TABELL_STORLEK >= 2 * MAX_QUERY_PARAMETRAR &&
+                   (QUERY_TABELL_STORLEK & (QUERY_TABELL_STORLEK - 1)) == 0,
+                   "QUERY_TABELL_STORLEK måste vara en tvåpotens minst dubbelt så stor som MAX_QUERY_PARAMETRAR");
+    _Static_assert(MAX_QUERY_PARAMETRAR < 256, "Tabellen sparar index i en byte");
+
+    resultat->antal = 0;
+    memset(resultat->tabell, 0, sizeof(resultat->tabell));
+    if (!query.data) {
+        return true;
+    }
+
+    // Avkodad text blir aldrig längre än kodad. Varje parameter behöver två
+    // nollterminerade strängar, där '=' och '&' ger plats åt högst en av
+    // nollorna - så det räcker med en extra byte per parameter
+    if (query.langd + MAX_QUERY_PARAMETRAR + 1 > sizeof(resultat->data)) {
+        return false;
+    }
+
+    // Ett pass över strängen: '&' avslutar en parameter, första '=' delar
+    // namn från värde och övriga tecken avkodas direkt in i data
+    char* ut = resultat->data;
+    char* namn = ut;               // Parametern som läses just nu
+    char* varde = NULL;            // NULL tills '=' har setts
+    uint32_t hash = HASH_START;    // Hash för det avkodade namnet
+
+    for (size_t i = 0; i <= query.langd; i++) {
+        if (i == query.langd || query.data[i] == '&') {
+            if (ut == namn && !varde) {
+                continue;  // Tom del ("a=1&&b=2")
+            }
+            if (resultat->antal == MAX_QUERY_PARAMETRAR) {
+                return false;
+            }
+            *ut++ = '\0';
+            if (!varde) {
+                varde = ut - 1;  // Utan '=' blir värdet ""
+            }
+            QueryParameter* parameter = &resultat->parametrar[resultat->antal];
+            parameter->namn = namn;
+            parameter->varde = varde;
+            parameter->varde_langd = (size_t)(ut - 1 - varde);
+
+            // Första förekomsten av ett namn gäller
+            size_t plats = hitta_plats(resultat, namn, hash);
+            if (resultat->tabell[plats] == 0) {
+                resultat->tabell[plats] = (uint8_t)(resultat->antal + 1);
+            }
+            resultat->antal++;
+
+            namn = ut;
+            varde = NULL;
+            hash = HASH_START;
+        } else if (query.data[i] == '=' && !varde) {
+            *ut++ = '\0';
+            varde = ut;
+        } else {
+            char tecken = las_tecken(query, &i);
+            if (tecken == '\0') {
+                return false;  // %00 skulle korta av strängarna
+            }
+            if (!varde) {
+                hash = HASHA_TECKEN(hash, tecken);
+            }
+            *ut++ = tecken;
+        }
+    }
+    return true;
+}
+
+/**
+ * Slår upp en parameter i tabellen
+ *
+ * @param query - Tolkad query-sträng
+ * @param namn - Avkodat namn (t.ex. "city")
+ * @return Avkodat värde, eller NULL om parametern saknas
+ */
+const char* query_varde(const HttpQuery* query, const char* namn) {
+    if (!query || !namn) {
+        return NULL;
+    }
+    uint8_t index = query->tabell[hitta_plats(query, namn, hasha(namn))];
+    return index ? query->parametrar[index - 1].varde : NULL;
+}
+
+/**
+ * Kopierar värdet av en parameter
+ *
+ * @param query - Tolkad query-sträng
+ * @param namn - Avkodat namn
+ * @param varde - Mål (nollterminerat, avkortat om det är för litet)
+ * @param varde_storlek - Storlek på varde
+ * @return true om parametern fanns
+ */
+bool query_kopiera(const HttpQuery* query, const char* namn, char* varde, size_t varde_storlek) {
+    const char* kalla = query_varde(query, namn);
+    if (!kalla || !varde || varde_storlek == 0) {
+        return false;
+    }
+    size_t langd = strlen(kalla);
+    if (langd >= varde_storlek) {
+        langd = varde_storlek - 1;
+    }
+    memcpy(varde, kalla, langd);
+    varde[langd] = '\0';
+    return true;
+}
@@ -1,142 +1,1195 @@
 #include "http_server.h"   // Egna funktioner för HTTP-hantering
+#include "http_skanning.h"  // SIMD-sökning efter radslut, blanksteg, '?' och ':'
+#include "http_query.h"     // För avkodning av %XX i query-parametrar
 #include "loggning.h"       // För att logga debug-meddelanden och varningar
 #include <string.h>         // För strängfunktioner: strcmp, strchr, strstr, strlen, strncpy, memcpy, memset
+#include <stdlib.h>         // För malloc, realloc, free
 #include <stdio.h>          // För sscanf och snprintf
+#include <stdint.h>         // För int8_t i mallindexet
+#include <ctype.h>          // För tolower vid skiftlägesokänsliga header-jämförelser
+#include <time.h>           // För time() till Date-headern
+#include "konfiguration.h"  // För TIMEOUT_SEKUNDER, BUFFER_STORLEK och MAX_REQUEST_STORLEK
+
+// Gör om en numerisk konstant till en strängliteral vid kompilering
+#define HTTP_STRANG_INRE(x) #x
+#define HTTP_STRANG(x) HTTP_STRANG_INRE(x)
+
+/**
+ * Jämför två strängar utan hänsyn till skiftläge
+ *
+ * @param a - Första strängen
+ * @param b - Andra strängen
+ * @param langd - Antal tecken att jämföra
+ * @return true om de första langd tecknen är lika
+ *
+ * Egen variant eftersom strncasecmp() saknas på Windows.
+ */
+static bool lika_utan_skiftlage(const char* a, const char* b, size_t langd) {
+    for (size_t i = 0; i < langd; i++) {
+        if (tolower((unsigned char)a[i]) != tolower((unsigned char)b[i])) {
+            return false;
+        }
+        if (a[i] == '\0') {
+            return true;  // Båda strängarna slutade samtidigt
+        }
+    }
+    return true;
+}
+
+/**
+ * Jämför en vy med en nollterminerad sträng
+ *
+ * @param vy - Vyn
+ * @param text - Strängen att jämföra med
+ * @return true om de är exakt lika
+ */
+bool http_vy_lika(HttpVy vy, const char* text) {
+    size_t langd = strlen(text);
+    return vy.langd == langd && memcmp(vy.data, text, langd) == 0;
+}
+
+/**
+ * Kontrollerar om en vy börjar med en text, utan hänsyn till skiftläge
+ *
+ * @param vy - Vyn
+ * @param text - Början att leta efter
+ * @return true om vyn börjar med text
+ */
+static bool vy_borjar_med(HttpVy vy, const char* text) {
+    size_t langd = strlen(text);
+    return vy.langd >= langd && lika_utan_skiftlage(vy.data, text, langd);
+}
+
+/**
+ * Jämför en vy med en nollterminerad sträng utan hänsyn till skiftläge
+ *
+ * @param vy - Vyn
+ * @param text - Strängen att jämföra med
+ * @return true om de är lika bortsett från skiftläge
+ */
+static bool vy_lika_utan_skiftlage(HttpVy vy, const char* text) {
+    size_t langd = strlen(text);
+    return vy.langd == langd && lika_utan_skiftlage(vy.data, text, langd);
+}
+
+/**
+ * Läser nästa ord (fram till blanksteg) på request-raden
+ *
+ * @param position - In/ut: var läsningen börjar, flyttas förbi ordet
+ * @param slut - Radens slut (exklusive CRLF)
+ * @return Ordet som vy (tom om raden är slut)
+ */
+static HttpVy nasta_ord(const char** position, const char* slut) {
+    const char* p = *position;
+    while (p < slut && (*p == ' ' || *p == '\t')) {
+        p++;
+    }
+    HttpVy ord = { p, 0 };
+    while (p < slut && *p != ' ' && *p != '\t') {
+        p++;
+    }
+    ord.langd = (size_t)(p - ord.data);
+    *position = p;
+    return ord;
+}
+
+/**
+ * Läser en rad och dess strukturtecken i ett pass
+ *
+ * @param position - Radens början
+ * @param slut - Slutet på datan
+ * @param nasta - Här sparas början på nästa rad (slut om ingen finns)
+ * @param skanning - Strukturtecknens index från radens början
+ * @return Raden utan CRLF
+ */
+static HttpVy las_rad(const char* position, const char* slut, const char** nasta,
+                      HttpRadSkanning* skanning) {
+    size_t langd = (size_t)(slut - position);
+    http_skanna_rad(position, langd, skanning);
+    size_t radslut = skanning->radslut;
+    *nasta = radslut < langd ? position + radslut + 1 : slut;
+    if (radslut > 0 && position[radslut - 1] == '\r') {
+        radslut--;
+    }
+    HttpVy rad = { position, radslut };
+    return rad;
+}
+
+/**
+ * Delar en headerrad i namn och värde
+ *
+ * @param rad - Raden utan CRLF
+ * @param kolon - Index för första ':' från las_rad()
+ * @param namn - Här sparas namnet (före kolon)
+ * @param varde - Här sparas värdet utan inledande och avslutande blanksteg
+ * @return false om raden saknar kolon
+ */
+static bool dela_headerrad(HttpVy rad, size_t kolon, HttpVy* namn, HttpVy* varde) {
+    if (kolon >= rad.langd) {
+        return false;
+    }
+    namn->data = rad.data;
+    namn->langd = kolon;
+
+    const char* borjan = rad.data + kolon + 1;
+    const char* slut = rad.data + rad.langd;
+    while (borjan < slut && (*borjan == ' ' || *borjan == '\t')) {
+        borjan++;
+    }
+    while (slut > borjan && (slut[-1] == ' ' || slut[-1] == '\t')) {
+        slut--;
+    }
+    varde->data = borjan;
+    varde->langd = (size_t)(slut - borjan);
+    return true;
+}
+
+/**
+ * Letar upp en header i ett block av headerrader
+ *
+ * @param headers - Headerraderna (utan request-raden och den tomma raden)
+ * @param namn - Headerns namn utan kolon, skiftlägesokänsligt
+ * @param varde - Här sparas värdet
+ * @return true om headern finns
+ */
+static bool hitta_header(HttpVy headers, const char* namn, HttpVy* varde) {
+    size_t namn_langd = strlen(namn);
+    const char* slut = headers.data + headers.langd;
+    const char* nasta = headers.data;
+    while (nasta < slut) {
+        HttpRadSkanning skanning;
+        HttpVy rad = las_rad(nasta, slut, &nasta, &skanning);
+        HttpVy rad_namn;
+        if (skanning.kolon == namn_langd &&
+            dela_headerrad(rad, skanning.kolon, &rad_namn, varde) &&
+            lika_utan_skiftlage(rad_namn.data, namn, namn_langd)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Parsar en HTTP-förfrågan till vyer in i den mottagna datan
+ *
+ * @param data - Den råa HTTP-texten (t.ex. "GET /weather HTTP/1.1\r\n...")
+ * @param langd - Antal bytes i data (behöver inte vara nollterminerad)
+ * @param request - Fylls i med vyer in i data
+ * @return true om parsningen lyckades, false vid fel
+ *
+ * Datan gås igenom en gång: request-raden delas i metod, sökväg, query och
+ * version, varje headerrad undersöks en gång (Connection avgör keep-alive)
+ * och resten efter den tomma raden är body. Ingenting kopieras, så långa
+ * URL:er kortas inte av - gränsen är mottagningsbufferten.
+ */
+bool parsa_http_request_vy(const char* data, size_t langd, HttpRequestVy* request) {
+    const char* slut = data + langd;
+    const char* nasta;
+
+    // Request-raden: "METOD URL HTTP/VERSION"
+    // Exempel: "GET /weather?city=Stockholm HTTP/1.1"
+    // En skanning ger blankstegen och '?' - i en vanlig request-rad (ett
+    // blanksteg mellan delarna) behöver inget tecken läsas en gång till
+    HttpRadSkanning skanning;
+    HttpVy rad = las_rad(data, slut, &nasta, &skanning);
+    HttpVy url;
+    const char* fragetecken = NULL;
+    size_t mellanslag0 = skanning.mellanslag[0];
+    size_t mellanslag1 = skanning.mellanslag[1];
+    if (mellanslag0 > 0 && mellanslag0 < rad.langd && mellanslag1 > mellanslag0 + 1) {
+        if (mellanslag1 > rad.langd) {
+            mellanslag1 = rad.langd;  // HTTP/0.9: ingen version
+        }
+        request->metod_text.data = data;
+        request->metod_text.langd = mellanslag0;
+        url.data = data + mellanslag0 + 1;
+        url.langd = mellanslag1 - mellanslag0 - 1;
+        request->version.data = data + mellanslag1 + (mellanslag1 < rad.langd);
+        request->version.langd = rad.langd - (size_t)(request->version.data - data);
+        if (skanning.fragetecken > mellanslag0 && skanning.fragetecken < mellanslag1) {
+            fragetecken = data + skanning.fragetecken;
+        }
+    } else {
+        // Ovanlig request-rad (flera blanksteg, tabbar) - dela upp ord för ord
+        const char* position = rad.data;
+        const char* rad_slut = rad.data + rad.langd;
+        request->metod_text = nasta_ord(&position, rad_slut);
+        url = nasta_ord(&position, rad_slut);
+        request->version = nasta_ord(&position, rad_slut);  // Saknas i HTTP/0.9
+        fragetecken = memchr(url.data, '?', url.langd);
+    }
+
+    if (request->metod_text.langd == 0 || url.langd == 0) {
+        // Om vi inte kunde läsa både metod och URL är requesten ogiltig
+        LOGG_VARNING("Kunde inte parsa HTTP request-rad");
+        request->metod = HTTP_UNKNOWN;
+        return false;
+    }
+
+    // Identifiera HTTP-metoden
+    if (http_vy_lika(request->metod_text, "GET")) {
+        request->metod = HTTP_GET;                // GET-förfrågan (hämta data)
+    } else if (http_vy_lika(request->metod_text, "POST")) {
+        request->metod = HTTP_POST;               // POST-förfrågan (skicka data)
+    } else {
+        request->metod = HTTP_UNKNOWN;            // Okänd metod (PUT, DELETE, etc.)
+        return false;
+    }
+
+    // Dela upp URL:en i sökväg och query-parametrar vid första '?'
+    if (fragetecken) {
+        request->sokvag.data = url.data;
+        request->sokvag.langd = (size_t)(fragetecken - url.data);
+        request->query.data = fragetecken + 1;
+        request->query.langd = url.langd - request->sokvag.langd - 1;
+    } else {
+        request->sokvag = url;
+        request->query.data = url.data + url.langd;
+        request->query.langd = 0;
+    }
+
+    // HTTP/1.1 är persistent om inte klienten skickar "Connection: close",
+    // HTTP/1.0 bara om klienten uttryckligen ber om "Connection: keep-alive"
+    request->hall_vid_liv = http_vy_lika(request->version, "HTTP/1.1");
+
+    // Headers fram till den tomma raden; allt efter den är body
+    request->headers.data = nasta;
+    request->headers.langd = (size_t)(slut - nasta);  // Om den tomma raden saknas
+    request->body.data = slut;
+    request->body.langd = 0;
+    while (nasta < slut) {
+        const char* rad_borjan = nasta;
+        rad = las_rad(rad_borjan, slut, &nasta, &skanning);
+        if (rad.langd == 0) {
+            request->headers.langd = (size_t)(rad_borjan - request->headers.data);
+            request->body.data = nasta;
+            request->body.langd = (size_t)(slut - nasta);
+            break;
+        }
+
+        HttpVy namn, varde;
+        if (skanning.kolon == 10 && dela_headerrad(rad, skanning.kolon, &namn, &varde) &&
+            lika_utan_skiftlage(namn.data, "Connection", 10)) {
+            if (vy_borjar_med(varde, "close")) {
+                request->hall_vid_liv = false;
+            } else if (vy_borjar_med(varde, "keep-alive")) {
+                request->hall_vid_liv = true;
+            }
+        }
+    }
+    // Logga den parsade requesten för debugging
+    LOGG_DEBUG("Parsad HTTP %.*s %.*s (query: %.*s)",
+               (int)request->metod_text.langd, request->metod_text.data,
+               (int)request->sokvag.langd, request->sokvag.data,
+               (int)request->query.langd, request->query.data);
+
+    return true;  // Parsningen lyckades
+}
 
 /**
- * Parsar en HTTP-förfrågan från rå textdata
+ * Hämtar värdet för en header ur en parsad request
+ *
+ * @param request - Request från parsa_http_request_vy()
+ * @param namn - Headerns namn utan kolon (t.ex. "Accept-Encoding")
+ * @param varde - Här sparas värdet som vy (utan omgivande blanksteg)
+ * @return true om headern finns
+ */
+bool hamta_http_header(const HttpRequestVy* request, const char* namn, HttpVy* varde) {
+    return hitta_header(request->headers, namn, varde);
+}
+
+/**
+ * Avgör om requestens If-None-Match matchar en ETag
+ *
+ * @param request - Request från parsa_http_request_vy()
+ * @param etag - Svarets ETag inklusive citattecken (t.ex. "\"a1b2\"")
+ * @return true om klienten redan har den versionen (svara 304)
+ *
+ * Headern är "*" eller en kommaseparerad lista av ETags. If-None-Match
+ * jämförs svagt (RFC 9110 13.1.2), så W/"a1b2" matchar "a1b2".
+ */
+bool http_etag_matchar(const HttpRequestVy* request, const char* etag) {
+    HttpVy varde;
+    if (!hamta_http_header(request, "If-None-Match", &varde)) {
+        return false;
+    }
+    size_t etag_langd = strlen(etag);
+    size_t i = 0;
+    while (i < varde.langd) {
+        // Hoppa över blanksteg och komman mellan posterna
+        while (i < varde.langd && (varde.data[i] == ' ' || varde.data[i] == '\t' ||
+                                   varde.data[i] == ',')) {
+            i++;
+        }
+        size_t start = i;
+        while (i < varde.langd && varde.data[i] != ',') {
+            i++;
+        }
+        size_t slut = i;
+        while (slut > start && (varde.data[slut - 1] == ' ' || varde.data[slut - 1] == '\t')) {
+            slut--;
+        }
+        if (slut - start == 1 && varde.data[start] == '*') {
+            return true;
+        }
+        if (slut - start >= 2 && varde.data[start] == 'W' && varde.data[start + 1] == '/') {
+            start += 2;
+        }
+        if (slut - start == etag_langd && memcmp(varde.data + start, etag, etag_langd) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Läser q-värdet i en Accept-Encoding-post
+ *
+ * @param parametrar - Det som står efter ';' (t.ex. " q=0.5"), eller tom
+ * @return Vikten i tusendelar (1000 om q saknas, 0 = inte acceptabel)
+ */
+static int las_q_varde(HttpVy parametrar) {
+    for (size_t i = 0; i + 1 < parametrar.langd; i++) {
+        if ((parametrar.data[i] == 'q' || parametrar.data[i] == 'Q') && parametrar.data[i + 1] == '=') {
+            const char* p = parametrar.data + i + 2;
+            const char* slut = parametrar.data + parametrar.langd;
+            if (p < slut && *p == '1') {
+                return 1000;
+            }
+            int varde = 0, skala = 100;
+            if (p < slut && *p == '0') {
+                p++;
+                if (p < slut && *p == '.') {
+                    for (p++; p < slut && *p >= '0' && *p <= '9' && skala > 0; p++, skala /= 10) {
+                        varde += (*p - '0') * skala;
+                    }
+                }
+            }
+            return varde;
+        }
+    }
+    return 1000;
+}
+
+/**
+ * Väljer komprimering utifrån requestens Accept-Encoding
+ *
+ * @param request - Request från parsa_http_request_vy()
+ * @return KOMPRIMERING_GZIP, KOMPRIMERING_DEFLATE eller KOMPRIMERING_INGEN
+ *
+ * Högst q-värde vinner och gzip går före deflate vid lika vikt. "*" gäller
+ * de kodningar som inte nämns, och q=0 betyder att kodningen inte får
+ * användas (RFC 9110 12.5.3).
+ */
+Komprimering http_valj_komprimering(const HttpRequestVy* request) {
+    HttpVy varde;
+    if (!hamta_http_header(request, "Accept-Encoding", &varde)) {
+        return KOMPRIMERING_INGEN;
+    }
+    int gzip = -1, deflate = -1, ovriga = -1;   // -1 = inte nämnd
+    size_t i = 0;
+    while (i < varde.langd) {
+        while (i < varde.langd && (varde.data[i] == ' ' || varde.data[i] == '\t' ||
+                                   varde.data[i] == ',')) {
+            i++;
+        }
+        size_t start = i;
+        while (i < varde.langd && varde.data[i] != ',' && varde.data[i] != ';' &&
+               varde.data[i] != ' ' && varde.data[i] != '\t') {
+            i++;
+        }
+        HttpVy namn = { varde.data + start, i - start };
+        size_t parametrar_start = i;
+        while (i < varde.langd && varde.data[i] != ',') {
+            i++;
+        }
+        HttpVy parametrar = { varde.data + parametrar_start, i - parametrar_start };
+        int q = las_q_varde(parametrar);
+
+        if (namn.langd == 4 && lika_utan_skiftlage(namn.data, "gzip", 4)) {
+            gzip = q;
+        } else if (namn.langd == 6 && lika_utan_skiftlage(namn.data, "x-gzip", 6)) {
+            gzip = gzip < 0 ? q : gzip;
+        } else if (namn.langd == 7 && lika_utan_skiftlage(namn.data, "deflate", 7)) {
+            deflate = q;
+        } else if (namn.langd == 1 && namn.data[0] == '*') {
+            ovriga = q;
+        }
+    }
+    if (gzip < 0) gzip = ovriga < 0 ? 0 : ovriga;
+    if (deflate < 0) deflate = ovriga < 0 ? 0 : ovriga;
+
+    if (gzip > 0 && gzip >= deflate) {
+        return KOMPRIMERING_GZIP;
+    }
+    return deflate > 0 ? KOMPRIMERING_DEFLATE : KOMPRIMERING_INGEN;
+}
+
+/**
+ * Kopierar en vy till en nollterminerad buffer
+ *
+ * @param mal - Buffern
+ * @param storlek - Buffertens storlek (vyn kortas av om den inte får plats)
+ * @param vy - Vyn att kopiera
+ */
+static void kopiera_vy(char* mal, size_t storlek, HttpVy vy) {
+    size_t langd = vy.langd < storlek ? vy.langd : storlek - 1;
+    memcpy(mal, vy.data, langd);
+    mal[langd] = '\0';
+}
+
+/**
+ * Parsar en HTTP-förfrågan från rå textdata och kopierar fälten
  *
  * @param raadata - Den råa HTTP-texten som kom från klienten (t.ex. "GET /weather HTTP/1.1\r\n...")
  * @param forfragan - Pekare till HttpRequest-struktur där resultatet ska sparas
  * @return true om parsningen lyckades, false vid fel
  *
- * Funktionen analyserar HTTP-förfrågan och extraherar:
- * - Metod (GET, POST, etc.)
- * - Sökväg (t.ex. "/weather")
- * - Query-parametrar (t.ex. "city=Stockholm&country=SE")
- * - Body-data (för POST-förfrågningar)
+ * Äldre gränssnitt ovanpå parsa_http_request_vy(): sökväg, query och body
+ * kopieras till de fasta fälten i HttpRequest och kortas av om de är för
+ * långa. Body kopieras bara för POST.
  */
 bool parsa_http_request(const char* raadata, HttpRequest* forfragan) {
     // Nollställ hela request-strukturen för att undvika skräpdata
     memset(forfragan, 0, sizeof(HttpRequest));
 
-    // Buffrar för att temporärt lagra metod och URL under parsning
-    char metod_strang[16];   // För "GET", "POST", etc. (max 15 tecken + nullterminator)
-    char url[512];           // För hela URL:en (sökväg + eventuella query-parametrar)
+    HttpRequestVy vy;
+    bool ok = parsa_http_request_vy(raadata, strlen(raadata), &vy);
+    forfragan->metod = vy.metod;
+    if (!ok) {
+        return false;
+    }
 
-    // Parsa första raden i HTTP-requesten: "METOD URL HTTP/VERSION"
-    // Exempel: "GET /weather?city=Stockholm HTTP/1.1"
-    // %15s läser max 15 tecken för metoden, %511s läser max 511 tecken för URL
-    if (sscanf(raadata, "%15s %511s", metod_strang, url) != 2) {
-        // Om vi inte kunde läsa både metod och URL är requesten ogiltig
-        LOGG_VARNING("Kunde inte parsa HTTP request-rad");
+    kopiera_vy(forfragan->sokvag, sizeof(forfragan->sokvag), vy.sokvag);
+    kopiera_vy(forfragan->query, sizeof(forfragan->query), vy.query);
+    if (vy.metod == HTTP_POST) {
+        kopiera_vy(forfragan->body, sizeof(forfragan->body), vy.body);
+    }
+    forfragan->hall_vid_liv = vy.hall_vid_liv;
+    return true;
+}
+
+/**
+ * Allokerar en tom mottagningsbuffer för en anslutning
+ *
+ * @param mottagning - Strukturen som ska initieras
+ * @return true vid framgång, false om minnet tog slut
+ *
+ * Bufferten börjar på BUFFER_STORLEK bytes, vilket räcker för nästan alla
+ * requests, och växer bara för ovanligt stora headers eller bodies.
+ */
+bool initiera_http_mottagning(HttpMottagning* mottagning) {
+    memset(mottagning, 0, sizeof(HttpMottagning));
+    mottagning->data = malloc(BUFFER_STORLEK + 1);  // +1 för nullterminator
+    if (!mottagning->data) {
         return false;
     }
+    mottagning->kapacitet = BUFFER_STORLEK;
+    mottagning->data[0] = '\0';
+    return true;
+}
 
-    // Identifiera HTTP-metoden genom att jämföra strängen
-    if (strcmp(metod_strang, "GET") == 0) {
-        forfragan->metod = HTTP_GET;              // GET-förfrågan (hämta data)
-    } else if (strcmp(metod_strang, "POST") == 0) {
-        forfragan->metod = HTTP_POST;             // POST-förfrågan (skicka data)
-    } else {
-        forfragan->metod = HTTP_UNKNOWN;          // Okänd metod (PUT, DELETE, etc.)
+/**
+ * Frigör en mottagningsbuffer
+ *
+ * @param mottagning - Bufferten (får anropas flera gånger)
+ */
+void stang_http_mottagning(HttpMottagning* mottagning) {
+    free(mottagning->data);
+    mottagning->data = NULL;
+    mottagning->langd = 0;
+    mottagning->kapacitet = 0;
+}
+
+/**
+ * Ändrar buffertens kapacitet
+ *
+ * @param mottagning - Bufferten
+ * @param kapacitet - Ny kapacitet, minst mottagning->langd
+ * @return true vid framgång, false om minnet tog slut (bufferten är då orörd)
+ */
+static bool andra_kapacitet(HttpMottagning* mottagning, size_t kapacitet) {
+    char* ny = realloc(mottagning->data, kapacitet + 1);
+    if (!ny) {
         return false;
     }
+    mottagning->data = ny;
+    mottagning->kapacitet = kapacitet;
+    return true;
+}
 
-    // Dela upp URL:en i sökväg och query-parametrar
-    // Exempel: "/weather?city=Stockholm" delas till "/weather" och "city=Stockholm"
-    char* query_start = strchr(url, '?');         // Leta efter '?' som markerar start på query
+/**
+ * Ger ledigt utrymme i slutet av bufferten att ta emot data till
+ *
+ * @param mottagning - Bufferten
+ * @param ledigt - Här sparas antal lediga bytes
+ * @return Pekare till första lediga byte, eller NULL om bufferten inte kan växa
+ *
+ * När bufferten är full fördubblas den, eller växer direkt till hela
+ * requesten om Content-Length redan är känd. Den växer aldrig förbi
+ * MAX_REQUEST_STORLEK.
+ */
+char* http_mottagning_ledigt(HttpMottagning* mottagning, size_t* ledigt) {
+    if (mottagning->langd == mottagning->kapacitet) {
+        size_t ny_kapacitet = mottagning->kapacitet * 2;
+        if (ny_kapacitet < mottagning->request_langd) {
+            ny_kapacitet = mottagning->request_langd;
+        }
+        if (ny_kapacitet > MAX_REQUEST_STORLEK) {
+            ny_kapacitet = MAX_REQUEST_STORLEK;
+        }
+        if (ny_kapacitet <= mottagning->kapacitet || !andra_kapacitet(mottagning, ny_kapacitet)) {
+            *ledigt = 0;
+            return NULL;
+        }
+    }
+    *ledigt = mottagning->kapacitet - mottagning->langd;
+    return mottagning->data + mottagning->langd;
+}
 
-    if (query_start) {
-        // URL:en innehåller query-parametrar (allt efter '?')
+/**
+ * Registrerar nyss mottagen data
+ *
+ * @param mottagning - Bufferten
+ * @param antal - Antal bytes som skrevs till utrymmet från http_mottagning_ledigt()
+ */
+void http_mottagning_tillfor(HttpMottagning* mottagning, size_t antal) {
+    mottagning->langd += antal;
+    mottagning->data[mottagning->langd] = '\0';
+}
+
+/**
+ * Tolkar värdet i en Content-Length-header
+ *
+ * @param varde - Headerns värde
+ * @param langd - Här sparas värdet (MAX_REQUEST_STORLEK + något om större)
+ * @return true om värdet är ett icke-tomt decimaltal, annars false
+ */
+static bool tolka_content_length(HttpVy varde, size_t* langd) {
+    *langd = 0;
+    if (varde.langd == 0) {
+        return false;
+    }
+    for (size_t i = 0; i < varde.langd; i++) {
+        if (varde.data[i] < '0' || varde.data[i] > '9') {
+            return false;
+        }
+        if (*langd <= MAX_REQUEST_STORLEK) {  // Redan för stor - exakt värde spelar ingen roll
+            *langd = *langd * 10 + (size_t)(varde.data[i] - '0');
+        }
+    }
+    return true;
+}
+
+/**
+ * Avgör hur lång en requests body är utifrån dess headers
+ *
+ * @param data - Requesten
+ * @param huvud_langd - Längd på request-rad och headers inklusive den tomma raden
+ * @param langd - Här sparas body-längden (0 om Content-Length saknas)
+ * @return HTTP_RAM_KOMPLETT om längden är känd, HTTP_RAM_FELAKTIG vid ogiltiga
+ *         eller motstridiga Content-Length och HTTP_RAM_EJ_STODD vid
+ *         Transfer-Encoding
+ *
+ * Alla headerrader gås igenom, inte bara den första Content-Length: två
+ * olika värden, eller Transfer-Encoding som servern inte avkodar, gör att
+ * det är okänt var nästa pipelinade request börjar (RFC 9112 6.1 och 6.3).
+ */
+static HttpRamStatus las_kroppslangd(const char* data, size_t huvud_langd, size_t* langd) {
+    *langd = 0;
 
-        // Beräkna längden på sökvägen (allt före '?')
-        size_t sokvag_langd = (size_t)(query_start - url);
+    // Headerraderna ligger mellan request-raden och den tomma raden
+    const char* forsta_radslut = memchr(data, '\n', huvud_langd);
+    const char* slut = data + huvud_langd - 2;
+    const char* nasta = forsta_radslut + 1;
+    bool har_langd = false;
 
-        // Säkerställ att sökvägen inte är längre än bufferten kan hantera
-        if (sokvag_langd >= sizeof(forfragan->sokvag)) {
-            sokvag_langd = sizeof(forfragan->sokvag) - 1;  // Lämna plats för nullterminator
+    while (nasta < slut) {
+        HttpRadSkanning skanning;
+        HttpVy rad = las_rad(nasta, slut, &nasta, &skanning);
+        HttpVy namn;
+        HttpVy varde;
+        if (!dela_headerrad(rad, skanning.kolon, &namn, &varde)) {
+            continue;
         }
+        if (vy_lika_utan_skiftlage(namn, "Transfer-Encoding")) {
+            return HTTP_RAM_EJ_STODD;
+        }
+        if (vy_lika_utan_skiftlage(namn, "Content-Length")) {
+            size_t rad_langd;
+            if (!tolka_content_length(varde, &rad_langd) ||
+                (har_langd && rad_langd != *langd)) {
+                return HTTP_RAM_FELAKTIG;
+            }
+            *langd = rad_langd;
+            har_langd = true;
+        }
+    }
+    return HTTP_RAM_KOMPLETT;
+}
 
-        // Kopiera sökvägen till request-strukturen
-        memcpy(forfragan->sokvag, url, sokvag_langd);
-        forfragan->sokvag[sokvag_langd] = '\0';   // Lägg till nullterminator
+/**
+ * Letar efter en komplett request i början av bufferten
+ *
+ * @param mottagning - Bufferten
+ * @return KOMPLETT (request_langd satt), OFULLSTANDIG, FOR_STOR, FELAKTIG
+ *         eller EJ_STODD
+ *
+ * Slutet på headers söks bara i nyss mottagen data (plus tre bytes bakåt
+ * ifall "\r\n\r\n" delats mellan två mottagningar), så en request som
+ * kommer i många små segment söks inte igenom från början varje gång.
+ * När headers är kompletta läggs Content-Length till för POST-bodies.
+ */
+HttpRamStatus hitta_http_request(HttpMottagning* mottagning) {
+    if (mottagning->huvud_langd == 0) {
+        size_t start = mottagning->sokt_till > 3 ? mottagning->sokt_till - 3 : 0;
+        size_t kvar = mottagning->langd - start;
+        size_t slut = http_hitta_huvudslut(mottagning->data + start, kvar);
+        if (slut == kvar) {
+            mottagning->sokt_till = mottagning->langd;
+            return mottagning->langd >= MAX_REQUEST_STORLEK ? HTTP_RAM_FOR_STOR
+                                                             : HTTP_RAM_OFULLSTANDIG;
+        }
+        size_t huvud_langd = start + slut + 4;
 
-        // Kopiera query-parametrarna (hoppa över '?'-tecknet)
-        strncpy(forfragan->query, query_start + 1, sizeof(forfragan->query) - 1);
-        forfragan->query[sizeof(forfragan->query) - 1] = '\0';  // Säkerställ nullterminering
+        // Sparas först när längden är känd, så att ett nytt anrop ger samma fel
+        size_t body_langd;
+        HttpRamStatus status = las_kroppslangd(mottagning->data, huvud_langd, &body_langd);
+        if (status != HTTP_RAM_KOMPLETT) {
+            return status;
+        }
+        mottagning->huvud_langd = huvud_langd;
+        mottagning->request_langd = huvud_langd + body_langd;
+    }
+
+    if (mottagning->request_langd > MAX_REQUEST_STORLEK) {
+        return HTTP_RAM_FOR_STOR;
+    }
+    return mottagning->langd >= mottagning->request_langd ? HTTP_RAM_KOMPLETT
+                                                          : HTTP_RAM_OFULLSTANDIG;
+}
+
+/**
+ * Tar bort den kompletta requesten från början av bufferten
+ *
+ * @param mottagning - Bufferten (hitta_http_request() har gett KOMPLETT)
+ *
+ * Pipelinade requests flyttas fram till buffertens början. En buffer som
+ * vuxit för en stor request krymps tillbaka när den blivit tom, så att
+ * vilande keep-alive-anslutningar inte håller kvar minnet.
+ */
+void http_mottagning_konsumera(HttpMottagning* mottagning) {
+    size_t kvar = mottagning->langd - mottagning->request_langd;
+    memmove(mottagning->data, mottagning->data + mottagning->request_langd, kvar);
+    mottagning->langd = kvar;
+    mottagning->data[kvar] = '\0';
+    mottagning->sokt_till = 0;
+    mottagning->huvud_langd = 0;
+    mottagning->request_langd = 0;
+
+    if (kvar == 0 && mottagning->kapacitet > BUFFER_STORLEK) {
+        andra_kapacitet(mottagning, BUFFER_STORLEK);  // Misslyckas = behåll den stora
+    }
+}
+
+/**
+ * Skapar felsvaret för en request som inte kan tas emot
+ *
+ * @param svar - Svaret som fylls i (hall_vid_liv sätts till false)
+ * @param kropp_buffer - Buffer där JSON-bodyn skrivs
+ * @param kropp_storlek - Storlek på kropp_buffer
+ * @param mottagning - Bufferten som requesten låg i
+ * @param status - HTTP_RAM_FOR_STOR, HTTP_RAM_FELAKTIG eller HTTP_RAM_EJ_STODD
+ *
+ * Anslutningen måste stängas efter svaret eftersom det är okänt var
+ * nästa request börjar.
+ */
+void skapa_http_mottagningsfel(HttpSvar* svar, char* kropp_buffer, size_t kropp_storlek,
+                               const HttpMottagning* mottagning, HttpRamStatus status) {
+    int statuskod;
+    const char* meddelande;
+    if (status == HTTP_RAM_FELAKTIG) {
+        statuskod = 400;
+        meddelande = "Ogiltig Content-Length";
+    } else if (status == HTTP_RAM_EJ_STODD) {
+        statuskod = 501;
+        meddelande = "Transfer-Encoding stöds inte";
+    } else if (mottagning->huvud_langd == 0) {
+        statuskod = 431;
+        meddelande = "Headers är för stora";
     } else {
-        // URL:en har inga query-parametrar, bara en sökväg
-        strncpy(forfragan->sokvag, url, sizeof(forfragan->sokvag) - 1);
-        forfragan->sokvag[sizeof(forfragan->sokvag) - 1] = '\0';
+        statuskod = 413;
+        meddelande = "Request body är för stor";
+    }
+
+    int langd = snprintf(kropp_buffer, kropp_storlek,
+                         "{\n  \"fel\": true,\n  \"felkod\": %d,\n  \"meddelande\": \"%s\"\n}",
+                         statuskod, meddelande);
+    size_t kropp_langd = 0;
+    if (langd > 0) {
+        kropp_langd = (size_t)langd < kropp_storlek ? (size_t)langd : kropp_storlek - 1;
+    }
+    svar->hall_vid_liv = false;
+    skapa_http_svar(svar, statuskod, kropp_buffer, kropp_langd);
+}
+
+// ============================================================================
+// DATE-HEADER OCH SVARSMALLAR
+// ============================================================================
+
+// Datum i Date-headern plus tom rad, efter "Date: " i de förbyggda svaren
+#define HTTP_DATUM_SLUT_LANGD (HTTP_DATUM_LANGD + 4)
+
+/**
+ * Formaterar en tidpunkt som i Date-headern (RFC 9110 IMF-fixdate)
+ *
+ * @param tid - Sekunder sedan 1970-01-01 UTC
+ * @param ut - Buffer med plats för HTTP_DATUM_LANGD + 1 tecken
+ *
+ * Räknas fram för hand i stället för med gmtime_r()/strftime(), som varken
+ * finns likadant på alla plattformar eller är oberoende av locale.
+ * Exempel: "Sun, 06 Nov 1994 08:49:37 GMT"
+ */
+void formatera_http_datum(time_t tid, char* ut) {
+    static const char DAGAR[7][4] = { "Thu", "Fri", "Sat", "Sun", "Mon", "Tue", "Wed" };
+    static const char MANADER[12][4] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                         "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+    long long sekunder = (long long)tid;
+    long long dag = sekunder / 86400;
+    long long rest = sekunder % 86400;
+    if (rest < 0) {
+        rest += 86400;
+        dag--;
+    }
+    int veckodag = (int)(((dag % 7) + 7) % 7);   // 1970-01-01 var en torsdag
+
+    // Dagnummer till år, månad och dag (Howard Hinnants civil_from_days)
+    long long z = dag + 719468;
+    long long era = (z >= 0 ? z : z - 146096) / 146097;
+    long long doe = z - era * 146097;
+    long long yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    long long doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    long long mp = (5 * doy + 2) / 153;
+    int mdag = (int)(doy - (153 * mp + 2) / 5 + 1);
+    int manad = (int)(mp < 10 ? mp + 3 : mp - 9);
+    long long ar = yoe + era * 400 + (manad <= 2);
+
+    if (ar < 0) ar = 0;          // Formatet har plats för fyra siffror
+    if (ar > 9999) ar = 9999;
+
+    // Fast bredd: "Www, DD Mmm YYYY hh:mm:ss GMT"
+    int timme = (int)(rest / 3600), minut = (int)(rest / 60 % 60), sekund = (int)(rest % 60);
+    memcpy(ut, DAGAR[veckodag], 3);
+    memcpy(ut + 3, ", ", 2);
+    ut[5] = (char)('0' + mdag / 10);
+    ut[6] = (char)('0' + mdag % 10);
+    ut[7] = ' ';
+    memcpy(ut + 8, MANADER[manad - 1], 3);
+    ut[11] = ' ';
+    ut[12] = (char)('0' + ar / 1000);
+    ut[13] = (char)('0' + ar / 100 % 10);
+    ut[14] = (char)('0' + ar / 10 % 10);
+    ut[15] = (char)('0' + ar % 10);
+    ut[16] = ' ';
+    ut[17] = (char)('0' + timme / 10);
+    ut[18] = (char)('0' + timme % 10);
+    ut[19] = ':';
+    ut[20] = (char)('0' + minut / 10);
+    ut[21] = (char)('0' + minut % 10);
+    ut[22] = ':';
+    ut[23] = (char)('0' + sekund / 10);
+    ut[24] = (char)('0' + sekund % 10);
+    memcpy(ut + 25, " GMT", 5);   // Inklusive '\0'
+}
+
+// Date-headern byggs om högst en gång per sekund och tråd
+typedef struct {
+    long long sekund;
+    char text[HTTP_DATUM_LANGD + 1];
+} DatumCache;
+
+static _Thread_local DatumCache datum_cache = { -1, { 0 } };
+
+/**
+ * Aktuell tid som i Date-headern
+ *
+ * @return HTTP_DATUM_LANGD tecken (trådens egen buffer)
+ */
+static const char* aktuellt_http_datum(void) {
+    long long nu = (long long)time(NULL);
+    if (nu != datum_cache.sekund) {
+        formatera_http_datum((time_t)nu, datum_cache.text);
+        datum_cache.sekund = nu;
     }
+    return datum_cache.text;
+}
 
-    // För POST-förfrågningar, extrahera body-datan (data som skickades med requesten)
-    if (forfragan->metod == HTTP_POST) {
-        // HTTP-headers avslutas med "\r\n\r\n", efter det kommer body
-        const char* body_start = strstr(raadata, "\r\n\r\n");
+// Statuskoder som servern använder. Andra koder får "Unknown" och
+// formateras per svar.
+static const struct {
+    int kod;
+    const char* text;
+} STATUSKODER[] = {
+    { 200, "OK" },                                // Allt gick bra
+    { 304, "Not Modified" },                      // Klienten har redan svaret (If-None-Match)
+    { 400, "Bad Request" },                       // Klienten skickade ogiltig förfrågan
+    { 404, "Not Found" },                         // Resursen finns inte
+    { 413, "Content Too Large" },                 // Body större än MAX_REQUEST_STORLEK
+    { 429, "Too Many Requests" },                 // Klientens gräns nådd
+    { 431, "Request Header Fields Too Large" },   // Headers för stora
+    { 500, "Internal Server Error" },             // Serverfel
+    { 501, "Not Implemented" },                   // Transfer-Encoding i request
+    { 503, "Service Unavailable" },               // Överlast
+};
+#define ANTAL_STATUSKODER ((int)(sizeof(STATUSKODER) / sizeof(STATUSKODER[0])))
 
-        if (body_start) {
-            body_start += 4;  // Hoppa över "\r\n\r\n" (4 tecken)
+// Headers efter statusraden, fram till Date. Persistenta anslutningar får
+// även veta hur länge servern väntar på nästa request (TIMEOUT_SEKUNDER).
+static const char* const MALL_SVANS[2] = {
+    "Content-Type: application/json; charset=utf-8\r\n"
+    "Connection: close\r\n"
+    "Server: Vaderserver/1.0\r\n"
+    "Date: ",
+    "Content-Type: application/json; charset=utf-8\r\n"
+    "Connection: keep-alive\r\nKeep-Alive: timeout=" HTTP_STRANG(TIMEOUT_SEKUNDER) "\r\n"
+    "Server: Vaderserver/1.0\r\n"
+    "Date: ",
+};
 
-            // Kopiera body-datan till request-strukturen
-            strncpy(forfragan->body, body_start, sizeof(forfragan->body) - 1);
-            forfragan->body[sizeof(forfragan->body) - 1] = '\0';
+static const char LANGD_HUVUD[] = "\r\nContent-Length: ";
+static const char HUVUD_SLUT[] = "\r\n\r\n";
+
+// Plats för datum, Content-Length (högst 20 siffror), tom rad och '\0' efter mallen
+#define MALL_RESERV (HTTP_DATUM_LANGD + sizeof(LANGD_HUVUD) - 1 + 20 + sizeof(HUVUD_SLUT))
+
+// En mall per statuskod och Connection-läge: statusrad och headers fram
+// till "Date: ". Byggs av initiera_http_svar() och läses sedan bara.
+typedef struct {
+    char text[HTTP_HUVUD_STORLEK - MALL_RESERV];
+    size_t langd;
+} SvarsMall;
+
+static SvarsMall svarsmallar[ANTAL_STATUSKODER][2];
+static int8_t mall_index[600];    // Statuskod -> index i svarsmallar + 1, 0 = ingen mall
+
+/**
+ * Bygger svarsmallarna
+ *
+ * @return false om någon mall inte får plats i HTTP_HUVUD_STORLEK
+ *
+ * Anropas en gång vid start innan trådarna startar. Därefter är ett svars
+ * headers några memcpy(): mallen, datumet och Content-Length.
+ */
+bool initiera_http_svar(void) {
+    memset(mall_index, 0, sizeof(mall_index));
+    for (int i = 0; i < ANTAL_STATUSKODER; i++) {
+        for (int hall_vid_liv = 0; hall_vid_liv < 2; hall_vid_liv++) {
+            SvarsMall* mall = &svarsmallar[i][hall_vid_liv];
+            int langd = snprintf(mall->text, sizeof(mall->text), "HTTP/1.1 %d %s\r\n%s",
+                                 STATUSKODER[i].kod, STATUSKODER[i].text,
+                                 MALL_SVANS[hall_vid_liv]);
+            if (langd < 0 || (size_t)langd >= sizeof(mall->text)) {
+                return false;
+            }
+            mall->langd = (size_t)langd;
         }
+        mall_index[STATUSKODER[i].kod] = (int8_t)(i + 1);
     }
+    return true;
+}
 
-    // Logga den parsade requesten för debugging
-    LOGG_DEBUG("Parsad HTTP %s %s (query: %s)",
-               metod_strang, forfragan->sokvag, forfragan->query);
+/**
+ * Skriver datum, Content-Length och tom rad efter en mall i svar->huvud
+ *
+ * @param svar - Svaret; svar->huvud_langd är mallens längd och uppdateras
+ * @param kropp_langd - Bodyns längd
+ * @param med_langd - false för 304, som inte får ange längden 0 (RFC 9110 8.6)
+ */
+static void avsluta_huvud(HttpSvar* svar, size_t kropp_langd, bool med_langd) {
+    char* p = svar->huvud + svar->huvud_langd;
+    memcpy(p, aktuellt_http_datum(), HTTP_DATUM_LANGD);
+    p += HTTP_DATUM_LANGD;
+    if (!med_langd) {
+        memcpy(p, HUVUD_SLUT, sizeof(HUVUD_SLUT));
+        svar->huvud_langd = (size_t)(p + sizeof(HUVUD_SLUT) - 1 - svar->huvud);
+        return;
+    }
+    memcpy(p, LANGD_HUVUD, sizeof(LANGD_HUVUD) - 1);
+    p += sizeof(LANGD_HUVUD) - 1;
 
-    return true;  // Parsningen lyckades
+    // Siffrorna skrivs baklänges i en liten buffer och kopieras sedan
+    char siffror[20];
+    size_t n = sizeof(siffror);
+    do {
+        siffror[--n] = (char)('0' + kropp_langd % 10);
+        kropp_langd /= 10;
+    } while (kropp_langd > 0);
+    memcpy(p, siffror + n, sizeof(siffror) - n);
+    p += sizeof(siffror) - n;
+
+    memcpy(p, HUVUD_SLUT, sizeof(HUVUD_SLUT));   // Nollterminerat för loggning och tester
+    p += sizeof(HUVUD_SLUT) - 1;
+    svar->huvud_langd = (size_t)(p - svar->huvud);
 }
 
+// Svaret vid överlast byggs vid kompilering - att avvisa en request ska
+// kosta så lite som möjligt när servern redan ligger efter
+#define OVERLAST_KROPP "{\n  \"fel\": true,\n  \"felkod\": 503,\n" \
+                       "  \"meddelande\": \"Servern är överbelastad, försök igen om en stund\"\n}"
+#define OVERLAST_KROPP_LANGD 106
+_Static_assert(sizeof(OVERLAST_KROPP) - 1 == OVERLAST_KROPP_LANGD, "Fel längd på OVERLAST_KROPP");
+
+static const char OVERLAST_HUVUD[] =
+    "HTTP/1.1 503 Service Unavailable\r\n"
+    "Content-Type: application/json; charset=utf-8\r\n"
+    "Content-Length: " HTTP_STRANG(OVERLAST_KROPP_LANGD) "\r\n"
+    "Retry-After: " HTTP_STRANG(ANTAGNING_RETRY_AFTER_SEKUNDER) "\r\n"
+    "Connection: close\r\n"
+    "Server: Vaderserver/1.0\r\n"
+    "Date: ";
+_Static_assert(sizeof(OVERLAST_HUVUD) + HTTP_DATUM_SLUT_LANGD <= HTTP_HUVUD_STORLEK,
+               "OVERLAST_HUVUD får inte plats");
+
+// Likaså svaret till en klient som överskridit sin gräns (klientgrans.c)
+#define BEGRANSAD_KROPP "{\n  \"fel\": true,\n  \"felkod\": 429,\n" \
+                        "  \"meddelande\": \"För många requests från din adress, försök igen om en stund\"\n}"
+#define BEGRANSAD_KROPP_LANGD 118
+_Static_assert(sizeof(BEGRANSAD_KROPP) - 1 == BEGRANSAD_KROPP_LANGD, "Fel längd på BEGRANSAD_KROPP");
+
+static const char BEGRANSAD_HUVUD[] =
+    "HTTP/1.1 429 Too Many Requests\r\n"
+    "Content-Type: application/json; charset=utf-8\r\n"
+    "Content-Length: " HTTP_STRANG(BEGRANSAD_KROPP_LANGD) "\r\n"
+    "Retry-After: " HTTP_STRANG(KLIENTGRANS_RETRY_AFTER_SEKUNDER) "\r\n"
+    "Connection: close\r\n"
+    "Server: Vaderserver/1.0\r\n"
+    "Date: ";
+_Static_assert(sizeof(BEGRANSAD_HUVUD) + HTTP_DATUM_SLUT_LANGD <= HTTP_HUVUD_STORLEK,
+               "BEGRANSAD_HUVUD får inte plats");
+
 /**
- * Skapar ett komplett HTTP-svar med JSON-data
+ * Fyller i ett förbyggt svar som stänger anslutningen
  *
- * @param buffer - Buffert där HTTP-svaret ska skrivas
- * @param buffer_storlek - Storlek på bufferten i bytes
+ * @param svar - Svaret
+ * @param huvud - Statusrad och headers fram till "Date: "
+ * @param huvud_langd - Antal bytes i huvud
+ * @param kropp - Body (statisk)
+ * @param kropp_langd - Antal bytes i kropp
+ */
+static void fyll_forbyggt_svar(HttpSvar* svar, const char* huvud, size_t huvud_langd,
+                               const char* kropp, size_t kropp_langd) {
+    memcpy(svar->huvud, huvud, huvud_langd);
+    memcpy(svar->huvud + huvud_langd, aktuellt_http_datum(), HTTP_DATUM_LANGD);
+    memcpy(svar->huvud + huvud_langd + HTTP_DATUM_LANGD, HUVUD_SLUT, sizeof(HUVUD_SLUT));
+    svar->huvud_langd = huvud_langd + HTTP_DATUM_SLUT_LANGD;
+    svar->kropp = kropp;
+    svar->kropp_langd = kropp_langd;
+    svar->hall_vid_liv = false;
+}
+
+/**
+ * Fyller i det förbyggda svaret vid överlast
+ *
+ * @param svar - Svaret
+ *
+ * Anslutningen stängs efter svaret: en överbelastad server vinner på att
+ * klienterna kopplar ned, och Retry-After säger när de kan försöka igen.
+ */
+void skapa_http_overlast(HttpSvar* svar) {
+    fyll_forbyggt_svar(svar, OVERLAST_HUVUD, sizeof(OVERLAST_HUVUD) - 1,
+                       OVERLAST_KROPP, OVERLAST_KROPP_LANGD);
+}
+
+/**
+ * Fyller i det förbyggda svaret till en klient som nått sin gräns
+ *
+ * @param svar - Svaret
+ *
+ * Anslutningen stängs även här, så att en klient som skickar för mycket
+ * inte kan fortsätta pipelina requests på samma anslutning.
+ */
+void skapa_http_begransad(HttpSvar* svar) {
+    fyll_forbyggt_svar(svar, BEGRANSAD_HUVUD, sizeof(BEGRANSAD_HUVUD) - 1,
+                       BEGRANSAD_KROPP, BEGRANSAD_KROPP_LANGD);
+}
+
+/**
+ * Fyller i headers och body för ett HTTP-svar
+ *
+ * @param svar - Svaret; hall_vid_liv avgör Connection-headern
  * @param statuskod - HTTP-statuskod (200 = OK, 404 = Not Found, 500 = Server Error, etc.)
- * @param json_data - JSON-strängen som ska skickas i body (kan vara NULL)
+ * @param kropp - JSON-body (kopieras inte - måste leva tills svaret skickats)
+ * @param kropp_langd - Antal bytes i kropp
  *
- * Funktionen bygger ett komplett HTTP-svar med headers och body.
- * Exempel på genererat svar:
+ * Headers kopieras från den förbyggda mallen för statuskoden; bara datumet
+ * (cachat per sekund) och Content-Length skrivs in. Bodyn skickas från den
+ * buffer den byggdes i. Exempel på headers:
  * HTTP/1.1 200 OK
  * Content-Type: application/json; charset=utf-8
- * Content-Length: 42
  * Connection: close
  * Server: Vaderserver/1.0
+ * Date: Sun, 06 Nov 1994 08:49:37 GMT
+ * Content-Length: 42
+ */
+void skapa_http_svar(HttpSvar* svar, int statuskod, const char* kropp, size_t kropp_langd) {
+    int index = statuskod >= 0 && statuskod < (int)sizeof(mall_index) ? mall_index[statuskod] : 0;
+    int hall_vid_liv = svar->hall_vid_liv ? 1 : 0;
+    if (index > 0) {
+        const SvarsMall* mall = &svarsmallar[index - 1][hall_vid_liv];
+        memcpy(svar->huvud, mall->text, mall->langd);
+        svar->huvud_langd = mall->langd;
+    } else {
+        // Statuskod utan mall (eller initiera_http_svar() ej anropad):
+        // formatera statusraden som förr
+        const char* status_text = "Unknown";
+        for (int i = 0; i < ANTAL_STATUSKODER; i++) {
+            if (STATUSKODER[i].kod == statuskod) {
+                status_text = STATUSKODER[i].text;
+            }
+        }
+        size_t max = sizeof(svar->huvud) - MALL_RESERV;
+        int langd = snprintf(svar->huvud, max, "HTTP/1.1 %d %s\r\n%s",
+                             statuskod, status_text, MALL_SVANS[hall_vid_liv]);
+        svar->huvud_langd = langd < 0 ? 0 : ((size_t)langd < max ? (size_t)langd : max - 1);
+    }
+    avsluta_huvud(svar, kropp_langd, statuskod != 304);
+    svar->kropp = kropp;
+    svar->kropp_langd = kropp_langd;
+}
+
+/**
+ * Lägger till en header i ett svar från skapa_http_svar()
+ *
+ * @param svar - Svaret
+ * @param namn - Headerns namn (t.ex. "ETag")
+ * @param varde - Headerns värde
+ * @return false om headern inte får plats i HTTP_HUVUD_STORLEK (svaret är då oförändrat)
+ *
+ * Headern skrivs över den avslutande tomma raden, som läggs till igen efter.
+ */
+bool lagg_till_http_header(HttpSvar* svar, const char* namn, const char* varde) {
+    size_t namn_langd = strlen(namn);
+    size_t varde_langd = strlen(varde);
+    size_t pos = svar->huvud_langd - 2;    // Början på den tomma raden
+    if (svar->huvud_langd < 4 ||
+        pos + namn_langd + 2 + varde_langd + sizeof(HUVUD_SLUT) > sizeof(svar->huvud)) {
+        return false;
+    }
+    char* p = svar->huvud + pos;
+    memcpy(p, namn, namn_langd);
+    p += namn_langd;
+    memcpy(p, ": ", 2);
+    p += 2;
+    memcpy(p, varde, varde_langd);
+    p += varde_langd;
+    memcpy(p, HUVUD_SLUT, sizeof(HUVUD_SLUT));
+    svar->huvud_langd = (size_t)(p + sizeof(HUVUD_SLUT) - 1 - svar->huvud);
+    return true;
+}
+
+/**
+ * Skapar ett komplett HTTP-svar med JSON-data som en sammanhängande sträng
+ *
+ * @param buffer - Buffert där HTTP-svaret ska skrivas
+ * @param buffer_storlek - Storlek på bufferten i bytes
+ * @param statuskod - HTTP-statuskod (200 = OK, 404 = Not Found, 500 = Server Error, etc.)
+ * @param json_data - JSON-strängen som ska skickas i body (kan vara NULL)
  *
- * {"stad":"Stockholm","temperatur":15.5}
+ * Anslutningen stängs efter svaret. Servern själv använder skapa_http_svar()
+ * och skickar headers och body utan att slå ihop dem.
  */
 void skapa_http_response(char* buffer, size_t buffer_storlek,
                          int statuskod, const char* json_data) {
-    // Välj lämplig statustext baserat på statuskoden
-    const char* status_text;
-    switch (statuskod) {
-        case 200: status_text = "OK"; break;                          // Allt gick bra
-        case 400: status_text = "Bad Request"; break;                 // Klienten skickade ogiltig förfrågan
-        case 404: status_text = "Not Found"; break;                   // Resursen finns inte
-        case 500: status_text = "Internal Server Error"; break;       // Serverfel
-        default: status_text = "Unknown"; break;                      // Okänd statuskod
-    }
-
-    // Beräkna längden på JSON-datan (0 om ingen data finns)
-    size_t json_langd = json_data ? strlen(json_data) : 0;
-
-    // Bygg det kompletta HTTP-svaret med alla headers
-    snprintf(buffer, buffer_storlek,
-             "HTTP/1.1 %d %s\r\n"                                     // Statusrad (t.ex. "HTTP/1.1 200 OK")
-             "Content-Type: application/json; charset=utf-8\r\n"      // Typ av innehåll (JSON med UTF-8)
-             "Content-Length: %zu\r\n"                                // Längd på body i bytes
-             "Connection: close\r\n"                                  // Stäng anslutning efter svar
-             "Server: Vaderserver/1.0\r\n"                           // Serveridentifikation
-             "\r\n"                                                   // Tom rad markerar slut på headers
-             "%s",                                                    // JSON-data (body)
-             statuskod, status_text,
-             json_langd,
-             json_data ? json_data : "");  // Använd tom sträng om json_data är NULL
+    HttpSvar svar;
+    svar.hall_vid_liv = false;
+    skapa_http_svar(&svar, statuskod, json_data ? json_data : "",
+                    json_data ? strlen(json_data) : 0);
+    snprintf(buffer, buffer_storlek, "%s%s", svar.huvud, svar.kropp);
+}
+
+#ifndef _WIN32
+/**
+ * Beskriver det som återstår av ett svar som en iovec-array
+ *
+ * @param svar - Svaret
+ * @param skickat - Antal bytes (headers + body) som redan skickats
+ * @param iov - Array med plats för två poster
+ * @return Antal använda poster (0 när allt är skickat)
+ */
+int http_svar_iovec(const HttpSvar* svar, size_t skickat, struct iovec iov[2]) {
+    int antal = 0;
+    if (skickat < svar->huvud_langd) {
+        iov[antal].iov_base = (void*)(svar->huvud + skickat);
+        iov[antal].iov_len = svar->huvud_langd - skickat;
+        antal++;
+        skickat = 0;
+    } else {
+        skickat -= svar->huvud_langd;
+    }
+    if (skickat < svar->kropp_langd) {
+        iov[antal].iov_base = (void*)(svar->kropp + skickat);
+        iov[antal].iov_len = svar->kropp_langd - skickat;
+        antal++;
+    }
+    return antal;
+}
+#endif
+
+/**
+ * Skickar så mycket som möjligt av ett svar
+ *
+ * @param fd - Klientens socket (blockerande eller icke-blockerande)
+ * @param svar - Svaret
+ * @param skickat - In: redan skickat, ut: skickat efter anropet
+ * @return true om inget fel uppstod (allt skickat eller EAGAIN), false vid fel
+ *
+ * Headers och body går i samma sendmsg() (scatter/gather), så bodyn behöver
+ * aldrig kopieras in bakom headers. Korta skrivningar fortsätter där de
+ * slutade; på en icke-blockerande socket returneras vid EAGAIN.
+ */
+bool skicka_http_svar(socket_t fd, const HttpSvar* svar, size_t* skickat) {
+    size_t totalt = svar->huvud_langd + svar->kropp_langd;
+    while (*skickat < totalt) {
+#ifdef _WIN32
+        // Ingen sendmsg() - skicka headers och body var för sig
+        const char* data;
+        size_t langd;
+        if (*skickat < svar->huvud_langd) {
+            data = svar->huvud + *skickat;
+            langd = svar->huvud_langd - *skickat;
+        } else {
+            data = svar->kropp + (*skickat - svar->huvud_langd);
+            langd = totalt - *skickat;
+        }
+        int n = send(fd, data, (int)langd, 0);
+        if (n == SOCKET_FEL && WSAGetLastError() == WSAEWOULDBLOCK) {
+            return true;
+        }
+#else
+        struct iovec iov[2];
+        struct msghdr meddelande;
+        memset(&meddelande, 0, sizeof(meddelande));
+        meddelande.msg_iov = iov;
+        meddelande.msg_iovlen = (size_t)http_svar_iovec(svar, *skickat, iov);
+#ifdef MSG_NOSIGNAL
+        // MSG_NOSIGNAL förhindrar SIGPIPE om klienten redan har stängt
+        ssize_t n = sendmsg(fd, &meddelande, MSG_NOSIGNAL);
+#else
+        ssize_t n = sendmsg(fd, &meddelande, 0);
+#endif
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return true;  // Socketbufferten är full, fortsätt när den blir skrivbar
+        }
+#endif
+        if (n <= 0) {
+            return false;
+        }
+        *skickat += (size_t)n;
+    }
+    return true;
 }
 
 /**
@@ -154,46 +1207,55 @@ void skapa_http_response(char* buffer, size_t buffer_storlek,
 bool hamta_query_parameter(const char* query, const char* parameter_namn,
                            char* varde, size_t varde_storlek) {
     // Säkerhetscheck: Om någon pekare är NULL, returnera false
-    if (!query || !parameter_namn || !varde) {
+    if (!query) {
         return false;
     }
+    HttpVy vy = { query, strlen(query) };
+    return hamta_query_parameter_vy(vy, parameter_namn, varde, varde_storlek);
+}
 
-    // Bygg söksträng i formatet "parameter=" (t.ex. "city=")
-    char sokstrang[128];
-    snprintf(sokstrang, sizeof(sokstrang), "%s=", parameter_namn);
-
-    // Leta efter denna söksträng i query-strängen
-    const char* start = strstr(query, sokstrang);
-
-    // Om parametern inte finns i query-strängen
-    if (!start) {
+/**
+ * Hämtar värdet av en query-parameter ur en vy
+ *
+ * @param query - Query-delen som vy (behöver inte vara nollterminerad)
+ * @param parameter_namn - Namnet på parametern att hämta (t.ex. "city")
+ * @param varde - Buffert där parameterns värde ska sparas (nollterminerat)
+ * @param varde_storlek - Storlek på värde-bufferten
+ * @return true om parametern hittades, false annars
+ *
+ * Namn och värde avkodas (%XX och '+'). Söker igenom hela query-strängen
+ * för varje anrop - för flera parametrar ur samma request är
+ * tolka_query() och query_varde() snabbare.
+ */
+bool hamta_query_parameter_vy(HttpVy query, const char* parameter_namn,
+                              char* varde, size_t varde_storlek) {
+    // Säkerhetscheck: Om någon pekare är NULL, returnera false
+    if (!query.data || !parameter_namn || !varde) {
         return false;
     }
 
-    // Hoppa förbi "parameter=" för att komma till värdet
-    start += strlen(sokstrang);
-
-    // Hitta slutet på värdet (antingen '&' för nästa parameter, eller slutet av strängen)
-    const char* slut = strchr(start, '&');
-
-    // Beräkna längden på värdet
-    size_t langd;
-    if (slut) {
-        // Värdet avslutas med '&' (det finns fler parametrar efter)
-        langd = (size_t)(slut - start);
-    } else {
-        // Värdet går till slutet av strängen (sista parametern)
-        langd = strlen(start);
-    }
+    // Gå igenom parametrarna ("namn=värde" mellan '&') och jämför hela det
+    // avkodade namnet, så att t.ex. "xcity=" inte tas för "city="
+    size_t namn_langd = strlen(parameter_namn);
+    const char* p = query.data;
+    const char* slut = query.data + query.langd;
+    while (p < slut) {
+        const char* amp = memchr(p, '&', (size_t)(slut - p));
+        const char* del_slut = amp ? amp : slut;
+        const char* lika = memchr(p, '=', (size_t)(del_slut - p));
+        HttpVy namn = { p, (size_t)((lika ? lika : del_slut) - p) };
 
-    // Säkerställ att värdet inte är längre än bufferten kan hantera
-    if (langd >= varde_storlek) {
-        langd = varde_storlek - 1;  // Lämna plats för nullterminator
+        // Ett kodat namn är aldrig kortare än det avkodade
+        char avkodat[64];
+        if (namn.langd >= namn_langd && namn_langd + 2 <= sizeof(avkodat) &&
+            query_avkoda(namn, avkodat, namn_langd + 2) == namn_langd &&
+            memcmp(avkodat, parameter_namn, namn_langd) == 0) {
+            HttpVy vy = { lika ? lika + 1 : del_slut, 0 };
+            vy.langd = (size_t)(del_slut - vy.data);
+            query_avkoda(vy, varde, varde_storlek);
+            return true;  // Parametern hittades och kopierades
+        }
+        p = del_slut + 1;
     }
-
-    // Kopiera värdet till output-bufferten
-    memcpy(varde, start, langd);
-    varde[langd] = '\0';  // Lägg till nullterminator
-
-    return true;  // Parametern hittades och kopierades
+    return false;  // Parametern finns inte i query-strängen
 }
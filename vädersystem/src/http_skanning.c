@@ -0,0 +1,380 @@
+#include "http_skanning.h"   // Egna deklarationer
+#include <stdint.h>          // För uint32_t och SIZE_MAX
+#include <string.h>          // För memchr
+
+// SIMD-kärnorna kompileras med target-attribut, så resten av programmet
+// behöver inga -mavx2 och körs även på äldre processorer
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define HTTP_SKANNING_X86 1
+#include <immintrin.h>       // SSE2- och AVX2-intrinsics
+#endif
+
+// Index för ett tecken som inte har hittats (än)
+#define EJ_HITTAD SIZE_MAX
+
+// ============================================================================
+// GEMENSAMT
+// ============================================================================
+
+/**
+ * Nollställer en radskanning innan sökningen börjar
+ *
+ * @param rad - Skanningen som ska fyllas i
+ */
+static void borja_rad(HttpRadSkanning* rad) {
+    rad->radslut = EJ_HITTAD;
+    rad->mellanslag[0] = EJ_HITTAD;
+    rad->mellanslag[1] = EJ_HITTAD;
+    rad->fragetecken = EJ_HITTAD;
+    rad->kolon = EJ_HITTAD;
+}
+
+/**
+ * Sparar positionen för ett strukturtecken om det är det första av sitt slag
+ *
+ * @param rad - Skanningen
+ * @param index - Teckens position
+ * @param tecken - ' ', '?' eller ':'
+ */
+static inline void registrera(HttpRadSkanning* rad, size_t index, char tecken) {
+    if (tecken == ' ') {
+        if (rad->mellanslag[0] == EJ_HITTAD) {
+            rad->mellanslag[0] = index;
+        } else if (rad->mellanslag[1] == EJ_HITTAD) {
+            rad->mellanslag[1] = index;
+        }
+    } else if (tecken == '?') {
+        if (rad->fragetecken == EJ_HITTAD) {
+            rad->fragetecken = index;
+        }
+    } else if (tecken == ':') {
+        if (rad->kolon == EJ_HITTAD) {
+            rad->kolon = index;
+        }
+    }
+}
+
+/**
+ * Skannar resten av en rad tecken för tecken (slutet efter sista SIMD-blocket)
+ *
+ * @param data - Raden
+ * @param i - Var skanningen fortsätter
+ * @param langd - Antal bytes i data
+ * @param rad - Skanningen (radslut sätts alltid)
+ */
+static void skanna_bytevis(const char* data, size_t i, size_t langd, HttpRadSkanning* rad) {
+    for (; i < langd; i++) {
+        if (data[i] == '\n') {
+            rad->radslut = i;
+            return;
+        }
+        registrera(rad, i, data[i]);
+    }
+    rad->radslut = langd;
+}
+
+/**
+ * Ger tecken som saknas på raden samma index som radslutet
+ *
+ * @param rad - Skanningen (radslut måste vara satt)
+ */
+static void avsluta_rad(HttpRadSkanning* rad) {
+    if (rad->mellanslag[0] == EJ_HITTAD) rad->mellanslag[0] = rad->radslut;
+    if (rad->mellanslag[1] == EJ_HITTAD) rad->mellanslag[1] = rad->radslut;
+    if (rad->fragetecken == EJ_HITTAD) rad->fragetecken = rad->radslut;
+    if (rad->kolon == EJ_HITTAD) rad->kolon = rad->radslut;
+}
+
+/**
+ * Registrerar strukturtecknen i ett SIMD-block utifrån jämförelsernas
+ * bitmasker (bit n motsvarar tecknet på position start + n)
+ *
+ * @param rad - Skanningen
+ * @param start - Blockets position i raden
+ * @param m_nl, m_sp, m_fr, m_ko - Masker för '\n', ' ', '?' och ':'
+ * @return true om radslutet låg i blocket (skanningen är då avslutad)
+ */
+static inline bool registrera_block(HttpRadSkanning* rad, size_t start, uint32_t m_nl,
+                                    uint32_t m_sp, uint32_t m_fr, uint32_t m_ko) {
+    // Bara tecken före radslutet räknas
+    if (m_nl) {
+        uint32_t fore = (1u << __builtin_ctz(m_nl)) - 1;
+        m_sp &= fore;
+        m_fr &= fore;
+        m_ko &= fore;
+    }
+    while (m_sp && rad->mellanslag[1] == EJ_HITTAD) {
+        registrera(rad, start + (size_t)__builtin_ctz(m_sp), ' ');
+        m_sp &= m_sp - 1;
+    }
+    if (m_fr && rad->fragetecken == EJ_HITTAD) {
+        rad->fragetecken = start + (size_t)__builtin_ctz(m_fr);
+    }
+    if (m_ko && rad->kolon == EJ_HITTAD) {
+        rad->kolon = start + (size_t)__builtin_ctz(m_ko);
+    }
+    if (m_nl) {
+        rad->radslut = start + (size_t)__builtin_ctz(m_nl);
+        avsluta_rad(rad);
+        return true;
+    }
+    return false;
+}
+
+// ============================================================================
+// SKALÄR (LIBC)
+// ============================================================================
+
+/**
+ * Hittar "\r\n\r\n" med memchr (libc är själv vektoriserad på de flesta
+ * plattformar, så detta är också referensen för mätningarna)
+ */
+static size_t huvudslut_skalar(const char* data, size_t langd) {
+    const char* p = data;
+    const char* slut = data + langd;
+    while (slut - p >= 4) {
+        const char* cr = memchr(p, '\r', (size_t)(slut - p) - 3);
+        if (!cr) {
+            break;
+        }
+        if (cr[1] == '\n' && cr[2] == '\r' && cr[3] == '\n') {
+            return (size_t)(cr - data);
+        }
+        p = cr + 1;
+    }
+    return langd;
+}
+
+/**
+ * Letar upp ett tecken före radslutet
+ *
+ * @return Index, eller EJ_HITTAD
+ */
+static size_t hitta_fore(const char* data, size_t fran, size_t till, char tecken) {
+    if (fran >= till) {
+        return EJ_HITTAD;
+    }
+    const char* p = memchr(data + fran, tecken, till - fran);
+    return p ? (size_t)(p - data) : EJ_HITTAD;
+}
+
+/**
+ * Skannar en rad med ett memchr per tecken (flera pass över raden)
+ */
+static void rad_skalar(const char* data, size_t langd, HttpRadSkanning* rad) {
+    borja_rad(rad);
+    const char* nl = memchr(data, '\n', langd);
+    rad->radslut = nl ? (size_t)(nl - data) : langd;
+
+    rad->mellanslag[0] = hitta_fore(data, 0, rad->radslut, ' ');
+    if (rad->mellanslag[0] != EJ_HITTAD) {
+        rad->mellanslag[1] = hitta_fore(data, rad->mellanslag[0] + 1, rad->radslut, ' ');
+    }
+    rad->fragetecken = hitta_fore(data, 0, rad->radslut, '?');
+    rad->kolon = hitta_fore(data, 0, rad->radslut, ':');
+    avsluta_rad(rad);
+}
+
+#ifdef HTTP_SKANNING_X86
+// ============================================================================
+// SSE2
+// ============================================================================
+
+// Samma metod som AVX2 nedan men 16 bytes per varv. SSE4.2:s
+// strängjämförelser (_mm_cmpestri/_mm_cmpestrm) prövades först men är
+// mikrokodade och blev långsammare än libc:s memchr.
+
+__attribute__((target("sse2")))
+static size_t huvudslut_sse2(const char* data, size_t langd) {
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i nl = _mm_set1_epi8('\n');
+    size_t i = 0;
+
+    // Fyra överlappande laddningar: bit n är satt om "\r\n\r\n" börjar på n
+    for (; i + 16 + 3 <= langd; i += 16) {
+        const char* p = data + i;
+        __m128i a = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)p), cr);
+        __m128i b = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + 1)), nl);
+        __m128i c = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + 2)), cr);
+        __m128i d = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + 3)), nl);
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(
+            _mm_and_si128(_mm_and_si128(a, b), _mm_and_si128(c, d)));
+        if (mask) {
+            return i + (size_t)__builtin_ctz(mask);
+        }
+    }
+    size_t rest = huvudslut_skalar(data + i, langd - i);
+    return rest == langd - i ? langd : i + rest;
+}
+
+__attribute__((target("sse2")))
+static void rad_sse2(const char* data, size_t langd, HttpRadSkanning* rad) {
+    const __m128i nl = _mm_set1_epi8('\n');
+    const __m128i sp = _mm_set1_epi8(' ');
+    const __m128i fr = _mm_set1_epi8('?');
+    const __m128i ko = _mm_set1_epi8(':');
+    borja_rad(rad);
+
+    size_t i = 0;
+    for (; i + 16 <= langd; i += 16) {
+        __m128i block = _mm_loadu_si128((const __m128i*)(data + i));
+        uint32_t m_nl = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(block, nl));
+        uint32_t m_sp = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(block, sp));
+        uint32_t m_fr = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(block, fr));
+        uint32_t m_ko = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(block, ko));
+        if (registrera_block(rad, i, m_nl, m_sp, m_fr, m_ko)) {
+            return;
+        }
+    }
+    skanna_bytevis(data, i, langd, rad);
+    avsluta_rad(rad);
+}
+
+// ============================================================================
+// AVX2
+// ============================================================================
+
+__attribute__((target("avx2")))
+static size_t huvudslut_avx2(const char* data, size_t langd) {
+    const __m256i cr = _mm256_set1_epi8('\r');
+    const __m256i nl = _mm256_set1_epi8('\n');
+    size_t i = 0;
+
+    // Fyra överlappande laddningar: bit n är satt om "\r\n\r\n" börjar på n
+    for (; i + 32 + 3 <= langd; i += 32) {
+        const char* p = data + i;
+        __m256i a = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)p), cr);
+        __m256i b = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(p + 1)), nl);
+        __m256i c = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(p + 2)), cr);
+        __m256i d = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(p + 3)), nl);
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_and_si256(a, b), _mm256_and_si256(c, d)));
+        if (mask) {
+            return i + (size_t)__builtin_ctz(mask);
+        }
+    }
+    size_t rest = huvudslut_skalar(data + i, langd - i);
+    return rest == langd - i ? langd : i + rest;
+}
+
+__attribute__((target("avx2")))
+static void rad_avx2(const char* data, size_t langd, HttpRadSkanning* rad) {
+    const __m256i nl = _mm256_set1_epi8('\n');
+    const __m256i sp = _mm256_set1_epi8(' ');
+    const __m256i fr = _mm256_set1_epi8('?');
+    const __m256i ko = _mm256_set1_epi8(':');
+    borja_rad(rad);
+
+    size_t i = 0;
+    for (; i + 32 <= langd; i += 32) {
+        __m256i block = _mm256_loadu_si256((const __m256i*)(data + i));
+        uint32_t m_nl = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, nl));
+        uint32_t m_sp = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, sp));
+        uint32_t m_fr = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, fr));
+        uint32_t m_ko = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, ko));
+
+        if (registrera_block(rad, i, m_nl, m_sp, m_fr, m_ko)) {
+            return;
+        }
+    }
+    skanna_bytevis(data, i, langd, rad);
+    avsluta_rad(rad);
+}
+#endif // HTTP_SKANNING_X86
+
+// ============================================================================
+// VAL AV IMPLEMENTATION
+// ============================================================================
+
+typedef size_t (*HuvudslutFunktion)(const char* data, size_t langd);
+typedef void (*RadFunktion)(const char* data, size_t langd, HttpRadSkanning* rad);
+
+// Sätts en gång vid start (före trådarna) och läses sedan bara
+static HttpSkanningNiva aktuell_niva = HTTP_SKANNING_SKALAR;
+static HuvudslutFunktion hitta_huvudslut = huvudslut_skalar;
+static RadFunktion skanna_rad = rad_skalar;
+
+/**
+ * Kontrollerar om processorn klarar en nivå
+ *
+ * @param niva - Nivån
+ * @return true om den kan användas
+ */
+static bool stods(HttpSkanningNiva niva) {
+    switch (niva) {
+    case HTTP_SKANNING_SKALAR:
+        return true;
+#ifdef HTTP_SKANNING_X86
+    case HTTP_SKANNING_SSE2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("sse2");
+    case HTTP_SKANNING_AVX2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#endif
+    default:
+        return false;
+    }
+}
+
+/**
+ * Byter till en viss implementation
+ *
+ * @param niva - Önskad nivå
+ * @return false om processorn saknar stöd (nivån ändras då inte)
+ */
+bool satt_http_skanning(HttpSkanningNiva niva) {
+    if (!stods(niva)) {
+        return false;
+    }
+    switch (niva) {
+#ifdef HTTP_SKANNING_X86
+    case HTTP_SKANNING_AVX2:
+        hitta_huvudslut = huvudslut_avx2;
+        skanna_rad = rad_avx2;
+        break;
+    case HTTP_SKANNING_SSE2:
+        hitta_huvudslut = huvudslut_sse2;
+        skanna_rad = rad_sse2;
+        break;
+#endif
+    default:
+        hitta_huvudslut = huvudslut_skalar;
+        skanna_rad = rad_skalar;
+        break;
+    }
+    aktuell_niva = niva;
+    return true;
+}
+
+/**
+ * Väljer den snabbaste implementationen som processorn klarar
+ *
+ * @return Vald nivå
+ */
+HttpSkanningNiva initiera_http_skanning(void) {
+    if (!satt_http_skanning(HTTP_SKANNING_AVX2) && !satt_http_skanning(HTTP_SKANNING_SSE2)) {
+        satt_http_skanning(HTTP_SKANNING_SKALAR);
+    }
+    return aktuell_niva;
+}
+
+HttpSkanningNiva http_skanning_niva(void) {
+    return aktuell_niva;
+}
+
+const char* http_skanning_namn(HttpSkanningNiva niva) {
+    switch (niva) {
+    case HTTP_SKANNING_AVX2:  return "avx2";
+    case HTTP_SKANNING_SSE2:  return "sse2";
+    default:                  return "skalär";
+    }
+}
+
+size_t http_hitta_huvudslut(const char* data, size_t langd) {
+    return hitta_huvudslut(data, langd);
+}
+
+void http_skanna_rad(const char* data, size_t langd, HttpRadSkanning* rad) {
+    skanna_rad(data, langd, rad);
+}
@@ -0,0 +1,671 @@
+#include "json_skrivare.h"   // Egna deklarationer
+#include <stdio.h>           // För snprintf (bara för mycket stora tal)
+#include <stdlib.h>          // För malloc, realloc och free
+#include <string.h>          // För memcpy, memchr och strlen
+#include <math.h>            // För isfinite och signbit (makron, inget libm)
+
+// Escape-sökningen använder SSE2 där det finns. SSE2 ingår i alla
+// x86-64-processorer, så här behövs ingen nivåväxling som i http_skanning.
+#if defined(__SSE2__)
+#include <emmintrin.h>       // SSE2-intrinsics
+#endif
+
+// ============================================================================
+// BUFFERT
+// ============================================================================
+
+/**
+ * Skapar en skrivare över en befintlig buffert
+ *
+ * @param skrivare - Skrivaren som initieras
+ * @param buffer - Bufferten (får vara NULL om storlek är 0)
+ * @param storlek - Buffertens storlek i bytes, inklusive nullterminatorn
+ */
+void json_skrivare_fast(JsonSkrivare* skrivare, char* buffer, size_t storlek) {
+    skrivare->data = buffer;
+    skrivare->langd = 0;
+    skrivare->kapacitet = buffer ? storlek : 0;
+    skrivare->behov = 0;
+    skrivare->vaxande = false;
+}
+
+/**
+ * Skapar en skrivare med en allokerad buffert som växer vid behov
+ *
+ * @param skrivare - Skrivaren som initieras
+ * @param kapacitet - Startstorlek i bytes
+ * @return true vid framgång, false om minnet inte räcker
+ */
+bool json_skrivare_vaxande(JsonSkrivare* skrivare, size_t kapacitet) {
+    if (kapacitet < 64) {
+        kapacitet = 64;
+    }
+    json_skrivare_fast(skrivare, malloc(kapacitet), kapacitet);
+    skrivare->vaxande = true;
+    return skrivare->data != NULL;
+}
+
+/**
+ * Frigör bufferten i en växande skrivare (en fast lämnas orörd)
+ *
+ * @param skrivare - Skrivaren
+ */
+void json_skrivare_frigor(JsonSkrivare* skrivare) {
+    if (skrivare->vaxande) {
+        free(skrivare->data);
+    }
+    json_skrivare_fast(skrivare, NULL, 0);
+}
+
+/**
+ * Kontrollerar att allt som skrivits fick plats
+ *
+ * @param skrivare - Skrivaren
+ * @return true om utdatan är komplett
+ */
+bool json_skrivare_ok(const JsonSkrivare* skrivare) {
+    return skrivare->behov == skrivare->langd;
+}
+
+/**
+ * Null-terminerar utdatan
+ *
+ * @param skrivare - Skrivaren
+ * @return Antal skrivna bytes (exklusive nullterminatorn)
+ */
+size_t json_avsluta(JsonSkrivare* skrivare) {
+    if (skrivare->kapacitet > 0) {
+        skrivare->data[skrivare->langd] = '\0';
+    }
+    return skrivare->langd;
+}
+
+/**
+ * Utökar en växande skrivares buffert
+ *
+ * @param skrivare - Skrivaren
+ * @param behov - Antal bytes som måste få plats (inklusive nullterminatorn)
+ * @return true om bufferten nu räcker
+ */
+static bool vaxa(JsonSkrivare* skrivare, size_t behov) {
+    if (!skrivare->vaxande) {
+        return false;
+    }
+    size_t ny_kapacitet = skrivare->kapacitet * 2;
+    if (ny_kapacitet < behov) {
+        ny_kapacitet = behov;
+    }
+    char* ny_data = realloc(skrivare->data, ny_kapacitet);
+    if (!ny_data) {
+        return false;
+    }
+    skrivare->data = ny_data;
+    skrivare->kapacitet = ny_kapacitet;
+    return true;
+}
+
+/**
+ * Reserverar plats för nästa del av utdatan
+ *
+ * @param skrivare - Skrivaren
+ * @param n - Antal bytes
+ * @return Var delen ska skrivas, eller NULL om den inte får plats
+ *
+ * Delen räknas i behov även när den inte får plats. Efter första delen
+ * som inte fick plats skrivs ingenting mer, så utdatan slutar aldrig med
+ * en lucka följd av senare delar. En byte hålls alltid fri för
+ * nullterminatorn.
+ */
+static inline char* reservera(JsonSkrivare* skrivare, size_t n) {
+    skrivare->behov += n;
+    if (skrivare->behov != skrivare->langd + n ||
+        (skrivare->langd + n >= skrivare->kapacitet && !vaxa(skrivare, skrivare->langd + n + 1))) {
+        return NULL;
+    }
+    char* plats = skrivare->data + skrivare->langd;
+    skrivare->langd += n;
+    return plats;
+}
+
+/**
+ * Skriver text som den är
+ *
+ * @param skrivare - Skrivaren
+ * @param text - Texten
+ * @param langd - Antal bytes
+ */
+void json_skriv_ra(JsonSkrivare* skrivare, const char* text, size_t langd) {
+    char* plats = reservera(skrivare, langd);
+    if (plats) {
+        memcpy(plats, text, langd);
+    }
+}
+
+// Strängliteral utan att räkna längden vid körning
+#define SKRIV_LITERAL(skrivare, literal) json_skriv_ra((skrivare), (literal), sizeof(literal) - 1)
+
+// ============================================================================
+// STRÄNGAR
+// ============================================================================
+
+// Tecken som måste escapas: styrtecken, '"' och '\\'
+static const bool MASTE_ESCAPAS[256] = {
+    [0x00] = 1, [0x01] = 1, [0x02] = 1, [0x03] = 1, [0x04] = 1, [0x05] = 1, [0x06] = 1, [0x07] = 1,
+    [0x08] = 1, [0x09] = 1, [0x0A] = 1, [0x0B] = 1, [0x0C] = 1, [0x0D] = 1, [0x0E] = 1, [0x0F] = 1,
+    [0x10] = 1, [0x11] = 1, [0x12] = 1, [0x13] = 1, [0x14] = 1, [0x15] = 1, [0x16] = 1, [0x17] = 1,
+    [0x18] = 1, [0x19] = 1, [0x1A] = 1, [0x1B] = 1, [0x1C] = 1, [0x1D] = 1, [0x1E] = 1, [0x1F] = 1,
+    ['"'] = 1, ['\\'] = 1
+};
+
+/**
+ * Hittar nästa tecken som måste escapas: '"', '\\' och styrtecken (< 0x20)
+ *
+ * @param text - Strängen
+ * @param i - Var sökningen börjar
+ * @param langd - Strängens längd
+ * @return Index för tecknet, eller langd om inget finns
+ *
+ * Bytes från 0x80 (UTF-8) skrivs som de är.
+ */
+static size_t hitta_escape(const char* text, size_t i, size_t langd) {
+#if defined(__SSE2__)
+    const __m128i citat = _mm_set1_epi8('"');
+    const __m128i bakstreck = _mm_set1_epi8('\\');
+    const __m128i styr_max = _mm_set1_epi8(0x1F);
+    // Träffar i ett block: '"', '\\' och styrtecken (min(x, 0x1F) == x
+    // gäller precis när x <= 0x1F, osignerat)
+#define ESCAPE_TRAFF(block) \
+    _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8((block), citat), _mm_cmpeq_epi8((block), bakstreck)), \
+                 _mm_cmpeq_epi8(_mm_min_epu8((block), styr_max), (block)))
+    // Långa strängar: 64 bytes per varv med en gemensam kontroll, blocket
+    // med träffen letas sedan upp 16 bytes i taget nedan
+    for (; i + 64 <= langd; i += 64) {
+        const __m128i* p = (const __m128i*)(text + i);
+        __m128i traff = _mm_or_si128(
+            _mm_or_si128(ESCAPE_TRAFF(_mm_loadu_si128(p)), ESCAPE_TRAFF(_mm_loadu_si128(p + 1))),
+            _mm_or_si128(ESCAPE_TRAFF(_mm_loadu_si128(p + 2)), ESCAPE_TRAFF(_mm_loadu_si128(p + 3))));
+        if (_mm_movemask_epi8(traff)) {
+            break;
+        }
+    }
+    for (; i + 16 <= langd; i += 16) {
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(
+            ESCAPE_TRAFF(_mm_loadu_si128((const __m128i*)(text + i))));
+        if (mask) {
+            return i + (size_t)__builtin_ctz(mask);
+        }
+    }
+#undef ESCAPE_TRAFF
+#endif
+    for (; i < langd; i++) {
+        if (MASTE_ESCAPAS[(unsigned char)text[i]]) {
+            return i;
+        }
+    }
+    return langd;
+}
+
+/**
+ * Skriver ett tecken som escape-sekvens
+ *
+ * @param skrivare - Skrivaren
+ * @param c - Tecknet ('"', '\\' eller ett styrtecken)
+ */
+static void skriv_escape(JsonSkrivare* skrivare, unsigned char c) {
+    static const char HEX[] = "0123456789abcdef";
+    char kort = 0;
+    switch (c) {
+    case '"':  kort = '"'; break;
+    case '\\': kort = '\\'; break;
+    case '\b': kort = 'b'; break;
+    case '\f': kort = 'f'; break;
+    case '\n': kort = 'n'; break;
+    case '\r': kort = 'r'; break;
+    case '\t': kort = 't'; break;
+    default: break;
+    }
+    if (kort) {
+        char sekvens[2] = { '\\', kort };
+        json_skriv_ra(skrivare, sekvens, 2);
+    } else {
+        char sekvens[6] = { '\\', 'u', '0', '0', HEX[c >> 4], HEX[c & 0xF] };
+        json_skriv_ra(skrivare, sekvens, 6);
+    }
+}
+
+/**
+ * Skriver en sträng med känd längd inom citattecken
+ *
+ * @param skrivare - Skrivaren
+ * @param text - Strängen
+ * @param langd - Antal bytes
+ *
+ * Sträckor utan specialtecken kopieras i ett stycke, och en sträng utan
+ * några alls (det vanliga) skrivs med en enda reservation.
+ */
+static void skriv_strang_langd(JsonSkrivare* skrivare, const char* text, size_t langd) {
+    size_t j = hitta_escape(text, 0, langd);
+    if (j == langd) {
+        char* plats = reservera(skrivare, langd + 2);
+        if (plats) {
+            plats[0] = '"';
+            memcpy(plats + 1, text, langd);
+            plats[langd + 1] = '"';
+        }
+        return;
+    }
+
+    SKRIV_LITERAL(skrivare, "\"");
+    size_t i = 0;
+    while (i < langd) {
+        if (i > 0) {
+            j = hitta_escape(text, i, langd);
+        }
+        json_skriv_ra(skrivare, text + i, j - i);
+        if (j == langd) {
+            break;
+        }
+        skriv_escape(skrivare, (unsigned char)text[j]);
+        i = j + 1;
+    }
+    SKRIV_LITERAL(skrivare, "\"");
+}
+
+/**
+ * Skriver en sträng inom citattecken, escapad
+ *
+ * @param skrivare - Skrivaren
+ * @param text - Null-terminerad sträng
+ */
+void json_skriv_strang(JsonSkrivare* skrivare, const char* text) {
+    skriv_strang_langd(skrivare, text, strlen(text));
+}
+
+// ============================================================================
+// TAL
+// ============================================================================
+
+/**
+ * Skriver ett positivt heltal, eventuellt med decimalpunkt
+ *
+ * @param skrivare - Skrivaren
+ * @param varde - Talet
+ * @param decimaler - Antal siffror sist som står efter en decimalpunkt (0 = ingen)
+ *
+ * Med decimaler fylls talet ut med nollor så att det finns minst en siffra
+ * före punkten: 5 med två decimaler blir "0.05". Heltalsdelen skrivs två
+ * siffror i taget från en tabell.
+ */
+static void skriv_siffror(JsonSkrivare* skrivare, uint64_t varde, int decimaler) {
+    static const char SIFFERPAR[] =
+        "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+        "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+    char siffror[32];
+    char* p = siffror + sizeof(siffror);
+    if (decimaler > 0) {
+        for (int i = 0; i < decimaler; i++) {
+            *--p = (char)('0' + varde % 10);
+            varde /= 10;
+        }
+        *--p = '.';
+    }
+    while (varde >= 100) {
+        p -= 2;
+        memcpy(p, SIFFERPAR + (varde % 100) * 2, 2);
+        varde /= 100;
+    }
+    if (varde >= 10) {
+        p -= 2;
+        memcpy(p, SIFFERPAR + varde * 2, 2);
+    } else {
+        *--p = (char)('0' + varde);
+    }
+    json_skriv_ra(skrivare, p, (size_t)(siffror + sizeof(siffror) - p));
+}
+
+/**
+ * Skriver ett heltal
+ *
+ * @param skrivare - Skrivaren
+ * @param varde - Talet
+ */
+void json_skriv_heltal(JsonSkrivare* skrivare, int64_t varde) {
+    uint64_t absolut = (uint64_t)varde;
+    if (varde < 0) {
+        SKRIV_LITERAL(skrivare, "-");
+        absolut = 0 - absolut;
+    }
+    skriv_siffror(skrivare, absolut, 0);
+}
+
+/**
+ * Räknar ut avrundningsfelet i en multiplikation (Dekkers metod)
+ *
+ * @param a, b - Faktorerna
+ * @param produkt - a * b avrundat till double
+ * @return fel så att a * b == produkt + fel exakt
+ */
+static double produktfel(double a, double b, double produkt) {
+    const double delare = 134217729.0;     // 2^27 + 1
+    double ta = delare * a, tb = delare * b;
+    double a_hog = ta - (ta - a), a_lag = a - a_hog;
+    double b_hog = tb - (tb - b), b_lag = b - b_hog;
+    return ((a_hog * b_hog - produkt) + a_hog * b_lag + a_lag * b_hog) + a_lag * b_lag;
+}
+
+/**
+ * Skriver ett decimaltal med fast antal decimaler
+ *
+ * @param skrivare - Skrivaren
+ * @param varde - Talet
+ * @param decimaler - Antal decimaler (0-9)
+ *
+ * Resultatet är detsamma som printf("%.*f"): det exakta binära värdet
+ * avrundas, och exakt mitt emellan avrundas till jämn siffra. Talet skalas
+ * med 10^decimaler och felet i den multiplikationen räknas ut exakt, så
+ * avrundningen avgörs utan strängkonvertering. Tal vars skalade värde inte
+ * ryms i 52 bitar (över 4.5e15) går via snprintf.
+ */
+void json_skriv_decimal(JsonSkrivare* skrivare, double varde, int decimaler) {
+    static const double TIOPOTENS[10] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9
+    };
+    if (!isfinite(varde)) {
+        SKRIV_LITERAL(skrivare, "null");
+        return;
+    }
+    if (decimaler < 0) decimaler = 0;
+    if (decimaler > 9) decimaler = 9;
+
+    double absolut = signbit(varde) ? -varde : varde;
+    double skalad = absolut * TIOPOTENS[decimaler];
+    if (skalad >= 4503599627370496.0) {    // 2^52
+        char text[330];
+        int langd = snprintf(text, sizeof(text), "%.*f", decimaler, varde);
+        json_skriv_ra(skrivare, text, langd > 0 ? (size_t)langd : 0);
+        return;
+    }
+
+    // skalad är en multipel av sin ulp (högst 0.5), och felet är högst en
+    // halv ulp - resten avgör alltså avrundningen, utom exakt på 0.5
+    uint64_t heltal = (uint64_t)skalad;
+    double rest = skalad - (double)heltal;
+    if (rest > 0.5 || rest == 0.5) {
+        double fel = produktfel(absolut, TIOPOTENS[decimaler], skalad);
+        if (rest > 0.5 || fel > 0 || (fel == 0 && (heltal & 1))) {
+            heltal++;
+        }
+    }
+
+    // Tecknet skrivs även för -0.0, som printf gör
+    if (signbit(varde)) {
+        SKRIV_LITERAL(skrivare, "-");
+    }
+    skriv_siffror(skrivare, heltal, decimaler);
+}
+
+// ============================================================================
+// VÄDERDATA
+// ============================================================================
+
+// Hur ett fält i VaderData skrivs
+typedef enum {
+    FALT_TEXT,                     // char-array
+    FALT_DECIMAL,                  // float med fast antal decimaler
+    FALT_HELTAL                    // int64_t
+} FaltTyp;
+
+typedef struct {
+    const char* namn;              // Namnet i JSON och i ?fields=
+    const char* nyckel;            // "\"namn\": " (utan blanksteget i kompakt format)
+    size_t nyckel_langd;
+    FaltTyp typ;
+    size_t offset;                 // Position i VaderData
+    size_t storlek;                // Medlemmens storlek (för textfält)
+    int decimaler;
+} VaderFalt;
+
+#define VADER_FALT(namn, typ, medlem, decimaler) \
+    { namn, "\"" namn "\": ", sizeof("\"" namn "\": ") - 1, typ, \
+      offsetof(VaderData, medlem), sizeof(((VaderData*)0)->medlem), decimaler }
+
+// Fälten i den ordning de skrivs (fält i har biten 1 << i i JsonFormat)
+static const VaderFalt VADER_FALTEN[] = {
+    VADER_FALT("stad",          FALT_TEXT,    stad,          0),
+    VADER_FALT("land",          FALT_TEXT,    land,          0),
+    VADER_FALT("temperatur",    FALT_DECIMAL, temperatur,    1),   // Celsius
+    VADER_FALT("luftfuktighet", FALT_DECIMAL, luftfuktighet, 0),   // Procent
+    VADER_FALT("vindhastighet", FALT_DECIMAL, vindhastighet, 1),   // m/s
+    VADER_FALT("lufttryck",     FALT_DECIMAL, lufttryck,     0),   // hPa
+    VADER_FALT("beskrivning",   FALT_TEXT,    beskrivning,   0),
+    VADER_FALT("ikon_id",       FALT_TEXT,    ikon_id,       0),
+    VADER_FALT("tidsstampel",   FALT_HELTAL,  tidsstampel,   0),   // Unix-tid
+};
+#define ANTAL_VADER_FALT (sizeof(VADER_FALTEN) / sizeof(VADER_FALTEN[0]))
+_Static_assert((1u << ANTAL_VADER_FALT) - 1 == JSON_ALLA_FALT, "JSON_ALLA_FALT matchar inte VADER_FALTEN");
+
+/**
+ * Tolkar en kommaseparerad lista med fältnamn
+ *
+ * @param lista - T.ex. "temperatur,lufttryck" (tomma element hoppas över)
+ * @param falt - Här sparas masken med fälten
+ * @return false om listan saknar fält eller har ett okänt namn
+ *
+ * Fälten skrivs alltid i samma ordning, oavsett ordningen i listan.
+ */
+bool json_tolka_falt(const char* lista, uint32_t* falt) {
+    uint32_t mask = 0;
+    const char* p = lista;
+    while (*p) {
+        const char* komma = strchr(p, ',');
+        size_t langd = komma ? (size_t)(komma - p) : strlen(p);
+        if (langd > 0) {
+            size_t i = 0;
+            while (i < ANTAL_VADER_FALT &&
+                   (strncmp(VADER_FALTEN[i].namn, p, langd) != 0 ||
+                    VADER_FALTEN[i].namn[langd] != '\0')) {
+                i++;
+            }
+            if (i == ANTAL_VADER_FALT) {
+                return false;
+            }
+            mask |= 1u << i;
+        }
+        p += langd;
+        if (*p == ',') {
+            p++;
+        }
+    }
+    *falt = mask;
+    return mask != 0;
+}
+
+/**
+ * Avgör om ett format är standardformatet
+ *
+ * @param format - Formatet
+ * @return true om det är indraget och har alla fält
+ */
+bool json_format_ar_standard(const JsonFormat* format) {
+    return !format->kompakt && format->falt == JSON_ALLA_FALT;
+}
+
+/**
+ * Skriver värdet för ett fält
+ *
+ * @param skrivare - Skrivaren
+ * @param data - Väderdatan
+ * @param falt - Fältet
+ */
+static void skriv_falt(JsonSkrivare* skrivare, const VaderData* data, const VaderFalt* falt) {
+    const char* medlem = (const char*)data + falt->offset;
+    switch (falt->typ) {
+    case FALT_TEXT: {
+        // Texten får inte läsas förbi medlemmen om nullterminatorn saknas
+        const char* slut = memchr(medlem, '\0', falt->storlek);
+        skriv_strang_langd(skrivare, medlem, slut ? (size_t)(slut - medlem) : falt->storlek);
+        break;
+    }
+    case FALT_DECIMAL: {
+        float varde;
+        memcpy(&varde, medlem, sizeof(varde));
+        json_skriv_decimal(skrivare, varde, falt->decimaler);
+        break;
+    }
+    case FALT_HELTAL: {
+        int64_t varde;
+        memcpy(&varde, medlem, sizeof(varde));
+        json_skriv_heltal(skrivare, varde);
+        break;
+    }
+    }
+}
+
+/**
+ * Skriver ett väderobjekt
+ *
+ * @param skrivare - Skrivaren
+ * @param data - Väderdatan
+ * @param format - Layout och vilka fält som tas med
+ * @param indrag - Objektets indrag (fälten får två blanksteg till)
+ * @param indrag_langd - Antal tecken i indrag
+ *
+ * Indraget format har ett fält per rad; kompakt format har varken
+ * blanksteg, radbrytningar eller indrag.
+ */
+static void skriv_vader_objekt(JsonSkrivare* skrivare, const VaderData* data,
+                               const JsonFormat* format, const char* indrag,
+                               size_t indrag_langd) {
+    bool kompakt = format->kompakt;
+    if (kompakt) {
+        indrag_langd = 0;
+    }
+    json_skriv_ra(skrivare, indrag, indrag_langd);
+    json_skriv_ra(skrivare, "{\n", kompakt ? 1 : 2);
+    bool forsta = true;
+    for (size_t i = 0; i < ANTAL_VADER_FALT; i++) {
+        if (!(format->falt & (1u << i))) {
+            continue;
+        }
+        if (!forsta) {
+            json_skriv_ra(skrivare, ",\n", kompakt ? 1 : 2);
+        }
+        forsta = false;
+        if (!kompakt) {
+            json_skriv_ra(skrivare, indrag, indrag_langd);
+            SKRIV_LITERAL(skrivare, "  ");
+        }
+        json_skriv_ra(skrivare, VADER_FALTEN[i].nyckel, VADER_FALTEN[i].nyckel_langd - (kompakt ? 1 : 0));
+        skriv_falt(skrivare, data, &VADER_FALTEN[i]);
+    }
+    if (!kompakt) {
+        if (!forsta) {
+            SKRIV_LITERAL(skrivare, "\n");
+        }
+        json_skriv_ra(skrivare, indrag, indrag_langd);
+    }
+    SKRIV_LITERAL(skrivare, "}");
+}
+
+// Standardformatet, när anroparen inte anger något
+static const JsonFormat STANDARDFORMAT = { false, JSON_ALLA_FALT };
+
+/**
+ * Skapar en JSON-representation av väderdata
+ *
+ * @param data - Pekare till VaderData-struktur med väderinfo
+ * @param format - Layout och fält (NULL = indraget med alla fält)
+ * @param json_buffer - Buffert där JSON-strängen ska skapas
+ * @param storlek - Storlek på bufferten i bytes
+ * @return Antal bytes i JSON-strängen, eller 0 om den inte får plats
+ *
+ * Exempel på output:
+ * {
+ *   "stad": "Stockholm",
+ *   "land": "SE",
+ *   "temperatur": 15.5,
+ *   "luftfuktighet": 65,
+ *   "vindhastighet": 3.2,
+ *   "lufttryck": 1013,
+ *   "beskrivning": "lätt regn",
+ *   "ikon_id": "10d",
+ *   "tidsstampel": 1234567890
+ * }
+ *
+ * Kompakt med fälten temperatur och lufttryck:
+ * {"temperatur":15.5,"lufttryck":1013}
+ */
+size_t skapa_vader_json(const VaderData* data, const JsonFormat* format,
+                        char* json_buffer, size_t storlek) {
+    JsonSkrivare skrivare;
+    json_skrivare_fast(&skrivare, json_buffer, storlek);
+    skriv_vader_objekt(&skrivare, data, format ? format : &STANDARDFORMAT, "", 0);
+    size_t langd = json_avsluta(&skrivare);
+    return json_skrivare_ok(&skrivare) ? langd : 0;
+}
+
+/**
+ * Skapar en JSON-representation av prognosdata
+ *
+ * @param prognos - Pekare till VaderPrognos-struktur med prognos för flera dagar
+ * @param format - Layout och fält för varje dag (NULL = indraget med alla fält)
+ * @param json_buffer - Buffert där JSON-strängen ska skapas
+ * @param storlek - Storlek på bufferten i bytes
+ * @return Antal bytes i JSON-strängen, eller 0 om den inte får plats
+ *
+ * Exempel på output:
+ * {
+ *   "antal_dagar": 2,
+ *   "dagar": [
+ *     {
+ *       "stad": "Stockholm",
+ *       ...
+ *     },
+ *     {
+ *       "stad": "Stockholm",
+ *       ...
+ *     }
+ *   ]
+ * }
+ */
+size_t skapa_prognos_json(const VaderPrognos* prognos, const JsonFormat* format,
+                          char* json_buffer, size_t storlek) {
+    if (!format) {
+        format = &STANDARDFORMAT;
+    }
+
+    // antal_dagar kommer från cachefilen - begränsa till arrayens storlek
+    int max_dagar = (int)(sizeof(prognos->dagar) / sizeof(prognos->dagar[0]));
+    int antal = prognos->antal_dagar < 0 ? 0 : prognos->antal_dagar;
+    if (antal > max_dagar) {
+        antal = max_dagar;
+    }
+
+    JsonSkrivare skrivare;
+    json_skrivare_fast(&skrivare, json_buffer, storlek);
+    if (format->kompakt) {
+        SKRIV_LITERAL(&skrivare, "{\"antal_dagar\":");
+        json_skriv_heltal(&skrivare, antal);
+        SKRIV_LITERAL(&skrivare, ",\"dagar\":[");
+    } else {
+        SKRIV_LITERAL(&skrivare, "{\n  \"antal_dagar\": ");
+        json_skriv_heltal(&skrivare, antal);
+        SKRIV_LITERAL(&skrivare, ",\n  \"dagar\": [\n");
+    }
+    for (int i = 0; i < antal; i++) {
+        skriv_vader_objekt(&skrivare, &prognos->dagar[i], format, "    ", 4);
+        if (i + 1 < antal) {
+            json_skriv_ra(&skrivare, ",\n", format->kompakt ? 1 : 2);
+        } else if (!format->kompakt) {
+            SKRIV_LITERAL(&skrivare, "\n");
+        }
+    }
+    if (format->kompakt) {
+        SKRIV_LITERAL(&skrivare, "]}");
+    } else {
+        SKRIV_LITERAL(&skrivare, "  ]\n}");
+    }
+    size_t langd = json_avsluta(&skrivare);
+    return json_skrivare_ok(&skrivare) ? langd : 0;
+}
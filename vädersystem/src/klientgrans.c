@@ -0,0 +1,267 @@
+#define _POSIX_C_SOURCE 200809L  // För clock_gettime
+#include "klientgrans.h"      // Klientgränsens API
+#include "konfiguration.h"    // För KLIENTGRANS_SKARVOR, KLIENTGRANS_PLATSER och KLIENTGRANS_SONDERINGAR
+#include <stdatomic.h>        // Tabellen uppdateras med compare-and-swap
+#include <string.h>           // För memset
+
+#ifdef _WIN32
+#include <windows.h>          // För GetTickCount64
+#else
+#include <time.h>             // För clock_gettime
+#endif
+
+// En hinks tillstånd packas i ett 64-bitars ord så att påfyllning och
+// uttag blir ett enda compare-and-swap: tid för senaste påfyllning i
+// millisekunder (40 bitar, räcker i 34 år) och antal tokens i tusendelar
+// (24 bitar). Med tusendelar blir påfyllningen per millisekund exakt
+// per_sekund, utan division.
+#define TOKEN_BITAR 24
+#define TOKEN_MASK (((uint64_t)1 << TOKEN_BITAR) - 1)
+#define TID_MASK (((uint64_t)1 << 40) - 1)
+#define ETT_TOKEN 1000
+#define MAX_SKUR ((int)(TOKEN_MASK / ETT_TOKEN))
+
+// En plats per klient-IP, på en egen cache-rad
+typedef struct {
+    _Alignas(64) _Atomic uint64_t nyckel;         // IP-adress | 1 << 32, 0 = ledig
+    _Atomic uint64_t hink;                        // Tid och tokens, se ovan
+    _Atomic unsigned long long tillatna;
+    _Atomic unsigned long long begransade;
+} KlientPlats;
+
+static KlientPlats platser[KLIENTGRANS_SKARVOR][KLIENTGRANS_PLATSER];
+
+// Gränser - skrivs en gång vid start, läses av alla trådar
+static uint64_t per_ms = 0;                       // Tusendels tokens per millisekund (= tokens per sekund)
+static uint64_t full_hink = 0;                    // Skur i tusendels tokens
+
+static _Atomic unsigned long long utan_plats = 0;
+
+/**
+ * Hämtar monoton tid i millisekunder
+ *
+ * @return Millisekunder från en godtycklig fast startpunkt
+ */
+static uint64_t monoton_ms(void) {
+#ifdef _WIN32
+    return GetTickCount64();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+#endif
+}
+
+/**
+ * Räknar ut hur många tokens en hink har vid en viss tidpunkt
+ *
+ * @param hink - Packat tillstånd
+ * @param nu - Aktuell tid (redan maskad med TID_MASK)
+ * @param tid - Här sparas tiden som ska lagras (nu, eller hinkens egen
+ *              tid om en annan tråd redan har skrivit en senare)
+ * @return Tokens i tusendelar, högst full_hink
+ */
+static uint64_t fyll_pa(uint64_t hink, uint64_t nu, uint64_t* tid) {
+    // En aldrig använd plats är full. Monoton tid räknas från uppstart, så
+    // påfyllning sedan tid 0 räcker inte alltid till en hel hink.
+    if (hink == 0) {
+        *tid = nu;
+        return full_hink;
+    }
+
+    uint64_t senast = hink >> TOKEN_BITAR;
+    uint64_t tokens = hink & TOKEN_MASK;
+    uint64_t forflutet = (nu - senast) & TID_MASK;
+
+    // Trådar läser klockan vid olika tillfällen, så en annan tråd kan ha
+    // skrivit en tid som ligger någon millisekund efter vår. Flytta inte
+    // tiden bakåt.
+    if (forflutet > TID_MASK / 2) {
+        *tid = senast;
+        return tokens;
+    }
+    *tid = nu;
+
+    if (tokens >= full_hink || forflutet >= (full_hink - tokens) / per_ms + 1) {
+        return full_hink;
+    }
+    return tokens + forflutet * per_ms;
+}
+
+/**
+ * Sätter gränserna och tömmer tabellen
+ *
+ * @param per_sekund - Tokens som fylls på per sekund (0 = ingen begränsning)
+ * @param skur - Största antal tokens en hink rymmer (requests i följd)
+ */
+void konfigurera_klientgrans(int per_sekund, int skur) {
+    if (skur < 1) {
+        skur = 1;
+    }
+    if (skur > MAX_SKUR) {
+        skur = MAX_SKUR;  // Måste få plats i hinkens 24 bitar
+    }
+    per_ms = per_sekund > 0 ? (uint64_t)per_sekund : 0;
+    full_hink = (uint64_t)skur * ETT_TOKEN;
+    memset(platser, 0, sizeof(platser));
+    atomic_store(&utan_plats, 0);
+}
+
+/**
+ * Hittar var en nyckel börjar söka i tabellen
+ *
+ * @param nyckel - Klientens nyckel (IP-adress | 1 << 32)
+ * @param start - Här sparas startplatsen (före modulo KLIENTGRANS_PLATSER)
+ * @return Den del av tabellen som nyckeln hör till
+ */
+static KlientPlats* hitta_skarva(uint64_t nyckel, size_t* start) {
+    uint64_t hash = nyckel * 0x9E3779B97F4A7C15ull;        // Fibonacci-hashning
+    *start = (size_t)(hash >> 32);
+    return platser[(hash >> 58) % KLIENTGRANS_SKARVOR];
+}
+
+/**
+ * Tar ett token för en klient
+ *
+ * @param ip - Klientens IPv4-adress i nätverksordning
+ * @return true om requesten får fortsätta, false om den ska få 429
+ *
+ * Adressen hashas till en del av tabellen och en startplats; därifrån
+ * provas högst KLIENTGRANS_SONDERINGAR platser i följd. Först söks hela
+ * sekvensen efter adressens egen plats, och bara om den saknas tas första
+ * platsen som är ledig eller har en full hink. Annars kunde en granne
+ * längre fram i sekvensen ta över en tidigare plats vars hink blivit full,
+ * få en ny skur och lämna sin gamla, tömda plats kvar. Hittas ingen plats
+ * släpps requesten igenom - under en attack från väldigt många
+ * adresser är det bättre än att neka legitima klienter.
+ */
+bool klientgrans_tillat(uint32_t ip) {
+    // Lokala klienter via Unix-socketen delar ingen hink - en upptagen
+    // sidovagn ska inte kunna stänga ute de andra eller 127.0.0.1 över TCP.
+    // Socketfilens rättigheter avgör vem som får ansluta.
+    if (per_ms == 0 || ip == 0) {
+        return true;
+    }
+
+    uint64_t nyckel = (uint64_t)ip | ((uint64_t)1 << 32);  // Aldrig 0 (ledig plats)
+    size_t start;
+    KlientPlats* skarva = hitta_skarva(nyckel, &start);
+    uint64_t nu = monoton_ms() & TID_MASK;
+
+    // Adressens egen plats, var den än ligger i sekvensen
+    KlientPlats* plats = NULL;
+    for (int i = 0; i < KLIENTGRANS_SONDERINGAR && !plats; i++) {
+        KlientPlats* kandidat = &skarva[(start + (size_t)i) % KLIENTGRANS_PLATSER];
+        if (atomic_load_explicit(&kandidat->nyckel, memory_order_acquire) == nyckel) {
+            plats = kandidat;
+        }
+    }
+
+    // Annars en ledig plats eller en som kan tas över
+    for (int i = 0; i < KLIENTGRANS_SONDERINGAR && !plats; i++) {
+        KlientPlats* kandidat = &skarva[(start + (size_t)i) % KLIENTGRANS_PLATSER];
+        uint64_t agare = atomic_load_explicit(&kandidat->nyckel, memory_order_acquire);
+        if (agare == nyckel) {
+            plats = kandidat;  // En annan tråd tog en plats åt samma adress
+        } else if (agare == 0) {
+            if (atomic_compare_exchange_strong(&kandidat->nyckel, &agare, nyckel) ||
+                agare == nyckel) {
+                plats = kandidat;  // Ny plats, eller en annan tråd tog den åt samma adress
+            }
+        } else {
+            // En full hink beter sig som en ny - platsen kan tas över.
+            // Hinken behålls som den är (den är ju full), bara räknarna
+            // börjar om för den nya adressen.
+            uint64_t tid;
+            uint64_t hink = atomic_load_explicit(&kandidat->hink, memory_order_relaxed);
+            if (fyll_pa(hink, nu, &tid) == full_hink &&
+                atomic_compare_exchange_strong(&kandidat->nyckel, &agare, nyckel)) {
+                atomic_store_explicit(&kandidat->tillatna, 0, memory_order_relaxed);
+                atomic_store_explicit(&kandidat->begransade, 0, memory_order_relaxed);
+                plats = kandidat;
+            }
+        }
+    }
+
+    if (!plats) {
+        atomic_fetch_add_explicit(&utan_plats, 1, memory_order_relaxed);
+        return true;
+    }
+
+    // Fyll på och ta ett token i samma compare-and-swap
+    uint64_t hink = atomic_load_explicit(&plats->hink, memory_order_relaxed);
+    bool tillat;
+    for (;;) {
+        uint64_t tid;
+        uint64_t tokens = fyll_pa(hink, nu, &tid);
+        tillat = tokens >= ETT_TOKEN;
+        if (tillat) {
+            tokens -= ETT_TOKEN;
+        }
+        uint64_t ny = (tid << TOKEN_BITAR) | tokens;
+        if (ny == hink ||
+            atomic_compare_exchange_weak_explicit(&plats->hink, &hink, ny,
+                                                  memory_order_relaxed,
+                                                  memory_order_relaxed)) {
+            break;
+        }
+    }
+
+    atomic_fetch_add_explicit(tillat ? &plats->tillatna : &plats->begransade, 1,
+                              memory_order_relaxed);
+    return tillat;
+}
+
+/**
+ * Kopierar räknarna för de mest aktiva klienterna
+ *
+ * @param ut - Array med plats för max_antal poster
+ * @param max_antal - Största antal poster
+ * @return Antal ifyllda poster, sorterade efter antal requests (flest först)
+ *
+ * Går igenom hela tabellen och behåller de max_antal största med
+ * insättningssortering. Räknarna läses utan lås och kan vara en aning
+ * inaktuella, eller höra till en adress som just tagit över platsen.
+ */
+int hamta_klientgrans_statistik(KlientGransStatistik* ut, int max_antal) {
+    int antal = 0;
+    for (int s = 0; s < KLIENTGRANS_SKARVOR; s++) {
+        for (int p = 0; p < KLIENTGRANS_PLATSER; p++) {
+            KlientPlats* plats = &platser[s][p];
+            uint64_t nyckel = atomic_load_explicit(&plats->nyckel, memory_order_acquire);
+            if (nyckel == 0) {
+                continue;
+            }
+            KlientGransStatistik post;
+            post.ip = (uint32_t)nyckel;
+            post.tillatna = atomic_load_explicit(&plats->tillatna, memory_order_relaxed);
+            post.begransade = atomic_load_explicit(&plats->begransade, memory_order_relaxed);
+            unsigned long long summa = post.tillatna + post.begransade;
+
+            // Hitta postens plats bland de hittills största
+            int i = antal < max_antal ? antal : max_antal;
+            while (i > 0 && ut[i - 1].tillatna + ut[i - 1].begransade < summa) {
+                if (i < max_antal) {
+                    ut[i] = ut[i - 1];
+                }
+                i--;
+            }
+            if (i < max_antal) {
+                ut[i] = post;
+                if (antal < max_antal) {
+                    antal++;
+                }
+            }
+        }
+    }
+    return antal;
+}
+
+/**
+ * Hämtar antal requests som inte kunde begränsas
+ *
+ * @return Requests som släpptes igenom för att tabellen var full
+ */
+unsigned long long klientgrans_utan_plats(void) {
+    return atomic_load_explicit(&utan_plats, memory_order_relaxed);
+}
@@ -0,0 +1,319 @@
+#include "komprimering.h"    // Egna deklarationer
+#include <stdlib.h>          // För malloc och free
+#include <string.h>          // För memcpy
+
+// ============================================================================
+// KONTROLLSUMMOR
+// ============================================================================
+
+/**
+ * CRC-32 (IEEE 802.3, samma som gzip och zlibs crc32())
+ *
+ * @param crc - Tidigare värde (0 för början)
+ * @param data - Data
+ * @param langd - Antal bytes
+ * @return Uppdaterad CRC
+ *
+ * Bit för bit utan tabell - räknas bara när en post läggs i cachen.
+ */
+uint32_t berakna_crc32(uint32_t crc, const void* data, size_t langd) {
+    const uint8_t* p = (const uint8_t*)data;
+    crc = ~crc;
+    for (size_t i = 0; i < langd; i++) {
+        crc ^= p[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+/**
+ * Adler-32 (zlib-formatet)
+ *
+ * @param adler - Tidigare värde (1 för början)
+ * @param data - Data
+ * @param langd - Antal bytes
+ * @return Uppdaterad summa
+ */
+uint32_t berakna_adler32(uint32_t adler, const void* data, size_t langd) {
+    const uint8_t* p = (const uint8_t*)data;
+    uint32_t a = adler & 0xFFFF, b = adler >> 16;
+    for (size_t i = 0; i < langd; i++) {
+        a = (a + p[i]) % 65521;
+        b = (b + a) % 65521;
+    }
+    return (b << 16) | a;
+}
+
+// ============================================================================
+// DEFLATE
+// ============================================================================
+
+#define FONSTER 32768          // Längsta avstånd bakåt
+#define MIN_MATCHNING 3
+#define MAX_MATCHNING 258
+#define HASH_BITAR 12
+#define MAX_KEDJA 64           // Så många tidigare positioner provas per position
+
+// Längdkoder 257-285: baslängd och antal extrabitar
+static const uint16_t LANGD_BAS[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8_t LANGD_EXTRA[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+
+// Avståndskoder 0-29
+static const uint16_t AVSTAND_BAS[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const uint8_t AVSTAND_EXTRA[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+// Skriver bitar med minst signifikanta biten först, som deflate kräver
+typedef struct {
+    uint8_t* ut;
+    size_t storlek;
+    size_t pos;
+    uint32_t bitar;            // Bitar som ännu inte bildar en hel byte
+    int antal;                 // Antal bitar i bitar
+    bool fullt;                // ut räckte inte
+} BitSkrivare;
+
+static void skriv_bitar(BitSkrivare* b, uint32_t varde, int antal) {
+    b->bitar |= varde << b->antal;
+    b->antal += antal;
+    while (b->antal >= 8) {
+        if (b->pos < b->storlek) {
+            b->ut[b->pos++] = (uint8_t)b->bitar;
+        } else {
+            b->fullt = true;
+        }
+        b->bitar >>= 8;
+        b->antal -= 8;
+    }
+}
+
+/**
+ * Skriver en Huffman-kod (lagras med mest signifikanta biten först)
+ */
+static void skriv_kod(BitSkrivare* b, uint32_t kod, int langd) {
+    uint32_t vand = 0;
+    for (int i = 0; i < langd; i++) {
+        vand = (vand << 1) | ((kod >> i) & 1);
+    }
+    skriv_bitar(b, vand, langd);
+}
+
+/**
+ * Skriver en symbol ur alfabetet för tecken och längder med de fasta
+ * koderna (RFC 1951 3.2.6)
+ */
+static void skriv_symbol(BitSkrivare* b, int symbol) {
+    if (symbol < 144) {
+        skriv_kod(b, 0x30 + (uint32_t)symbol, 8);
+    } else if (symbol < 256) {
+        skriv_kod(b, 0x190 + (uint32_t)(symbol - 144), 9);
+    } else if (symbol < 280) {
+        skriv_kod(b, (uint32_t)(symbol - 256), 7);
+    } else {
+        skriv_kod(b, 0xC0 + (uint32_t)(symbol - 280), 8);
+    }
+}
+
+/**
+ * Skriver en bakåtreferens: längdkod, avståndskod och deras extrabitar
+ */
+static void skriv_matchning(BitSkrivare* b, int langd, int avstand) {
+    int kod = 28;
+    while (LANGD_BAS[kod] > langd) {
+        kod--;
+    }
+    skriv_symbol(b, 257 + kod);
+    skriv_bitar(b, (uint32_t)(langd - LANGD_BAS[kod]), LANGD_EXTRA[kod]);
+
+    kod = 29;
+    while (AVSTAND_BAS[kod] > avstand) {
+        kod--;
+    }
+    skriv_kod(b, (uint32_t)kod, 5);
+    skriv_bitar(b, (uint32_t)(avstand - AVSTAND_BAS[kod]), AVSTAND_EXTRA[kod]);
+}
+
+static inline uint32_t hasha_tre(const uint8_t* p) {
+    uint32_t v = ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2];
+    return (v * 2654435761u) >> (32 - HASH_BITAR);
+}
+
+/**
+ * Komprimerar data till en rå deflate-ström (ett block, fasta koder)
+ *
+ * @param data - Indata
+ * @param langd - Antal bytes
+ * @param ut - Mål
+ * @param ut_storlek - Storlek på ut (DEFLATE_MAX_STORLEK(langd) räcker alltid)
+ * @return Strömmens längd, eller 0 om ut är för liten eller malloc misslyckas
+ *
+ * Varje position läggs i en hashtabell över de tre följande bytes, med
+ * en kedja bakåt till tidigare positioner med samma hash. Längsta
+ * matchningen bland de MAX_KEDJA senaste väljs girigt.
+ */
+size_t deflate_komprimera(const void* data, size_t langd, uint8_t* ut, size_t ut_storlek) {
+    const uint8_t* in = (const uint8_t*)data;
+    int32_t* huvud = malloc(sizeof(int32_t) * ((size_t)1 << HASH_BITAR));
+    int32_t* foregaende = malloc(sizeof(int32_t) * (langd > 0 ? langd : 1));
+    if (!huvud || !foregaende || langd > INT32_MAX) {
+        free(huvud);
+        free(foregaende);
+        return 0;
+    }
+    for (size_t i = 0; i < ((size_t)1 << HASH_BITAR); i++) {
+        huvud[i] = -1;
+    }
+
+    BitSkrivare b = { ut, ut_storlek, 0, 0, 0, false };
+    skriv_bitar(&b, 1, 1);     // BFINAL: sista blocket
+    skriv_bitar(&b, 1, 2);     // BTYPE 01: fasta Huffman-koder
+
+    size_t i = 0;
+    while (i < langd && !b.fullt) {
+        int basta_langd = 0, basta_avstand = 0;
+        if (i + MIN_MATCHNING <= langd) {
+            uint32_t h = hasha_tre(in + i);
+            size_t max = langd - i < MAX_MATCHNING ? langd - i : MAX_MATCHNING;
+            int32_t kandidat = huvud[h];
+            for (int steg = 0; steg < MAX_KEDJA && kandidat >= 0 &&
+                               i - (size_t)kandidat <= FONSTER; steg++) {
+                const uint8_t* a = in + kandidat;
+                size_t n = 0;
+                while (n < max && a[n] == in[i + n]) {
+                    n++;
+                }
+                if ((int)n > basta_langd) {
+                    basta_langd = (int)n;
+                    basta_avstand = (int)(i - (size_t)kandidat);
+                    if (n == max) {
+                        break;
+                    }
+                }
+                kandidat = foregaende[kandidat];
+            }
+        }
+
+        size_t steg = 1;
+        if (basta_langd >= MIN_MATCHNING) {
+            skriv_matchning(&b, basta_langd, basta_avstand);
+            steg = (size_t)basta_langd;
+        } else {
+            skriv_symbol(&b, in[i]);
+        }
+        // Alla positioner som passeras läggs i hashtabellen
+        for (size_t slut = i + steg; i < slut; i++) {
+            if (i + MIN_MATCHNING <= langd) {
+                uint32_t h = hasha_tre(in + i);
+                foregaende[i] = huvud[h];
+                huvud[h] = (int32_t)i;
+            }
+        }
+    }
+
+    skriv_symbol(&b, 256);     // Blockets slut
+    if (b.antal > 0) {
+        skriv_bitar(&b, 0, 8 - b.antal);
+    }
+    free(huvud);
+    free(foregaende);
+    return b.fullt ? 0 : b.pos;
+}
+
+// ============================================================================
+// FÖRPACKNING
+// ============================================================================
+
+/**
+ * Komprimerar en body och räknar kontrollsummorna
+ *
+ * @param data - Bodyn
+ * @param langd - Antal bytes
+ * @param tidsstampel - Tidsstämpeln för datan som bodyn byggdes från
+ * @param post - Fylls i
+ * @param ut - Mål för deflate-strömmen
+ * @param ut_storlek - Storlek på ut
+ * @return false om komprimeringen misslyckades eller inte sparar plats
+ */
+bool komprimera_post(const void* data, size_t langd, int64_t tidsstampel,
+                     KomprimeradPost* post, uint8_t* ut, size_t ut_storlek) {
+    size_t deflate_langd = deflate_komprimera(data, langd, ut, ut_storlek);
+    // gzip lägger till 18 bytes huvud och svans
+    if (deflate_langd == 0 || langd > UINT32_MAX ||
+        deflate_langd + KOMPRIMERING_HUVUD_RESERV + KOMPRIMERING_SVANS_RESERV >= langd) {
+        return false;
+    }
+    post->tidsstampel = tidsstampel;
+    post->crc32 = berakna_crc32(0, data, langd);
+    post->adler32 = berakna_adler32(1, data, langd);
+    post->langd = (uint32_t)langd;
+    post->deflate_langd = (uint32_t)deflate_langd;
+    return true;
+}
+
+static void skriv_le32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+/**
+ * Packar en deflate-ström som gzip eller zlib
+ *
+ * @param komprimering - KOMPRIMERING_GZIP eller KOMPRIMERING_DEFLATE
+ * @param post - Strömmens kontrollsummor och längder
+ * @param buffer - Strömmen ligger på buffer + KOMPRIMERING_HUVUD_RESERV och
+ *                 följs av minst KOMPRIMERING_SVANS_RESERV lediga bytes
+ * @param langd - Här sparas bodyns längd
+ * @return Bodyns början i buffer
+ *
+ * Huvud och svans skrivs runt strömmen, så den kopieras aldrig.
+ */
+const uint8_t* komprimering_packa(Komprimering komprimering, const KomprimeradPost* post,
+                                  uint8_t* buffer, size_t* langd) {
+    uint8_t* strom = buffer + KOMPRIMERING_HUVUD_RESERV;
+    uint8_t* svans = strom + post->deflate_langd;
+
+    if (komprimering == KOMPRIMERING_GZIP) {
+        // ID1 ID2 CM=deflate FLG=0 MTIME=0 XFL=0 OS=okänt
+        static const uint8_t GZIP_HUVUD[KOMPRIMERING_HUVUD_RESERV] = {
+            0x1F, 0x8B, 8, 0, 0, 0, 0, 0, 0, 0xFF
+        };
+        memcpy(buffer, GZIP_HUVUD, sizeof(GZIP_HUVUD));
+        skriv_le32(svans, post->crc32);
+        skriv_le32(svans + 4, post->langd);
+        *langd = KOMPRIMERING_HUVUD_RESERV + post->deflate_langd + 8;
+        return buffer;
+    }
+
+    // zlib: CMF=0x78 (deflate, 32K fönster), FLG=0x01 (kontrollbitar), Adler-32 big-endian
+    strom[-2] = 0x78;
+    strom[-1] = 0x01;
+    svans[0] = (uint8_t)(post->adler32 >> 24);
+    svans[1] = (uint8_t)(post->adler32 >> 16);
+    svans[2] = (uint8_t)(post->adler32 >> 8);
+    svans[3] = (uint8_t)post->adler32;
+    *langd = 2 + post->deflate_langd + 4;
+    return strom - 2;
+}
+
+const char* komprimering_namn(Komprimering komprimering) {
+    switch (komprimering) {
+    case KOMPRIMERING_GZIP:    return "gzip";
+    case KOMPRIMERING_DEFLATE: return "deflate";
+    default:                   return "identity";
+    }
+}
@@ -1,3 +1,4 @@
+#define _POSIX_C_SOURCE 200809L  // För localtime_r
 #include "loggning.h"
 #include <stdarg.h>  // För variabla argumentlistor (va_list, va_start, va_end)
 #include <string.h>  // För stränghantering (strrchr, strftime)
@@ -52,11 +53,16 @@ void skriv_logg(LogNiva niva, const char* fil, int rad, const char* format, ...)
 
     // Hämta aktuell systemtid för att tidsstämpla meddelandet
     time_t nu = time(NULL);                      // Hämta nuvarande tid i sekunder sedan 1970
-    struct tm* tid_info = localtime(&nu);        // Konvertera till lokal tid (år, månad, dag, etc)
+    struct tm tid_info;                          // Lokal tid (år, månad, dag, etc)
+#ifdef _WIN32
+    localtime_s(&tid_info, &nu);
+#else
+    localtime_r(&nu, &tid_info);                 // Trådsäker variant - localtime() delar en statisk buffer
+#endif
     char tid_strang[64];                         // Buffer för den formaterade tidssträngen
 
     // Formatera tiden som "YYYY-MM-DD HH:MM:SS" (ex: "2025-12-25 15:30:45")
-    strftime(tid_strang, sizeof(tid_strang), "%Y-%m-%d %H:%M:%S", tid_info);
+    strftime(tid_strang, sizeof(tid_strang), "%Y-%m-%d %H:%M:%S", &tid_info);
 
     // Array med textrepresentationer av loggningsnivåerna
     const char* niva_texter[] = {"DEBUG", "INFO", "VARNING", "FEL"};
@@ -106,6 +112,10 @@ void skriv_logg(LogNiva niva, const char* fil, int rad, const char* format, ...)
  * att stängd fil används av misstag senare.
  */
 void stang_loggning(void) {
+    // Konsolen är fullt buffrad när utdata går till en fil eller pipe
+    fflush(stdout);
+    fflush(stderr);
+
     // Om loggfilen är öppen, stäng den
     if (logg_fil) {
         fclose(logg_fil);              // Stäng filen och skriv ut eventuella buffrade data
@@ -1,16 +1,34 @@
-#define _DEFAULT_SOURCE      // För usleep() på Linux
 #include "tcp_server.h"      // För TCP-serverfunktionalitet
+#include "reaktor.h"         // För den händelsedrivna serverloopen (epoll)
+#include "uring_reaktor.h"   // För att kontrollera stöd för io_uring
+#include "arbetarpool.h"     // För trådpoolen som hanterar requests
 #include "vader_api.h"       // För att hämta väderdata från OpenWeatherMap
 #include "cache.h"           // För att cacha väderdata lokalt
+#include "samordning.h"      // För att slå ihop samtidiga hämtningar av samma stad
+#include "http_klient.h"     // För upstream-anslutningspoolen
+#include "dns_cache.h"       // För DNS-cachen för upstream-värdar
+#include "antagning.h"       // För antagningskontroll vid överlast
+#include "klientgrans.h"     // För begränsning av requests per klient-IP
+#include "overlamning.h"     // För omstart utan avbrott
 #include "loggning.h"        // För loggningssystem
 #include "konfiguration.h"   // För SERVER_PORT och andra konfigurationer
 #include "http_server.h"     // För att parsa och skapa HTTP-meddelanden
+#include "http_skanning.h"   // För SIMD-sökning i HTTP-headers
+#include "http_query.h"      // För att tolka och avkoda query-strängen
+#include "rutter.h"          // För tabellen med endpoints
+#include "komprimering.h"    // För komprimerade bodies i cachen
+#include "json_skrivare.h"   // För JSON-bodies och escapade strängar
 #include <stdio.h>           // För fprintf, snprintf
 #include <string.h>          // För strcmp, strlen
 #include <signal.h>          // För signal-hantering (Ctrl+C)
 #include <stdbool.h>         // För bool, true, false
 #include <stdlib.h>          // För atoi
-#include <unistd.h>          // För usleep (Unix/Linux)
+#include <ctype.h>           // För isalpha och toupper i landskoden
+#include <time.h>            // För time() vid periodisk cache-rensning
+#include <stdatomic.h>       // För trådsäker tidsstämpel för cache-rensning
+#ifdef __linux__
+#include <unistd.h>          // För sysconf (antal kärnor)
+#endif
 
 // Global flagga för att kontrollera serverns huvudloop
 // Sätts till false när användaren trycker Ctrl+C för att stoppa servern
@@ -24,125 +42,27 @@ static volatile bool kors = true;
  *
  * Funktionen anropas när användaren trycker Ctrl+C eller när systemet
  * skickar en SIGTERM-signal. Den sätter kors-flaggan till false vilket
- * gör att huvudloopen avslutas och servern stängs ned på ett snyggt sätt.
+ * gör att huvudloopen avslutas och servern dränerar pågående requests
+ * innan den stängs. Ingen loggning här - stdio är inte signalsäkert och
+ * signalen kan komma mitt i ett annat loggmeddelande.
  */
 void signal_hanterare(int signal) {
     (void)signal;  // Markera parametern som avsiktligt oanvänd för att undvika kompilatorvarningar
-    LOGG_INFO("Mottog stoppSignal, stänger servern...");
     kors = false;  // Detta gör att huvudloopen i main() avslutas
 }
 
 /**
- * Skapar en JSON-representation av väderdata
- *
- * @param data - Pekare till VaderData-struktur med väderinfo
- * @param json_buffer - Buffert där JSON-strängen ska skapas
- * @param storlek - Storlek på bufferten i bytes
+ * Räknar ut hur många bytes snprintf() faktiskt skrev
  *
- * Funktionen formaterar väderdata som en välformad JSON-struktur.
- * Resultatet kan skickas direkt till HTTP-klienter som förstår JSON.
- *
- * Exempel på output:
- * {
- *   "stad": "Stockholm",
- *   "temperatur": 15.5,
- *   "luftfuktighet": 65,
- *   "vindhastighet": 3.2,
- *   "lufttryck": 1013,
- *   "beskrivning": "lätt regn",
- *   "ikon_id": "10d",
- *   "tidsstampel": 1234567890
- * }
+ * @param skrivet - Returvärdet från snprintf()
+ * @param storlek - Storleken som gavs till snprintf()
+ * @return Antal skrivna bytes (exklusive nullterminator), även vid trunkering
  */
-void skapa_vader_json(const VaderData* data, char* json_buffer, size_t storlek) {
-    snprintf(json_buffer, storlek,
-             "{\n"
-             "  \"stad\": \"%s\",\n"                  // Stadens namn som text
-             "  \"land\": \"%s\",\n"                  // Landskod (t.ex. SE, GB, US)
-             "  \"temperatur\": %.1f,\n"              // Temperatur med 1 decimal (Celsius)
-             "  \"luftfuktighet\": %.0f,\n"           // Luftfuktighet utan decimaler (%)
-             "  \"vindhastighet\": %.1f,\n"           // Vindhastighet med 1 decimal (m/s)
-             "  \"lufttryck\": %.0f,\n"               // Lufttryck utan decimaler (hPa)
-             "  \"beskrivning\": \"%s\",\n"           // Textbeskrivning av vädret
-             "  \"ikon_id\": \"%s\",\n"               // Ikon-ID för väderikoner
-             "  \"tidsstampel\": %lld\n"              // Unix-tidsstämpel (sekunder sedan 1970)
-             "}",
-             data->stad,
-             data->land,
-             data->temperatur,
-             data->luftfuktighet,
-             data->vindhastighet,
-             data->lufttryck,
-             data->beskrivning,
-             data->ikon_id,
-             (long long)data->tidsstampel);
-}
-
-/**
- * Skapar en JSON-representation av prognosdata
- *
- * @param prognos - Pekare till VaderPrognos-struktur med prognos för flera dagar
- * @param json_buffer - Buffert där JSON-strängen ska skapas
- * @param storlek - Storlek på bufferten i bytes
- *
- * Funktionen formaterar prognosdata som en JSON-array med objekt för varje dag.
- * Denna struktur gör det enkelt för klienter att iterera genom dagarna.
- *
- * Exempel på output:
- * {
- *   "antal_dagar": 2,
- *   "dagar": [
- *     { "stad": "Stockholm", "temperatur": 15.5, ... },
- *     { "stad": "Stockholm", "temperatur": 16.2, ... }
- *   ]
- * }
- */
-void skapa_prognos_json(const VaderPrognos* prognos, char* json_buffer, size_t storlek) {
-    char* ptr = json_buffer;         // Pekare som flyttas framåt i bufferten när vi skriver
-    size_t kvarvarande = storlek;    // Håller reda på hur mycket plats som finns kvar
-
-    // Skriv början på JSON-objektet med antal dagar
-    int skrivet = snprintf(ptr, kvarvarande,
-                           "{\n"
-                           "  \"antal_dagar\": %d,\n"
-                           "  \"dagar\": [\n",
-                           prognos->antal_dagar);
-    ptr += skrivet;          // Flytta pekaren framåt
-    kvarvarande -= skrivet;  // Minska kvarvarande plats
-
-    // Iterera genom alla dagar i prognosen (max 5 dagar)
-    for (int i = 0; i < prognos->antal_dagar && i < 5; i++) {
-        const VaderData* dag = &prognos->dagar[i];  // Pekare till aktuell dags väderdata
-
-        // Skriv JSON-objekt för denna dag
-        skrivet = snprintf(ptr, kvarvarande,
-                          "    {\n"
-                          "      \"stad\": \"%s\",\n"
-                          "      \"land\": \"%s\",\n"
-                          "      \"temperatur\": %.1f,\n"
-                          "      \"luftfuktighet\": %.0f,\n"
-                          "      \"vindhastighet\": %.1f,\n"
-                          "      \"lufttryck\": %.0f,\n"
-                          "      \"beskrivning\": \"%s\",\n"
-                          "      \"ikon_id\": \"%s\",\n"
-                          "      \"tidsstampel\": %lld\n"
-                          "    }%s\n",                      // Komma efter alla utom sista objektet
-                          dag->stad,
-                          dag->land,
-                          dag->temperatur,
-                          dag->luftfuktighet,
-                          dag->vindhastighet,
-                          dag->lufttryck,
-                          dag->beskrivning,
-                          dag->ikon_id,
-                          (long long)dag->tidsstampel,
-                          (i < prognos->antal_dagar - 1) ? "," : "");  // Komma om inte sista
-        ptr += skrivet;
-        kvarvarande -= skrivet;
-    }
-
-    // Stäng JSON-strukturen (array och objekt)
-    snprintf(ptr, kvarvarande, "  ]\n}");
+static size_t skriven_langd(int skrivet, size_t storlek) {
+    if (skrivet < 0 || storlek == 0) {
+        return 0;
+    }
+    return (size_t)skrivet < storlek ? (size_t)skrivet : storlek - 1;
 }
 
 /**
@@ -152,6 +72,7 @@ void skapa_prognos_json(const VaderPrognos* prognos, char* json_buffer, size_t s
  * @param meddelande - Beskrivande felmeddelande
  * @param json_buffer - Buffert där JSON-felet ska skapas
  * @param storlek - Storlek på bufferten i bytes
+ * @return Antal bytes i JSON-strängen
  *
  * Funktionen skapar ett standardiserat JSON-felmeddelande som kan
  * skickas till klienter när något går fel. Detta gör felhanteringen
@@ -164,212 +85,825 @@ void skapa_prognos_json(const VaderPrognos* prognos, char* json_buffer, size_t s
  *   "meddelande": "Endpoint hittades inte"
  * }
  */
-void skapa_fel_json(int felkod, const char* meddelande, char* json_buffer, size_t storlek) {
-    snprintf(json_buffer, storlek,
+size_t skapa_fel_json(int felkod, const char* meddelande, char* json_buffer, size_t storlek) {
+    int skrivet = snprintf(json_buffer, storlek,
              "{\n"
              "  \"fel\": true,\n"                 // Boolean flagga som indikerar fel
              "  \"felkod\": %d,\n"                 // HTTP-statuskod
              "  \"meddelande\": \"%s\"\n"          // Beskrivande felmeddelande
              "}",
              felkod, meddelande);
+    return skriven_langd(skrivet, storlek);
 }
 
 /**
- * Hanterar en HTTP-klient som anslutit till servern
+ * Komprimerar JSON-bodyn för nyss hämtad data och sparar den i cachen
  *
- * @param klient_socket - Socket-descriptor för klientanslutningen
- * @param api_nyckel - OpenWeatherMap API-nyckel för att hämta väderdata
+ * @param typ - "vader" eller "prognos"
+ * @param stad - Stadens namn
+ * @param landskod - Landskod
+ * @param tidsstampel - Datans tidsstämpel (knyter bodyn till datan)
+ * @param json - Bodyn som den skickas okomprimerad
+ * @param langd - Antal bytes i json
  *
- * Funktionen läser HTTP-förfrågan från klienten, avgör vilken endpoint som
- * efterfrågas (/weather eller /forecast), hämtar data (från cache eller API),
- * och skickar tillbaka ett HTTP-svar med JSON-data.
+ * En body som inte blir mindre sparas inte - den skickas då okomprimerad.
+ * Detsamma gäller en tom body (som inte fick plats när den skapades).
+ */
+static void komprimera_till_cache(const char* typ, const char* stad, const char* landskod,
+                                  int64_t tidsstampel, const char* json, size_t langd) {
+    uint8_t deflate[DEFLATE_MAX_STORLEK(SVAR_BUFFER_STORLEK)];
+    KomprimeradPost post;
+    if (langd > 0 && komprimera_post(json, langd, tidsstampel, &post, deflate, sizeof(deflate))) {
+        skriv_komprimerad_till_cache(stad, landskod, typ, &post, deflate);
+    }
+}
+
+/**
+ * Hämtar aktuellt väder från API:et och sparar det i cachen
  *
- * Flöde:
- * 1. Ta emot HTTP-request från klient
- * 2. Parsa request för att få metod, sökväg och parametrar
- * 3. Kontrollera cache för data
- * 4. Om cache miss, hämta från OpenWeatherMap API
- * 5. Cacha ny data
- * 6. Skicka HTTP-svar med JSON till klient
- * 7. Stäng klientanslutningen
+ * @param stad - Stadens namn
+ * @param landskod - Landskod
+ * @param resultat - VaderData som fylls i
+ * @param kontext - OpenWeatherMap API-nyckel (const char*)
+ * @return true vid framgång, false om API-anropet misslyckades
+ *
+ * Körs av den tråd som leder en samordnad hämtning. Cachen kontrolleras
+ * igen först: en tidigare ledare kan ha fyllt den mellan vår cachemiss och
+ * att vi startade hämtningen.
  */
-void hantera_http_klient(socket_t klient_socket, const char* api_nyckel) {
-    char buffer[BUFFER_STORLEK];  // Buffer för HTTP-request från klient
-    char svar_buffer[8192];        // Buffer för att bygga HTTP-svar
-    char json_buffer[4096];        // Buffer för JSON-data
-
-    // Ta emot HTTP-request från klienten
-    // recv() returnerar antal mottagna bytes, eller <= 0 vid fel/stängd anslutning
-    int mottaget = recv(klient_socket, buffer, sizeof(buffer) - 1, 0);
-    if (mottaget <= 0) {
-        LOGG_VARNING("Mottog ingen data från klient");
-        stang_socket(klient_socket);
-        return;
+static bool hamta_vader_till_cache(const char* stad, const char* landskod,
+                                   void* resultat, void* kontext) {
+    VaderData* vader_data = (VaderData*)resultat;
+    if (las_fran_cache(stad, landskod, vader_data)) {
+        return true;
+    }
+    if (!hamta_aktuellt_vader(stad, landskod, (const char*)kontext, vader_data)) {
+        return false;
     }
-    buffer[mottaget] = '\0';  // Null-terminera för att göra det en giltig C-sträng
+    // Spara i cache för framtida förfrågningar
+    skriv_till_cache(stad, landskod, vader_data);
 
-    // Parsa HTTP-requesten till en strukturerad form
-    HttpRequest request;
-    if (!parsa_http_request(buffer, &request)) {
-        // Om parsningen misslyckas, skicka 400 Bad Request
-        LOGG_VARNING("Ogiltig HTTP-request");
-        skapa_fel_json(400, "Ogiltig HTTP-request", json_buffer, sizeof(json_buffer));
-        skapa_http_response(svar_buffer, sizeof(svar_buffer), 400, json_buffer);
-        send(klient_socket, svar_buffer, (int)strlen(svar_buffer), 0);
-        stang_socket(klient_socket);
-        return;
+    // Komprimera bodyn en gång här i stället för vid varje träff
+    char json[SVAR_BUFFER_STORLEK];
+    size_t langd = skapa_vader_json(vader_data, NULL, json, sizeof(json));
+    komprimera_till_cache("vader", stad, landskod, vader_data->tidsstampel, json, langd);
+    return true;
+}
+
+/**
+ * Hämtar väderprognos från API:et och sparar den i cachen
+ *
+ * @param stad - Stadens namn
+ * @param landskod - Landskod
+ * @param resultat - VaderPrognos som fylls i
+ * @param kontext - OpenWeatherMap API-nyckel (const char*)
+ * @return true vid framgång, false om API-anropet misslyckades
+ */
+static bool hamta_prognos_till_cache(const char* stad, const char* landskod,
+                                     void* resultat, void* kontext) {
+    VaderPrognos* prognos = (VaderPrognos*)resultat;
+    if (las_prognos_fran_cache(stad, landskod, prognos)) {
+        return true;
     }
+    if (hamta_vader_prognos(stad, landskod, (const char*)kontext, prognos) <= 0) {
+        return false;
+    }
+    skriv_prognos_till_cache(stad, landskod, prognos);
+
+    char json[SVAR_BUFFER_STORLEK];
+    size_t langd = skapa_prognos_json(prognos, NULL, json, sizeof(json));
+    komprimera_till_cache("prognos", stad, landskod,
+                          prognos->antal_dagar > 0 ? prognos->dagar[0].tidsstampel : 0,
+                          json, langd);
+    return true;
+}
 
-    // Hantera /weather endpoint - Hämta aktuellt väder
-    if (strcmp(request.sokvag, "/weather") == 0 && request.metod == HTTP_GET) {
-        char stad[64] = {0};        // Buffer för stadens namn
-        char landskod[3] = "SE";    // Standardvärde: Sverige
+/**
+ * Svarar med ett JSON-felmeddelande
+ *
+ * @param svar - Svaret som fylls i
+ * @param felkod - HTTP-statuskod
+ * @param meddelande - Felmeddelandet
+ * @param kropp_buffer - Buffert för bodyn
+ * @param kropp_storlek - Storlek på kropp_buffer
+ */
+static void svara_med_fel(HttpSvar* svar, int felkod, const char* meddelande,
+                          char* kropp_buffer, size_t kropp_storlek) {
+    size_t langd = skapa_fel_json(felkod, meddelande, kropp_buffer, kropp_storlek);
+    skapa_http_svar(svar, felkod, kropp_buffer, langd);
+}
 
-        // Extrahera 'city'-parametern från query-strängen (obligatorisk)
-        if (!hamta_query_parameter(request.query, "city", stad, sizeof(stad))) {
-            skapa_fel_json(400, "Parameter 'city' saknas", json_buffer, sizeof(json_buffer));
-            skapa_http_response(svar_buffer, sizeof(svar_buffer), 400, json_buffer);
-            send(klient_socket, svar_buffer, (int)strlen(svar_buffer), 0);
-            stang_socket(klient_socket);
-            return;
+// Validerare för ett svar med väderdata: ETag och återstående tid i cachen
+typedef struct {
+    char etag[19];                 // Citattecken + 16 hexsiffror + citattecken
+    char etag_komprimerad[28];     // Samma med "-gzip"/"-deflate" (om klienten accepterar det)
+    Komprimering komprimering;     // Vald utifrån Accept-Encoding
+    char cache_control[40];        // "public, max-age=N"
+} SvarsValidering;
+
+/**
+ * Beräknar ETag och Cache-Control för väderdata
+ *
+ * @param typ - "vader" eller "prognos" (samma stad får olika ETags)
+ * @param stad - Stad som i cachenyckeln (avkodad)
+ * @param landskod - Landskod som i cachenyckeln (versaler)
+ * @param tidsstampel - När datan hämtades från OpenWeatherMap
+ * @param format - Bodyns format (?format= och ?fields=)
+ * @param komprimering - Komprimering som klienten accepterar
+ * @param validering - Fylls i
+ *
+ * Datan för en stad ändras bara när den hämtas på nytt, så en stark ETag
+ * över (typ, stad, landskod, tidsstampel) räcker - bodyn behöver inte
+ * byggas för att avgöra om klienten redan har den. En komprimerad body är
+ * en annan representation och får en egen ETag, liksom ett annat format
+ * än standardformatet. Bara standardformatet finns komprimerat i cachen.
+ * max-age är tiden som återstår tills cachen hämtar ny data.
+ */
+static void berakna_validering(const char* typ, const char* stad, const char* landskod,
+                               int64_t tidsstampel, const JsonFormat* format,
+                               Komprimering komprimering, SvarsValidering* validering) {
+    // FNV-1a (64 bitar) över fälten, med '\0' mellan strängarna
+    const char* delar[3] = { typ, stad, landskod };
+    uint64_t h = 14695981039346656037ull;
+    for (int i = 0; i < 3; i++) {
+        for (const char* p = delar[i]; ; p++) {
+            h = (h ^ (unsigned char)*p) * 1099511628211ull;
+            if (*p == '\0') {
+                break;
+            }
         }
+    }
+    for (int i = 0; i < 8; i++) {
+        h = (h ^ (unsigned char)((uint64_t)tidsstampel >> (8 * i))) * 1099511628211ull;
+    }
+    // Standardformatet behåller sina ETags; övriga får formatet inräknat
+    if (!json_format_ar_standard(format)) {
+        h = (h ^ (format->kompakt ? 1u : 0u)) * 1099511628211ull;
+        for (int i = 0; i < 4; i++) {
+            h = (h ^ (unsigned char)(format->falt >> (8 * i))) * 1099511628211ull;
+        }
+        komprimering = KOMPRIMERING_INGEN;
+    }
+    snprintf(validering->etag, sizeof(validering->etag), "\"%016llx\"", (unsigned long long)h);
+    snprintf(validering->etag_komprimerad, sizeof(validering->etag_komprimerad),
+             "\"%016llx-%s\"", (unsigned long long)h, komprimering_namn(komprimering));
+    validering->komprimering = komprimering;
 
-        // Extrahera 'country'-parametern om den finns (valfri, standard SE)
-        hamta_query_parameter(request.query, "country", landskod, sizeof(landskod));
+    long long kvar = CACHE_GILTIGHETSTID - ((long long)time(NULL) - (long long)tidsstampel);
+    if (kvar < 0) kvar = 0;
+    if (kvar > CACHE_GILTIGHETSTID) kvar = CACHE_GILTIGHETSTID;
+    snprintf(validering->cache_control, sizeof(validering->cache_control),
+             "public, max-age=%lld", kvar);
+}
+
+/**
+ * Lägger till ETag, Cache-Control och Vary i ett svar
+ *
+ * @param svar - Svaret
+ * @param validering - Svarets validerare
+ * @param komprimerad - Om bodyn är komprimerad (avgör vilken ETag som skickas)
+ */
+static void lagg_till_validering(HttpSvar* svar, const SvarsValidering* validering,
+                                 bool komprimerad) {
+    const char* etag = komprimerad ? validering->etag_komprimerad : validering->etag;
+    if (!lagg_till_http_header(svar, "ETag", etag) ||
+        !lagg_till_http_header(svar, "Cache-Control", validering->cache_control) ||
+        !lagg_till_http_header(svar, "Vary", "Accept-Encoding")) {
+        LOGG_VARNING("Validerings-headers får inte plats i HTTP_HUVUD_STORLEK");
+    }
+}
+
+/**
+ * Svarar 304 Not Modified om klienten redan har den här versionen
+ *
+ * @param a - Anropet
+ * @param validering - Svarets validerare
+ * @return true om svaret blev 304 (ingen body ska byggas)
+ *
+ * Både den okomprimerade och den komprimerade ETagen godtas - klienten
+ * har en giltig kopia av datan i vilket fall.
+ */
+static bool svara_om_oforandrad(const RuttAnrop* a, const SvarsValidering* validering) {
+    bool komprimerad = false;
+    if (!http_etag_matchar(a->request, validering->etag)) {
+        komprimerad = validering->komprimering != KOMPRIMERING_INGEN &&
+                      http_etag_matchar(a->request, validering->etag_komprimerad);
+        if (!komprimerad) {
+            return false;
+        }
+    }
+    skapa_http_svar(a->svar, 304, "", 0);
+    lagg_till_validering(a->svar, validering, komprimerad);
+    return true;
+}
 
-        LOGG_INFO("HTTP GET /weather?city=%s&country=%s", stad, landskod);
+/**
+ * Svarar med den komprimerade bodyn ur cachen om klienten accepterar den
+ *
+ * @param a - Anropet
+ * @param typ - "vader" eller "prognos"
+ * @param stad - Stad som i cachenyckeln
+ * @param landskod - Landskod som i cachenyckeln
+ * @param tidsstampel - Tidsstämpeln i datan som besvaras
+ * @param validering - Svarets validerare
+ * @return true om svaret blev komprimerat; annars byggs JSON som vanligt
+ *
+ * Deflate-strömmen läses direkt till sin plats i kropp_buffer och får
+ * gzip- eller zlib-huvud runt sig - ingen komprimering per request.
+ */
+static bool svara_komprimerat(const RuttAnrop* a, const char* typ, const char* stad,
+                              const char* landskod, int64_t tidsstampel,
+                              const SvarsValidering* validering) {
+    if (validering->komprimering == KOMPRIMERING_INGEN ||
+        a->kropp_storlek < KOMPRIMERING_HUVUD_RESERV + KOMPRIMERING_SVANS_RESERV) {
+        return false;
+    }
+    uint8_t* buffer = (uint8_t*)a->kropp_buffer;
+    KomprimeradPost post;
+    if (!las_komprimerad_fran_cache(stad, landskod, typ, tidsstampel, &post,
+                                    buffer + KOMPRIMERING_HUVUD_RESERV,
+                                    a->kropp_storlek - KOMPRIMERING_HUVUD_RESERV -
+                                    KOMPRIMERING_SVANS_RESERV)) {
+        return false;
+    }
+    size_t langd;
+    const uint8_t* kropp = komprimering_packa(validering->komprimering, &post, buffer, &langd);
+    skapa_http_svar(a->svar, 200, (const char*)kropp, langd);
+    lagg_till_http_header(a->svar, "Content-Encoding", komprimering_namn(validering->komprimering));
+    lagg_till_validering(a->svar, validering, true);
+    return true;
+}
 
-        VaderData vader_data;
-        bool lyckades = false;
+/**
+ * Läser stad och landskod ur requestens query-sträng
+ *
+ * @param query - Requestens tolkade query-sträng ('city' finns alltid)
+ * @param stad - Här sparas stadens namn (avkodat)
+ * @param stad_storlek - Storlek på stad
+ * @param landskod - Här sparas landskoden med versaler (orörd om den saknas)
+ * @param landskod_storlek - Storlek på landskod
+ * @return NULL om det gick bra, annars ett felmeddelande för ett 400-svar
+ *
+ * Query-strängen är avkodad, så "G%C3%B6teborg", "G%c3%b6teborg" och
+ * "Göteborg" blir samma cachenyckel. Värdena används i cachefilernas namn,
+ * så snedstreck och kontrolltecken nekas.
+ */
+static const char* las_plats(const HttpQuery* query, char* stad, size_t stad_storlek,
+                             char* landskod, size_t landskod_storlek) {
+    query_kopiera(query, "city", stad, stad_storlek);
+    query_kopiera(query, "country", landskod, landskod_storlek);
 
-        // Försök hämta från cache först (snabbare och sparar API-anrop)
-        if (las_fran_cache(stad, landskod, &vader_data)) {
-            lyckades = true;
-            LOGG_INFO("Använder cachad data");
-        } else {
-            // Cache miss - hämta från OpenWeatherMap API
-            if (hamta_aktuellt_vader(stad, landskod, api_nyckel, &vader_data)) {
-                lyckades = true;
-                // Spara i cache för framtida förfrågningar
-                skriv_till_cache(stad, landskod, &vader_data);
-            }
+    for (const unsigned char* p = (const unsigned char*)stad; *p; p++) {
+        if (*p < 0x20 || *p == 0x7F || *p == '/' || *p == '\\') {
+            return "Ogiltigt tecken i 'city'";
+        }
+    }
+    for (char* p = landskod; *p; p++) {
+        if (!isalpha((unsigned char)*p)) {
+            return "Ogiltig parameter 'country'";
         }
+        *p = (char)toupper((unsigned char)*p);  // "se" och "SE" är samma land
+    }
+    return NULL;
+}
 
-        // Skapa HTTP-svar baserat på om vi lyckades hämta data
-        if (lyckades) {
-            // 200 OK med väderdata som JSON
-            skapa_vader_json(&vader_data, json_buffer, sizeof(json_buffer));
-            skapa_http_response(svar_buffer, sizeof(svar_buffer), 200, json_buffer);
-        } else {
-            // 500 Internal Server Error om API-anropet misslyckades
-            skapa_fel_json(500, "Kunde inte hämta väderdata", json_buffer, sizeof(json_buffer));
-            skapa_http_response(svar_buffer, sizeof(svar_buffer), 500, json_buffer);
+/**
+ * Läser bodyns format ur requestens query-sträng
+ *
+ * @param query - Requestens tolkade query-sträng
+ * @param format - Fylls i (standardformatet om parametrarna saknas)
+ * @return NULL om det gick bra, annars ett felmeddelande för ett 400-svar
+ *
+ * format=compact ger JSON utan blanksteg och radbrytningar, och fields är
+ * en kommaseparerad lista med fälten som ska skrivas (t.ex.
+ * "temperatur,lufttryck"). Fälten skrivs i samma ordning som i
+ * standardformatet.
+ */
+static const char* las_format(const HttpQuery* query, JsonFormat* format) {
+    format->kompakt = false;
+    format->falt = JSON_ALLA_FALT;
+
+    const char* varde = query_varde(query, "format");
+    if (varde) {
+        if (strcmp(varde, "compact") == 0) {
+            format->kompakt = true;
+        } else if (strcmp(varde, "pretty") != 0) {
+            return "Ogiltig parameter 'format'";
         }
+    }
+    varde = query_varde(query, "fields");
+    if (varde && !json_tolka_falt(varde, &format->falt)) {
+        return "Ogiltig parameter 'fields'";
+    }
+    return NULL;
+}
 
-        send(klient_socket, svar_buffer, (int)strlen(svar_buffer), 0);
+// ============================================================================
+// ENDPOINTS
+// ============================================================================
+// Varje endpoint är en RuttHanterare i tabellen RUTTER längre ned.
+// Obligatoriska query-parametrar kontrolleras innan hanteraren anropas.
 
-    // Hantera /forecast endpoint - Hämta väderprognos
-    } else if (strcmp(request.sokvag, "/forecast") == 0 && request.metod == HTTP_GET) {
-        char stad[64] = {0};
-        char landskod[3] = "SE";
+// Rutterna i en perfekt hashtabell - byggs i main() innan trådarna startar
+static RuttTabell ruttabell;
 
-        // Extrahera 'city'-parametern (obligatorisk)
-        if (!hamta_query_parameter(request.query, "city", stad, sizeof(stad))) {
-            skapa_fel_json(400, "Parameter 'city' saknas", json_buffer, sizeof(json_buffer));
-            skapa_http_response(svar_buffer, sizeof(svar_buffer), 400, json_buffer);
-            send(klient_socket, svar_buffer, (int)strlen(svar_buffer), 0);
-            stang_socket(klient_socket);
+/**
+ * GET /weather - Aktuellt väder för en stad
+ */
+static void hantera_vader(const RuttAnrop* a) {
+    const char* api_nyckel = (const char*)a->kontext;
+    char stad[64] = {0};        // Buffer för stadens namn
+    char landskod[3] = "SE";    // Standardvärde: Sverige
+    size_t langd;
+
+    // 'city' är obligatorisk (kontrollerad av registret), 'country',
+    // 'format' och 'fields' valfria
+    JsonFormat format;
+    const char* fel = las_plats(a->query, stad, sizeof(stad), landskod, sizeof(landskod));
+    if (!fel) {
+        fel = las_format(a->query, &format);
+    }
+    if (fel) {
+        svara_med_fel(a->svar, 400, fel, a->kropp_buffer, a->kropp_storlek);
+        return;
+    }
+
+    LOGG_DEBUG("HTTP GET /weather?city=%s&country=%s", stad, landskod);
+
+    VaderData vader_data;
+    bool lyckades = false;
+
+    // Försök hämta från cache först (snabbare och sparar API-anrop)
+    if (las_fran_cache(stad, landskod, &vader_data)) {
+        lyckades = true;
+        LOGG_DEBUG("Använder cachad data");
+    } else if (antagning_borja_upstream()) {
+        // Cache miss - hämta från OpenWeatherMap API, eller vänta in en
+        // hämtning av samma stad som en annan tråd redan har startat
+        lyckades = samordnad_hamtning("vader", stad, landskod,
+                                      &vader_data, sizeof(vader_data),
+                                      hamta_vader_till_cache, (void*)api_nyckel);
+        antagning_slapp_upstream();
+    } else {
+        // Alla upstream-platser är upptagna - övriga arbetare är
+        // reserverade för requests som kan besvaras från cachen
+        skapa_http_overlast(a->svar);
+        return;
+    }
+
+    // Skapa HTTP-svar baserat på om vi lyckades hämta data
+    if (lyckades) {
+        // 304 om klienten redan har datan - innan någon JSON byggs
+        SvarsValidering validering;
+        berakna_validering("vader", stad, landskod, vader_data.tidsstampel, &format,
+                           http_valj_komprimering(a->request), &validering);
+        if (svara_om_oforandrad(a, &validering) ||
+            svara_komprimerat(a, "vader", stad, landskod, vader_data.tidsstampel, &validering)) {
             return;
         }
+        // 200 OK med väderdata som JSON
+        langd = skapa_vader_json(&vader_data, &format, a->kropp_buffer, a->kropp_storlek);
+        if (langd == 0) {
+            svara_med_fel(a->svar, 500, "Svaret blev för stort", a->kropp_buffer, a->kropp_storlek);
+            return;
+        }
+        skapa_http_svar(a->svar, 200, a->kropp_buffer, langd);
+        lagg_till_validering(a->svar, &validering, false);
+    } else {
+        // 500 Internal Server Error om API-anropet misslyckades
+        svara_med_fel(a->svar, 500, "Kunde inte hämta väderdata", a->kropp_buffer, a->kropp_storlek);
+    }
+}
 
-        // Extrahera 'country'-parametern (valfri)
-        hamta_query_parameter(request.query, "country", landskod, sizeof(landskod));
+/**
+ * GET /forecast - 5-dagarsprognos för en stad
+ */
+static void hantera_prognos(const RuttAnrop* a) {
+    const char* api_nyckel = (const char*)a->kontext;
+    char stad[64] = {0};
+    char landskod[3] = "SE";
 
-        LOGG_INFO("HTTP GET /forecast?city=%s&country=%s", stad, landskod);
+    // Som för /weather
+    JsonFormat format;
+    const char* fel = las_plats(a->query, stad, sizeof(stad), landskod, sizeof(landskod));
+    if (!fel) {
+        fel = las_format(a->query, &format);
+    }
+    if (fel) {
+        svara_med_fel(a->svar, 400, fel, a->kropp_buffer, a->kropp_storlek);
+        return;
+    }
 
-        VaderPrognos prognos;
-        bool lyckades = false;
+    LOGG_DEBUG("HTTP GET /forecast?city=%s&country=%s", stad, landskod);
 
-        // Försök cache först
-        if (las_prognos_fran_cache(stad, landskod, &prognos)) {
-            lyckades = true;
-        } else {
-            // Cache miss - hämta från API
-            if (hamta_vader_prognos(stad, landskod, api_nyckel, &prognos) > 0) {
-                lyckades = true;
-                skriv_prognos_till_cache(stad, landskod, &prognos);
-            }
+    VaderPrognos prognos;
+    bool lyckades = false;
+
+    // Försök cache först
+    if (las_prognos_fran_cache(stad, landskod, &prognos)) {
+        lyckades = true;
+    } else if (antagning_borja_upstream()) {
+        // Cache miss - hämta från API (samordnat med andra trådar)
+        lyckades = samordnad_hamtning("prognos", stad, landskod,
+                                      &prognos, sizeof(prognos),
+                                      hamta_prognos_till_cache, (void*)api_nyckel);
+        antagning_slapp_upstream();
+    } else {
+        skapa_http_overlast(a->svar);  // Som för /weather
+        return;
+    }
+
+    // Skapa HTTP-svar
+    if (lyckades) {
+        // Första dagens tidsstämpel är när prognosen hämtades
+        int64_t tidsstampel = prognos.antal_dagar > 0 ? prognos.dagar[0].tidsstampel : 0;
+        SvarsValidering validering;
+        berakna_validering("prognos", stad, landskod, tidsstampel, &format,
+                           http_valj_komprimering(a->request), &validering);
+        if (svara_om_oforandrad(a, &validering) ||
+            svara_komprimerat(a, "prognos", stad, landskod, tidsstampel, &validering)) {
+            return;
+        }
+        size_t langd = skapa_prognos_json(&prognos, &format, a->kropp_buffer, a->kropp_storlek);
+        if (langd == 0) {
+            svara_med_fel(a->svar, 500, "Svaret blev för stort", a->kropp_buffer, a->kropp_storlek);
+            return;
         }
+        skapa_http_svar(a->svar, 200, a->kropp_buffer, langd);
+        lagg_till_validering(a->svar, &validering, false);
+    } else {
+        svara_med_fel(a->svar, 500, "Kunde inte hämta prognos", a->kropp_buffer, a->kropp_storlek);
+    }
+}
 
-        // Skapa HTTP-svar
-        if (lyckades) {
-            skapa_prognos_json(&prognos, json_buffer, sizeof(json_buffer));
-            skapa_http_response(svar_buffer, sizeof(svar_buffer), 200, json_buffer);
-        } else {
-            skapa_fel_json(500, "Kunde inte hämta prognos", json_buffer, sizeof(json_buffer));
-            skapa_http_response(svar_buffer, sizeof(svar_buffer), 500, json_buffer);
+/**
+ * GET /statistik - Räknare per reaktortråd, upstream, DNS och antagning
+ */
+static void hantera_statistik(const RuttAnrop* a) {
+    LOGG_DEBUG("HTTP GET /statistik");
+    size_t langd;
+
+    ReaktorStatistik statistik[MAX_REAKTORER];
+    int antal = hamta_reaktor_statistik(statistik, MAX_REAKTORER);
+
+    // Bygg en post per reaktor så att fördelningen mellan dem syns direkt
+    size_t pos = skriven_langd(snprintf(a->kropp_buffer, a->kropp_storlek,
+                                        "{\n  \"reaktorer\": ["), a->kropp_storlek);
+    for (int i = 0; i < antal; i++) {
+        pos += skriven_langd(snprintf(a->kropp_buffer + pos, a->kropp_storlek - pos,
+                                "%s\n    {\"id\": %d, \"anslutningar\": %llu, "
+                                "\"requests\": %llu, \"oppna\": %ld}",
+                                i > 0 ? "," : "", i, statistik[i].anslutningar,
+                                statistik[i].requests, statistik[i].oppna),
+                             a->kropp_storlek - pos);
+    }
+    // Upstream-hämtningar, hur många som slogs ihop med en pågående
+    // och hur många som slapp en ny TCP-anslutning
+    SamordningsStatistik samordning;
+    HttpKlientStatistik klient;
+    DnsStatistik dns;
+    AntagningsStatistik antagning;
+    hamta_samordnings_statistik(&samordning);
+    hamta_http_klient_statistik(&klient);
+    hamta_dns_statistik(&dns);
+    hamta_antagnings_statistik(&antagning);
+    langd = pos + skriven_langd(snprintf(a->kropp_buffer + pos, a->kropp_storlek - pos,
+                                         "\n  ],\n"
+                                         "  \"upstream\": {\"hamtningar\": %llu, "
+                                         "\"samordnade\": %llu, \"pagaende\": %llu, "
+                                         "\"nya_anslutningar\": %llu, "
+                                         "\"ateranvanda_anslutningar\": %llu},\n"
+                                         "  \"dns\": {\"traffar\": %llu, "
+                                         "\"uppslagningar\": %llu, \"misslyckade\": %llu},\n"
+                                         "  \"antagning\": {\"avvisade_ko\": %llu, "
+                                         "\"avvisade_kotid\": %llu, \"avvisade_upstream\": %llu, "
+                                         "\"upstream_pagaende\": %llu}\n}",
+                                         samordning.hamtningar, samordning.samordnade,
+                                         samordning.pagaende, klient.nya_anslutningar,
+                                         klient.ateranvanda, dns.traffar,
+                                         dns.uppslagningar, dns.misslyckade,
+                                         antagning.avvisade_ko, antagning.avvisade_kotid,
+                                         antagning.avvisade_upstream,
+                                         antagning.upstream_pagaende),
+                                a->kropp_storlek - pos);
+    skapa_http_svar(a->svar, 200, a->kropp_buffer, langd);
+}
+
+/**
+ * GET /statistik/klienter - Räknare per klient-IP för klientgränsen
+ */
+static void hantera_klientstatistik(const RuttAnrop* a) {
+    LOGG_DEBUG("HTTP GET /statistik/klienter");
+    size_t langd;
+
+    // De 50 klienter som gjort flest requests (ryms med god marginal i bodyn)
+    KlientGransStatistik klienter[50];
+    int antal = hamta_klientgrans_statistik(klienter, 50);
+
+    size_t pos = skriven_langd(snprintf(a->kropp_buffer, a->kropp_storlek,
+                                        "{\n  \"klienter\": ["), a->kropp_storlek);
+    for (int i = 0; i < antal; i++) {
+        struct in_addr adress;
+        char ip[INET_ADDRSTRLEN];
+        adress.s_addr = klienter[i].ip;
+        inet_ntop(AF_INET, &adress, ip, sizeof(ip));
+        pos += skriven_langd(snprintf(a->kropp_buffer + pos, a->kropp_storlek - pos,
+                                "%s\n    {\"ip\": \"%s\", \"tillatna\": %llu, "
+                                "\"begransade\": %llu}",
+                                i > 0 ? "," : "", ip, klienter[i].tillatna,
+                                klienter[i].begransade),
+                             a->kropp_storlek - pos);
+    }
+    // Requests från adresser som inte fick plats i tabellen (släpps igenom)
+    langd = pos + skriven_langd(snprintf(a->kropp_buffer + pos, a->kropp_storlek - pos,
+                                         "\n  ],\n  \"utan_plats\": %llu\n}",
+                                         klientgrans_utan_plats()),
+                                a->kropp_storlek - pos);
+    skapa_http_svar(a->svar, 200, a->kropp_buffer, langd);
+}
+
+/**
+ * GET / - API-dokumentation, byggd från rutt-tabellen
+ */
+static void hantera_rot(const RuttAnrop* a) {
+    LOGG_DEBUG("HTTP GET / (API-dokumentation)");
+
+    size_t pos = skriven_langd(snprintf(a->kropp_buffer, a->kropp_storlek,
+                     "{\n"
+                     "  \"service\": \"Vädersystem API\",\n"
+                     "  \"version\": \"1.0.0\",\n"
+                     "  \"beskrivning\": \"HTTP/JSON väder-API med OpenWeatherMap integration\",\n"
+                     "  \"endpoints\": ["), a->kropp_storlek);
+    for (int i = 0; i < ruttabell.antal; i++) {
+        const Rutt* rutt = &ruttabell.rutter[i];
+        pos += skriven_langd(snprintf(a->kropp_buffer + pos, a->kropp_storlek - pos,
+                                      "%s\n    {\n"
+                                      "      \"metod\": \"%s\",\n"
+                                      "      \"sokvag\": \"%s\",\n",
+                                      i > 0 ? "," : "", http_metod_namn(rutt->metod),
+                                      rutt->sokvag),
+                             a->kropp_storlek - pos);
+        if (rutt->parametrar) {
+            pos += skriven_langd(snprintf(a->kropp_buffer + pos, a->kropp_storlek - pos,
+                                          "      \"parametrar\": \"%s\",\n", rutt->parametrar),
+                                 a->kropp_storlek - pos);
+        }
+        if (rutt->exempel) {
+            pos += skriven_langd(snprintf(a->kropp_buffer + pos, a->kropp_storlek - pos,
+                                          "      \"exempel\": \"%s\",\n", rutt->exempel),
+                                 a->kropp_storlek - pos);
         }
+        pos += skriven_langd(snprintf(a->kropp_buffer + pos, a->kropp_storlek - pos,
+                                      "      \"beskrivning\": \"%s\"\n    }", rutt->beskrivning),
+                             a->kropp_storlek - pos);
+    }
+    size_t langd = pos + skriven_langd(snprintf(a->kropp_buffer + pos, a->kropp_storlek - pos,
+                     "\n  ],\n"
+                     "  \"cache\": \"30 minuter TTL\",\n"
+                     "  \"landskoder\": \"ISO 3166-1 alpha-2 (SE, GB, US, FR, etc.)\"\n"
+                     "}"), a->kropp_storlek - pos);
+    skapa_http_svar(a->svar, 200, a->kropp_buffer, langd);
+}
 
-        send(klient_socket, svar_buffer, (int)strlen(svar_buffer), 0);
-
-    // Hantera root endpoint (/) - Visa API-dokumentation
-    } else if (strcmp(request.sokvag, "/") == 0 && request.metod == HTTP_GET) {
-        LOGG_INFO("HTTP GET / (API-dokumentation)");
-
-        // Skapa ett välkomstmeddelande med tillgängliga endpoints
-        snprintf(json_buffer, sizeof(json_buffer),
-                 "{\n"
-                 "  \"service\": \"Vädersystem API\",\n"
-                 "  \"version\": \"1.0.0\",\n"
-                 "  \"beskrivning\": \"HTTP/JSON väder-API med OpenWeatherMap integration\",\n"
-                 "  \"endpoints\": [\n"
-                 "    {\n"
-                 "      \"metod\": \"GET\",\n"
-                 "      \"sokvag\": \"/weather\",\n"
-                 "      \"parametrar\": \"city (obligatorisk), country (valfri, standard: SE)\",\n"
-                 "      \"exempel\": \"/weather?city=Stockholm&country=SE\",\n"
-                 "      \"beskrivning\": \"Hämta aktuellt väder för en stad\"\n"
-                 "    },\n"
-                 "    {\n"
-                 "      \"metod\": \"GET\",\n"
-                 "      \"sokvag\": \"/forecast\",\n"
-                 "      \"parametrar\": \"city (obligatorisk), country (valfri, standard: SE)\",\n"
-                 "      \"exempel\": \"/forecast?city=Stockholm&country=SE\",\n"
-                 "      \"beskrivning\": \"Hämta 5-dagars väderprognos för en stad\"\n"
-                 "    }\n"
-                 "  ],\n"
-                 "  \"cache\": \"30 minuter TTL\",\n"
-                 "  \"landskoder\": \"ISO 3166-1 alpha-2 (SE, GB, US, FR, etc.)\"\n"
-                 "}");
-
-        skapa_http_response(svar_buffer, sizeof(svar_buffer), 200, json_buffer);
-        send(klient_socket, svar_buffer, (int)strlen(svar_buffer), 0);
+// Alla endpoints. En ny endpoint läggs till här (och i README) - dispatch,
+// kontroll av obligatoriska parametrar, API-dokumentationen på / och
+// listan i 404-svaret följer med automatiskt.
+static const Rutt RUTTER[] = {
+    { HTTP_GET, "/", hantera_rot, { NULL }, NULL, NULL,
+      "API-dokumentation (den här listan)" },
+    { HTTP_GET, "/weather", hantera_vader, { "city" },
+      "city (obligatorisk), country (valfri, standard: SE), format (valfri: compact), "
+      "fields (valfri, t.ex. temperatur,lufttryck)",
+      "/weather?city=Stockholm&country=SE",
+      "Hämta aktuellt väder för en stad" },
+    { HTTP_GET, "/forecast", hantera_prognos, { "city" },
+      "city (obligatorisk), country (valfri, standard: SE), format (valfri: compact), "
+      "fields (valfri, t.ex. temperatur,lufttryck)",
+      "/forecast?city=Stockholm&country=SE",
+      "Hämta 5-dagars väderprognos för en stad" },
+    { HTTP_GET, "/statistik", hantera_statistik, { NULL }, NULL, NULL,
+      "Anslutningar och requests per reaktortråd" },
+    { HTTP_GET, "/statistik/klienter", hantera_klientstatistik, { NULL }, NULL, NULL,
+      "Tillåtna och begränsade requests per klient-IP" },
+};
 
-    } else {
+/**
+ * Svarar 404 med en lista över tillgängliga endpoints
+ *
+ * @param request - Requesten som inte matchade någon rutt
+ * @param kropp_buffer - Buffert för bodyn
+ * @param kropp_storlek - Storlek på kropp_buffer
+ * @param svar - Svaret som fylls i
+ */
+static void svara_okand_endpoint(const HttpRequestVy* request, char* kropp_buffer,
+                                 size_t kropp_storlek, HttpSvar* svar) {
+    // Sökvägen kommer oförändrad från klienten och kan vara lika lång som
+    // mottagningsbufferten: den kortas av och escapas som en JSON-sträng
+    // innan den hamnar i loggen eller i bodyn
+    char sokvag[MAX_VISAD_SOKVAG + 1];
+    size_t sokvag_langd = request->sokvag.langd < MAX_VISAD_SOKVAG ? request->sokvag.langd
+                                                                   : MAX_VISAD_SOKVAG;
+    memcpy(sokvag, request->sokvag.data, sokvag_langd);
+    sokvag[sokvag_langd] = '\0';
+
+    char citerad[MAX_VISAD_SOKVAG * 6 + 3];  // Varje byte blir högst "\u00XX", plus citattecken
+    JsonSkrivare skrivare;
+    json_skrivare_fast(&skrivare, citerad, sizeof(citerad));
+    json_skriv_strang(&skrivare, sokvag);
+    size_t citerad_langd = json_avsluta(&skrivare);
+
+    // DEBUG, inte VARNING: 404 styrs helt av klienten, så en sökvägsskanner
+    // skulle annars kunna fylla loggen med en rad per request
+    LOGG_DEBUG("Okänd endpoint: %s", citerad);
+
+    // Ge användaren en hint om tillgängliga endpoints
+    size_t pos = skriven_langd(snprintf(kropp_buffer, kropp_storlek,
+                     "{\n"
+                     "  \"fel\": true,\n"
+                     "  \"felkod\": 404,\n"
+                     "  \"meddelande\": \"Endpoint hittades inte: %.*s\",\n"
+                     "  \"tillgangliga_endpoints\": [",
+                     (int)citerad_langd - 2, citerad + 1), kropp_storlek);  // Utan citattecknen
+    for (int i = 0; i < ruttabell.antal; i++) {
+        const Rutt* rutt = &ruttabell.rutter[i];
+        pos += skriven_langd(snprintf(kropp_buffer + pos, kropp_storlek - pos,
+                                      "%s\n    \"%s %s\"", i > 0 ? "," : "",
+                                      http_metod_namn(rutt->metod),
+                                      rutt->exempel ? rutt->exempel : rutt->sokvag),
+                             kropp_storlek - pos);
+    }
+    size_t langd = pos + skriven_langd(snprintf(kropp_buffer + pos, kropp_storlek - pos,
+                                                "\n  ]\n}"), kropp_storlek - pos);
+    skapa_http_svar(svar, 404, kropp_buffer, langd);
+}
+
+/**
+ * Bygger HTTP-svaret för en komplett HTTP-request
+ *
+ * @param radata - Den mottagna requesten (pekar in i mottagningsbufferten)
+ * @param radata_langd - Requestens längd i bytes (radata är inte nollterminerad)
+ * @param kropp_buffer - Buffert där svarets JSON-body byggs
+ * @param kropp_storlek - Storlek på kropp_buffer i bytes
+ * @param svar - Fylls i med headers och pekare till bodyn. svar->hall_vid_liv
+ *               är in: om anslutningen får hållas öppen, ut: om den ska det
+ * @param kontext - OpenWeatherMap API-nyckel (const char*)
+ *
+ * Funktionen slår upp endpointen i rutt-tabellen, kontrollerar dess
+ * obligatoriska parametrar och anropar dess hanterare. Den gör ingen
+ * socket-I/O själv, så den kan anropas både från reaktorn och från den
+ * blockerande loopen.
+ *
+ * Flöde:
+ * 1. Parsa request för att få metod, sökväg och parametrar
+ * 2. Slå upp (metod, sökväg) i den perfekta hashtabellen
+ * 3. Tolka query-strängen och kontrollera obligatoriska parametrar
+ * 4. Hanteraren hämtar data (cache eller API) och bygger svaret
+ */
+static void hantera_http_request(const char* radata, size_t radata_langd,
+                                 char* kropp_buffer, size_t kropp_storlek,
+                                 HttpSvar* svar, void* kontext) {
+    // Parsa HTTP-requesten till vyer in i mottagningsbufferten (ingen kopiering)
+    HttpRequestVy request;
+    if (!parsa_http_request_vy(radata, radata_langd, &request)) {
+        // Om parsningen misslyckas, skicka 400 Bad Request
+        LOGG_VARNING("Ogiltig HTTP-request");
+        svar->hall_vid_liv = false;  // Okänt var nästa request börjar - stäng
+        svara_med_fel(svar, 400, "Ogiltig HTTP-request", kropp_buffer, kropp_storlek);
+        return;
+    }
+
+    // Behåll anslutningen bara om både reaktorn och klienten vill det
+    svar->hall_vid_liv = svar->hall_vid_liv && request.hall_vid_liv;
+
+    const Rutt* rutt = hitta_rutt(&ruttabell, request.metod, request.sokvag);
+    if (!rutt) {
         // Okänd endpoint eller metod - skicka 404 Not Found med hjälpsam information
-        LOGG_VARNING("Okänd endpoint: %s", request.sokvag);
-
-        // Ge användaren en hint om tillgängliga endpoints
-        snprintf(json_buffer, sizeof(json_buffer),
-                 "{\n"
-                 "  \"fel\": true,\n"
-                 "  \"felkod\": 404,\n"
-                 "  \"meddelande\": \"Endpoint hittades inte: %s\",\n"
-                 "  \"tillgangliga_endpoints\": [\n"
-                 "    \"GET /\",\n"
-                 "    \"GET /weather?city=STAD&country=LANDSKOD\",\n"
-                 "    \"GET /forecast?city=STAD&country=LANDSKOD\"\n"
-                 "  ]\n"
-                 "}",
-                 request.sokvag);
-
-        skapa_http_response(svar_buffer, sizeof(svar_buffer), 404, json_buffer);
-        send(klient_socket, svar_buffer, (int)strlen(svar_buffer), 0);
+        svara_okand_endpoint(&request, kropp_buffer, kropp_storlek, svar);
+        return;
+    }
+
+    // Query-strängen tolkas en gång här, och hanteraren slår upp i tabellen
+    HttpQuery query;
+    if (!tolka_query(request.query, &query)) {
+        svara_med_fel(svar, 400, "Ogiltig query-sträng", kropp_buffer, kropp_storlek);
+        return;
+    }
+    const char* saknad = saknad_parameter(rutt, &query);
+    if (saknad) {
+        char meddelande[64];
+        snprintf(meddelande, sizeof(meddelande),
+                 query_varde(&query, saknad) ? "Parameter '%s' får inte vara tom"
+                                             : "Parameter '%s' saknas", saknad);
+        svara_med_fel(svar, 400, meddelande, kropp_buffer, kropp_storlek);
+        return;
+    }
+
+    RuttAnrop anrop = { &request, &query, kropp_buffer, kropp_storlek, svar, kontext };
+    rutt->hanterare(&anrop);
+
+    // Rensa gammal cache högst en gång per minut för att hålla cache-katalogen fräsch
+    // (tidsbaserat i stället för var 10:e klient, så att katalogen inte
+    // skannas hundratals gånger per sekund under hög last). Compare-and-swap
+    // gör att bara en arbetartråd åt gången gör rensningen.
+    static _Atomic long long senaste_rensning = 0;
+    long long nu = (long long)time(NULL);
+    long long forra = atomic_load(&senaste_rensning);
+    if (nu - forra >= 60 && atomic_compare_exchange_strong(&senaste_rensning, &forra, nu)) {
+        rensa_gammal_cache();
+    }
+}
+
+#ifndef __linux__
+/**
+ * Hanterar en HTTP-klient med blockerande I/O
+ *
+ * @param klient_socket - Socket-descriptor för klientanslutningen
+ * @param klient_ip - Klientens IPv4-adress (nätverksordning) för klientgränsen
+ * @param api_nyckel - OpenWeatherMap API-nyckel för att hämta väderdata
+ *
+ * Används på plattformar utan epoll. Tar emot en hel request (även om den
+ * kommer i flera TCP-segment), bygger svaret med hantera_http_request()
+ * och stänger anslutningen. Requesten måste bli komplett inom
+ * REQUEST_TIDSGRANS_SEKUNDER - annars skulle en klient som skickar en
+ * byte i taget blockera den enda hanteraren hur länge som helst.
+ */
+static void hantera_http_klient(socket_t klient_socket, uint32_t klient_ip,
+                                const char* api_nyckel) {
+    char kropp_buffer[SVAR_BUFFER_STORLEK]; // Buffer för svarets body
+    HttpSvar svar;                          // Headers + pekare till bodyn
+    HttpMottagning mottagning;              // Växande buffer för HTTP-requesten
+
+    if (!initiera_http_mottagning(&mottagning)) {
+        LOGG_FEL("Minnesallokering misslyckades för mottagningsbuffer");
+        stang_socket(klient_socket);
+        return;
+    }
+
+    // Ta emot tills requesten är komplett (headers + eventuell body)
+    time_t deadline = time(NULL) + REQUEST_TIDSGRANS_SEKUNDER;
+    HttpRamStatus status;
+    while ((status = hitta_http_request(&mottagning)) == HTTP_RAM_OFULLSTANDIG) {
+        // Varje recv() får bara vänta den tid som återstår för hela requesten
+        long kvar = (long)(deadline - time(NULL));
+        if (kvar <= 0 || satt_socket_tidsgrans(klient_socket, kvar * 1000) != 0) {
+            LOGG_VARNING("Requesten blev inte komplett inom %d s", REQUEST_TIDSGRANS_SEKUNDER);
+            stang_http_mottagning(&mottagning);
+            stang_socket(klient_socket);
+            return;
+        }
+        size_t ledigt;
+        char* mal = http_mottagning_ledigt(&mottagning, &ledigt);
+        // recv() returnerar antal mottagna bytes, eller <= 0 vid fel/stängd anslutning
+        int mottaget = mal ? recv(klient_socket, mal, (int)ledigt, 0) : -1;
+        if (mottaget <= 0) {
+            LOGG_VARNING("Anslutningen stängdes innan requesten var komplett");
+            stang_http_mottagning(&mottagning);
+            stang_socket(klient_socket);
+            return;
+        }
+        http_mottagning_tillfor(&mottagning, (size_t)mottaget);
     }
 
+    if (status == HTTP_RAM_KOMPLETT && !klientgrans_tillat(klient_ip)) {
+        skapa_http_begransad(&svar);  // Förbyggt 429 - requesten parsas inte
+        kasta_vantande_data(klient_socket);
+    } else if (status == HTTP_RAM_KOMPLETT) {
+        svar.hall_vid_liv = false;  // Den blockerande loopen stänger alltid efter svaret
+        hantera_http_request(mottagning.data, mottagning.request_langd,  // Bara den första requesten
+                             kropp_buffer, sizeof(kropp_buffer), &svar, (void*)api_nyckel);
+    } else {
+        skapa_http_mottagningsfel(&svar, kropp_buffer, sizeof(kropp_buffer),
+                                  &mottagning, status);
+        kasta_vantande_data(klient_socket);
+    }
+    // Blockerande socket - skicka_http_svar() returnerar när allt är skickat,
+    // eller med fel om klienten inte läser på TIMEOUT_SEKUNDER
+    satt_socket_tidsgrans(klient_socket, TIMEOUT_SEKUNDER * 1000L);
+    size_t skickat = 0;
+    skicka_http_svar(klient_socket, &svar, &skickat);
+
     // Stäng klientanslutningen när vi är klara
+    stang_http_mottagning(&mottagning);
     stang_socket(klient_socket);
 }
+#endif
+
+/**
+ * Läser värdet från en kommandoradsflagga på formen --namn=värde
+ *
+ * @param argument - Kommandoradsargumentet (t.ex. "--tradar=8")
+ * @param namn - Flaggans namn utan "--" (t.ex. "tradar")
+ * @return Pekare till värdet efter '=', eller NULL om argumentet inte är flaggan
+ */
+static const char* hamta_flagga(const char* argument, const char* namn) {
+    size_t namn_langd = strlen(namn);
+    if (strncmp(argument, "--", 2) == 0 &&
+        strncmp(argument + 2, namn, namn_langd) == 0 &&
+        argument[2 + namn_langd] == '=') {
+        return argument + 2 + namn_langd + 1;
+    }
+    return NULL;
+}
 
 /**
  * Huvudfunktion - Programmets startpunkt
@@ -386,22 +920,115 @@ void hantera_http_klient(socket_t klient_socket, const char* api_nyckel) {
  *   argv[1] - OpenWeatherMap API-nyckel (obligatorisk)
  *   argv[2] - Portnummer (valfritt, standard från konfiguration.h)
  *   argv[3] - Lognivå 0-3 (valfritt, 0=DEBUG, 1=INFO, 2=VARNING, 3=FEL)
+ *
+ * Flaggor (valfria, var som helst efter API-nyckeln):
+ *   --tradar=N  - Antal arbetartrådar (0 = hantera requests i reaktortråden)
+ *   --ko=N      - Antal platser i arbetskön
+ *   --reaktorer=N - Antal reaktortrådar med egen SO_REUSEPORT-socket (0 = en per kärna)
+ *   --io=epoll|uring - I/O-bakände för reaktorerna
+ *   --dns-ttl=N - Sekunder som en DNS-uppslagning av API-värden gäller
+ *   --dranering=N - Sekunder som pågående requests får bli klara vid SIGTERM
+ *   --max-ko=N  - Väntande requests i arbetskön innan nya får 503 (0 = ingen gräns)
+ *   --max-kotid=N - Millisekunders kötid innan nya requests får 503 (0 = ingen gräns)
+ *   --klientgrans=N - Requests per sekund och klient-IP innan 429 (0 = ingen gräns)
+ *   --klientskur=N - Requests i följd som en klient-IP får skicka innan gränsen gäller
+ *   --overlamning=SÖKVÄG - Unix-socket för omstart utan avbrott
+ *   --unix=SÖKVÄG - Lyssna även på en Unix-socket för klienter på samma maskin
  */
 int main(int argc, char* argv[]) {
     // Kontrollera att API-nyckel har angetts
     if (argc < 2) {
-        fprintf(stderr, "Användning: %s <OpenWeatherMap-API-nyckel> [port] [lognivå]\n", argv[0]);
+        fprintf(stderr, "Användning: %s <OpenWeatherMap-API-nyckel> [port] [lognivå] [flaggor]\n", argv[0]);
         fprintf(stderr, "Lognivå: 0=DEBUG, 1=INFO, 2=VARNING, 3=FEL (standard: 1)\n");
+        fprintf(stderr, "Flaggor:\n");
+        fprintf(stderr, "  --tradar=N   Antal arbetartrådar (standard: %d, 0 = ingen trådpool)\n",
+                ANTAL_ARBETARTRADAR);
+        fprintf(stderr, "  --ko=N       Platser i arbetskön (standard: %d)\n", ARBETSKO_STORLEK);
+        fprintf(stderr, "  --reaktorer=N  Reaktortrådar, en lyssnande socket var (standard: %d, 0 = en per kärna)\n",
+                ANTAL_REAKTORER);
+        fprintf(stderr, "  --io=epoll|uring  I/O-bakände för reaktorerna (standard: epoll)\n");
+        fprintf(stderr, "  --dns-ttl=N  Sekunder som en DNS-uppslagning gäller (standard: %d)\n",
+                DNS_TTL_SEKUNDER);
+        fprintf(stderr, "  --dranering=N  Sekunder för pågående requests vid avstängning (standard: %d)\n",
+                DRANERING_SEKUNDER);
+        fprintf(stderr, "  --max-ko=N   Väntande requests innan 503 vid överlast (standard: %d)\n",
+                ANTAGNING_MAX_KO);
+        fprintf(stderr, "  --max-kotid=N  Kötid i ms innan 503 vid överlast (standard: %d)\n",
+                ANTAGNING_MAX_KOTID_MS);
+        fprintf(stderr, "  --klientgrans=N  Requests per sekund och klient-IP (standard: %d, 0 = av)\n",
+                KLIENTGRANS_PER_SEKUND);
+        fprintf(stderr, "  --klientskur=N   Requests i följd per klient-IP (standard: %d)\n",
+                KLIENTGRANS_SKUR);
+        fprintf(stderr, "  --overlamning=SÖKVÄG  Unix-socket för omstart utan avbrott: ta över\n"
+                        "                        porten från processen där, vänta sedan på nästa\n");
+        fprintf(stderr, "  --unix=SÖKVÄG  Lyssna även på en Unix-socket (klienter på samma maskin)\n");
         fprintf(stderr, "\nExempel:\n");
         fprintf(stderr, "  %s abc123xyz456\n", argv[0]);
         fprintf(stderr, "  %s abc123xyz456 8080 0\n", argv[0]);
+        fprintf(stderr, "  %s abc123xyz456 8080 1 --tradar=16\n", argv[0]);
         return 1;
     }
 
     // Läs in kommandoradsargument
     const char* api_nyckel = argv[1];  // Första argumentet är API-nyckeln
-    int port = (argc > 2) ? atoi(argv[2]) : SERVER_PORT;  // Andra arg = port, annars standard
-    LogNiva log_niva = (argc > 3) ? (LogNiva)atoi(argv[3]) : LOG_NIVA_INFO;  // Tredje arg = lognivå
+    int port = SERVER_PORT;            // Andra positionella arg = port, annars standard
+    LogNiva log_niva = LOG_NIVA_INFO;  // Tredje positionella arg = lognivå
+    int antal_tradar = ANTAL_ARBETARTRADAR;
+    int ko_storlek = ARBETSKO_STORLEK;
+    int antal_reaktorer = ANTAL_REAKTORER;
+    ReaktorIo io = REAKTOR_IO_EPOLL;
+    int dranering_sekunder = DRANERING_SEKUNDER;
+    int max_ko = ANTAGNING_MAX_KO;
+    int max_kotid = ANTAGNING_MAX_KOTID_MS;
+    int klientgrans = KLIENTGRANS_PER_SEKUND;
+    int klientskur = KLIENTGRANS_SKUR;
+    const char* overlamning = NULL;    // Sökväg för omstart utan avbrott (NULL = av)
+    const char* unix_sokvag = NULL;    // Lokal Unix-socket (NULL = bara TCP)
+
+    // Flaggor (--namn=värde) kan stå var som helst; övriga argument är positionella
+    int positionella = 0;
+    for (int i = 2; i < argc; i++) {
+        const char* varde;
+        if ((varde = hamta_flagga(argv[i], "tradar"))) {
+            antal_tradar = atoi(varde);
+        } else if ((varde = hamta_flagga(argv[i], "ko"))) {
+            ko_storlek = atoi(varde);
+        } else if ((varde = hamta_flagga(argv[i], "reaktorer"))) {
+            antal_reaktorer = atoi(varde);
+        } else if ((varde = hamta_flagga(argv[i], "io"))) {
+            if (strcmp(varde, "uring") == 0) {
+                io = REAKTOR_IO_URING;
+            } else if (strcmp(varde, "epoll") != 0) {
+                fprintf(stderr, "Okänd I/O-bakände: %s (epoll eller uring)\n", varde);
+                return 1;
+            }
+        } else if ((varde = hamta_flagga(argv[i], "dns-ttl"))) {
+            dns_cache_satt_ttl(atoi(varde));
+        } else if ((varde = hamta_flagga(argv[i], "dranering"))) {
+            dranering_sekunder = atoi(varde);
+        } else if ((varde = hamta_flagga(argv[i], "max-ko"))) {
+            max_ko = atoi(varde);
+        } else if ((varde = hamta_flagga(argv[i], "max-kotid"))) {
+            max_kotid = atoi(varde);
+        } else if ((varde = hamta_flagga(argv[i], "klientgrans"))) {
+            klientgrans = atoi(varde);
+        } else if ((varde = hamta_flagga(argv[i], "klientskur"))) {
+            klientskur = atoi(varde);
+        } else if ((varde = hamta_flagga(argv[i], "overlamning"))) {
+            overlamning = varde;
+        } else if ((varde = hamta_flagga(argv[i], "unix"))) {
+            unix_sokvag = varde;
+        } else if (strncmp(argv[i], "--", 2) == 0) {
+            fprintf(stderr, "Okänd flagga: %s\n", argv[i]);
+            return 1;
+        } else if (positionella == 0) {
+            port = atoi(argv[i]);
+            positionella++;
+        } else if (positionella == 1) {
+            log_niva = (LogNiva)atoi(argv[i]);
+            positionella++;
+        }
+    }
 
     // Initialisera loggningssystemet med vald nivå
     initiera_loggning(log_niva);
@@ -419,61 +1046,212 @@ int main(int argc, char* argv[]) {
         // Vi fortsätter ändå - servern fungerar utan cache, bara långsammare
     }
 
+    // Välj SIMD-implementation för HTTP-parsern innan några trådar startar
+    LOGG_INFO("HTTP-skanning: %s", http_skanning_namn(initiera_http_skanning()));
+
+    // Bygg svarsmallarna (statusrad och headers per statuskod)
+    if (!initiera_http_svar()) {
+        LOGG_FEL("Svarsmallarna får inte plats i HTTP_HUVUD_STORLEK");
+        return 1;
+    }
+
+    // Lägg endpoints i den perfekta hashtabellen (läses sedan bara av trådarna)
+    if (!bygg_ruttabell(&ruttabell, RUTTER, (int)(sizeof(RUTTER) / sizeof(RUTTER[0])))) {
+        LOGG_FEL("Kunde inte bygga rutt-tabellen");
+        return 1;
+    }
+    LOGG_DEBUG("Rutt-tabell: %d endpoints, startvärde %u", ruttabell.antal, (unsigned)ruttabell.fro);
+
+    // Begränsning per klient-IP gäller alla I/O-vägar
+    konfigurera_klientgrans(klientgrans, klientskur);
+    if (klientgrans > 0) {
+        LOGG_INFO("Klientgräns: %d requests/s per IP, skur %d", klientgrans, klientskur);
+    }
+
     // Registrera signal-hanterare för att fånga Ctrl+C
     signal(SIGINT, signal_hanterare);   // SIGINT = Ctrl+C på alla plattformar
 #ifndef _WIN32
     signal(SIGTERM, signal_hanterare);  // SIGTERM = avslutningssignal från systemet (Unix/Linux)
 #endif
 
-    // Initialisera TCP-server och börja lyssna på anslutningar
-    TcpServer server;
-    if (initiera_tcp_server(&server, port) != 0) {
-        LOGG_FEL("Kunde inte starta TCP-server");
-        stang_loggning();
-        return 1;
+#ifdef __linux__
+    // Antal reaktorer: 0 betyder en per tillgänglig kärna
+    if (antal_reaktorer <= 0) {
+        long karnor = sysconf(_SC_NPROCESSORS_ONLN);
+        antal_reaktorer = karnor > 0 ? (int)karnor : 1;
+    }
+    // Unix-socketen får en egen reaktor utöver TCP-reaktorerna
+    int max_tcp = unix_sokvag ? MAX_REAKTORER - 1 : MAX_REAKTORER;
+    if (antal_reaktorer > max_tcp) {
+        antal_reaktorer = max_tcp;
+    }
+
+    // io_uring kan saknas eller vara avstängt (äldre kärna, seccomp)
+    if (io == REAKTOR_IO_URING && !uring_stods()) {
+        LOGG_VARNING("io_uring stöds inte av kärnan, använder epoll");
+        io = REAKTOR_IO_EPOLL;
+    }
+#else
+    antal_reaktorer = 1;  // Blockerande loop utan epoll - alltid en socket
+    (void)io;             // Ingen reaktor att välja bakände för
+    (void)antal_tradar;   // Ingen trådpool utan reaktor
+    (void)ko_storlek;
+    (void)dranering_sekunder;  // Pågående request blir alltid klar innan loopen avslutas
+    (void)max_ko;         // Ingen arbetskö - en request i taget
+    (void)max_kotid;
+    if (unix_sokvag) {
+        LOGG_VARNING("--unix kräver reaktorn (Linux), lyssnar bara på TCP");
+        unix_sokvag = NULL;
+    }
+#endif
+
+    // Initialisera TCP-server(ar) och börja lyssna på anslutningar.
+    // Med flera reaktorer får varje reaktor en egen SO_REUSEPORT-socket.
+    // Vid omstart utan avbrott tas den gamla processens sockets över i
+    // stället, och antalet reaktorer följer antalet sockets.
+    static TcpServer servrar[MAX_REAKTORER];
+    int mottagna = overlamning ? ta_over_lyssnare(overlamning, port, servrar, MAX_REAKTORER) : 0;
+
+    // En ärvd Unix-socket läggs åt sidan och används bara om samma sökväg
+    // har begärts igen; TCP-socketarna packas först i servrar
+    TcpServer lokal;
+    bool har_lokal = false;
+    int arvda = 0;
+    for (int i = 0; i < mottagna; i++) {
+        if (servrar[i].familj == AF_INET) {
+            servrar[arvda++] = servrar[i];
+        } else if (!har_lokal && unix_sokvag && strcmp(servrar[i].sokvag, unix_sokvag) == 0) {
+            lokal = servrar[i];
+            har_lokal = true;
+        } else {
+            stang_tcp_server(&servrar[i]);
+        }
+    }
+
+    if (arvda > 0 && arvda != antal_reaktorer) {
+        LOGG_INFO("Kör %d reaktorer, en per ärvd socket", arvda);
+    }
+    if (arvda > 0) {
+        antal_reaktorer = arvda;
+    }
+    for (int i = arvda; i < antal_reaktorer; i++) {
+        int resultat = antal_reaktorer > 1 ? initiera_tcp_server_delad(&servrar[i], port)
+                                           : initiera_tcp_server(&servrar[i], port);
+        if (resultat != 0) {
+            LOGG_FEL("Kunde inte starta TCP-server");
+            while (i-- > 0) {
+                stang_tcp_server(&servrar[i]);
+            }
+            stang_loggning();
+            return 1;
+        }
+    }
+
+    // Lokala klienter: samma HTTP över en Unix-socket, med en egen reaktor
+    // sist i servrar. Går den inte att öppna körs servern bara med TCP.
+    int antal_servrar = antal_reaktorer;
+    if (har_lokal) {
+        servrar[antal_servrar++] = lokal;
+    } else if (unix_sokvag) {
+        if (initiera_unix_server(&servrar[antal_servrar], unix_sokvag) == 0) {
+            antal_servrar++;
+        } else {
+            LOGG_VARNING("Kunde inte lyssna på %s, fortsätter med bara TCP", unix_sokvag);
+        }
     }
 
     // Skriv ut användbar information om servern
     LOGG_INFO("");
     LOGG_INFO("✓ Server lyssnar på http://localhost:%d", port);
+    if (antal_servrar > antal_reaktorer) {
+        LOGG_INFO("✓ Lokala klienter: %s", servrar[antal_reaktorer].sokvag);
+    }
     LOGG_INFO("✓ Endpoints:");
-    LOGG_INFO("  GET /weather?city=Stockholm&country=SE");
-    LOGG_INFO("  GET /forecast?city=Stockholm&country=SE");
+    for (int i = 0; i < ruttabell.antal; i++) {
+        const Rutt* rutt = &ruttabell.rutter[i];
+        LOGG_INFO("  %s %s", http_metod_namn(rutt->metod), rutt->sokvag);
+    }
     LOGG_INFO("");
     LOGG_INFO("Tryck Ctrl+C för att stoppa servern");
     LOGG_INFO("");
 
-    // Huvudloop - Kör tills användaren trycker Ctrl+C
-    int klient_raknare = 0;  // Räknare för antal hanterade klienter
-    while (kors) {
-        // Acceptera en ny klientanslutning (blockerar tills klient ansluter)
-        socket_t klient = acceptera_klient(&server);
+    // Lyssna efter nästa process. Anropas från huvudtråden, som är den
+    // som ska få SIGTERM när socketarna har lämnats över.
+    if (overlamning) {
+        starta_overlamning(overlamning, servrar, antal_servrar, &kors);
+    }
 
-        if (klient != OGILTIG_SOCKET) {
-            // Logga att en klient har anslutit
-            LOGG_INFO("🔌 Ny klient anslöt (#%d)", klient_raknare + 1);
+#ifdef __linux__
+    // Starta trådpoolen så att cache-missar (API-anrop) inte stoppar reaktorn.
+    // Varje arbetare får en egen svarsbuffer som återanvänds mellan requests.
+    ArbetarPool pool;
+    bool har_pool = antal_tradar > 0 &&
+                    initiera_arbetarpool(&pool, antal_tradar, (size_t)ko_storlek,
+                                         SVAR_BUFFER_STORLEK);
+    if (antal_tradar > 0 && !har_pool) {
+        LOGG_VARNING("Kunde inte starta trådpool, hanterar requests i reaktorn");
+    }
 
-            // Hantera klientens HTTP-request och skicka svar
-            hantera_http_klient(klient, api_nyckel);
+    // Antagningskontroll: avvisa med 503 innan kön växer så mycket att
+    // klienterna får timeout. ANTAGNING_CACHE_RESERV_PROCENT av arbetarna
+    // (avrundat uppåt) hålls lediga för cacheträffar; resten får hämta
+    // från API:et, men alltid minst en.
+    if (har_pool) {
+        int reserverade = (pool.antal_tradar * ANTAGNING_CACHE_RESERV_PROCENT + 99) / 100;
+        int upstream_platser = pool.antal_tradar - reserverade;
+        konfigurera_antagning(max_ko > 0 ? (size_t)max_ko : 0,
+                              max_kotid > 0 ? (unsigned)max_kotid : 0,
+                              upstream_platser > 0 ? upstream_platser : 1);
+    }
 
-            // Rensa gammal cache var 10:e klient för att hålla cache-katalogen fräsch
-            // Detta förhindrar att gamla filer samlas och tar upp diskutrymme
-            if (++klient_raknare % 10 == 0) {
-                rensa_gammal_cache();
-            }
-        }
+    // Händelsedriven huvudloop - kör tills användaren trycker Ctrl+C
+    // epoll_wait() väcks direkt av nya anslutningar, så ingen fast paus behövs
+    ReaktorInstallningar installningar = {
+        .hanterare = hantera_http_request,
+        .kontext = (void*)api_nyckel,
+        .io = io,
+        .dranering_sekunder = dranering_sekunder,
+        .pool = har_pool ? &pool : NULL,
+    };
+    if (antal_reaktorer > 1) {
+        LOGG_INFO("Startar %d reaktorer med SO_REUSEPORT", antal_reaktorer);
+    }
+    if (antal_servrar > antal_reaktorer) {
+        LOGG_INFO("Startar en reaktor för Unix-socketen");
+    }
+    kor_reaktorer(servrar, antal_servrar, &installningar, &kors);
 
-        // Kort paus för att inte spinna CPU:n för hårt
-        // Detta ger också andra processer chans att köra
-#ifdef _WIN32
-        Sleep(10);              // Windows: Sleep tar millisekunder
+    if (har_pool) {
+        stang_arbetarpool(&pool);
+    }
 #else
-        usleep(10000);          // Unix/Linux: usleep tar mikrosekunder (10000 µs = 10 ms)
-#endif
+    // Blockerande huvudloop för plattformar utan epoll. En request som
+    // påbörjats hinner alltid besvaras innan kors kontrolleras igen.
+    while (kors) {
+        // Vänta högst en sekund i taget så att stoppsignalen märks även när
+        // ingen klient ansluter
+        if (!vanta_pa_klient(&servrar[0], 1000)) {
+            continue;
+        }
+
+        // Acceptera en ny klientanslutning (en klient väntar redan)
+        uint32_t klient_ip;
+        socket_t klient = acceptera_klient(&servrar[0], &klient_ip);
+
+        if (klient != OGILTIG_SOCKET) {
+            // Hantera klientens HTTP-request och skicka svar
+            hantera_http_klient(klient, klient_ip, api_nyckel);
+        }
     }
+#endif
 
     // Stäng ned servern på ett snyggt sätt
-    stang_tcp_server(&server);
+    stang_overlamning();
+    for (int i = 0; i < antal_servrar; i++) {
+        stang_tcp_server(&servrar[i]);
+    }
+    stang_http_klient_pool();
+    stang_dns_cache();
     LOGG_INFO("Server stoppad");
     stang_loggning();
 
@@ -0,0 +1,366 @@
+#define _GNU_SOURCE           // För struct ucred (SO_PEERCRED) och CMSG_SPACE
+#include "overlamning.h"      // Överlämningens API
+#include "loggning.h"         // För loggning av överlämningen
+#include "konfiguration.h"    // För MAX_REAKTORER och OVERLAMNING_TIDSGRANS_SEKUNDER
+#include <string.h>           // För memset, memcpy och strlen
+
+#ifndef _WIN32
+#include <sys/un.h>           // För sockaddr_un
+#include <sys/stat.h>         // För chmod
+#include <sys/uio.h>          // För iovec
+#include <poll.h>             // Tråden väntar på anslutning eller stopp
+#include <pthread.h>          // Överlämningstråden
+#include <signal.h>           // SIGTERM till huvudtråden efter överlämning
+#include <stdint.h>           // För uint32_t
+
+// Byte som nya processen skickar när den har tagit över socketarna. Först
+// då börjar den gamla processen dränera; uteblir svaret fortsätter den.
+#define KVITTO 'K'
+
+// Utan MSG_NOSIGNAL (macOS) gäller processens SIGPIPE-hantering
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+static int lyssnare = -1;                         // Unix-socket som nästa process ansluter till
+static int stopp_ror[2] = { -1, -1 };             // Skrivs vid avstängning för att väcka tråden
+static pthread_t trad;
+static bool trad_startad = false;
+static bool overlamnad = false;                   // Skrivs av tråden, läses efter join
+static pthread_t huvudtrad;                       // Får SIGTERM efter överlämningen
+static TcpServer* egna_servrar = NULL;
+static int egna_antal = 0;
+static volatile bool* egen_kors = NULL;
+static char egen_sokvag[sizeof(((struct sockaddr_un*)0)->sun_path)];
+
+/**
+ * Fyller i adressen för en Unix-socket
+ *
+ * @param adress - Adressen som fylls i
+ * @param sokvag - Sökväg i filsystemet
+ * @return false om sökvägen är för lång
+ */
+static bool fyll_adress(struct sockaddr_un* adress, const char* sokvag) {
+    size_t langd = strlen(sokvag);
+    if (langd == 0 || langd >= sizeof(adress->sun_path)) {
+        LOGG_FEL("Ogiltig sökväg för överlämning: %s", sokvag);
+        return false;
+    }
+    memset(adress, 0, sizeof(*adress));
+    adress->sun_family = AF_UNIX;
+    memcpy(adress->sun_path, sokvag, langd + 1);
+    return true;
+}
+
+/**
+ * Hämtar lyssnande sockets från en tidigare serverprocess
+ *
+ * @param sokvag - Unix-socket där den gamla processen lyssnar
+ * @param port - Porten som TCP-socketarna måste vara bundna till (en lokal
+ *               Unix-socket följer med utan kontroll)
+ * @param servrar - Array som fylls med de mottagna servrarna
+ * @param max_antal - Antal platser i servrar
+ * @return Antal mottagna sockets, 0 om ingen överlämning gjordes
+ *
+ * Den gamla processen skickar antalet som data och socketarna som
+ * SCM_RIGHTS i samma meddelande. Varje socket kontrolleras innan kvittot
+ * skickas; går något fel stängs våra kopior och den gamla processen
+ * fortsätter som om inget hänt.
+ */
+int ta_over_lyssnare(const char* sokvag, int port, TcpServer* servrar, int max_antal) {
+    struct sockaddr_un adress;
+    if (!fyll_adress(&adress, sokvag)) {
+        return 0;
+    }
+
+    int uttag = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (uttag < 0) {
+        LOGG_VARNING("Kunde inte skapa socket för överlämning: fel %d", errno);
+        return 0;
+    }
+    if (connect(uttag, (struct sockaddr*)&adress, sizeof(adress)) != 0) {
+        // Ingen process lyssnar - första starten, eller en kvarglömd sökväg
+        if (errno != ENOENT && errno != ECONNREFUSED) {
+            LOGG_VARNING("Kunde inte ansluta till %s för överlämning: fel %d", sokvag, errno);
+        }
+        close(uttag);
+        return 0;
+    }
+    satt_socket_tidsgrans(uttag, OVERLAMNING_TIDSGRANS_SEKUNDER * 1000);
+
+    uint32_t antal = 0;
+    struct iovec data = { .iov_base = &antal, .iov_len = sizeof(antal) };
+    union {
+        char buffer[CMSG_SPACE(sizeof(int) * MAX_REAKTORER)];
+        struct cmsghdr justering;                 // Ger bufferten rätt justering
+    } kontroll;
+    struct msghdr meddelande;
+    memset(&meddelande, 0, sizeof(meddelande));
+    meddelande.msg_iov = &data;
+    meddelande.msg_iovlen = 1;
+    meddelande.msg_control = kontroll.buffer;
+    meddelande.msg_controllen = sizeof(kontroll.buffer);
+
+    ssize_t mottaget = recvmsg(uttag, &meddelande, 0);
+
+    // Plocka ut socketarna innan något kontrolleras - de är redan våra
+    // och måste stängas om överlämningen avbryts
+    int socketar[MAX_REAKTORER];
+    int mottagna = 0;
+    if (mottaget > 0) {
+        for (struct cmsghdr* c = CMSG_FIRSTHDR(&meddelande); c; c = CMSG_NXTHDR(&meddelande, c)) {
+            if (c->cmsg_level != SOL_SOCKET || c->cmsg_type != SCM_RIGHTS) {
+                continue;
+            }
+            int antal_i = (int)((c->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+            for (int i = 0; i < antal_i && mottagna < MAX_REAKTORER; i++) {
+                memcpy(&socketar[mottagna++], CMSG_DATA(c) + i * sizeof(int), sizeof(int));
+            }
+        }
+    }
+
+    bool ok = mottaget == (ssize_t)sizeof(antal) && !(meddelande.msg_flags & MSG_CTRUNC) &&
+              mottagna > 0 && (uint32_t)mottagna == antal && mottagna <= max_antal;
+    if (!ok) {
+        LOGG_VARNING("Ogiltig överlämning från %s (%d sockets), binder porten själv",
+                     sokvag, mottagna);
+    }
+    for (int i = 0; ok && i < mottagna; i++) {
+        if (initiera_tcp_server_fran_socket(&servrar[i], socketar[i]) != 0) {
+            ok = false;
+        } else if (servrar[i].familj == AF_INET && servrar[i].port != port) {
+            LOGG_VARNING("Processen på %s lyssnar på port %d, inte %d - tar inte över",
+                         sokvag, servrar[i].port, port);
+            ok = false;
+        }
+    }
+
+    char kvitto = KVITTO;
+    if (ok && send(uttag, &kvitto, 1, MSG_NOSIGNAL) != 1) {
+        LOGG_VARNING("Kunde inte bekräfta överlämningen: fel %d", errno);
+        ok = false;
+    }
+    close(uttag);
+
+    if (!ok) {
+        for (int i = 0; i < mottagna; i++) {
+            close(socketar[i]);  // Gamla processen har kvar sina kopior
+        }
+        return 0;
+    }
+    LOGG_INFO("Tog över %d lyssnande sockets från %s", mottagna, sokvag);
+    return mottagna;
+}
+
+/**
+ * Skickar servrarnas sockets till en ny process och väntar på kvittot
+ *
+ * @param uttag - Anslutningen från den nya processen
+ * @return true om den nya processen har tagit över
+ */
+static bool lamna_over(int uttag) {
+#ifdef SO_PEERCRED
+    // Sökvägen är bara skrivbar för ägaren, men kontrollera ändå att det
+    // är samma användare i andra änden innan portarna lämnas ut
+    struct ucred avsandare;
+    socklen_t langd = sizeof(avsandare);
+    if (getsockopt(uttag, SOL_SOCKET, SO_PEERCRED, &avsandare, &langd) != 0 ||
+        avsandare.uid != getuid()) {
+        LOGG_VARNING("Överlämning nekad: annan användare");
+        return false;
+    }
+#endif
+
+    // Har dräneringen redan börjat kan socketarna vara stängda
+    if (!*egen_kors) {
+        LOGG_VARNING("Överlämning nekad: servern håller redan på att stängas");
+        return false;
+    }
+    satt_socket_tidsgrans(uttag, OVERLAMNING_TIDSGRANS_SEKUNDER * 1000);
+
+    uint32_t antal = (uint32_t)egna_antal;
+    struct iovec data = { .iov_base = &antal, .iov_len = sizeof(antal) };
+    union {
+        char buffer[CMSG_SPACE(sizeof(int) * MAX_REAKTORER)];
+        struct cmsghdr justering;
+    } kontroll;
+    memset(&kontroll, 0, sizeof(kontroll));
+    struct msghdr meddelande;
+    memset(&meddelande, 0, sizeof(meddelande));
+    meddelande.msg_iov = &data;
+    meddelande.msg_iovlen = 1;
+    meddelande.msg_control = kontroll.buffer;
+    meddelande.msg_controllen = CMSG_SPACE(sizeof(int) * (size_t)egna_antal);
+
+    struct cmsghdr* c = CMSG_FIRSTHDR(&meddelande);
+    c->cmsg_level = SOL_SOCKET;
+    c->cmsg_type = SCM_RIGHTS;
+    c->cmsg_len = CMSG_LEN(sizeof(int) * (size_t)egna_antal);
+    for (int i = 0; i < egna_antal; i++) {
+        int fd = egna_servrar[i].lyssnar_socket;
+        memcpy(CMSG_DATA(c) + (size_t)i * sizeof(int), &fd, sizeof(int));
+    }
+
+    if (sendmsg(uttag, &meddelande, MSG_NOSIGNAL) != (ssize_t)sizeof(antal)) {
+        LOGG_VARNING("Kunde inte skicka lyssnande sockets: fel %d", errno);
+        return false;
+    }
+
+    char kvitto = 0;
+    if (recv(uttag, &kvitto, 1, 0) != 1 || kvitto != KVITTO) {
+        LOGG_VARNING("Ny process tog inte över socketarna, fortsätter som vanligt");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Trådloop: väntar på nästa process eller på stopp
+ *
+ * @param argument - Oanvänd
+ * @return NULL
+ */
+static void* overlamning_loop(void* argument) {
+    (void)argument;
+    for (;;) {
+        struct pollfd vantar[2] = {
+            { .fd = lyssnare, .events = POLLIN },
+            { .fd = stopp_ror[0], .events = POLLIN },
+        };
+        if (poll(vantar, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOGG_FEL("poll misslyckades i överlämningstråden: fel %d", errno);
+            return NULL;
+        }
+        if (vantar[1].revents) {
+            return NULL;  // stang_overlamning()
+        }
+
+        int uttag = accept(lyssnare, NULL, NULL);
+        if (uttag < 0) {
+            continue;
+        }
+        bool klart = lamna_over(uttag);
+        close(uttag);
+        if (klart) {
+            // Samma väg som en vanlig SIGTERM: sluta ta emot och dränera.
+            // Socketarna lever vidare i den nya processen.
+            LOGG_INFO("Lyssnande sockets överlämnade till ny process, dränerar");
+            overlamnad = true;
+            pthread_kill(huvudtrad, SIGTERM);
+            return NULL;
+        }
+    }
+}
+
+/**
+ * Börjar ta emot överlämningsförfrågningar
+ *
+ * @param sokvag - Sökväg för Unix-socketen
+ * @param servrar - Servrar vars sockets lämnas över
+ * @param antal - Antal servrar (1 till MAX_REAKTORER)
+ * @param kors - Serverns stoppflagga; ingen överlämning när den är false
+ * @return true om tråden startade
+ *
+ * En gammal socketfil på sökvägen tas bort först. Den tillhör antingen en
+ * process som just lämnat över till oss eller en som inte längre körs.
+ */
+bool starta_overlamning(const char* sokvag, TcpServer* servrar, int antal,
+                        volatile bool* kors) {
+    struct sockaddr_un adress;
+    if (antal < 1 || antal > MAX_REAKTORER || !fyll_adress(&adress, sokvag)) {
+        return false;
+    }
+
+    lyssnare = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (lyssnare < 0) {
+        LOGG_FEL("Kunde inte skapa socket för överlämning: fel %d", errno);
+        return false;
+    }
+    unlink(sokvag);
+    if (bind(lyssnare, (struct sockaddr*)&adress, sizeof(adress)) != 0 ||
+        chmod(sokvag, S_IRUSR | S_IWUSR) != 0 ||
+        listen(lyssnare, 1) != 0 ||
+        pipe(stopp_ror) != 0) {
+        LOGG_FEL("Kunde inte lyssna på %s för överlämning: fel %d", sokvag, errno);
+        close(lyssnare);
+        lyssnare = -1;
+        return false;
+    }
+
+    egna_servrar = servrar;
+    egna_antal = antal;
+    egen_kors = kors;
+    memcpy(egen_sokvag, adress.sun_path, sizeof(egen_sokvag));
+    huvudtrad = pthread_self();
+    overlamnad = false;
+
+    // Signaler ska hanteras av huvudtråden
+    sigset_t alla, gammal;
+    sigfillset(&alla);
+    pthread_sigmask(SIG_BLOCK, &alla, &gammal);
+    trad_startad = pthread_create(&trad, NULL, overlamning_loop, NULL) == 0;
+    pthread_sigmask(SIG_SETMASK, &gammal, NULL);
+
+    if (!trad_startad) {
+        LOGG_FEL("Kunde inte starta överlämningstråd");
+        stang_overlamning();
+        return false;
+    }
+    LOGG_INFO("Väntar på omstart via %s", sokvag);
+    return true;
+}
+
+/**
+ * Stoppar överlämningstråden och stänger Unix-socketen
+ */
+void stang_overlamning(void) {
+    if (lyssnare < 0) {
+        return;
+    }
+    if (trad_startad) {
+        char stopp = 1;
+        ssize_t skrivet = write(stopp_ror[1], &stopp, 1);
+        (void)skrivet;
+        pthread_join(trad, NULL);
+        trad_startad = false;
+    }
+    close(lyssnare);
+    close(stopp_ror[0]);
+    close(stopp_ror[1]);
+    lyssnare = stopp_ror[0] = stopp_ror[1] = -1;
+
+    // Efter en överlämning lyssnar den nya processen på sökvägen
+    if (!overlamnad) {
+        unlink(egen_sokvag);
+    }
+}
+
+#else
+
+// Windows saknar SCM_RIGHTS - servern startas alltid med en egen socket
+
+int ta_over_lyssnare(const char* sokvag, int port, TcpServer* servrar, int max_antal) {
+    (void)sokvag;
+    (void)port;
+    (void)servrar;
+    (void)max_antal;
+    return 0;
+}
+
+bool starta_overlamning(const char* sokvag, TcpServer* servrar, int antal,
+                        volatile bool* kors) {
+    (void)sokvag;
+    (void)servrar;
+    (void)antal;
+    (void)kors;
+    LOGG_VARNING("Omstart utan avbrott stöds inte på Windows");
+    return false;
+}
+
+void stang_overlamning(void) {
+}
+
+#endif
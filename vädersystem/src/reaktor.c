@@ -0,0 +1,1073 @@
+#define _POSIX_C_SOURCE 200809L  // För pthread_sigmask
+#include "reaktor.h"          // Reaktorns API och tillstånd
+#include "loggning.h"         // För loggning av händelser och fel
+#include "konfiguration.h"    // För BUFFER_STORLEK, SVAR_BUFFER_STORLEK och MAX_REAKTORER
+#include "http_server.h"      // För HttpMottagning och hitta_http_request
+#include "uring_reaktor.h"    // io_uring-bakänden
+#include "timerhjul.h"        // För tidsgränser per anslutning
+#include "antagning.h"        // För antagningskontroll vid överlast
+#include "klientgrans.h"      // För begränsning av requests per klient-IP
+#include <stdlib.h>           // För malloc, free
+#include <string.h>           // För memcpy, strstr
+#include <stdatomic.h>        // För räknare som läses från andra trådar
+
+#ifdef __linux__
+#include <sys/epoll.h>        // För epoll_create1, epoll_ctl, epoll_wait
+#include <sys/eventfd.h>      // För eventfd - arbetare väcker reaktorn
+#include <poll.h>             // För poll() när reaktorn väntar in arbetare
+#include <pthread.h>          // För reaktortrådar och mutex runt listan med klara anslutningar
+#include <signal.h>           // För pthread_sigmask i reaktortrådar
+#include <time.h>             // För clock_gettime till timerhjulet
+
+#define MAX_HANDELSER 256     // Max antal händelser per epoll_wait()-anrop
+
+typedef struct Reaktor Reaktor;
+
+// Statisk lagring så att räknarna kan läsas även medan reaktorer startas
+// eller stängs; antal_reaktorer anger hur många poster som är giltiga
+static ReaktorRaknare reaktor_raknare[MAX_REAKTORER];
+static _Atomic int antal_reaktorer = 0;
+
+// Per-anslutningsdata. Pekaren lagras i epoll_event.data.ptr så att
+// varje händelse leder direkt till rätt anslutning utan uppslagning.
+typedef struct Anslutning {
+    socket_t fd;                                  // Klientens socket
+    uint32_t klient_ip;                           // Klientens IPv4-adress (nätverksordning)
+    AnslutningsTillstand tillstand;               // Ägs av reaktortråden
+    AnslutningsTillstand nasta_tillstand;         // Sätts av arbetaren, gäller när den lämnat tillbaka
+    Reaktor* reaktor;                             // Reaktorn som äger anslutningen
+    struct Anslutning* forra;                     // Lista över alla öppna anslutningar
+    struct Anslutning* nasta;
+    struct Anslutning* nasta_klar;                // Lista över anslutningar som arbetare är klara med
+    HttpMottagning mottagning;                    // Mottagen requestdata (kan rymma flera requests)
+    bool hall_vid_liv;                            // Anslutningen ska vara öppen efter aktuellt svar
+    bool eof;                                     // Klienten har stängt sin skrivsida
+    bool besvarad;                                // Minst en request har tagits emot
+    Timer timer;                                  // Anslutningens tidsgräns i reaktorns timerhjul
+    AnslutningsTidsgrans tidsgrans;               // Vilken tidsgräns timern är satt för
+    char* ut_buffer;                              // Osänt svar (allokeras bara vid korta skrivningar)
+    size_t ut_langd;                              // Totalt antal bytes i ut_buffer
+    size_t ut_skickat;                            // Antal bytes som redan skickats
+} Anslutning;
+
+// Reaktorns tillstånd
+struct Reaktor {
+    TcpServer* server;                            // Lyssnande server (egen socket per reaktor)
+    const ReaktorInstallningar* installningar;    // Hanterare, kontext och trådpool
+    volatile bool* kors;                          // Loopen avslutas när denna blir false
+    int index;                                    // Reaktorns nummer (0 = anropande tråd)
+    ReaktorRaknare* raknare;                      // Reaktorns post i reaktor_raknare
+    int epoll_fd;                                 // epoll-instansen
+    int vacknings_fd;                             // eventfd som arbetare skriver till
+    pthread_mutex_t klara_las;                    // Skyddar listan klara
+    Anslutning* klara;                            // Anslutningar som lämnats tillbaka av arbetare
+    Anslutning* oppna;                            // Alla öppna anslutningar
+    int antal_bearbetas;                          // Anslutningar som just nu ägs av arbetare
+    bool avslutar;                                // Dräneringstiden är ute - inga fler requests besvaras
+    uint64_t forsta_request_slut;                 // Vid dränering: nya anslutningar utan request stängs efter detta
+    uint64_t nu;                                  // Monoton tid (ms), uppdateras efter varje epoll_wait
+    TimerHjul timers;                             // Tidsgränser för reaktorns anslutningar
+    char kropp_buffer[SVAR_BUFFER_STORLEK];       // Svarsbody när requests hanteras i reaktorn
+};
+
+/**
+ * Stänger en anslutning och frigör dess resurser
+ *
+ * @param anslutning - Anslutningen som ska stängas
+ *
+ * close() tar automatiskt bort socketen från epoll-instansen.
+ * Får bara anropas av reaktortråden.
+ */
+static void stang_anslutning(Anslutning* anslutning) {
+    Reaktor* reaktor = anslutning->reaktor;
+    if (anslutning->forra) {
+        anslutning->forra->nasta = anslutning->nasta;
+    } else {
+        reaktor->oppna = anslutning->nasta;
+    }
+    if (anslutning->nasta) {
+        anslutning->nasta->forra = anslutning->forra;
+    }
+
+    stoppa_timer(&reaktor->timers, &anslutning->timer);
+    stang_socket(anslutning->fd);
+    stang_http_mottagning(&anslutning->mottagning);
+    free(anslutning->ut_buffer);
+    free(anslutning);
+    atomic_fetch_sub_explicit(&reaktor->raknare->oppna, 1, memory_order_relaxed);
+}
+
+/**
+ * Stänger en anslutning vars tidsgräns har löpt ut
+ *
+ * @param timer - Anslutningens timer
+ * @param data - Anslutningen
+ *
+ * Anropas från kor_timerhjul() i reaktortråden.
+ */
+static void tidsgrans_utlopt(Timer* timer, void* data) {
+    (void)timer;
+    Anslutning* anslutning = (Anslutning*)data;
+    switch (anslutning->tidsgrans) {
+        case TIDSGRANS_REQUEST:
+            LOGG_DEBUG("Stänger anslutning: requesten blev inte komplett inom %d s",
+                       REQUEST_TIDSGRANS_SEKUNDER);
+            break;
+        case TIDSGRANS_SKRIVNING:
+            LOGG_DEBUG("Stänger anslutning: klienten har inte läst svaret på %d s",
+                       TIMEOUT_SEKUNDER);
+            break;
+        default:
+            LOGG_DEBUG("Stänger inaktiv anslutning efter %d s", TIMEOUT_SEKUNDER);
+            break;
+    }
+    stang_anslutning(anslutning);
+}
+
+/**
+ * Sätter anslutningens timer efter dess tillstånd
+ *
+ * @param anslutning - Anslutningen (ägs av reaktortråden)
+ *
+ * Anropas efter varje händelse. Timern startas om bara när sorten av
+ * tidsgräns byts, eller när tidsgrans nollställts efter aktivitet som ska
+ * förlänga den (ett besvarat request, framsteg i en skrivning). Bytes som
+ * kommer till en påbörjad request flyttar alltså inte gränsen.
+ */
+static void uppdatera_tidsgrans(Anslutning* anslutning) {
+    Reaktor* reaktor = anslutning->reaktor;
+    AnslutningsTidsgrans onskad = TIDSGRANS_INGEN;
+    int sekunder = 0;
+
+    if (anslutning->tillstand == ANSLUTNING_LASER) {
+        bool paborjad = anslutning->mottagning.langd > 0;
+        onskad = paborjad ? TIDSGRANS_REQUEST : TIDSGRANS_VILA;
+        sekunder = paborjad ? REQUEST_TIDSGRANS_SEKUNDER : TIMEOUT_SEKUNDER;
+    } else if (anslutning->tillstand == ANSLUTNING_SKRIVER) {
+        onskad = TIDSGRANS_SKRIVNING;
+        sekunder = TIMEOUT_SEKUNDER;
+    }
+
+    if (onskad == TIDSGRANS_INGEN) {
+        stoppa_timer(&reaktor->timers, &anslutning->timer);
+    } else if (onskad != anslutning->tidsgrans) {
+        starta_timer(&reaktor->timers, &anslutning->timer,
+                     reaktor->nu + (uint64_t)sekunder * 1000);
+    }
+    anslutning->tidsgrans = onskad;
+}
+
+/**
+ * Skickar så mycket som möjligt av ett svar utan att blockera
+ *
+ * @param fd - Klientens socket
+ * @param data - Data att skicka
+ * @param langd - Antal bytes i data
+ * @param skickat - In: redan skickat, ut: skickat efter anropet
+ * @return true om inget fel uppstod (allt skickat eller EAGAIN), false vid fel
+ */
+static bool skicka_icke_blockerande(socket_t fd, const char* data,
+                                    size_t langd, size_t* skickat) {
+    while (*skickat < langd) {
+        // MSG_NOSIGNAL förhindrar SIGPIPE om klienten redan har stängt
+        ssize_t n = send(fd, data + *skickat, langd - *skickat, MSG_NOSIGNAL);
+        if (n > 0) {
+            *skickat += (size_t)n;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return true;  // Socketbufferten är full, fortsätt vid nästa EPOLLOUT
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Skickar ett färdigt svar och avgör anslutningens nästa tillstånd
+ *
+ * @param anslutning - Anslutningen svaret gäller
+ * @param svar - Headers och body (bodyn ligger i en buffer som återanvänds
+ *               efter anropet)
+ * @return ANSLUTNING_LASER om allt skickats och anslutningen hålls öppen,
+ *         ANSLUTNING_STANGD om allt skickats utan keep-alive eller fel uppstod,
+ *         ANSLUTNING_SKRIVER om resten ligger i anslutningens ut_buffer
+ *
+ * I normalfallet går headers och body ut i ett enda sendmsg() utan att
+ * bodyn kopieras. Endast om socketen inte tar emot allt kopieras resten
+ * till anslutningens egen buffer.
+ */
+static AnslutningsTillstand skicka_svar(Anslutning* anslutning, const HttpSvar* svar) {
+    size_t skickat = 0;
+    if (!skicka_http_svar(anslutning->fd, svar, &skickat)) {
+        return ANSLUTNING_STANGD;
+    }
+
+    size_t langd = svar->huvud_langd + svar->kropp_langd;
+    if (skickat == langd) {
+        // Hela svaret skickat - läs nästa request eller stäng
+        return anslutning->hall_vid_liv ? ANSLUTNING_LASER : ANSLUTNING_STANGD;
+    }
+
+    // Kort skrivning: spara resten tills socketen blir skrivbar igen
+    anslutning->ut_langd = langd - skickat;
+    anslutning->ut_skickat = 0;
+    anslutning->ut_buffer = malloc(anslutning->ut_langd);
+    if (!anslutning->ut_buffer) {
+        LOGG_FEL("Minnesallokering misslyckades för svarsbuffer");
+        return ANSLUTNING_STANGD;
+    }
+    char* mal = anslutning->ut_buffer;
+    if (skickat < svar->huvud_langd) {
+        size_t rest = svar->huvud_langd - skickat;
+        memcpy(mal, svar->huvud + skickat, rest);
+        memcpy(mal + rest, svar->kropp, svar->kropp_langd);
+    } else {
+        size_t forskjutning = skickat - svar->huvud_langd;
+        memcpy(mal, svar->kropp + forskjutning, svar->kropp_langd - forskjutning);
+    }
+    return ANSLUTNING_SKRIVER;
+}
+
+/**
+ * Fortsätter skicka ett buffrat svar
+ *
+ * @param anslutning - Anslutning i tillståndet SKRIVER
+ *
+ * När svaret är helt skickat stängs anslutningen, eller så går den
+ * tillbaka till LASER om den är persistent.
+ */
+static void fortsatt_skriva(Anslutning* anslutning) {
+    size_t fore = anslutning->ut_skickat;
+    if (!skicka_icke_blockerande(anslutning->fd, anslutning->ut_buffer,
+                                 anslutning->ut_langd, &anslutning->ut_skickat)) {
+        anslutning->tillstand = ANSLUTNING_STANGD;
+        return;
+    }
+    if (anslutning->ut_skickat != fore) {
+        anslutning->tidsgrans = TIDSGRANS_INGEN;  // Klienten läser - förläng tidsgränsen
+    }
+    if (anslutning->ut_skickat == anslutning->ut_langd) {
+        free(anslutning->ut_buffer);
+        anslutning->ut_buffer = NULL;
+        if (anslutning->hall_vid_liv) {
+            http_mottagning_konsumera(&anslutning->mottagning);
+            anslutning->tillstand = ANSLUTNING_LASER;
+        } else {
+            anslutning->tillstand = ANSLUTNING_STANGD;
+        }
+    }
+}
+
+/**
+ * Besvarar alla kompletta requests som ligger i anslutningens buffer
+ *
+ * @param anslutning - Anslutningen (ägs av anroparen under hela anropet)
+ * @param kropp_buffer - Buffer för svarets body
+ * @param kropp_storlek - Storlek på kropp_buffer
+ * @return Nästa tillstånd: LASER om alla requests besvarats och mer data
+ *         behövs, SKRIVER vid kort skrivning, STANGD när anslutningen är klar
+ *
+ * Pipelinade requests besvaras i ordning. Hanteraren får requesten som
+ * pekare och längd direkt i mottagningsbufferten. En request som
+ * inte kan tas emot (för stor, ogiltig Content-Length) får ett felsvar och
+ * anslutningen stängs. Den första requesten har redan passerat
+ * klientgränsen i bearbeta_request(); pipelinade requests efter den
+ * kontrolleras här.
+ */
+static AnslutningsTillstand besvara_buffrade(Anslutning* anslutning,
+                                             char* kropp_buffer, size_t kropp_storlek) {
+    const ReaktorInstallningar* inst = anslutning->reaktor->installningar;
+    HttpMottagning* mottagning = &anslutning->mottagning;
+    HttpSvar svar;
+    bool forsta = true;
+
+    for (;;) {
+        HttpRamStatus status = hitta_http_request(mottagning);
+        if (status == HTTP_RAM_OFULLSTANDIG) {
+            return anslutning->eof ? ANSLUTNING_STANGD : ANSLUTNING_LASER;
+        }
+        atomic_fetch_add_explicit(&anslutning->reaktor->raknare->requests, 1,
+                                  memory_order_relaxed);
+        anslutning->besvarad = true;
+
+        if (status != HTTP_RAM_KOMPLETT) {
+            anslutning->hall_vid_liv = false;
+            skapa_http_mottagningsfel(&svar, kropp_buffer, kropp_storlek, mottagning, status);
+            kasta_vantande_data(anslutning->fd);
+            return skicka_svar(anslutning, &svar);
+        }
+        if (!forsta && !klientgrans_tillat(anslutning->klient_ip)) {
+            anslutning->hall_vid_liv = false;
+            skapa_http_begransad(&svar);
+            kasta_vantande_data(anslutning->fd);
+            return skicka_svar(anslutning, &svar);
+        }
+        forsta = false;
+
+        svar.hall_vid_liv = !anslutning->eof && *anslutning->reaktor->kors;  // Stäng efter svaret vid dränering
+        inst->hanterare(mottagning->data, mottagning->request_langd,
+                        kropp_buffer, kropp_storlek, &svar, inst->kontext);
+        anslutning->hall_vid_liv = svar.hall_vid_liv;
+
+        AnslutningsTillstand tillstand = skicka_svar(anslutning, &svar);
+        anslutning->tidsgrans = TIDSGRANS_INGEN;  // Nästa request får en ny tidsgräns
+        if (tillstand != ANSLUTNING_LASER) {
+            return tillstand;  // Kort skrivning eller stängning - request konsumeras senare
+        }
+        http_mottagning_konsumera(mottagning);
+    }
+}
+
+/**
+ * Arbetaruppgift: bygg och skicka svaret för en anslutning
+ *
+ * @param argument - Anslutningen (tillstånd BEARBETAR)
+ * @param scratch - Arbetarens egen buffer för svarets body
+ * @param scratch_storlek - Storlek på scratch
+ *
+ * Körs i en arbetartråd. Reaktorn rör inte anslutningen medan den är i
+ * BEARBETAR, så arbetaren kan läsa mottagningsbufferten och skriva till socketen
+ * direkt. Alla pipelinade requests i bufferten besvaras i samma uppgift.
+ * Därefter lämnas anslutningen tillbaka via eventfd.
+ *
+ * Eventfd skrivs medan klara_las hålls: så fort reaktorn ser anslutningen
+ * i klara kan den vid avstängning frigöra sig själv och stänga eventfd,
+ * så arbetaren får inte röra reaktorn efter att låset släppts.
+ */
+static void arbeta_med_request(void* argument, char* scratch, size_t scratch_storlek) {
+    Anslutning* anslutning = (Anslutning*)argument;
+    Reaktor* reaktor = anslutning->reaktor;
+
+    anslutning->nasta_tillstand = besvara_buffrade(anslutning, scratch, scratch_storlek);
+
+    // Lämna tillbaka anslutningen till reaktorn
+    pthread_mutex_lock(&reaktor->klara_las);
+    anslutning->nasta_klar = reaktor->klara;
+    reaktor->klara = anslutning;
+    uint64_t ett = 1;
+    ssize_t skrivet = write(reaktor->vacknings_fd, &ett, sizeof(ett));
+    (void)skrivet;  // EAGAIN betyder att räknaren redan är satt - reaktorn vaknar ändå
+    pthread_mutex_unlock(&reaktor->klara_las);
+}
+
+/**
+ * Avvisar en request med ett förbyggt svar
+ *
+ * @param reaktor - Reaktorn
+ * @param anslutning - Anslutningen med en komplett request
+ * @param skapa - skapa_http_overlast (503) eller skapa_http_begransad (429)
+ *
+ * Anslutningen stängs efter svaret; pipelinade requests bakom den kastas.
+ */
+static void avvisa_request(Reaktor* reaktor, Anslutning* anslutning,
+                           void (*skapa)(HttpSvar* svar)) {
+    HttpSvar svar;
+    atomic_fetch_add_explicit(&reaktor->raknare->requests, 1, memory_order_relaxed);
+    anslutning->hall_vid_liv = false;
+    skapa(&svar);
+    kasta_vantande_data(anslutning->fd);
+    anslutning->tillstand = skicka_svar(anslutning, &svar);
+}
+
+/**
+ * Skickar kompletta requests vidare för bearbetning
+ *
+ * @param reaktor - Reaktorn
+ * @param anslutning - Anslutningen med minst en komplett request i mottagningsbufferten
+ *
+ * Med trådpool läggs anslutningen i arbetskön så att reaktorn direkt kan
+ * fortsätta med andra klienter medan ett API-anrop pågår. Utan pool, eller
+ * om kön är full, besvaras requesten direkt i reaktortråden. En klient
+ * som överskridit sin gräns får 429, och ligger arbetarna redan för långt
+ * efter (antagningskontrollen) får requesten 503 - båda direkt, utan att
+ * requesten köas eller parsas.
+ */
+static void bearbeta_request(Reaktor* reaktor, Anslutning* anslutning) {
+    const ReaktorInstallningar* inst = reaktor->installningar;
+
+    if (!klientgrans_tillat(anslutning->klient_ip)) {
+        avvisa_request(reaktor, anslutning, skapa_http_begransad);
+        return;
+    }
+
+    if (inst->pool) {
+        if (!antagning_slapp_in(arbetarpool_kodjup(inst->pool),
+                                arbetarpool_kotid_ms(inst->pool))) {
+            avvisa_request(reaktor, anslutning, skapa_http_overlast);
+            return;
+        }
+
+        // Timern stoppas innan arbetaren tar över - den rör bara reaktorn
+        anslutning->tillstand = ANSLUTNING_BEARBETAR;
+        uppdatera_tidsgrans(anslutning);
+        if (lagg_till_uppgift(inst->pool, arbeta_med_request, anslutning)) {
+            reaktor->antal_bearbetas++;
+            return;
+        }
+        LOGG_DEBUG("Arbetskön är full, hanterar request i reaktorn");
+    }
+
+    anslutning->tillstand = besvara_buffrade(anslutning, reaktor->kropp_buffer,
+                                             sizeof(reaktor->kropp_buffer));
+}
+
+/**
+ * Läser all tillgänglig data från en anslutning (edge-triggered)
+ *
+ * @param anslutning - Anslutningen att läsa från
+ * @return true om en komplett request (eller ett fel att svara på) finns,
+ *         false om mer data behövs
+ *
+ * Med EPOLLET måste vi läsa tills recv() ger EAGAIN, annars kommer ingen
+ * ny notifiering för data som redan ligger i socketbufferten. Bufferten
+ * växer under tiden så att requests som kommer i många segment, eller är
+ * större än BUFFER_STORLEK, sätts ihop i sin helhet.
+ */
+static bool las_fran_anslutning(Anslutning* anslutning) {
+    HttpMottagning* mottagning = &anslutning->mottagning;
+    bool full = false;
+
+    while (!anslutning->eof) {
+        size_t ledigt;
+        char* mal = http_mottagning_ledigt(mottagning, &ledigt);
+        if (!mal) {
+            full = true;  // MAX_REQUEST_STORLEK nådd (eller slut på minne)
+            break;
+        }
+        ssize_t n = recv(anslutning->fd, mal, ledigt, 0);
+        if (n > 0) {
+            http_mottagning_tillfor(mottagning, (size_t)n);
+        } else if (n == 0) {
+            anslutning->eof = true;  // Klienten har stängt sin skrivsida
+        } else if (errno == EINTR) {
+            continue;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            break;
+        } else {
+            anslutning->tillstand = ANSLUTNING_STANGD;
+            return false;
+        }
+    }
+
+    if (hitta_http_request(mottagning) != HTTP_RAM_OFULLSTANDIG) {
+        return true;
+    }
+
+    // Halv request vid EOF, eller full buffer utan att requesten blivit
+    // komplett (bara möjligt om minnet tog slut) - inget att svara på
+    if (anslutning->eof || full) {
+        anslutning->tillstand = ANSLUTNING_STANGD;
+    }
+    return false;
+}
+
+/**
+ * Läser och besvarar requests så länge anslutningen är i LASER
+ *
+ * @param reaktor - Reaktorn
+ * @param anslutning - Anslutningen
+ *
+ * Anropas vid EPOLLIN och när en anslutning kommer tillbaka till LASER
+ * efter ett svar. I det senare fallet kan data ha kommit medan arbetaren
+ * eller skrivningen pågick - den kanten har redan passerat, så vi måste
+ * läsa själva. Om bufferten var full kan det även ligga mer i socketen.
+ */
+static void driv_lasning(Reaktor* reaktor, Anslutning* anslutning) {
+    while (anslutning->tillstand == ANSLUTNING_LASER && las_fran_anslutning(anslutning)) {
+        bearbeta_request(reaktor, anslutning);
+    }
+}
+
+/**
+ * Tar hand om anslutningar som arbetartrådar är klara med
+ *
+ * @param reaktor - Reaktorn
+ *
+ * Körs efter att en hel omgång epoll-händelser behandlats, så att ingen
+ * händelse i samma omgång kan peka på en anslutning som just stängts.
+ */
+static void hantera_klara(Reaktor* reaktor) {
+    uint64_t raknare;
+    ssize_t last = read(reaktor->vacknings_fd, &raknare, sizeof(raknare));
+    (void)last;
+
+    pthread_mutex_lock(&reaktor->klara_las);
+    Anslutning* lista = reaktor->klara;
+    reaktor->klara = NULL;
+    pthread_mutex_unlock(&reaktor->klara_las);
+
+    while (lista) {
+        Anslutning* anslutning = lista;
+        lista = lista->nasta_klar;
+        reaktor->antal_bearbetas--;
+
+        anslutning->tillstand = anslutning->nasta_tillstand;
+        if (anslutning->tillstand == ANSLUTNING_SKRIVER) {
+            // En EPOLLOUT-kant kan ha kommit medan arbetaren ägde anslutningen
+            fortsatt_skriva(anslutning);
+        }
+        if (anslutning->tillstand == ANSLUTNING_LASER && !reaktor->avslutar) {
+            // Likaså kan nästa request redan ha kommit (keep-alive).
+            // När dräneringstiden är ute besvaras inga fler requests.
+            driv_lasning(reaktor, anslutning);
+        }
+        if (anslutning->tillstand == ANSLUTNING_STANGD) {
+            stang_anslutning(anslutning);
+        } else {
+            uppdatera_tidsgrans(anslutning);
+        }
+    }
+}
+
+/**
+ * Tar emot alla väntande anslutningar och registrerar dem i epoll
+ *
+ * @param reaktor - Reaktorn med lyssnande server och epoll-instans
+ */
+static void acceptera_alla(Reaktor* reaktor) {
+    for (;;) {
+        uint32_t klient_ip;
+        socket_t klient = acceptera_klient(reaktor->server, &klient_ip);
+        if (klient == OGILTIG_SOCKET) {
+            return;  // Kön är tom (EAGAIN) eller fel som redan loggats
+        }
+
+        Anslutning* anslutning = malloc(sizeof(Anslutning));
+        if (!anslutning || !initiera_http_mottagning(&anslutning->mottagning)) {
+            LOGG_FEL("Minnesallokering misslyckades för ny anslutning");
+            free(anslutning);
+            stang_socket(klient);
+            continue;
+        }
+        atomic_fetch_add_explicit(&reaktor->raknare->anslutningar, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&reaktor->raknare->oppna, 1, memory_order_relaxed);
+
+        anslutning->fd = klient;
+        anslutning->klient_ip = klient_ip;
+        anslutning->tillstand = ANSLUTNING_LASER;
+        anslutning->nasta_tillstand = ANSLUTNING_LASER;
+        anslutning->reaktor = reaktor;
+        anslutning->nasta_klar = NULL;
+        anslutning->hall_vid_liv = false;
+        anslutning->eof = false;
+        anslutning->besvarad = false;
+        initiera_timer(&anslutning->timer, tidsgrans_utlopt, anslutning);
+        anslutning->tidsgrans = TIDSGRANS_INGEN;
+        anslutning->ut_buffer = NULL;
+        anslutning->ut_langd = 0;
+        anslutning->ut_skickat = 0;
+
+        // Länka in först i listan över öppna anslutningar
+        anslutning->forra = NULL;
+        anslutning->nasta = reaktor->oppna;
+        if (reaktor->oppna) {
+            reaktor->oppna->forra = anslutning;
+        }
+        reaktor->oppna = anslutning;
+
+        // Registrera för både läs- och skrivhändelser en gång för alla;
+        // edge-triggered läge ger bara notifiering vid förändring
+        struct epoll_event handelse;
+        handelse.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        handelse.data.ptr = anslutning;
+        if (epoll_ctl(reaktor->epoll_fd, EPOLL_CTL_ADD, klient, &handelse) < 0) {
+            LOGG_FEL("Kunde inte registrera klient i epoll: fel %d", errno);
+            stang_anslutning(anslutning);
+        } else {
+            uppdatera_tidsgrans(anslutning);  // Första requesten måste komma inom TIMEOUT_SEKUNDER
+        }
+    }
+}
+
+/**
+ * Driver en anslutnings tillståndsmaskin vid en epoll-händelse
+ *
+ * @param reaktor - Reaktorn
+ * @param anslutning - Anslutningen som händelsen gäller
+ * @param handelser - epoll-händelsemask (EPOLLIN, EPOLLOUT, ...)
+ */
+static void hantera_handelse(Reaktor* reaktor, Anslutning* anslutning, uint32_t handelser) {
+    if (anslutning->tillstand == ANSLUTNING_BEARBETAR) {
+        return;  // Arbetaren äger anslutningen, händelsen tas om hand efteråt
+    }
+
+    if (handelser & EPOLLERR) {
+        anslutning->tillstand = ANSLUTNING_STANGD;
+    }
+
+    bool skrev_klart = false;
+    if (anslutning->tillstand == ANSLUTNING_SKRIVER && (handelser & EPOLLOUT)) {
+        fortsatt_skriva(anslutning);
+        skrev_klart = anslutning->tillstand == ANSLUTNING_LASER;
+    }
+
+    // Läs både vid EPOLLIN och när en skrivning just blivit klar på en
+    // persistent anslutning (pipelinade requests kan redan ligga i bufferten)
+    if (anslutning->tillstand == ANSLUTNING_LASER &&
+        (skrev_klart || (handelser & (EPOLLIN | EPOLLRDHUP | EPOLLHUP)))) {
+        driv_lasning(reaktor, anslutning);
+    }
+
+    if (anslutning->tillstand == ANSLUTNING_STANGD) {
+        stang_anslutning(anslutning);
+    } else {
+        uppdatera_tidsgrans(anslutning);
+    }
+}
+
+/**
+ * Hämtar monoton tid i millisekunder
+ *
+ * @return Millisekunder sedan en godtycklig fast tidpunkt
+ */
+static uint64_t monoton_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+/**
+ * Väntar in anslutningar som fortfarande ägs av arbetartrådar
+ *
+ * @param reaktor - Reaktorn som ska avslutas
+ *
+ * Arbetarna skriver till reaktorns eventfd och lista, så reaktorn får inte
+ * försvinna förrän alla pågående requests har lämnats tillbaka.
+ */
+static void vanta_in_arbetare(Reaktor* reaktor) {
+    while (reaktor->antal_bearbetas > 0) {
+        struct pollfd pfd = { .fd = reaktor->vacknings_fd, .events = POLLIN };
+        poll(&pfd, 1, 100);
+        hantera_klara(reaktor);
+    }
+}
+
+/**
+ * Skapar en reaktor med egen epoll-instans och eventfd
+ *
+ * @param server - Initierad TCP-server som reaktorn ska lyssna på
+ * @param installningar - Hanterare, kontext och eventuell trådpool
+ * @param index - Reaktorns nummer, avgör vilken räknarpost den får
+ * @param kors - Loopen avslutas när denna flagga blir false
+ * @return Ny reaktor, eller NULL vid fel
+ */
+static Reaktor* skapa_reaktor(TcpServer* server, const ReaktorInstallningar* installningar,
+                              int index, volatile bool* kors) {
+    if (aktivera_icke_blockerande_lage(server) != 0) {
+        return NULL;
+    }
+
+    Reaktor* reaktor = calloc(1, sizeof(Reaktor));
+    if (!reaktor) {
+        LOGG_FEL("Minnesallokering misslyckades för reaktor");
+        return NULL;
+    }
+    reaktor->server = server;
+    reaktor->installningar = installningar;
+    reaktor->kors = kors;
+    reaktor->index = index;
+    reaktor->raknare = &reaktor_raknare[index];
+    reaktor->nu = monoton_ms();
+    initiera_timerhjul(&reaktor->timers, reaktor->nu);
+    pthread_mutex_init(&reaktor->klara_las, NULL);
+
+    reaktor->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    reaktor->vacknings_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (reaktor->epoll_fd < 0 || reaktor->vacknings_fd < 0) {
+        LOGG_FEL("Kunde inte skapa epoll-instans/eventfd: fel %d", errno);
+        if (reaktor->epoll_fd >= 0) close(reaktor->epoll_fd);
+        if (reaktor->vacknings_fd >= 0) close(reaktor->vacknings_fd);
+        pthread_mutex_destroy(&reaktor->klara_las);
+        free(reaktor);
+        return NULL;
+    }
+
+    // Lyssnande socket registreras nivåtriggad med data.ptr = NULL som markör,
+    // eventfd får pekaren till sitt eget fält som markör
+    struct epoll_event lyssnar_handelse = { .events = EPOLLIN, .data.ptr = NULL };
+    struct epoll_event vacknings_handelse = { .events = EPOLLIN,
+                                              .data.ptr = &reaktor->vacknings_fd };
+    if (epoll_ctl(reaktor->epoll_fd, EPOLL_CTL_ADD, server->lyssnar_socket, &lyssnar_handelse) < 0 ||
+        epoll_ctl(reaktor->epoll_fd, EPOLL_CTL_ADD, reaktor->vacknings_fd, &vacknings_handelse) < 0) {
+        LOGG_FEL("Kunde inte registrera sockets i epoll: fel %d", errno);
+        close(reaktor->epoll_fd);
+        close(reaktor->vacknings_fd);
+        pthread_mutex_destroy(&reaktor->klara_las);
+        free(reaktor);
+        return NULL;
+    }
+
+    // Nollställ räknarna (posten kan ha använts av en tidigare körning)
+    atomic_store(&reaktor->raknare->anslutningar, 0);
+    atomic_store(&reaktor->raknare->requests, 0);
+    atomic_store(&reaktor->raknare->oppna, 0);
+    atomic_store(&reaktor->raknare->avbrutna, 0);
+    return reaktor;
+}
+
+/**
+ * Frigör en reaktor efter att dess loop har avslutats
+ *
+ * @param reaktor - Reaktorn som ska frigöras
+ */
+static void forstor_reaktor(Reaktor* reaktor) {
+    close(reaktor->epoll_fd);
+    close(reaktor->vacknings_fd);
+    pthread_mutex_destroy(&reaktor->klara_las);
+    free(reaktor);
+}
+
+/**
+ * Väntar på och behandlar en omgång epoll-händelser
+ *
+ * @param reaktor - Reaktorn
+ * @param max_vantetid - Längsta väntan i millisekunder
+ * @return false om epoll_wait() misslyckades
+ *
+ * Ingen sömn behövs: epoll_wait() blockerar tills något händer eller
+ * nästa timer i timerhjulet kan löpa ut, dock högst max_vantetid.
+ */
+static bool kor_omgang(Reaktor* reaktor, int max_vantetid) {
+    struct epoll_event handelser[MAX_HANDELSER];
+
+    int vantetid = timerhjul_vantetid(&reaktor->timers, monoton_ms(), max_vantetid);
+    int antal = epoll_wait(reaktor->epoll_fd, handelser, MAX_HANDELSER, vantetid);
+    if (antal < 0) {
+        if (errno == EINTR) {
+            return true;  // Avbruten av signal, anroparen kontrollerar kors
+        }
+        LOGG_FEL("epoll_wait misslyckades: fel %d", errno);
+        return false;
+    }
+    reaktor->nu = monoton_ms();
+
+    bool har_klara = false;
+    for (int i = 0; i < antal; i++) {
+        void* ptr = handelser[i].data.ptr;
+        if (ptr == NULL) {
+            acceptera_alla(reaktor);
+        } else if (ptr == &reaktor->vacknings_fd) {
+            har_klara = true;
+        } else {
+            hantera_handelse(reaktor, (Anslutning*)ptr, handelser[i].events);
+        }
+    }
+
+    if (har_klara) {
+        hantera_klara(reaktor);
+    }
+
+    // Stäng anslutningar vars tidsgräns löpt ut. Körs efter händelserna
+    // så att ingen händelse i omgången pekar på en stängd anslutning.
+    kor_timerhjul(&reaktor->timers, reaktor->nu);
+    return true;
+}
+
+/**
+ * Kör den händelsedrivna serverloopen för en reaktor
+ *
+ * @param argument - Reaktorn (void* så att funktionen kan vara trådstart)
+ * @return NULL
+ *
+ * Väntar högst en sekund åt gången så att kors-flaggan kontrolleras även
+ * när servern är helt stilla. Anslutningarna lämnas öppna när loopen
+ * avslutas - de tas om hand av dranera_reaktor().
+ */
+static void* kor_handelseloop(void* argument) {
+    Reaktor* reaktor = (Reaktor*)argument;
+
+    LOGG_INFO("Reaktor %d startad (epoll, edge-triggered%s)", reaktor->index,
+              reaktor->installningar->pool ? ", med trådpool" : "");
+
+    while (*reaktor->kors && kor_omgang(reaktor, 1000)) {
+    }
+    return NULL;
+}
+
+/**
+ * Stänger anslutningar som inte ägs av en arbetare
+ *
+ * @param reaktor - Reaktorn
+ * @param alla - false: bara vilande anslutningar (inget påbörjat request),
+ *               true: även anslutningar mitt i en request eller ett svar
+ * @return Antal stängda anslutningar som hade en request på gång
+ *
+ * En nyss accepterad anslutning räknas inte som vilande förrän den fått
+ * sitt första svar eller DRANERING_FORSTA_REQUEST_MS har gått - klienten
+ * har troligen redan skickat requesten, den har bara inte kommit fram.
+ * Annars skulle en omstart avbryta anslutningar som just accepterats.
+ */
+static int stang_anslutningar(Reaktor* reaktor, bool alla) {
+    int avbrutna = 0;
+    Anslutning* anslutning = reaktor->oppna;
+    while (anslutning) {
+        Anslutning* nasta = anslutning->nasta;
+        bool vilande = anslutning->tillstand == ANSLUTNING_LASER &&
+                       anslutning->mottagning.langd == 0 &&
+                       (anslutning->besvarad || reaktor->nu >= reaktor->forsta_request_slut);
+        if (anslutning->tillstand != ANSLUTNING_BEARBETAR && (vilande || alla)) {
+            if (!vilande) {
+                avbrutna++;
+            }
+            stang_anslutning(anslutning);
+        }
+        anslutning = nasta;
+    }
+    return avbrutna;
+}
+
+/**
+ * Dränerar en reaktor efter att loopen har avslutats
+ *
+ * @param reaktor - Reaktorn
+ *
+ * Den lyssnande socketen stängs först, så att kärnan skickar nya
+ * anslutningar till övriga sockets på porten (t.ex. en ny serverprocess
+ * med SO_REUSEPORT) i stället för att lägga dem i kön här. Vilande
+ * keep-alive-anslutningar stängs direkt. Övriga får bli klara i högst
+ * dranering_sekunder; deras svar får Connection: close. Därefter stängs
+ * det som återstår och antalet avbrutna requests loggas.
+ */
+static void dranera_reaktor(Reaktor* reaktor) {
+    int sekunder = reaktor->installningar->dranering_sekunder;
+    uint64_t start = monoton_ms();
+    uint64_t slut = start + (uint64_t)(sekunder > 0 ? sekunder : 0) * 1000;
+    reaktor->nu = start;
+    reaktor->forsta_request_slut = start + DRANERING_FORSTA_REQUEST_MS;
+
+    // Ta bort lyssnaren ur epoll innan den stängs. close() räcker inte när
+    // socketen är öppen även i en annan process (efter en överlämning) -
+    // epoll följer socketen, inte descriptorn, och skulle fortsätta väcka oss.
+    epoll_ctl(reaktor->epoll_fd, EPOLL_CTL_DEL, reaktor->server->lyssnar_socket, NULL);
+    stang_tcp_server(reaktor->server);
+    stang_anslutningar(reaktor, false);
+    long kvar = atomic_load_explicit(&reaktor->raknare->oppna, memory_order_relaxed);
+    if (kvar > 0) {
+        LOGG_INFO("Reaktor %d dränerar %ld anslutningar (högst %d s)", reaktor->index,
+                  kvar, sekunder);
+    }
+
+    for (;;) {
+        uint64_t nu = monoton_ms();
+        if (!reaktor->oppna || nu >= slut) {
+            break;
+        }
+        uint64_t rest = slut - nu;
+        if (!kor_omgang(reaktor, rest < 1000 ? (int)rest : 1000)) {
+            break;
+        }
+        stang_anslutningar(reaktor, false);  // Klara med sitt sista svar
+    }
+
+    // Tiden är ute. Arbetare måste ändå väntas in (de skriver till
+    // reaktorns lista och eventfd), men inga fler requests besvaras.
+    reaktor->avslutar = true;
+    int avbrutna = stang_anslutningar(reaktor, true);
+    vanta_in_arbetare(reaktor);
+    avbrutna += stang_anslutningar(reaktor, true);
+    atomic_store(&reaktor->raknare->avbrutna, (unsigned long long)avbrutna);
+
+    unsigned long long tid = (unsigned long long)(monoton_ms() - start);
+    if (avbrutna > 0) {
+        LOGG_VARNING("Reaktor %d dränerad på %llu ms, %d requests avbrutna",
+                     reaktor->index, tid, avbrutna);
+    } else {
+        LOGG_INFO("Reaktor %d dränerad på %llu ms", reaktor->index, tid);
+    }
+}
+
+// En reaktortråd med den bakände som valts i ReaktorInstallningar.io
+typedef struct {
+    Reaktor* epoll;                               // Satt med REAKTOR_IO_EPOLL
+    UringReaktor* uring;                          // Satt med REAKTOR_IO_URING
+    pthread_t trad;                               // Tråden som kör reaktorn (index > 0)
+} ReaktorTrad;
+
+// Kör reaktorns loop med rätt bakände tills kors blir false
+static void kor_reaktor_loop(ReaktorTrad* trad) {
+    if (trad->uring) {
+        kor_uring_reaktor(trad->uring);
+    } else {
+        kor_handelseloop(trad->epoll);
+    }
+}
+
+// Dränerar och stänger reaktorns anslutningar efter loopen
+static void dranera_reaktor_trad(ReaktorTrad* trad) {
+    if (trad->uring) {
+        dranera_uring_reaktor(trad->uring);
+    } else {
+        dranera_reaktor(trad->epoll);
+    }
+}
+
+/**
+ * Trådstart för reaktorer utöver reaktor 0
+ *
+ * @param argument - ReaktorTrad
+ * @return NULL
+ */
+static void* kor_reaktor_trad(void* argument) {
+    ReaktorTrad* trad = (ReaktorTrad*)argument;
+    kor_reaktor_loop(trad);
+    dranera_reaktor_trad(trad);
+    return NULL;
+}
+
+/**
+ * Väcker en reaktor så att den ser att kors har blivit false
+ *
+ * @param trad - Reaktortråden
+ */
+static void vack_reaktor(ReaktorTrad* trad) {
+    if (trad->uring) {
+        vack_uring_reaktor(trad->uring);
+        return;
+    }
+    uint64_t ett = 1;
+    ssize_t skrivet = write(trad->epoll->vacknings_fd, &ett, sizeof(ett));
+    (void)skrivet;
+}
+
+// Frigör reaktorn i en reaktortråd efter att loopen har avslutats
+static void forstor_reaktor_trad(ReaktorTrad* trad) {
+    if (trad->uring) {
+        forstor_uring_reaktor(trad->uring);
+    } else {
+        forstor_reaktor(trad->epoll);
+    }
+}
+
+/**
+ * Kör en eller flera reaktorer tills servern stoppas
+ *
+ * @param servrar - Array med initierade TCP-servrar, en per reaktor
+ * @param antal - Antal servrar/reaktorer (1 till MAX_REAKTORER)
+ * @param installningar - Hanterare, kontext, trådpool och I/O-bakände (delas)
+ * @param kors - Reaktorerna avslutas när denna flagga blir false
+ * @return 0 vid normal avslutning, -1 vid fel
+ *
+ * Varje reaktor har egen epoll-instans (eller io_uring), egna anslutningar
+ * och egen lyssnande socket, så reaktorerna delar inget tillstånd utom
+ * trådpoolen. Reaktor 0 körs i den anropande tråden och tar emot
+ * SIGINT/SIGTERM; övriga trådar blockerar signaler och väcks via sin
+ * eventfd när reaktor 0 lämnar sin loop. Därefter dränerar varje reaktor
+ * sina egna anslutningar parallellt.
+ */
+int kor_reaktorer(TcpServer* servrar, int antal, const ReaktorInstallningar* installningar,
+                  volatile bool* kors) {
+    if (antal < 1 || antal > MAX_REAKTORER) {
+        LOGG_FEL("Ogiltigt antal reaktorer: %d (1-%d)", antal, MAX_REAKTORER);
+        return -1;
+    }
+
+    ReaktorTrad reaktorer[MAX_REAKTORER];
+    memset(reaktorer, 0, sizeof(reaktorer));
+    for (int i = 0; i < antal; i++) {
+        if (installningar->io == REAKTOR_IO_URING) {
+            reaktorer[i].uring = skapa_uring_reaktor(&servrar[i], installningar,
+                                                     &reaktor_raknare[i], kors);
+        } else {
+            reaktorer[i].epoll = skapa_reaktor(&servrar[i], installningar, i, kors);
+        }
+        if (!reaktorer[i].epoll && !reaktorer[i].uring) {
+            while (i-- > 0) {
+                forstor_reaktor_trad(&reaktorer[i]);
+            }
+            return -1;
+        }
+    }
+    atomic_store(&antal_reaktorer, antal);
+
+    // Blockera signaler medan trådarna skapas - de ärver signalmasken
+    sigset_t alla, gammal;
+    sigfillset(&alla);
+    pthread_sigmask(SIG_BLOCK, &alla, &gammal);
+
+    int startade = 1;
+    for (; startade < antal; startade++) {
+        if (pthread_create(&reaktorer[startade].trad, NULL, kor_reaktor_trad,
+                           &reaktorer[startade]) != 0) {
+            LOGG_FEL("Kunde inte skapa reaktortråd %d", startade);
+            break;
+        }
+    }
+
+    pthread_sigmask(SIG_SETMASK, &gammal, NULL);
+
+    int resultat = 0;
+    if (startade == antal) {
+        kor_reaktor_loop(&reaktorer[0]);
+        *kors = false;  // Även om reaktor 0 stoppade av ett fel ska alla stoppa
+        LOGG_INFO("Avslutar - tar inte emot fler anslutningar, dränerar pågående "
+                  "requests (högst %d s)", installningar->dranering_sekunder);
+    } else {
+        *kors = false;  // Starta inte halvvägs - stoppa de trådar som hann starta
+        resultat = -1;
+    }
+    uint64_t dranering_start = monoton_ms();
+
+    // Väck övriga reaktorer direkt i stället för att vänta på tidsgränsen
+    for (int i = 1; i < startade; i++) {
+        vack_reaktor(&reaktorer[i]);
+    }
+    if (startade == antal) {
+        dranera_reaktor_trad(&reaktorer[0]);
+    }
+    for (int i = 1; i < startade; i++) {
+        pthread_join(reaktorer[i].trad, NULL);
+    }
+
+    unsigned long long avbrutna = 0;
+    for (int i = 0; i < antal; i++) {
+        ReaktorRaknare* r = &reaktor_raknare[i];
+        LOGG_INFO("Reaktor %d: %llu anslutningar, %llu requests", i,
+                  atomic_load(&r->anslutningar), atomic_load(&r->requests));
+        avbrutna += atomic_load(&r->avbrutna);
+    }
+    LOGG_INFO("Dränering klar på %llu ms, %llu requests avbrutna",
+              (unsigned long long)(monoton_ms() - dranering_start), avbrutna);
+
+    atomic_store(&antal_reaktorer, 0);
+    for (int i = 0; i < antal; i++) {
+        forstor_reaktor_trad(&reaktorer[i]);
+    }
+    return resultat;
+}
+
+/**
+ * Hämtar räknarna för alla reaktorer som körs
+ *
+ * @param ut - Array där ögonblicksbilderna skrivs
+ * @param max_antal - Antal platser i ut
+ * @return Antal reaktorer som skrevs till ut
+ *
+ * Räknarna läses utan lås, så summan av flera fält kan vara några
+ * requests ur fas med varandra - tillräckligt för att se fördelningen.
+ */
+int hamta_reaktor_statistik(ReaktorStatistik* ut, int max_antal) {
+    int antal = atomic_load(&antal_reaktorer);
+    if (antal > max_antal) {
+        antal = max_antal;
+    }
+    for (int i = 0; i < antal; i++) {
+        ReaktorRaknare* r = &reaktor_raknare[i];
+        ut[i].anslutningar = atomic_load_explicit(&r->anslutningar, memory_order_relaxed);
+        ut[i].requests = atomic_load_explicit(&r->requests, memory_order_relaxed);
+        ut[i].oppna = atomic_load_explicit(&r->oppna, memory_order_relaxed);
+    }
+    return antal;
+}
+
+#else
+
+// Utan epoll finns ingen reaktor och därmed ingen statistik
+int hamta_reaktor_statistik(ReaktorStatistik* ut, int max_antal) {
+    (void)ut;
+    (void)max_antal;
+    return 0;
+}
+
+#endif // __linux__
@@ -0,0 +1,131 @@
+#include "rutter.h"          // Egna deklarationer
+#include <string.h>          // För memcmp, memset och strlen
+
+// Så många startvärden provas innan bygget ger upp. Med minst fyra
+// platser per rutt räcker det i praktiken med ett fåtal försök.
+#define MAX_FORSOK 100000
+
+/**
+ * Hash (FNV-1a) över metod och sökväg
+ *
+ * @param fro - Startvärde
+ * @param metod - HTTP-metoden
+ * @param sokvag - Sökvägen
+ * @return Plats i tabellen
+ */
+static size_t hasha_rutt(uint32_t fro, HttpMetod metod, HttpVy sokvag) {
+    uint32_t h = (2166136261u ^ fro) * 16777619u;
+    h = (h ^ (uint32_t)metod) * 16777619u;
+    for (size_t i = 0; i < sokvag.langd; i++) {
+        h = (h ^ (unsigned char)sokvag.data[i]) * 16777619u;
+    }
+    // Blanda de höga bitarna in i de låga som används som plats
+    h ^= h >> 15;
+    return h & (RUTT_TABELL_STORLEK - 1);
+}
+
+static HttpVy sokvag_vy(const Rutt* rutt) {
+    HttpVy vy = { rutt->sokvag, strlen(rutt->sokvag) };
+    return vy;
+}
+
+/**
+ * Bygger den perfekta hashtabellen för rutterna
+ *
+ * @param tabell - Tabellen som fylls i
+ * @param rutter - Rutterna (måste finnas kvar så länge tabellen används)
+ * @param antal - Antal rutter
+ * @return false om rutterna är för många, innehåller dubbletter eller
+ *         om inget startvärde ger en tabell utan krockar
+ *
+ * Startvärdet provas fram från 0, så samma rutter ger alltid samma tabell.
+ * Anropas en gång vid start, innan trådarna som gör uppslag startar.
+ */
+bool bygg_ruttabell(RuttTabell* tabell, const Rutt* rutter, int antal) {
+    _Static_assert((RUTT_TABELL_STORLEK & (RUTT_TABELL_STORLEK - 1)) == 0 &&
+                   RUTT_TABELL_STORLEK >= 4 * MAX_RUTTER && MAX_RUTTER < 256,
+                   "RUTT_TABELL_STORLEK måste vara en tvåpotens, minst 4 * MAX_RUTTER");
+
+    if (antal < 0 || antal > MAX_RUTTER) {
+        return false;
+    }
+    // Dubbletter kan aldrig få egna platser
+    for (int i = 0; i < antal; i++) {
+        for (int j = i + 1; j < antal; j++) {
+            if (rutter[i].metod == rutter[j].metod &&
+                strcmp(rutter[i].sokvag, rutter[j].sokvag) == 0) {
+                return false;
+            }
+        }
+    }
+
+    tabell->rutter = rutter;
+    tabell->antal = antal;
+    for (uint32_t fro = 0; fro < MAX_FORSOK; fro++) {
+        memset(tabell->platser, 0, sizeof(tabell->platser));
+        bool krock = false;
+        for (int i = 0; i < antal && !krock; i++) {
+            size_t plats = hasha_rutt(fro, rutter[i].metod, sokvag_vy(&rutter[i]));
+            if (tabell->platser[plats] != 0) {
+                krock = true;
+            } else {
+                tabell->platser[plats] = (uint8_t)(i + 1);
+            }
+        }
+        if (!krock) {
+            tabell->fro = fro;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Slår upp rutten för en request
+ *
+ * @param tabell - Tabell från bygg_ruttabell()
+ * @param metod - Requestens metod
+ * @param sokvag - Requestens sökväg (utan query)
+ * @return Rutten, eller NULL om ingen endpoint har den metoden och sökvägen
+ */
+const Rutt* hitta_rutt(const RuttTabell* tabell, HttpMetod metod, HttpVy sokvag) {
+    uint8_t index = tabell->platser[hasha_rutt(tabell->fro, metod, sokvag)];
+    if (index == 0) {
+        return NULL;
+    }
+    // Platsen kan tillhöra en annan (metod, sökväg) med samma hash
+    const Rutt* rutt = &tabell->rutter[index - 1];
+    if (rutt->metod != metod || strlen(rutt->sokvag) != sokvag.langd ||
+        memcmp(rutt->sokvag, sokvag.data, sokvag.langd) != 0) {
+        return NULL;
+    }
+    return rutt;
+}
+
+/**
+ * Kontrollerar att rutternas obligatoriska parametrar har ett värde
+ *
+ * @param rutt - Rutten
+ * @param query - Requestens tolkade query-sträng
+ * @return Namnet på första parameter som saknas eller är tom, eller NULL
+ *
+ * "?city=" räknas som saknad: ett tomt värde skulle annars skickas vidare
+ * till hanteraren (och upstream) och komma tillbaka som ett serverfel.
+ */
+const char* saknad_parameter(const Rutt* rutt, const HttpQuery* query) {
+    for (int i = 0; i < RUTT_MAX_PARAMETRAR && rutt->obligatoriska[i]; i++) {
+        const char* varde = query_varde(query, rutt->obligatoriska[i]);
+        if (!varde || varde[0] == '\0') {
+            return rutt->obligatoriska[i];
+        }
+    }
+    return NULL;
+}
+
+const char* http_metod_namn(HttpMetod metod) {
+    switch (metod) {
+    case HTTP_GET:  return "GET";
+    case HTTP_POST: return "POST";
+    default:        return "?";
+    }
+}
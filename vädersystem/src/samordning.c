@@ -0,0 +1,185 @@
+#include "samordning.h"      // Samordningens API
+#include "loggning.h"         // För loggning av samordnade hämtningar
+#include <stdlib.h>           // För malloc, free
+#include <string.h>           // För strcmp, memcpy
+#include <stdio.h>            // För snprintf
+#include <stdatomic.h>        // För räknarna
+
+// Räknare - läses av statistik-endpointen utan lås
+static _Atomic unsigned long long antal_hamtningar = 0;
+static _Atomic unsigned long long antal_samordnade = 0;
+static _Atomic unsigned long long antal_pagaende = 0;
+
+#ifdef __linux__
+#include <pthread.h>          // För mutex och villkorsvariabel
+
+// En hämtning som pågår. Posten ägs gemensamt av ledaren och alla som
+// väntar på den och frigörs av den som släpper den sist.
+typedef struct PagaendeHamtning {
+    char typ[16];                                 // Endpoint ("vader", "prognos")
+    char stad[64];                                // Samma storlek som stad i main.c
+    char landskod[8];
+    void* resultat;                               // Ledarens resultat, kopieras av väntande
+    bool klar;                                    // Ledaren är färdig
+    bool lyckades;                                // Hämtningens returvärde
+    int anvandare;                                // Ledare + väntande som håller posten
+    pthread_cond_t klar_signal;                   // Signaleras när klar blir true
+    struct PagaendeHamtning* nasta;
+} PagaendeHamtning;
+
+// Pågående hämtningar. Listan är kort (högst en post per arbetartråd),
+// så linjär sökning under ett lås räcker.
+static pthread_mutex_t pagaende_las = PTHREAD_MUTEX_INITIALIZER;
+static PagaendeHamtning* pagaende = NULL;
+
+/**
+ * Letar upp en pågående hämtning
+ *
+ * @param typ - Endpoint
+ * @param stad - Stadens namn
+ * @param landskod - Landskod
+ * @return Posten, eller NULL om ingen hämtning pågår för nyckeln
+ *
+ * Anroparen måste hålla pagaende_las.
+ */
+static PagaendeHamtning* hitta_pagaende(const char* typ, const char* stad,
+                                        const char* landskod) {
+    for (PagaendeHamtning* post = pagaende; post; post = post->nasta) {
+        if (strcmp(post->typ, typ) == 0 && strcmp(post->stad, stad) == 0 &&
+            strcmp(post->landskod, landskod) == 0) {
+            return post;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Tar bort en post ur listan med pågående hämtningar
+ *
+ * @param post - Posten som ska tas bort
+ *
+ * Anroparen måste hålla pagaende_las.
+ */
+static void ta_bort_pagaende(PagaendeHamtning* post) {
+    PagaendeHamtning** lank = &pagaende;
+    while (*lank && *lank != post) {
+        lank = &(*lank)->nasta;
+    }
+    if (*lank) {
+        *lank = post->nasta;
+    }
+}
+
+/**
+ * Släpper en användares referens till en post
+ *
+ * @param post - Posten
+ *
+ * Anroparen måste hålla pagaende_las. Den sista användaren frigör posten.
+ */
+static void slapp_post(PagaendeHamtning* post) {
+    if (--post->anvandare == 0) {
+        pthread_cond_destroy(&post->klar_signal);
+        free(post->resultat);
+        free(post);
+    }
+}
+#endif // __linux__
+
+/**
+ * Hämtar data, eller väntar in en identisk hämtning som redan pågår
+ *
+ * @param typ - Endpoint ("vader", "prognos")
+ * @param stad - Stadens namn
+ * @param landskod - Landskod
+ * @param resultat - Här hamnar resultatet
+ * @param resultat_storlek - Storlek på resultat i bytes
+ * @param hamta - Funktion som gör själva hämtningen
+ * @param kontext - Skickas vidare till hamta
+ * @return true om hämtningen lyckades, false annars
+ *
+ * Den första tråden för en nyckel blir ledare och kör hamta() utan att
+ * hålla låset. Trådar som kommer medan den pågår sover på en
+ * villkorsvariabel och kopierar ledarens resultat. Posten tas bort ur
+ * listan innan de väntande väcks, så en senare cachemiss startar en ny
+ * hämtning. hamta() bör därför skriva till cachen innan den returnerar.
+ */
+bool samordnad_hamtning(const char* typ, const char* stad, const char* landskod,
+                        void* resultat, size_t resultat_storlek,
+                        HamtningsFunktion hamta, void* kontext) {
+#ifdef __linux__
+    pthread_mutex_lock(&pagaende_las);
+
+    PagaendeHamtning* post = hitta_pagaende(typ, stad, landskod);
+    if (post) {
+        // Någon hämtar redan samma sak - vänta på den
+        post->anvandare++;
+        atomic_fetch_add_explicit(&antal_samordnade, 1, memory_order_relaxed);
+        LOGG_DEBUG("Väntar på pågående hämtning av %s för %s,%s", typ, stad, landskod);
+        while (!post->klar) {
+            pthread_cond_wait(&post->klar_signal, &pagaende_las);
+        }
+        bool lyckades = post->lyckades;
+        if (lyckades) {
+            memcpy(resultat, post->resultat, resultat_storlek);
+        }
+        slapp_post(post);
+        pthread_mutex_unlock(&pagaende_las);
+        return lyckades;
+    }
+
+    // Ingen hämtning pågår - bli ledare
+    post = calloc(1, sizeof(PagaendeHamtning));
+    if (!post || !(post->resultat = malloc(resultat_storlek))) {
+        // Utan post går det inte att samordna, men hämtningen kan ändå göras
+        free(post);
+        pthread_mutex_unlock(&pagaende_las);
+        LOGG_FEL("Minnesallokering misslyckades för samordnad hämtning");
+        atomic_fetch_add_explicit(&antal_hamtningar, 1, memory_order_relaxed);
+        return hamta(stad, landskod, resultat, kontext);
+    }
+    snprintf(post->typ, sizeof(post->typ), "%s", typ);
+    snprintf(post->stad, sizeof(post->stad), "%s", stad);
+    snprintf(post->landskod, sizeof(post->landskod), "%s", landskod);
+    post->anvandare = 1;
+    pthread_cond_init(&post->klar_signal, NULL);
+    post->nasta = pagaende;
+    pagaende = post;
+    atomic_fetch_add_explicit(&antal_pagaende, 1, memory_order_relaxed);
+    pthread_mutex_unlock(&pagaende_las);
+
+    // Själva hämtningen görs utan lås; ingen läser resultatet förrän klar är satt
+    atomic_fetch_add_explicit(&antal_hamtningar, 1, memory_order_relaxed);
+    bool lyckades = hamta(stad, landskod, post->resultat, kontext);
+    if (lyckades) {
+        memcpy(resultat, post->resultat, resultat_storlek);
+    }
+
+    pthread_mutex_lock(&pagaende_las);
+    ta_bort_pagaende(post);
+    post->lyckades = lyckades;
+    post->klar = true;
+    pthread_cond_broadcast(&post->klar_signal);
+    slapp_post(post);
+    pthread_mutex_unlock(&pagaende_las);
+    atomic_fetch_sub_explicit(&antal_pagaende, 1, memory_order_relaxed);
+    return lyckades;
+#else
+    // Den blockerande loopen hanterar en klient i taget - inget att samordna
+    (void)typ;
+    (void)resultat_storlek;
+    atomic_fetch_add_explicit(&antal_hamtningar, 1, memory_order_relaxed);
+    return hamta(stad, landskod, resultat, kontext);
+#endif
+}
+
+/**
+ * Kopierar samordningens räknare
+ *
+ * @param ut - Här sparas räknarna
+ */
+void hamta_samordnings_statistik(SamordningsStatistik* ut) {
+    ut->hamtningar = atomic_load_explicit(&antal_hamtningar, memory_order_relaxed);
+    ut->samordnade = atomic_load_explicit(&antal_samordnade, memory_order_relaxed);
+    ut->pagaende = atomic_load_explicit(&antal_pagaende, memory_order_relaxed);
+}
@@ -1,21 +1,28 @@
+#define _GNU_SOURCE           // För accept4() på Linux
 #include "tcp_server.h"      // TCP-serverfunktioner och datastrukturer
 #include "loggning.h"         // För loggning av händelser och fel
-#include "konfiguration.h"    // Konfigurationskonstanter (MAX_KLIENTER, portar, etc.)
+#include "konfiguration.h"    // Konfigurationskonstanter (LYSSNINGSKO_STORLEK, portar, etc.)
 #include <string.h>           // För memset (nollställning av minnesområden)
 #include <stdio.h>            // För snprintf och annan I/O
+#include <stddef.h>           // För offsetof
+#ifndef _WIN32
+#include <sys/un.h>           // För sockaddr_un (lokal Unix-socket)
+#include <sys/stat.h>         // För S_ISSOCK (kvarlämnad socketfil)
+#endif
 
 /**
- * Initierar och startar en TCP-server
+ * Skapar lyssnande socket för en TCP-server
  *
  * @param server - Pekare till TcpServer-struktur där serverdata ska lagras
  * @param port - Portnummer att lyssna på (t.ex. 8080)
+ * @param dela_port - True för SO_REUSEPORT (flera sockets på samma port)
  * @return 0 vid framgång, -1 vid fel
  *
  * Funktionen skapar en TCP-socket, binder den till angiven port och
- * börjar lyssna efter inkommande anslutningar. Servern kan hantera
- * upp till MAX_KLIENTER samtidiga anslutningar.
+ * börjar lyssna efter inkommande anslutningar. Upp till LYSSNINGSKO_STORLEK
+ * anslutningar kan vänta på accept() innan kärnan börjar tappa SYN.
  */
-int initiera_tcp_server(TcpServer* server, int port) {
+static int starta_tcp_server(TcpServer* server, int port, bool dela_port) {
     LOGG_INFO("Initierar TCP-server på port %d", port);
 
     // Initiera nätverksbiblioteket (krävs på Windows för Winsock, no-op på Linux)
@@ -25,11 +32,16 @@ int initiera_tcp_server(TcpServer* server, int port) {
     }
 
     // Spara porten i server-strukturen för framtida referens
+    server->familj = AF_INET;
     server->port = port;
+    server->sokvag[0] = '\0';
 
     // Servern är inte igång än (sätts till true när listen() lyckas)
     server->kors = false;
 
+    // Blockerande läge tills reaktorn eventuellt aktiverar icke-blockerande
+    server->icke_blockerande = false;
+
     // Skapa en TCP-socket (AF_INET = IPv4, SOCK_STREAM = TCP, IPPROTO_TCP = TCP-protokoll)
     server->lyssnar_socket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
 
@@ -49,6 +61,26 @@ int initiera_tcp_server(TcpServer* server, int port) {
         // Fortsätt ändå - inte kritiskt
     }
 
+    // SO_REUSEPORT låter flera sockets (en per reaktortråd) binda samma port.
+    // Kärnan fördelar då nya anslutningar mellan dem med en hash på
+    // klientens adress, så ingen enskild accept-kö blir en flaskhals.
+    if (dela_port) {
+#ifdef SO_REUSEPORT
+        if (setsockopt(server->lyssnar_socket, SOL_SOCKET, SO_REUSEPORT,
+                       (const char*)&ja, sizeof(ja)) < 0) {
+            LOGG_FEL("Kunde inte sätta SO_REUSEPORT: fel %d", hamta_senaste_socket_fel());
+            stang_socket(server->lyssnar_socket);
+            rensa_natverksbibliotek();
+            return -1;
+        }
+#else
+        LOGG_FEL("SO_REUSEPORT stöds inte på denna plattform");
+        stang_socket(server->lyssnar_socket);
+        rensa_natverksbibliotek();
+        return -1;
+#endif
+    }
+
     // Förbered serveradressen (IP och port)
     struct sockaddr_in server_adress;
 
@@ -78,8 +110,9 @@ int initiera_tcp_server(TcpServer* server, int port) {
     }
 
     // Börja lyssna efter inkommande anslutningar
-    // MAX_KLIENTER definierar hur många anslutningar som kan vänta i kö
-    if (listen(server->lyssnar_socket, MAX_KLIENTER) == SOCKET_FEL) {
+    // LYSSNINGSKO_STORLEK definierar hur många anslutningar som kan vänta i kö
+    // (kärnan begränsar värdet ytterligare med net.core.somaxconn)
+    if (listen(server->lyssnar_socket, LYSSNINGSKO_STORLEK) == SOCKET_FEL) {
         LOGG_FEL("Kunde inte lyssna på socket: fel %d", hamta_senaste_socket_fel());
         stang_socket(server->lyssnar_socket);
         rensa_natverksbibliotek();
@@ -92,27 +125,203 @@ int initiera_tcp_server(TcpServer* server, int port) {
     return 0;  // Framgång
 }
 
+/**
+ * Initierar och startar en TCP-server
+ *
+ * @param server - Pekare till TcpServer-struktur där serverdata ska lagras
+ * @param port - Portnummer att lyssna på (t.ex. 8080)
+ * @return 0 vid framgång, -1 vid fel
+ */
+int initiera_tcp_server(TcpServer* server, int port) {
+    return starta_tcp_server(server, port, false);
+}
+
+/**
+ * Initierar en TCP-server som delar porten med andra sockets
+ *
+ * @param server - Pekare till TcpServer-struktur där serverdata ska lagras
+ * @param port - Portnummer att lyssna på (t.ex. 8080)
+ * @return 0 vid framgång, -1 vid fel
+ *
+ * Används i multireaktorläget: varje reaktortråd får en egen lyssnande
+ * socket med egen accept-kö, alla bundna till samma port.
+ */
+int initiera_tcp_server_delad(TcpServer* server, int port) {
+    return starta_tcp_server(server, port, true);
+}
+
+/**
+ * Initierar en lyssnande Unix-socket för klienter på samma maskin
+ *
+ * @param server - Pekare till TcpServer-struktur där serverdata ska lagras
+ * @param sokvag - Sökväg i filsystemet (t.ex. /run/vader.sock)
+ * @return 0 vid framgång, -1 vid fel
+ *
+ * En sidovagn på samma värd slipper TCP-stackens kostnad (handskakning,
+ * kontrollsummor, loopback-gränssnittet) men talar samma HTTP. Servern
+ * behandlar anslutningarna exakt som TCP-anslutningar.
+ *
+ * En kvarlämnad socketfil från en tidigare körning tas bort innan bind().
+ * Filen tas inte bort vid stängning: efter en överlämning lyssnar nästa
+ * process fortfarande på samma sökväg.
+ */
+int initiera_unix_server(TcpServer* server, const char* sokvag) {
+#ifdef _WIN32
+    (void)server;
+    LOGG_FEL("Unix-socket (%s) stöds inte på denna plattform", sokvag);
+    return -1;
+#else
+    struct sockaddr_un adress;
+    if (strlen(sokvag) >= sizeof(adress.sun_path) ||
+        strlen(sokvag) >= sizeof(server->sokvag)) {
+        LOGG_FEL("För lång sökväg för Unix-socket: %s", sokvag);
+        return -1;
+    }
+
+    server->familj = AF_UNIX;
+    server->port = 0;
+    server->kors = false;
+    server->icke_blockerande = false;
+    snprintf(server->sokvag, sizeof(server->sokvag), "%s", sokvag);
+
+    server->lyssnar_socket = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (server->lyssnar_socket == OGILTIG_SOCKET) {
+        LOGG_FEL("Kunde inte skapa Unix-socket: fel %d", hamta_senaste_socket_fel());
+        return -1;
+    }
+
+    // Ta bara bort en gammal socket - aldrig en vanlig fil som råkar
+    // ligga på sökvägen
+    struct stat info;
+    if (lstat(sokvag, &info) == 0 && S_ISSOCK(info.st_mode)) {
+        unlink(sokvag);
+    }
+
+    memset(&adress, 0, sizeof(adress));
+    adress.sun_family = AF_UNIX;
+    memcpy(adress.sun_path, sokvag, strlen(sokvag) + 1);
+
+    if (bind(server->lyssnar_socket, (struct sockaddr*)&adress, sizeof(adress)) == SOCKET_FEL) {
+        LOGG_FEL("Kunde inte binda Unix-socket till %s: fel %d",
+                 sokvag, hamta_senaste_socket_fel());
+        stang_socket(server->lyssnar_socket);
+        return -1;
+    }
+
+    if (listen(server->lyssnar_socket, LYSSNINGSKO_STORLEK) == SOCKET_FEL) {
+        LOGG_FEL("Kunde inte lyssna på Unix-socket: fel %d", hamta_senaste_socket_fel());
+        stang_socket(server->lyssnar_socket);
+        unlink(sokvag);
+        return -1;
+    }
+
+    server->kors = true;
+    LOGG_INFO("Lyssnar på Unix-socket %s", sokvag);
+    return 0;
+#endif
+}
+
+/**
+ * Tar över en socket som redan är bunden och lyssnar
+ *
+ * @param server - Pekare till TcpServer-struktur där serverdata ska lagras
+ * @param lyssnar_socket - Lyssnande socket, t.ex. mottagen från en annan process
+ * @return 0 vid framgång, -1 om socketen inte lyssnar eller inte är IPv4/Unix
+ *
+ * Används vid omstart utan avbrott: socketen och dess accept-kö lever
+ * vidare, så anslutningar som kommer under bytet varken nekas eller tappas.
+ * SO_REUSEPORT och andra inställningar följer med socketen.
+ */
+int initiera_tcp_server_fran_socket(TcpServer* server, socket_t lyssnar_socket) {
+    if (initiera_natverksbibliotek() != 0) {
+        LOGG_FEL("Kunde inte initialisera nätverksbibliotek");
+        return -1;
+    }
+
+    // Kontrollera att det verkligen är en lyssnande socket - allt annat
+    // (t.ex. en redan stängd och återanvänd descriptor) avvisas
+    int lyssnar = 0;
+    socklen_t langd = sizeof(lyssnar);
+    struct sockaddr_storage adress;
+    socklen_t adress_langd = sizeof(adress);
+    memset(&adress, 0, sizeof(adress));
+    if (getsockopt(lyssnar_socket, SOL_SOCKET, SO_ACCEPTCONN, (char*)&lyssnar, &langd) != 0 ||
+        !lyssnar ||
+        getsockname(lyssnar_socket, (struct sockaddr*)&adress, &adress_langd) != 0) {
+        LOGG_FEL("Ärvd socket lyssnar inte");
+        rensa_natverksbibliotek();
+        return -1;
+    }
+
+    server->lyssnar_socket = lyssnar_socket;
+    server->familj = adress.ss_family;
+    server->port = 0;
+    server->sokvag[0] = '\0';
+    server->kors = true;
+    server->icke_blockerande = false;  // Sätts om av reaktorn som vanligt
+
+    if (adress.ss_family == AF_INET) {
+        server->port = ntohs(((struct sockaddr_in*)&adress)->sin_port);
+        LOGG_INFO("TCP-server tar över lyssnande socket på port %d", server->port);
+        return 0;
+    }
+#ifndef _WIN32
+    if (adress.ss_family == AF_UNIX) {
+        // sun_path är inte alltid nollterminerad när den är full
+        const struct sockaddr_un* lokal = (const struct sockaddr_un*)&adress;
+        size_t max = adress_langd > offsetof(struct sockaddr_un, sun_path)
+                   ? adress_langd - offsetof(struct sockaddr_un, sun_path) : 0;
+        if (max >= sizeof(server->sokvag)) {
+            max = sizeof(server->sokvag) - 1;
+        }
+        memcpy(server->sokvag, lokal->sun_path, max);
+        server->sokvag[max] = '\0';
+        LOGG_INFO("Tar över lyssnande Unix-socket %s", server->sokvag);
+        return 0;
+    }
+#endif
+
+    LOGG_FEL("Ärvd socket lyssnar inte på en IPv4-port eller Unix-socket");
+    server->kors = false;
+    rensa_natverksbibliotek();
+    return -1;
+}
+
 /**
  * Accepterar en väntande klientanslutning
  *
  * @param server - Pekare till den lyssn ande servern
+ * @param klient_ip - Här sparas klientens IPv4-adress i nätverksordning
+ *                    (för begränsning per klient); NULL om den inte behövs
  * @return Socket-descriptor för den nya klienten, eller OGILTIG_SOCKET vid fel
  *
  * Funktionen blockerar tills en klient ansluter (om inte socketen är icke-blockerande).
  * När en klient ansluter skapar funktionen en ny socket för kommunikation med
  * just den klienten, medan server->lyssnar_socket fortsätter lyssna efter fler.
  */
-socket_t acceptera_klient(TcpServer* server) {
-    // Struktur för att lagra klientens adressinformation (IP och port)
-    struct sockaddr_in klient_adress;
+socket_t acceptera_klient(TcpServer* server, uint32_t* klient_ip) {
+    // Struktur för att lagra klientens adressinformation (IP och port).
+    // sockaddr_storage rymmer även adressen från en Unix-socket.
+    struct sockaddr_storage klient_adress;
     socklen_t klient_adress_langd = sizeof(klient_adress);
 
     // Acceptera en väntande anslutning från kön
     // accept() skapar en ny socket för kommunikation med denna specifika klient
     // Den ursprungliga lyssnar_socket fortsätter ta emot nya anslutningar
+#ifdef __linux__
+    // accept4() sätter O_NONBLOCK direkt och sparar två fcntl()-anrop per klient
+    socket_t klient_socket = accept4(server->lyssnar_socket,
+                                     (struct sockaddr*)&klient_adress,
+                                     &klient_adress_langd,
+                                     server->icke_blockerande ? SOCK_NONBLOCK | SOCK_CLOEXEC : 0);
+#else
     socket_t klient_socket = accept(server->lyssnar_socket,
                                      (struct sockaddr*)&klient_adress,
                                      &klient_adress_langd);
+    if (klient_socket != OGILTIG_SOCKET && server->icke_blockerande) {
+        satt_icke_blockerande(klient_socket);
+    }
+#endif
 
     // Kontrollera om accept() misslyckades
     if (klient_socket == OGILTIG_SOCKET) {
@@ -131,18 +340,103 @@ socket_t acceptera_klient(TcpServer* server) {
         return OGILTIG_SOCKET;  // Ingen klient accepterades
     }
 
-    // Konvertera klientens IP-adress från binärt format till läsbar sträng
-    char klient_ip[INET_ADDRSTRLEN];  // Buffer för IP-strängen (t.ex. "192.168.1.100")
-    inet_ntop(AF_INET, &klient_adress.sin_addr, klient_ip, sizeof(klient_ip));
+    // Klienter via Unix-socket har ingen IP-adress och får 0, som
+    // klientgränsen inte begränsar
+    if (server->familj != AF_INET) {
+        if (klient_ip) {
+            *klient_ip = 0;
+        }
+        LOGG_DEBUG("Ny lokal klient ansluten via %s", server->sokvag);
+        return klient_socket;
+    }
+
+    const struct sockaddr_in* ipv4 = (const struct sockaddr_in*)&klient_adress;
+    if (klient_ip) {
+        *klient_ip = (uint32_t)ipv4->sin_addr.s_addr;
+    }
 
-    // Logga information om den nya klienten
-    // ntohs konverterar portnumret från network byte order till host byte order
-    LOGG_INFO("Ny klient ansluten från %s:%d",
-              klient_ip, ntohs(klient_adress.sin_port));
+    // Logga information om den nya klienten (DEBUG eftersom det sker per anslutning).
+    // Adressen görs bara om till text när debugloggen faktiskt skrivs.
+    if (aktuell_log_niva <= LOG_NIVA_DEBUG) {
+        char ip_text[INET_ADDRSTRLEN];  // Buffer för IP-strängen (t.ex. "192.168.1.100")
+        inet_ntop(AF_INET, &ipv4->sin_addr, ip_text, sizeof(ip_text));
+        // ntohs konverterar portnumret från network byte order till host byte order
+        LOGG_DEBUG("Ny klient ansluten från %s:%d", ip_text, ntohs(ipv4->sin_port));
+    }
 
     return klient_socket;  // Returnera socketen för kommunikation med klienten
 }
 
+/**
+ * Väntar på att en klient ska ansluta
+ *
+ * @param server - Pekare till en initierad server
+ * @param millisekunder - Längsta väntan
+ * @return true om en anslutning väntar, false vid tidsgräns, signal eller fel
+ *
+ * Låter den blockerande huvudloopen kontrollera stoppflaggan regelbundet.
+ * Ett blockerande accept() startas om efter en signal och kan annars vänta
+ * hur länge som helst på nästa klient.
+ */
+bool vanta_pa_klient(TcpServer* server, int millisekunder) {
+    fd_set lasbara;
+    FD_ZERO(&lasbara);
+    FD_SET(server->lyssnar_socket, &lasbara);
+
+    struct timeval tidsgrans;
+    tidsgrans.tv_sec = millisekunder / 1000;
+    tidsgrans.tv_usec = (millisekunder % 1000) * 1000;
+
+    // Första argumentet ignoreras på Windows
+    return select((int)server->lyssnar_socket + 1, &lasbara, NULL, NULL, &tidsgrans) > 0;
+}
+
+/**
+ * Växlar servern till icke-blockerande läge
+ *
+ * @param server - Pekare till en initierad server
+ * @return 0 vid framgång, -1 vid fel
+ *
+ * Används av den händelsedrivna reaktorn. Lyssnande socket blir icke-blockerande
+ * så att accept() returnerar direkt när kön är tom, och acceptera_klient()
+ * returnerar därefter icke-blockerande klientsockets.
+ */
+int aktivera_icke_blockerande_lage(TcpServer* server) {
+    if (satt_icke_blockerande(server->lyssnar_socket) != 0) {
+        LOGG_FEL("Kunde inte göra lyssnande socket icke-blockerande: fel %d",
+                 hamta_senaste_socket_fel());
+        return -1;
+    }
+
+    server->icke_blockerande = true;
+    return 0;
+}
+
+/**
+ * Läser och kastar data som redan ligger i en klientsockets mottagningskö
+ *
+ * @param klient - Klientens socket (blockerande eller icke-blockerande)
+ *
+ * Om en socket stängs med oläst data skickar kärnan RST i stället för FIN,
+ * och klienten kan då förlora ett svar som redan skickats (t.ex. 413 på en
+ * för stor request). Läser högst MAX_REQUEST_STORLEK bytes.
+ */
+void kasta_vantande_data(socket_t klient) {
+    char kasta[BUFFER_STORLEK];
+    size_t totalt = 0;
+    while (totalt < MAX_REQUEST_STORLEK) {
+#ifdef MSG_DONTWAIT
+        int n = (int)recv(klient, kasta, sizeof(kasta), MSG_DONTWAIT);
+#else
+        int n = -1;  // Går inte att läsa utan att riskera att blockera
+#endif
+        if (n <= 0) {
+            return;
+        }
+        totalt += (size_t)n;
+    }
+}
+
 /**
  * Stänger TCP-servern och frigör resurser
  *
@@ -157,7 +451,9 @@ void stang_tcp_server(TcpServer* server) {
     if (server->kors) {
         LOGG_INFO("Stänger TCP-server");
 
-        // Stäng den lyssnande socketen (inga fler anslutningar accepteras)
+        // Stäng den lyssnande socketen (inga fler anslutningar accepteras).
+        // En Unix-sockets fil lämnas kvar - efter en överlämning är det
+        // nästa process som lyssnar på den.
         stang_socket(server->lyssnar_socket);
 
         // Markera att servern inte längre körs
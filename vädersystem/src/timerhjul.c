@@ -0,0 +1,245 @@
+#include "timerhjul.h"        // Timerhjulets API
+#include "konfiguration.h"    // För TIMERHJUL_TICK_MS
+#include <string.h>           // För memset
+
+#define FACK_BITAR 6                              // log2(TIMERHJUL_FACK)
+#define FACK_MASK (TIMERHJUL_FACK - 1)
+#define MAX_AVSTAND (((uint64_t)1 << (FACK_BITAR * TIMERHJUL_NIVAER)) - 1)
+
+/**
+ * Länkar in en timer först i ett fack
+ *
+ * @param fack - Facket (listans huvudpekare)
+ * @param timer - Timern
+ */
+static void lanka_in(Timer** fack, Timer* timer) {
+    timer->nasta = *fack;
+    if (timer->nasta) {
+        timer->nasta->forra = &timer->nasta;
+    }
+    *fack = timer;
+    timer->forra = fack;
+}
+
+/**
+ * Länkar ur en timer ur den lista den ligger i
+ *
+ * @param timer - En aktiv timer
+ *
+ * forra pekar på föregående timers nasta-fält eller på facket självt,
+ * så timern kan tas bort utan att leta upp den.
+ */
+static void lanka_ur(Timer* timer) {
+    *timer->forra = timer->nasta;
+    if (timer->nasta) {
+        timer->nasta->forra = timer->forra;
+    }
+    timer->nasta = NULL;
+    timer->forra = NULL;
+}
+
+/**
+ * Lägger en timer i rätt fack utifrån hur långt bort den löper ut
+ *
+ * @param hjul - Hjulet
+ * @param timer - Timer med utgang satt, inte länkad
+ *
+ * Nivå n används när utgången ligger inom 64^(n+1) tick, och facket väljs
+ * med utgångens bitar för den nivån. En timer som redan har löpt ut
+ * hamnar i facket som behandlas härnäst.
+ */
+static void placera(TimerHjul* hjul, Timer* timer) {
+    uint64_t utgang = timer->utgang;
+    if (utgang < hjul->tick) {
+        lanka_in(&hjul->fack[0][hjul->tick & FACK_MASK], timer);
+        return;
+    }
+
+    uint64_t avstand = utgang - hjul->tick;
+    if (avstand > MAX_AVSTAND) {
+        // Utanför hjulet - lägg den sist på högsta nivån; den placeras om
+        // (med sin riktiga utgång) när facket flyttas ned
+        avstand = MAX_AVSTAND;
+        utgang = hjul->tick + MAX_AVSTAND;
+    }
+
+    int niva = 0;
+    while (niva < TIMERHJUL_NIVAER - 1 &&
+           avstand >= ((uint64_t)1 << (FACK_BITAR * (niva + 1)))) {
+        niva++;
+    }
+    lanka_in(&hjul->fack[niva][(utgang >> (FACK_BITAR * niva)) & FACK_MASK], timer);
+}
+
+/**
+ * Flyttar ned alla timers i ett fack på en högre nivå
+ *
+ * @param hjul - Hjulet
+ * @param niva - Nivån (1 och uppåt)
+ * @return Index för facket som flyttades; 0 betyder att nivån gått ett
+ *         varv och att nästa nivå också ska flyttas ned
+ */
+static int flytta_ned(TimerHjul* hjul, int niva) {
+    int index = (int)((hjul->tick >> (FACK_BITAR * niva)) & FACK_MASK);
+    Timer* lista = hjul->fack[niva][index];
+    hjul->fack[niva][index] = NULL;
+
+    while (lista) {
+        Timer* timer = lista;
+        lista = timer->nasta;
+        placera(hjul, timer);
+    }
+    return index;
+}
+
+/**
+ * Nollställer ett timerhjul
+ *
+ * @param hjul - Hjulet
+ * @param nu_ms - Aktuell monoton tid i millisekunder
+ */
+void initiera_timerhjul(TimerHjul* hjul, uint64_t nu_ms) {
+    memset(hjul, 0, sizeof(*hjul));
+    hjul->tick = nu_ms / TIMERHJUL_TICK_MS;
+}
+
+/**
+ * Förbereder en timer
+ *
+ * @param timer - Timern
+ * @param funktion - Anropas när timern löper ut
+ * @param data - Skickas till funktion
+ */
+void initiera_timer(Timer* timer, TimerFunktion funktion, void* data) {
+    timer->nasta = NULL;
+    timer->forra = NULL;
+    timer->utgang = 0;
+    timer->funktion = funktion;
+    timer->data = data;
+}
+
+/**
+ * Startar en timer, eller flyttar den om den redan är aktiv
+ *
+ * @param hjul - Hjulet
+ * @param timer - Timern
+ * @param utgang_ms - Monoton tid i millisekunder då timern ska löpa ut
+ *
+ * Utgången avrundas uppåt till helt tick, så en timer löper aldrig ut
+ * för tidigt - däremot upp till ett tick för sent.
+ */
+void starta_timer(TimerHjul* hjul, Timer* timer, uint64_t utgang_ms) {
+    if (timer->forra) {
+        lanka_ur(timer);
+    } else {
+        hjul->antal++;
+    }
+    timer->utgang = (utgang_ms + TIMERHJUL_TICK_MS - 1) / TIMERHJUL_TICK_MS;
+    placera(hjul, timer);
+}
+
+/**
+ * Stoppar en timer
+ *
+ * @param hjul - Hjulet
+ * @param timer - Timern (får vara inaktiv)
+ */
+void stoppa_timer(TimerHjul* hjul, Timer* timer) {
+    if (timer->forra) {
+        lanka_ur(timer);
+        hjul->antal--;
+    }
+}
+
+/**
+ * Kontrollerar om en timer är aktiv
+ *
+ * @param timer - Timern
+ * @return true om timern väntar på att löpa ut
+ */
+bool timer_aktiv(const Timer* timer) {
+    return timer->forra != NULL;
+}
+
+/**
+ * Kör alla timers som har löpt ut
+ *
+ * @param hjul - Hjulet
+ * @param nu_ms - Aktuell monoton tid i millisekunder
+ * @return Antal timers som löpte ut
+ *
+ * Hjulet stegas fram ett tick i taget. Vid varje varv på nivå 0 flyttas
+ * nästa fack på nivå 1 ned (och vid varv där, nästa fack på nivå 2 osv).
+ * Varje timer flyttas alltså högst en gång per nivå under sin livstid.
+ */
+int kor_timerhjul(TimerHjul* hjul, uint64_t nu_ms) {
+    uint64_t mal = nu_ms / TIMERHJUL_TICK_MS;
+    int korda = 0;
+
+    if (hjul->antal == 0) {
+        // Inget att stega igenom - hoppa direkt till nu
+        if (mal >= hjul->tick) {
+            hjul->tick = mal + 1;
+        }
+        return 0;
+    }
+
+    while (hjul->tick <= mal) {
+        int index = (int)(hjul->tick & FACK_MASK);
+        if (index == 0) {
+            for (int niva = 1; niva < TIMERHJUL_NIVAER && flytta_ned(hjul, niva) == 0; niva++) {
+            }
+        }
+
+        // Flytta facket till en egen lista innan funktionerna anropas, så att
+        // timers som startas om under tiden hamnar i rätt fack
+        Timer* lista = hjul->fack[0][index];
+        hjul->fack[0][index] = NULL;
+        if (lista) {
+            lista->forra = &lista;
+        }
+        hjul->tick++;
+
+        while (lista) {
+            Timer* timer = lista;
+            lanka_ur(timer);
+            hjul->antal--;
+            korda++;
+            timer->funktion(timer, timer->data);
+        }
+    }
+    return korda;
+}
+
+/**
+ * Beräknar hur länge anroparen kan vänta innan hjulet behöver köras
+ *
+ * @param hjul - Hjulet
+ * @param nu_ms - Aktuell monoton tid i millisekunder
+ * @param max_ms - Längsta väntan som returneras
+ * @return Millisekunder (0 om något redan har löpt ut)
+ *
+ * Bara nivå 0 gås igenom (högst TIMERHJUL_FACK fack). Ligger inget där
+ * räcker det att vakna när nivå 0 gått ett varv - ingen timer på en
+ * högre nivå kan löpa ut före det.
+ */
+int timerhjul_vantetid(const TimerHjul* hjul, uint64_t nu_ms, int max_ms) {
+    if (hjul->antal == 0) {
+        return max_ms;
+    }
+
+    uint64_t nasta = (hjul->tick | FACK_MASK) + 1;  // Nästa varv på nivå 0
+    for (uint64_t tick = hjul->tick; tick < nasta; tick++) {
+        if (hjul->fack[0][tick & FACK_MASK]) {
+            nasta = tick;
+            break;
+        }
+    }
+
+    uint64_t utgang_ms = nasta * TIMERHJUL_TICK_MS;
+    if (utgang_ms <= nu_ms) {
+        return 0;
+    }
+    uint64_t vantan = utgang_ms - nu_ms;
+    return vantan < (uint64_t)max_ms ? (int)vantan : max_ms;
+}
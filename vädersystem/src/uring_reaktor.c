@@ -0,0 +1,1205 @@
+#define _GNU_SOURCE           // För syscall() och MSG_WAITALL/MSG_NOSIGNAL
+#include "uring_reaktor.h"   // io_uring-reaktorns API
+#include "http_server.h"      // För HttpMottagning, HttpSvar och http_svar_iovec
+#include "loggning.h"         // För loggning av händelser och fel
+#include "konfiguration.h"    // För BUFFER_STORLEK, SVAR_BUFFER_STORLEK, TIMEOUT_SEKUNDER, URING_*
+#include "timerhjul.h"        // För tidsgränser per anslutning
+#include "antagning.h"        // För antagningskontroll vid överlast
+#include "klientgrans.h"      // För begränsning av requests per klient-IP
+#include <stdlib.h>           // För malloc, calloc, free
+#include <string.h>           // För memcpy, memmove, memset
+#include <stdint.h>           // För uintptr_t, uint64_t
+
+#ifdef __linux__
+#include <linux/io_uring.h>   // Kärnans io_uring-gränssnitt (ingen liburing behövs)
+#include <sys/syscall.h>      // För __NR_io_uring_setup/enter/register
+#include <sys/mman.h>         // För mmap av ringarna
+#include <sys/eventfd.h>      // För eventfd - arbetare väcker reaktorn
+#include <poll.h>             // För poll() när reaktorn väntar in arbetare
+#include <pthread.h>          // För mutex runt listan med klara anslutningar
+#include <time.h>             // För clock_gettime till timerhjulet
+
+// Markörer i user_data för operationer som inte hör till en anslutning.
+// Anslutningspekare är minst 16-bytes-justerade, så små tal krockar aldrig.
+#define UD_ACCEPT    1        // Multishot accept på lyssnande socket
+#define UD_VACKNING  2        // Läsning av eventfd (arbetare klara / avstängning)
+#define UD_TICK      3        // Timeout som väcker reaktorn till timerhjulet
+#define UD_AVBRYT    4        // Avbryt alla operationer vid avstängning
+
+// Operationstyp i de låga bitarna av en anslutningspekare
+#define OP_RECV      1
+#define OP_SEND      2
+#define OP_CLOSE     3
+#define OP_AVBRYT    4
+#define OP_MASK      7
+
+#define BUFFERT_GRUPP 0       // Buffertgrupp (bgid) för den registrerade buffertringen
+
+typedef struct UringAnslutning UringAnslutning;
+
+// Per-anslutningsdata. Svarets body byggs direkt i kropp_buffer (även av
+// arbetare) och headers i svar, så att båda ligger kvar tills kärnan har
+// skickat dem med SENDMSG.
+struct UringAnslutning {
+    int fd;                                       // Klientens socket
+    uint32_t klient_ip;                           // Klientens IPv4-adress (nätverksordning)
+    AnslutningsTillstand tillstand;               // Ägs av reaktortråden
+    UringReaktor* reaktor;                        // Reaktorn som äger anslutningen
+    UringAnslutning* forra;                       // Lista över alla öppna anslutningar
+    UringAnslutning* nasta;
+    UringAnslutning* nasta_klar;                  // Lista över anslutningar som arbetare är klara med
+    int aktiva_op;                                // Operationer i ringen som pekar på anslutningen
+    bool recv_aktiv;                              // En recv väntar i ringen
+    bool send_aktiv;                              // En send väntar i ringen
+    bool stanger;                                 // close är köad
+    bool fd_stangd;                               // close har utförts
+    bool eof;                                     // Klienten har stängt sin skrivsida
+    bool besvarad;                                // Minst en request har tagits emot
+    bool hall_vid_liv;                            // Anslutningen ska vara öppen efter aktuellt svar
+    Timer timer;                                  // Anslutningens tidsgräns i reaktorns timerhjul
+    AnslutningsTidsgrans tidsgrans;               // Vilken tidsgräns timern är satt för
+    HttpMottagning mottagning;                    // Mottagen requestdata (kan rymma flera requests)
+    HttpSvar svar;                                // Svarets headers och pekare till bodyn
+    char kropp_buffer[SVAR_BUFFER_STORLEK];       // Svarets body
+    struct iovec iov[2];                          // Headers + body för SENDMSG
+    struct msghdr meddelande;                     // Måste leva tills SENDMSG är klar
+    size_t ut_langd;                              // Antal bytes i hela svaret
+    size_t ut_skickat;                            // Antal bytes som redan skickats
+};
+
+// Reaktorns tillstånd: ringen, buffertringen och anslutningarna
+struct UringReaktor {
+    TcpServer* server;                            // Lyssnande server (egen socket per reaktor)
+    const ReaktorInstallningar* installningar;    // Hanterare, kontext och trådpool
+    ReaktorRaknare* raknare;                      // Reaktorns statistikpost
+    volatile bool* kors;                          // Loopen avslutas när denna blir false
+
+    int ring_fd;                                  // io_uring-instansen
+    void* ring_minne;                             // Gemensam mmap för SQ- och CQ-ringen
+    size_t ring_minne_storlek;
+    struct io_uring_sqe* sqes;                    // SQE-arrayen
+    size_t sqes_storlek;
+    unsigned* sq_huvud;                           // Kärnans läsposition i SQ
+    unsigned* sq_svans;                           // Vår skrivposition i SQ (delad)
+    unsigned* sq_index;                           // SQ-ringens indexarray
+    unsigned sq_mask;
+    unsigned sq_antal;
+    unsigned sq_lokal_svans;                      // Skrivposition som inte publicerats än
+    unsigned* cq_huvud;                           // Vår läsposition i CQ (delad)
+    unsigned* cq_svans;                           // Kärnans skrivposition i CQ
+    unsigned cq_mask;
+    struct io_uring_cqe* cqes;
+
+    struct io_uring_buf_ring* buffert_ring;       // Registrerad ring med lediga mottagningsbuffertar
+    size_t buffert_ring_storlek;
+    char* buffertar;                              // URING_ANTAL_BUFFERTAR * BUFFER_STORLEK bytes
+    unsigned short buffert_svans;                 // Nästa position att lämna tillbaka buffertar på
+
+    int vacknings_fd;                             // eventfd som arbetare skriver till
+    unsigned long long vacknings_varde;           // Mål för läsningen av eventfd
+    struct __kernel_timespec tick;                // Tid till nästa timer (högst en sekund), för UD_TICK
+    int utestaende;                               // SQE:er som ännu inte gett sin sista CQE
+
+    pthread_mutex_t klara_las;                    // Skyddar listan klara
+    UringAnslutning* klara;                       // Anslutningar som lämnats tillbaka av arbetare
+    UringAnslutning* oppna;                       // Alla öppna anslutningar
+    int antal_bearbetas;                          // Anslutningar som just nu ägs av arbetare
+    uint64_t dranering_slut;                      // Monoton tid (ms) då dräneringen avbryts, 0 = kör
+    uint64_t forsta_request_slut;                 // Vid dränering: nya anslutningar utan request stängs efter detta
+    bool avslutar;                                // Dräneringen är över - inget nytt köas
+    uint64_t nu;                                  // Monoton tid (ms), uppdateras efter varje väntan
+    TimerHjul timers;                             // Tidsgränser för reaktorns anslutningar
+};
+
+/**
+ * Hämtar monoton tid i millisekunder
+ *
+ * @return Millisekunder sedan en godtycklig fast tidpunkt
+ */
+static uint64_t monoton_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+/**
+ * Skickar köade SQE:er till kärnan och väntar eventuellt på händelser
+ *
+ * @param reaktor - Reaktorn
+ * @param vanta - Antal CQE:er att vänta på (0 = returnera direkt)
+ * @return Resultatet från io_uring_enter, -1 med errno vid fel
+ *
+ * Detta är reaktorns enda syscall i normalfallet: alla accept, recv, send
+ * och close som köats sedan förra anropet skickas in i samma anrop.
+ */
+static int skicka_in(UringReaktor* reaktor, unsigned vanta) {
+    unsigned antal = reaktor->sq_lokal_svans -
+                     __atomic_load_n(reaktor->sq_huvud, __ATOMIC_ACQUIRE);
+    __atomic_store_n(reaktor->sq_svans, reaktor->sq_lokal_svans, __ATOMIC_RELEASE);
+    if (antal == 0 && vanta == 0) {
+        return 0;
+    }
+    return (int)syscall(__NR_io_uring_enter, reaktor->ring_fd, antal, vanta,
+                        vanta ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+}
+
+/**
+ * Reserverar nästa lediga SQE
+ *
+ * @param reaktor - Reaktorn
+ * @param user_data - Värdet som kommer tillbaka i operationens CQE
+ * @return Nollställd SQE att fylla i
+ *
+ * Om SQ-ringen är full skickas den in först; kärnan tömmer den då direkt.
+ */
+static struct io_uring_sqe* ny_sqe(UringReaktor* reaktor, unsigned long long user_data) {
+    while (reaktor->sq_lokal_svans - __atomic_load_n(reaktor->sq_huvud, __ATOMIC_ACQUIRE) >=
+           reaktor->sq_antal) {
+        if (skicka_in(reaktor, 0) < 0 && errno != EINTR && errno != EBUSY && errno != EAGAIN) {
+            LOGG_FEL("io_uring_enter misslyckades: fel %d", errno);
+            break;
+        }
+    }
+
+    unsigned index = reaktor->sq_lokal_svans & reaktor->sq_mask;
+    struct io_uring_sqe* sqe = &reaktor->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->user_data = user_data;
+    reaktor->sq_index[index] = index;
+    reaktor->sq_lokal_svans++;
+    reaktor->utestaende++;
+    return sqe;
+}
+
+/**
+ * Lämnar tillbaka en mottagningsbuffert till buffertringen
+ *
+ * @param reaktor - Reaktorn
+ * @param bid - Buffertens id (från CQE-flaggorna)
+ */
+static void aterlamna_buffert(UringReaktor* reaktor, unsigned short bid) {
+    struct io_uring_buf* buffert =
+        &reaktor->buffert_ring->bufs[reaktor->buffert_svans & (URING_ANTAL_BUFFERTAR - 1)];
+    buffert->addr = (unsigned long long)(uintptr_t)(reaktor->buffertar + (size_t)bid * BUFFER_STORLEK);
+    buffert->len = BUFFER_STORLEK;
+    buffert->bid = bid;
+    reaktor->buffert_svans++;
+    __atomic_store_n(&reaktor->buffert_ring->tail, reaktor->buffert_svans, __ATOMIC_RELEASE);
+}
+
+// Köar en multishot accept: en SQE ger en CQE per ny klient
+static void koa_accept(UringReaktor* reaktor) {
+    struct io_uring_sqe* sqe = ny_sqe(reaktor, UD_ACCEPT);
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = reaktor->server->lyssnar_socket;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_CLOEXEC;
+}
+
+// Köar en läsning av eventfd som arbetare skriver till
+static void koa_vackning(UringReaktor* reaktor) {
+    struct io_uring_sqe* sqe = ny_sqe(reaktor, UD_VACKNING);
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = reaktor->vacknings_fd;
+    sqe->addr = (unsigned long long)(uintptr_t)&reaktor->vacknings_varde;
+    sqe->len = sizeof(reaktor->vacknings_varde);
+}
+
+// Köar en timeout till nästa timer i timerhjulet (högst en sekund, så att
+// kors kontrolleras även när det är tyst, och aldrig förbi dräneringens slut)
+static void koa_tick(UringReaktor* reaktor) {
+    uint64_t nu = monoton_ms();
+    int max_vantetid = 1000;
+    if (reaktor->dranering_slut > nu && reaktor->dranering_slut - nu < 1000) {
+        max_vantetid = (int)(reaktor->dranering_slut - nu);
+    }
+    int vantetid = timerhjul_vantetid(&reaktor->timers, nu, max_vantetid);
+    if (vantetid < 1) {
+        vantetid = 1;  // Timern körs efter den här omgången CQE:er ändå
+    }
+    reaktor->tick.tv_sec = vantetid / 1000;
+    reaktor->tick.tv_nsec = (long long)(vantetid % 1000) * 1000000;
+
+    struct io_uring_sqe* sqe = ny_sqe(reaktor, UD_TICK);
+    sqe->opcode = IORING_OP_TIMEOUT;
+    sqe->addr = (unsigned long long)(uintptr_t)&reaktor->tick;
+    sqe->len = 1;
+}
+
+/**
+ * Köar en recv som kärnan fyller med en buffert ur buffertringen
+ *
+ * @param anslutning - Anslutning i tillståndet LASER
+ * @return true om recv köades, false om mottagningsbufferten inte kan växa
+ *
+ * Längden begränsas till det lediga utrymmet i mottagningsbufferten (och
+ * buffertringens storlek) så att hela mottagningen alltid får plats när
+ * den kopieras dit.
+ */
+static bool koa_recv(UringAnslutning* anslutning) {
+    size_t ledigt;
+    if (!http_mottagning_ledigt(&anslutning->mottagning, &ledigt)) {
+        return false;
+    }
+    if (ledigt > BUFFER_STORLEK) {
+        ledigt = BUFFER_STORLEK;
+    }
+
+    struct io_uring_sqe* sqe = ny_sqe(anslutning->reaktor, (uintptr_t)anslutning | OP_RECV);
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = anslutning->fd;
+    sqe->len = (unsigned)ledigt;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = BUFFERT_GRUPP;
+    anslutning->recv_aktiv = true;
+    anslutning->aktiva_op++;
+    return true;
+}
+
+// Köar close för en anslutning (eventuellt länkad efter föregående SQE)
+static void koa_close(UringAnslutning* anslutning) {
+    struct io_uring_sqe* sqe = ny_sqe(anslutning->reaktor, (uintptr_t)anslutning | OP_CLOSE);
+    sqe->opcode = IORING_OP_CLOSE;
+    sqe->fd = anslutning->fd;
+    anslutning->aktiva_op++;
+}
+
+/**
+ * Köar resten av svaret, länkat till close om anslutningen inte ska hållas
+ *
+ * @param anslutning - Anslutningen vars svar ska skickas
+ *
+ * Headers och body skickas som två iovec i samma SENDMSG, så bodyn
+ * kopieras aldrig. MSG_WAITALL gör att kärnan själv fortsätter vid korta
+ * skrivningar. Med IOSQE_IO_LINK körs close först när send lyckats, utan
+ * ny syscall.
+ */
+static void koa_send(UringAnslutning* anslutning) {
+    memset(&anslutning->meddelande, 0, sizeof(anslutning->meddelande));
+    anslutning->meddelande.msg_iov = anslutning->iov;
+    anslutning->meddelande.msg_iovlen =
+        (size_t)http_svar_iovec(&anslutning->svar, anslutning->ut_skickat, anslutning->iov);
+
+    struct io_uring_sqe* sqe = ny_sqe(anslutning->reaktor, (uintptr_t)anslutning | OP_SEND);
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->fd = anslutning->fd;
+    sqe->addr = (unsigned long long)(uintptr_t)&anslutning->meddelande;
+    sqe->len = 1;
+    sqe->msg_flags = MSG_NOSIGNAL | MSG_WAITALL;
+    anslutning->send_aktiv = true;
+    anslutning->aktiva_op++;
+
+    if (!anslutning->hall_vid_liv) {
+        sqe->flags = IOSQE_IO_LINK;
+        anslutning->stanger = true;
+        anslutning->tillstand = ANSLUTNING_STANGD;
+        koa_close(anslutning);
+    }
+}
+
+/**
+ * Stänger en anslutning via ringen
+ *
+ * @param anslutning - Anslutningen som ska stängas
+ *
+ * Väntande recv/send avbryts först (hårt länkat så att close körs även om
+ * det inte fanns något att avbryta). Anslutningen frigörs när sista CQE:n
+ * som pekar på den har kommit.
+ */
+static void stang_anslutning(UringAnslutning* anslutning) {
+    stoppa_timer(&anslutning->reaktor->timers, &anslutning->timer);
+    anslutning->tillstand = ANSLUTNING_STANGD;
+    if (anslutning->stanger) {
+        return;
+    }
+    anslutning->stanger = true;
+
+    if (anslutning->recv_aktiv || anslutning->send_aktiv) {
+        unsigned op = anslutning->recv_aktiv ? OP_RECV : OP_SEND;
+        struct io_uring_sqe* sqe = ny_sqe(anslutning->reaktor, (uintptr_t)anslutning | OP_AVBRYT);
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->addr = (uintptr_t)anslutning | op;
+        sqe->flags = IOSQE_IO_HARDLINK;
+        anslutning->aktiva_op++;
+    }
+    koa_close(anslutning);
+}
+
+/**
+ * Frigör en anslutning om inga operationer längre pekar på den
+ *
+ * @param anslutning - Anslutningen vars operation just avslutades
+ */
+static void avsluta_op(UringAnslutning* anslutning) {
+    anslutning->aktiva_op--;
+    if (anslutning->aktiva_op > 0 || !anslutning->fd_stangd) {
+        return;
+    }
+
+    UringReaktor* reaktor = anslutning->reaktor;
+    stoppa_timer(&reaktor->timers, &anslutning->timer);
+    if (anslutning->forra) {
+        anslutning->forra->nasta = anslutning->nasta;
+    } else {
+        reaktor->oppna = anslutning->nasta;
+    }
+    if (anslutning->nasta) {
+        anslutning->nasta->forra = anslutning->forra;
+    }
+    stang_http_mottagning(&anslutning->mottagning);
+    free(anslutning);
+    atomic_fetch_sub_explicit(&reaktor->raknare->oppna, 1, memory_order_relaxed);
+}
+
+/**
+ * Stänger en anslutning oavsett var den befinner sig
+ *
+ * @param anslutning - Anslutningen (får inte ägas av en arbetare)
+ *
+ * Ett sista svar med länkad close kan inte stängas med stang_anslutning()
+ * (close är redan köad); där avbryts send i stället, så att close körs om
+ * från hantera_close().
+ */
+static void avbryt_anslutning(UringAnslutning* anslutning) {
+    if (!anslutning->stanger) {
+        stang_anslutning(anslutning);
+    } else if (anslutning->send_aktiv) {
+        struct io_uring_sqe* sqe = ny_sqe(anslutning->reaktor, (uintptr_t)anslutning | OP_AVBRYT);
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->addr = (uintptr_t)anslutning | OP_SEND;
+        anslutning->aktiva_op++;
+    }
+}
+
+/**
+ * Stänger en anslutning vars tidsgräns har löpt ut
+ *
+ * @param timer - Anslutningens timer
+ * @param data - Anslutningen
+ *
+ * Anropas från kor_timerhjul() i reaktortråden.
+ */
+static void tidsgrans_utlopt(Timer* timer, void* data) {
+    (void)timer;
+    UringAnslutning* anslutning = (UringAnslutning*)data;
+    switch (anslutning->tidsgrans) {
+        case TIDSGRANS_REQUEST:
+            LOGG_DEBUG("Stänger anslutning: requesten blev inte komplett inom %d s",
+                       REQUEST_TIDSGRANS_SEKUNDER);
+            break;
+        case TIDSGRANS_SKRIVNING:
+            LOGG_DEBUG("Stänger anslutning: klienten har inte läst svaret på %d s",
+                       TIMEOUT_SEKUNDER);
+            break;
+        default:
+            LOGG_DEBUG("Stänger inaktiv anslutning efter %d s", TIMEOUT_SEKUNDER);
+            break;
+    }
+    avbryt_anslutning(anslutning);
+}
+
+/**
+ * Sätter anslutningens timer efter dess tillstånd
+ *
+ * @param anslutning - Anslutningen (ägs av reaktortråden)
+ *
+ * Anropas efter varje CQE som rör anslutningen. Timern startas om bara
+ * när sorten av tidsgräns byts, eller när tidsgrans nollställts efter
+ * aktivitet som ska förlänga den (ett skickat svar, en kort skrivning).
+ * Bytes som kommer till en påbörjad request flyttar alltså inte gränsen.
+ */
+static void uppdatera_tidsgrans(UringAnslutning* anslutning) {
+    UringReaktor* reaktor = anslutning->reaktor;
+    AnslutningsTidsgrans onskad = TIDSGRANS_INGEN;
+    int sekunder = 0;
+
+    if (anslutning->fd_stangd) {
+        // Inget kvar att vänta på
+    } else if (anslutning->send_aktiv) {
+        onskad = TIDSGRANS_SKRIVNING;             // Även sista svaret före en länkad close
+        sekunder = TIMEOUT_SEKUNDER;
+    } else if (!anslutning->stanger && anslutning->tillstand == ANSLUTNING_LASER) {
+        bool paborjad = anslutning->mottagning.langd > 0;
+        onskad = paborjad ? TIDSGRANS_REQUEST : TIDSGRANS_VILA;
+        sekunder = paborjad ? REQUEST_TIDSGRANS_SEKUNDER : TIMEOUT_SEKUNDER;
+    }
+
+    if (onskad == TIDSGRANS_INGEN) {
+        stoppa_timer(&reaktor->timers, &anslutning->timer);
+    } else if (onskad != anslutning->tidsgrans) {
+        starta_timer(&reaktor->timers, &anslutning->timer,
+                     reaktor->nu + (uint64_t)sekunder * 1000);
+    }
+    anslutning->tidsgrans = onskad;
+}
+
+/**
+ * Bygger svaret på requesten som står först i mottagningsbufferten
+ *
+ * @param anslutning - Anslutningen (ägs av anroparen)
+ *
+ * Körs i reaktorn eller i en arbetartråd. Hanteraren får requesten som
+ * pekare och längd direkt i mottagningsbufferten.
+ */
+static void bygg_svar(UringAnslutning* anslutning) {
+    const ReaktorInstallningar* inst = anslutning->reaktor->installningar;
+
+    HttpMottagning* mottagning = &anslutning->mottagning;
+
+    anslutning->svar.hall_vid_liv = anslutning->hall_vid_liv;
+    inst->hanterare(mottagning->data, mottagning->request_langd, anslutning->kropp_buffer,
+                    sizeof(anslutning->kropp_buffer), &anslutning->svar, inst->kontext);
+    anslutning->hall_vid_liv = anslutning->svar.hall_vid_liv;
+    anslutning->ut_langd = anslutning->svar.huvud_langd + anslutning->svar.kropp_langd;
+    anslutning->ut_skickat = 0;
+}
+
+/**
+ * Arbetaruppgift: bygg svaret och lämna tillbaka anslutningen
+ *
+ * @param argument - Anslutningen (tillstånd BEARBETAR)
+ * @param scratch - Oanvänd, svaret byggs i anslutningens egna buffertar
+ * @param scratch_storlek - Oanvänd
+ *
+ * Arbetaren rör inte ringen (den har en enda ägartråd); reaktorn köar
+ * send när den tar emot anslutningen via eventfd. Eventfd skrivs medan
+ * klara_las hålls, av samma skäl som i epoll-reaktorn: efter att låset
+ * släppts kan reaktorn redan vara frigjord.
+ */
+static void arbeta_med_request(void* argument, char* scratch, size_t scratch_storlek) {
+    (void)scratch;
+    (void)scratch_storlek;
+    UringAnslutning* anslutning = (UringAnslutning*)argument;
+    UringReaktor* reaktor = anslutning->reaktor;
+
+    bygg_svar(anslutning);
+
+    pthread_mutex_lock(&reaktor->klara_las);
+    anslutning->nasta_klar = reaktor->klara;
+    reaktor->klara = anslutning;
+    uint64_t ett = 1;
+    ssize_t skrivet = write(reaktor->vacknings_fd, &ett, sizeof(ett));
+    (void)skrivet;  // EAGAIN betyder att räknaren redan är satt - reaktorn vaknar ändå
+    pthread_mutex_unlock(&reaktor->klara_las);
+}
+
+/**
+ * Avvisar en request med ett förbyggt svar och stänger efteråt
+ *
+ * @param anslutning - Anslutning med en komplett request
+ * @param skapa - skapa_http_overlast (503) eller skapa_http_begransad (429)
+ */
+static void avvisa_request(UringAnslutning* anslutning, void (*skapa)(HttpSvar* svar)) {
+    anslutning->hall_vid_liv = false;
+    skapa(&anslutning->svar);
+    anslutning->ut_langd = anslutning->svar.huvud_langd + anslutning->svar.kropp_langd;
+    kasta_vantande_data(anslutning->fd);
+    anslutning->ut_skickat = 0;
+    anslutning->tillstand = ANSLUTNING_SKRIVER;
+    koa_send(anslutning);
+}
+
+/**
+ * Besvarar nästa buffrade request eller köar en recv om mer data behövs
+ *
+ * @param reaktor - Reaktorn
+ * @param anslutning - Anslutning i LASER utan väntande recv
+ *
+ * En halv request vid EOF stängs utan svar. En request som inte kan tas
+ * emot (för stor, ogiltig Content-Length) får ett felsvar och anslutningen
+ * stängs efter det.
+ */
+static void fortsatt_lasa(UringReaktor* reaktor, UringAnslutning* anslutning) {
+    HttpRamStatus status = hitta_http_request(&anslutning->mottagning);
+    if (status == HTTP_RAM_OFULLSTANDIG) {
+        if (anslutning->eof || !koa_recv(anslutning)) {
+            stang_anslutning(anslutning);
+        }
+        return;
+    }
+    atomic_fetch_add_explicit(&reaktor->raknare->requests, 1, memory_order_relaxed);
+    anslutning->besvarad = true;
+
+    if (status != HTTP_RAM_KOMPLETT) {
+        anslutning->hall_vid_liv = false;
+        skapa_http_mottagningsfel(&anslutning->svar, anslutning->kropp_buffer,
+                                  sizeof(anslutning->kropp_buffer),
+                                  &anslutning->mottagning, status);
+        anslutning->ut_langd = anslutning->svar.huvud_langd + anslutning->svar.kropp_langd;
+        kasta_vantande_data(anslutning->fd);  // Sällsynt felväg - synkront är ok
+        anslutning->ut_skickat = 0;
+        anslutning->tillstand = ANSLUTNING_SKRIVER;
+        koa_send(anslutning);
+        return;
+    }
+    anslutning->hall_vid_liv = !anslutning->eof && *reaktor->kors;  // Stäng efter svaret vid dränering
+
+    // Klientens gräns (429) och överlast (503) besvaras direkt med förbyggda
+    // svar, utan att requesten köas eller parsas
+    ArbetarPool* pool = reaktor->installningar->pool;
+    if (!klientgrans_tillat(anslutning->klient_ip)) {
+        avvisa_request(anslutning, skapa_http_begransad);
+        return;
+    }
+    if (pool && !antagning_slapp_in(arbetarpool_kodjup(pool), arbetarpool_kotid_ms(pool))) {
+        avvisa_request(anslutning, skapa_http_overlast);
+        return;
+    }
+    if (pool) {
+        // Timern stoppas innan arbetaren tar över - den rör bara reaktorn
+        anslutning->tillstand = ANSLUTNING_BEARBETAR;
+        uppdatera_tidsgrans(anslutning);
+        if (lagg_till_uppgift(pool, arbeta_med_request, anslutning)) {
+            reaktor->antal_bearbetas++;
+            return;
+        }
+        LOGG_DEBUG("Arbetskön är full, hanterar request i reaktorn");
+    }
+
+    bygg_svar(anslutning);
+    anslutning->tillstand = ANSLUTNING_SKRIVER;
+    koa_send(anslutning);
+}
+
+/**
+ * Tar emot en ny klient från multishot accept
+ *
+ * @param reaktor - Reaktorn
+ * @param fd - Den accepterade socketen
+ */
+static void ny_anslutning(UringReaktor* reaktor, int fd) {
+    UringAnslutning* anslutning = malloc(sizeof(UringAnslutning));
+    if (!anslutning || !initiera_http_mottagning(&anslutning->mottagning)) {
+        LOGG_FEL("Minnesallokering misslyckades för ny anslutning");
+        free(anslutning);
+        close(fd);
+        return;
+    }
+    atomic_fetch_add_explicit(&reaktor->raknare->anslutningar, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&reaktor->raknare->oppna, 1, memory_order_relaxed);
+
+    // Multishot accept delar en adressbuffer mellan alla klienter som
+    // accepteras i samma omgång, så adressen hämtas per socket i stället
+    // (lokala klienter via Unix-socket har ingen adress och behåller 0)
+    struct sockaddr_in adress;
+    socklen_t adress_langd = sizeof(adress);
+    anslutning->klient_ip = 0;
+    if (reaktor->server->familj == AF_INET &&
+        getpeername(fd, (struct sockaddr*)&adress, &adress_langd) == 0 &&
+        adress.sin_family == AF_INET) {
+        anslutning->klient_ip = (uint32_t)adress.sin_addr.s_addr;
+    }
+
+    anslutning->fd = fd;
+    anslutning->tillstand = ANSLUTNING_LASER;
+    anslutning->reaktor = reaktor;
+    anslutning->nasta_klar = NULL;
+    anslutning->aktiva_op = 0;
+    anslutning->recv_aktiv = false;
+    anslutning->send_aktiv = false;
+    anslutning->stanger = false;
+    anslutning->fd_stangd = false;
+    anslutning->eof = false;
+    anslutning->besvarad = false;
+    anslutning->hall_vid_liv = false;
+    initiera_timer(&anslutning->timer, tidsgrans_utlopt, anslutning);
+    anslutning->tidsgrans = TIDSGRANS_INGEN;
+    anslutning->ut_langd = 0;
+    anslutning->ut_skickat = 0;
+
+    // Länka in först i listan över öppna anslutningar
+    anslutning->forra = NULL;
+    anslutning->nasta = reaktor->oppna;
+    if (reaktor->oppna) {
+        reaktor->oppna->forra = anslutning;
+    }
+    reaktor->oppna = anslutning;
+
+    koa_recv(anslutning);
+    uppdatera_tidsgrans(anslutning);  // Första requesten måste komma inom TIMEOUT_SEKUNDER
+}
+
+/**
+ * Hanterar resultatet av en recv
+ *
+ * @param reaktor - Reaktorn
+ * @param anslutning - Anslutningen
+ * @param cqe - Händelsen (res = antal bytes, flags innehåller buffertens id)
+ */
+static void hantera_recv(UringReaktor* reaktor, UringAnslutning* anslutning,
+                         const struct io_uring_cqe* cqe) {
+    anslutning->recv_aktiv = false;
+
+    if (cqe->res > 0 && !anslutning->stanger) {
+        // Kopiera ut ur ringens buffert så att den kan återanvändas direkt
+        // (koa_recv() har begränsat längden till det lediga utrymmet)
+        unsigned short bid = (unsigned short)(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+        size_t ledigt;
+        char* mal = http_mottagning_ledigt(&anslutning->mottagning, &ledigt);
+        memcpy(mal, reaktor->buffertar + (size_t)bid * BUFFER_STORLEK, (size_t)cqe->res);
+        http_mottagning_tillfor(&anslutning->mottagning, (size_t)cqe->res);
+    }
+    if (cqe->flags & IORING_CQE_F_BUFFER) {
+        aterlamna_buffert(reaktor, (unsigned short)(cqe->flags >> IORING_CQE_BUFFER_SHIFT));
+    }
+
+    if (!anslutning->stanger) {
+        if (cqe->res == 0) {
+            anslutning->eof = true;  // Klienten har stängt sin skrivsida
+            fortsatt_lasa(reaktor, anslutning);
+        } else if (cqe->res == -ENOBUFS || cqe->res == -EINTR || cqe->res == -EAGAIN) {
+            if (!koa_recv(anslutning)) {  // Tillfälligt slut på buffertar - försök igen
+                stang_anslutning(anslutning);
+            }
+        } else if (cqe->res < 0) {
+            stang_anslutning(anslutning);
+        } else {
+            fortsatt_lasa(reaktor, anslutning);
+        }
+    }
+    uppdatera_tidsgrans(anslutning);
+    avsluta_op(anslutning);
+}
+
+/**
+ * Hanterar resultatet av en send
+ *
+ * @param reaktor - Reaktorn
+ * @param anslutning - Anslutningen
+ * @param res - Antal skickade bytes eller negativt felnummer
+ *
+ * Om send var länkad till close sköter close-händelsen resten.
+ */
+static void hantera_send(UringReaktor* reaktor, UringAnslutning* anslutning, int res) {
+    anslutning->send_aktiv = false;
+
+    if (!anslutning->stanger) {
+        if (res < 0) {
+            stang_anslutning(anslutning);
+        } else if (anslutning->ut_skickat + (size_t)res < anslutning->ut_langd) {
+            anslutning->ut_skickat += (size_t)res;
+            anslutning->tidsgrans = TIDSGRANS_INGEN;  // Framsteg - förläng tidsgränsen
+            koa_send(anslutning);  // Kort skrivning (t.ex. avbruten) - skicka resten
+        } else {
+            // Hela svaret skickat på en persistent anslutning: nästa request
+            http_mottagning_konsumera(&anslutning->mottagning);
+            anslutning->tidsgrans = TIDSGRANS_INGEN;
+            anslutning->tillstand = ANSLUTNING_LASER;
+            if (!reaktor->avslutar) {
+                fortsatt_lasa(reaktor, anslutning);
+            }
+        }
+    }
+    uppdatera_tidsgrans(anslutning);
+    avsluta_op(anslutning);
+}
+
+/**
+ * Hanterar resultatet av en close
+ *
+ * @param anslutning - Anslutningen
+ * @param res - 0 eller negativt felnummer
+ *
+ * -ECANCELED betyder att den länkade send:en misslyckades eller blev kort
+ * och att close därför aldrig kördes - då köas den på nytt.
+ */
+static void hantera_close(UringAnslutning* anslutning, int res) {
+    if (res == -ECANCELED) {
+        koa_close(anslutning);
+    } else {
+        anslutning->fd_stangd = true;
+    }
+    avsluta_op(anslutning);
+}
+
+/**
+ * Tar hand om anslutningar som arbetartrådar är klara med
+ *
+ * @param reaktor - Reaktorn
+ */
+static void hantera_klara(UringReaktor* reaktor) {
+    pthread_mutex_lock(&reaktor->klara_las);
+    UringAnslutning* lista = reaktor->klara;
+    reaktor->klara = NULL;
+    pthread_mutex_unlock(&reaktor->klara_las);
+
+    while (lista) {
+        UringAnslutning* anslutning = lista;
+        lista = lista->nasta_klar;
+        reaktor->antal_bearbetas--;
+
+        anslutning->tillstand = ANSLUTNING_SKRIVER;
+        koa_send(anslutning);
+        uppdatera_tidsgrans(anslutning);
+    }
+}
+
+/**
+ * Behandlar en CQE
+ *
+ * @param reaktor - Reaktorn
+ * @param cqe - Händelsen
+ */
+static void hantera_cqe(UringReaktor* reaktor, const struct io_uring_cqe* cqe) {
+    // Multishot-operationer lever kvar så länge IORING_CQE_F_MORE är satt
+    if (!(cqe->flags & IORING_CQE_F_MORE)) {
+        reaktor->utestaende--;
+    }
+
+    switch (cqe->user_data) {
+        case UD_ACCEPT:
+            if (cqe->res >= 0) {
+                ny_anslutning(reaktor, cqe->res);
+            } else if (cqe->res != -ECANCELED) {
+                LOGG_FEL("Kunde inte acceptera klient: fel %d", -cqe->res);
+            }
+            if (!(cqe->flags & IORING_CQE_F_MORE) && *reaktor->kors) {
+                koa_accept(reaktor);
+            }
+            return;
+        case UD_VACKNING:
+            hantera_klara(reaktor);
+            if (!reaktor->avslutar) {
+                koa_vackning(reaktor);
+            }
+            return;
+        case UD_TICK:
+            if (!reaktor->avslutar) {
+                koa_tick(reaktor);
+            }
+            return;
+        case UD_AVBRYT:
+            return;
+        default:
+            break;
+    }
+
+    UringAnslutning* anslutning = (UringAnslutning*)(uintptr_t)(cqe->user_data & ~(unsigned long long)OP_MASK);
+    switch (cqe->user_data & OP_MASK) {
+        case OP_RECV:
+            hantera_recv(reaktor, anslutning, cqe);
+            break;
+        case OP_SEND:
+            hantera_send(reaktor, anslutning, cqe->res);
+            break;
+        case OP_CLOSE:
+            hantera_close(anslutning, cqe->res);
+            break;
+        case OP_AVBRYT:
+            avsluta_op(anslutning);
+            break;
+    }
+}
+
+/**
+ * Behandlar alla CQE:er som ligger i completion-ringen
+ *
+ * @param reaktor - Reaktorn
+ * @return Antal behandlade händelser
+ */
+static int hantera_cqes(UringReaktor* reaktor) {
+    unsigned huvud = *reaktor->cq_huvud;
+    unsigned svans = __atomic_load_n(reaktor->cq_svans, __ATOMIC_ACQUIRE);
+    int antal = 0;
+
+    while (huvud != svans) {
+        // Kopiera ut händelsen och frigör platsen innan den behandlas, så att
+        // kärnan kan fylla på ringen om behandlingen skickar in nya SQE:er
+        struct io_uring_cqe cqe = reaktor->cqes[huvud & reaktor->cq_mask];
+        huvud++;
+        __atomic_store_n(reaktor->cq_huvud, huvud, __ATOMIC_RELEASE);
+        hantera_cqe(reaktor, &cqe);
+        antal++;
+        if (huvud == svans) {
+            svans = __atomic_load_n(reaktor->cq_svans, __ATOMIC_ACQUIRE);
+        }
+    }
+    return antal;
+}
+
+/**
+ * Skapar en ring och mappar in dess delade minne
+ *
+ * @param reaktor - Reaktorn vars ringfält ska fyllas i
+ * @param flaggor - IORING_SETUP_*-flaggor
+ * @return true vid framgång, false vid fel (errno satt)
+ */
+static bool skapa_ring(UringReaktor* reaktor, unsigned flaggor) {
+    struct io_uring_params parametrar;
+    memset(&parametrar, 0, sizeof(parametrar));
+    parametrar.flags = flaggor;
+
+    reaktor->ring_fd = (int)syscall(__NR_io_uring_setup, URING_KO_STORLEK, &parametrar);
+    if (reaktor->ring_fd < 0) {
+        return false;
+    }
+    if (!(parametrar.features & IORING_FEAT_SINGLE_MMAP) ||
+        !(parametrar.features & IORING_FEAT_NODROP)) {
+        close(reaktor->ring_fd);
+        reaktor->ring_fd = -1;
+        errno = ENOSYS;
+        return false;
+    }
+
+    // SQ- och CQ-ringen delar en mappning (IORING_FEAT_SINGLE_MMAP)
+    size_t sq_storlek = parametrar.sq_off.array + parametrar.sq_entries * sizeof(unsigned);
+    size_t cq_storlek = parametrar.cq_off.cqes + parametrar.cq_entries * sizeof(struct io_uring_cqe);
+    reaktor->ring_minne_storlek = sq_storlek > cq_storlek ? sq_storlek : cq_storlek;
+    reaktor->ring_minne = mmap(NULL, reaktor->ring_minne_storlek, PROT_READ | PROT_WRITE,
+                               MAP_SHARED | MAP_POPULATE, reaktor->ring_fd, IORING_OFF_SQ_RING);
+    reaktor->sqes_storlek = parametrar.sq_entries * sizeof(struct io_uring_sqe);
+    reaktor->sqes = mmap(NULL, reaktor->sqes_storlek, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, reaktor->ring_fd, IORING_OFF_SQES);
+    if (reaktor->ring_minne == MAP_FAILED || reaktor->sqes == MAP_FAILED) {
+        int fel = errno;
+        if (reaktor->ring_minne != MAP_FAILED) munmap(reaktor->ring_minne, reaktor->ring_minne_storlek);
+        if (reaktor->sqes != MAP_FAILED) munmap(reaktor->sqes, reaktor->sqes_storlek);
+        close(reaktor->ring_fd);
+        reaktor->ring_fd = -1;
+        errno = fel;
+        return false;
+    }
+
+    char* bas = (char*)reaktor->ring_minne;
+    reaktor->sq_huvud = (unsigned*)(bas + parametrar.sq_off.head);
+    reaktor->sq_svans = (unsigned*)(bas + parametrar.sq_off.tail);
+    reaktor->sq_index = (unsigned*)(bas + parametrar.sq_off.array);
+    reaktor->sq_mask = *(unsigned*)(bas + parametrar.sq_off.ring_mask);
+    reaktor->sq_antal = parametrar.sq_entries;
+    reaktor->sq_lokal_svans = *reaktor->sq_svans;
+    reaktor->cq_huvud = (unsigned*)(bas + parametrar.cq_off.head);
+    reaktor->cq_svans = (unsigned*)(bas + parametrar.cq_off.tail);
+    reaktor->cq_mask = *(unsigned*)(bas + parametrar.cq_off.ring_mask);
+    reaktor->cqes = (struct io_uring_cqe*)(bas + parametrar.cq_off.cqes);
+    return true;
+}
+
+/**
+ * Kontrollerar att kärnan stödjer io_uring-bakänden
+ *
+ * @return true om en ring med buffertring kunde skapas
+ *
+ * io_uring kan vara avstängt (kernel.io_uring_disabled, seccomp i
+ * containrar) eller för gammalt för buffertringar (före 5.19).
+ */
+bool uring_stods(void) {
+    UringReaktor prov;
+    memset(&prov, 0, sizeof(prov));
+    if (!skapa_ring(&prov, 0)) {
+        return false;
+    }
+
+    void* ring = mmap(NULL, 4096, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    bool stods = false;
+    if (ring != MAP_FAILED) {
+        struct io_uring_buf_reg registrering;
+        memset(&registrering, 0, sizeof(registrering));
+        registrering.ring_addr = (unsigned long long)(uintptr_t)ring;
+        registrering.ring_entries = 1;
+        stods = syscall(__NR_io_uring_register, prov.ring_fd, IORING_REGISTER_PBUF_RING,
+                        &registrering, 1) == 0;
+        munmap(ring, 4096);
+    }
+
+    munmap(prov.sqes, prov.sqes_storlek);
+    munmap(prov.ring_minne, prov.ring_minne_storlek);
+    close(prov.ring_fd);
+    return stods;
+}
+
+/**
+ * Skapar en io_uring-reaktor
+ *
+ * @param server - Initierad TCP-server som reaktorn ska lyssna på
+ * @param installningar - Hanterare, kontext och eventuell trådpool
+ * @param raknare - Reaktorns statistikpost
+ * @param kors - Loopen avslutas när denna flagga blir false
+ * @return Ny reaktor, eller NULL vid fel
+ *
+ * Ringen skapas avstängd (IORING_SETUP_R_DISABLED) och aktiveras av
+ * reaktortråden själv, eftersom IORING_SETUP_SINGLE_ISSUER binder ringen
+ * till den tråd som aktiverar den.
+ */
+UringReaktor* skapa_uring_reaktor(TcpServer* server, const ReaktorInstallningar* installningar,
+                                  ReaktorRaknare* raknare, volatile bool* kors) {
+    UringReaktor* reaktor = calloc(1, sizeof(UringReaktor));
+    if (!reaktor) {
+        LOGG_FEL("Minnesallokering misslyckades för reaktor");
+        return NULL;
+    }
+    reaktor->server = server;
+    reaktor->installningar = installningar;
+    reaktor->raknare = raknare;
+    reaktor->kors = kors;
+    reaktor->ring_fd = -1;
+    reaktor->vacknings_fd = -1;
+    reaktor->nu = monoton_ms();
+    initiera_timerhjul(&reaktor->timers, reaktor->nu);
+    pthread_mutex_init(&reaktor->klara_las, NULL);
+
+    // Försök med flaggorna som minskar overhead (6.1+), annars utan
+    if (!skapa_ring(reaktor, IORING_SETUP_R_DISABLED | IORING_SETUP_SINGLE_ISSUER |
+                             IORING_SETUP_DEFER_TASKRUN | IORING_SETUP_SUBMIT_ALL) &&
+        !skapa_ring(reaktor, 0)) {
+        LOGG_FEL("Kunde inte skapa io_uring: fel %d", errno);
+        forstor_uring_reaktor(reaktor);
+        return NULL;
+    }
+
+    // Buffertring: kärnan plockar en ledig buffert vid varje recv i stället
+    // för att varje väntande anslutning håller en egen buffert
+    reaktor->buffert_ring_storlek = URING_ANTAL_BUFFERTAR * sizeof(struct io_uring_buf);
+    reaktor->buffert_ring = mmap(NULL, reaktor->buffert_ring_storlek, PROT_READ | PROT_WRITE,
+                                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    reaktor->buffertar = malloc((size_t)URING_ANTAL_BUFFERTAR * BUFFER_STORLEK);
+    if (reaktor->buffert_ring == MAP_FAILED || !reaktor->buffertar) {
+        LOGG_FEL("Minnesallokering misslyckades för mottagningsbuffertar");
+        forstor_uring_reaktor(reaktor);
+        return NULL;
+    }
+
+    struct io_uring_buf_reg registrering;
+    memset(&registrering, 0, sizeof(registrering));
+    registrering.ring_addr = (unsigned long long)(uintptr_t)reaktor->buffert_ring;
+    registrering.ring_entries = URING_ANTAL_BUFFERTAR;
+    registrering.bgid = BUFFERT_GRUPP;
+    if (syscall(__NR_io_uring_register, reaktor->ring_fd, IORING_REGISTER_PBUF_RING,
+                &registrering, 1) != 0) {
+        LOGG_FEL("Kunde inte registrera buffertring: fel %d", errno);
+        forstor_uring_reaktor(reaktor);
+        return NULL;
+    }
+    for (unsigned short i = 0; i < URING_ANTAL_BUFFERTAR; i++) {
+        aterlamna_buffert(reaktor, i);
+    }
+
+    reaktor->vacknings_fd = eventfd(0, EFD_CLOEXEC);
+    if (reaktor->vacknings_fd < 0) {
+        LOGG_FEL("Kunde inte skapa eventfd: fel %d", errno);
+        forstor_uring_reaktor(reaktor);
+        return NULL;
+    }
+
+    // Nollställ räknarna (posten kan ha använts av en tidigare körning)
+    atomic_store(&raknare->anslutningar, 0);
+    atomic_store(&raknare->requests, 0);
+    atomic_store(&raknare->oppna, 0);
+    atomic_store(&raknare->avbrutna, 0);
+    return reaktor;
+}
+
+/**
+ * Väntar in anslutningar som fortfarande ägs av arbetartrådar
+ *
+ * @param reaktor - Reaktorn som ska avslutas
+ *
+ * Deras svar skickas inte - servern håller på att stängas.
+ */
+static void vanta_in_arbetare(UringReaktor* reaktor) {
+    while (reaktor->antal_bearbetas > 0) {
+        struct pollfd pfd = { .fd = reaktor->vacknings_fd, .events = POLLIN };
+        poll(&pfd, 1, 100);
+
+        pthread_mutex_lock(&reaktor->klara_las);
+        UringAnslutning* lista = reaktor->klara;
+        reaktor->klara = NULL;
+        pthread_mutex_unlock(&reaktor->klara_las);
+
+        for (; lista; lista = lista->nasta_klar) {
+            reaktor->antal_bearbetas--;
+        }
+    }
+}
+
+/**
+ * Kör io_uring-reaktorns loop
+ *
+ * @param argument - Reaktorn (void* så att funktionen kan vara trådstart)
+ * @return NULL
+ *
+ * Varje varv: skicka in alla köade SQE:er och vänta på minst en CQE i
+ * samma io_uring_enter(), behandla sedan alla CQE:er och kör timerhjulet.
+ * UD_TICK väcker reaktorn när nästa tidsgräns kan löpa ut, och minst en
+ * gång per sekund så att kors kontrolleras även när det är tyst.
+ * Anslutningarna lämnas öppna när loopen avslutas.
+ */
+void* kor_uring_reaktor(void* argument) {
+    UringReaktor* reaktor = (UringReaktor*)argument;
+
+    // Aktivera ringen i den tråd som ska använda den (no-op utan R_DISABLED)
+    syscall(__NR_io_uring_register, reaktor->ring_fd, IORING_REGISTER_ENABLE_RINGS, NULL, 0);
+
+    koa_accept(reaktor);
+    koa_vackning(reaktor);
+    koa_tick(reaktor);
+
+    LOGG_INFO("Reaktor startad (io_uring%s)",
+              reaktor->installningar->pool ? ", med trådpool" : "");
+
+    while (*reaktor->kors) {
+        if (skicka_in(reaktor, 1) < 0 && errno != EINTR && errno != EBUSY &&
+            errno != EAGAIN && errno != ETIME) {
+            LOGG_FEL("io_uring_enter misslyckades: fel %d", errno);
+            break;
+        }
+        reaktor->nu = monoton_ms();
+        hantera_cqes(reaktor);
+        kor_timerhjul(&reaktor->timers, reaktor->nu);
+    }
+    return NULL;
+}
+
+/**
+ * Stänger anslutningar som inte ägs av en arbetare
+ *
+ * @param reaktor - Reaktorn
+ * @param alla - false: bara vilande anslutningar (inget påbörjat request),
+ *               true: även anslutningar mitt i en request eller ett svar
+ * @return Antal anslutningar som stängdes med en request på gång
+ *
+ * Som i epoll-reaktorn räknas en anslutning som ännu inte fått något
+ * svar som vilande först efter DRANERING_FORSTA_REQUEST_MS - dess första
+ * request kan vara på väg.
+ */
+static int stang_anslutningar(UringReaktor* reaktor, bool alla) {
+    int avbrutna = 0;
+    for (UringAnslutning* anslutning = reaktor->oppna; anslutning; anslutning = anslutning->nasta) {
+        if (anslutning->tillstand == ANSLUTNING_BEARBETAR ||
+            (anslutning->stanger && !anslutning->send_aktiv)) {
+            continue;  // Ägs av en arbetare, eller stängs redan
+        }
+        bool vilande = !anslutning->stanger && anslutning->tillstand == ANSLUTNING_LASER &&
+                       anslutning->mottagning.langd == 0 &&
+                       (anslutning->besvarad || reaktor->nu >= reaktor->forsta_request_slut);
+        if (vilande || alla) {
+            if (!vilande) {
+                avbrutna++;
+            }
+            avbryt_anslutning(anslutning);  // Frigörs först när CQE:erna kommit
+        }
+    }
+    return avbrutna;
+}
+
+/**
+ * Dränerar reaktorn och stänger alla anslutningar
+ *
+ * @param reaktor - Reaktorn (loopen har avslutats)
+ *
+ * Multishot accept avbryts och den lyssnande socketen stängs, så att nya
+ * anslutningar går till övriga sockets på porten. Vilande keep-alive-
+ * anslutningar stängs direkt; övriga får bli klara (med Connection: close)
+ * tills dranering_sekunder gått. Därefter avbryts resten.
+ */
+void dranera_uring_reaktor(UringReaktor* reaktor) {
+    int sekunder = reaktor->installningar->dranering_sekunder;
+    uint64_t start = monoton_ms();
+    reaktor->dranering_slut = start + (uint64_t)(sekunder > 0 ? sekunder : 0) * 1000;
+    reaktor->nu = start;
+    reaktor->forsta_request_slut = start + DRANERING_FORSTA_REQUEST_MS;
+
+    struct io_uring_sqe* sqe = ny_sqe(reaktor, UD_AVBRYT);
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->addr = UD_ACCEPT;
+    stang_tcp_server(reaktor->server);  // Accept håller socketen tills den avbrutits
+    stang_anslutningar(reaktor, false);
+    long kvar = 0;
+    for (UringAnslutning* anslutning = reaktor->oppna; anslutning; anslutning = anslutning->nasta) {
+        kvar += anslutning->stanger ? 0 : 1;
+    }
+    if (kvar > 0) {
+        LOGG_INFO("Reaktor dränerar %ld anslutningar (io_uring, högst %d s)", kvar, sekunder);
+    }
+
+    while (reaktor->oppna && monoton_ms() < reaktor->dranering_slut) {
+        if (skicka_in(reaktor, 1) < 0 && errno != EINTR && errno != EBUSY &&
+            errno != EAGAIN && errno != ETIME) {
+            break;
+        }
+        reaktor->nu = monoton_ms();
+        hantera_cqes(reaktor);
+        kor_timerhjul(&reaktor->timers, reaktor->nu);
+        stang_anslutningar(reaktor, false);  // Klara med sitt sista svar
+    }
+
+    // Tiden är ute: avbryt det som återstår. Svar som arbetare bygger nu
+    // skickas inte, de räknas också som avbrutna.
+    reaktor->avslutar = true;
+    int avbrutna = stang_anslutningar(reaktor, true) + reaktor->antal_bearbetas;
+    atomic_store(&reaktor->raknare->avbrutna, (unsigned long long)avbrutna);
+
+    // Avbryt allt som ligger i ringen och vänta tills kärnan släppt alla
+    // buffertar (klienterna stängs då direkt), vänta sedan in arbetarna -
+    // de rör aldrig ringen
+    sqe = ny_sqe(reaktor, UD_AVBRYT);
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->cancel_flags = IORING_ASYNC_CANCEL_ANY;
+    while (reaktor->utestaende > 0) {
+        if (skicka_in(reaktor, 1) < 0 && errno != EINTR && errno != EBUSY &&
+            errno != EAGAIN && errno != ETIME) {
+            break;
+        }
+        hantera_cqes(reaktor);
+    }
+    vanta_in_arbetare(reaktor);
+
+    while (reaktor->oppna) {
+        UringAnslutning* anslutning = reaktor->oppna;
+        reaktor->oppna = anslutning->nasta;
+        if (!anslutning->fd_stangd) {
+            close(anslutning->fd);
+        }
+        stang_http_mottagning(&anslutning->mottagning);
+        free(anslutning);
+        atomic_fetch_sub_explicit(&reaktor->raknare->oppna, 1, memory_order_relaxed);
+    }
+
+    unsigned long long tid = (unsigned long long)(monoton_ms() - start);
+    if (avbrutna > 0) {
+        LOGG_VARNING("Reaktor dränerad på %llu ms (io_uring), %d requests avbrutna", tid, avbrutna);
+    } else {
+        LOGG_INFO("Reaktor dränerad på %llu ms (io_uring)", tid);
+    }
+}
+
+/**
+ * Väcker en reaktor som väntar i io_uring_enter()
+ *
+ * @param reaktor - Reaktorn
+ */
+void vack_uring_reaktor(UringReaktor* reaktor) {
+    uint64_t ett = 1;
+    ssize_t skrivet = write(reaktor->vacknings_fd, &ett, sizeof(ett));
+    (void)skrivet;
+}
+
+/**
+ * Frigör en io_uring-reaktor
+ *
+ * @param reaktor - Reaktorn (loopen får inte köras längre)
+ */
+void forstor_uring_reaktor(UringReaktor* reaktor) {
+    if (reaktor->ring_fd >= 0) {
+        munmap(reaktor->sqes, reaktor->sqes_storlek);
+        munmap(reaktor->ring_minne, reaktor->ring_minne_storlek);
+        close(reaktor->ring_fd);
+    }
+    if (reaktor->buffert_ring && reaktor->buffert_ring != MAP_FAILED) {
+        munmap(reaktor->buffert_ring, reaktor->buffert_ring_storlek);
+    }
+    if (reaktor->vacknings_fd >= 0) {
+        close(reaktor->vacknings_fd);
+    }
+    free(reaktor->buffertar);
+    pthread_mutex_destroy(&reaktor->klara_las);
+    free(reaktor);
+}
+
+#else
+
+// Utan Linux finns ingen io_uring
+bool uring_stods(void) {
+    return false;
+}
+
+#endif // __linux__
@@ -2,118 +2,12 @@
 #include "json_helper.h"            // För att parsa JSON-svar från API
 #include "loggning.h"                // För att logga debug-meddelanden och varningar
 #include "konfiguration.h"           // För API_HOST, API_PORT, API_ENDPOINT, etc.
-#include "natverks_abstraktion.h"    // För plattformsoberoende nätverksfunktioner
+#include "http_klient.h"             // För HTTP-anrop över poolade anslutningar
+#include "http_query.h"              // För procentkodning av stad i URL:en
 #include <string.h>                  // För strängfunktioner: strlen, strstr, memcpy, memmove, memset
 #include <time.h>                    // För time() - tidsstämplar
 #include <stdio.h>                   // För snprintf - formatera strängar
 
-/**
- * Skickar en HTTP GET-förfrågan och tar emot svaret
- *
- * @param host - Värdnamnet att ansluta till (t.ex. "api.openweathermap.org")
- * @param port - Portnummer att ansluta till (vanligtvis 80 för HTTP)
- * @param path - URL-sökväg inklusive query-parametrar (t.ex. "/data/2.5/weather?q=Stockholm")
- * @param svar_buffer - Buffert där HTTP-svaret ska lagras
- * @param buffer_storlek - Storlek på svar-bufferten i bytes
- * @return true om förfrågan lyckades, false vid fel
- *
- * Funktionen etablerar en TCP-anslutning, skickar en HTTP GET-förfrågan,
- * tar emot svaret och extraherar JSON-kroppen. Detta är hjärtat i vår
- * kommunikation med OpenWeatherMap API.
- */
-static bool skicka_http_get(const char* host, int port, const char* path,
-                             char* svar_buffer, size_t buffer_storlek) {
-    // Skapa en socket för nätverkskommunikation
-    // AF_INET = IPv4, SOCK_STREAM = TCP-anslutning (tillförlitlig, strömbaserad)
-    socket_t sock = socket(AF_INET, SOCK_STREAM, 0);
-    if (sock == OGILTIG_SOCKET) {
-        LOGG_FEL("Kunde inte skapa socket för HTTP-förfrågan");
-        return false;
-    }
-
-    // Slå upp värdnamnet (DNS-lookup) för att få IP-adressen
-    // gethostbyname returnerar en hostent-struktur med IP-adressinformation
-    struct hostent* server = gethostbyname(host);
-    if (!server) {
-        LOGG_FEL("Kunde inte hitta värd: %s", host);
-        stang_socket(sock);  // Stäng socketen innan vi returnerar
-        return false;
-    }
-
-    // Konfigurera serveradressen för anslutningen
-    struct sockaddr_in server_addr;
-    memset(&server_addr, 0, sizeof(server_addr));  // Nollställ hela strukturen
-    server_addr.sin_family = AF_INET;              // IPv4-adressfamilj
-
-    // Kopiera IP-adressen från DNS-svaret till vår adress-struktur
-    // h_addr pekar på den första IP-adressen i listan
-    memcpy(&server_addr.sin_addr.s_addr, server->h_addr_list[0], (size_t)server->h_length);
-
-    // Sätt portnummer (konvertera från host byte order till network byte order)
-    server_addr.sin_port = htons((uint16_t)port);
-
-    // Försök ansluta till servern
-    // connect() etablerar en TCP-anslutning till den angivna adressen
-    if (connect(sock, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
-        LOGG_FEL("Kunde inte ansluta till %s:%d", host, port);
-        stang_socket(sock);
-        return false;
-    }
-
-    // Bygg HTTP GET-förfrågan enligt HTTP/1.1-protokollet
-    // Format: METOD SÖKVÄG VERSION\r\nHEADERS\r\n\r\n
-    char forfragan[1024];
-    snprintf(forfragan, sizeof(forfragan),
-             "GET %s HTTP/1.1\r\n"          // Förfrågansrad: metod, sökväg, version
-             "Host: %s\r\n"                  // Host-header (obligatorisk i HTTP/1.1)
-             "Connection: close\r\n"         // Be servern stänga anslutningen efter svar
-             "\r\n",                         // Tom rad markerar slutet på headers
-             path, host);
-
-    // Skicka HTTP-förfrågan till servern
-    // send() returnerar antal bytes som skickades, eller negativt värde vid fel
-    if (send(sock, forfragan, (int)strlen(forfragan), 0) < 0) {
-        LOGG_FEL("Kunde inte skicka HTTP-förfrågan");
-        stang_socket(sock);
-        return false;
-    }
-
-    // Ta emot HTTP-svaret från servern
-    // Vi tar emot data i en loop eftersom svaret kan komma i flera paket
-    int totalt_mottaget = 0;  // Räknare för totalt antal mottagna bytes
-    int mottaget;              // Antal bytes mottagna i varje recv()-anrop
-
-    // Loop tills servern stänger anslutningen (recv returnerar 0) eller bufferten är full
-    while ((mottaget = recv(sock, svar_buffer + totalt_mottaget,
-                            (int)(buffer_storlek - totalt_mottaget - 1), 0)) > 0) {
-        totalt_mottaget += mottaget;  // Summera totalt mottagna bytes
-
-        // Kontrollera om bufferten är nästan full (lämna plats för null-terminator)
-        if ((size_t)totalt_mottaget >= buffer_storlek - 1) break;
-    }
-
-    // Lägg till null-terminator för att göra det en giltig C-sträng
-    svar_buffer[totalt_mottaget] = '\0';
-
-    // Stäng socket-anslutningen, vi är klara
-    stang_socket(sock);
-
-    // Extrahera JSON-kroppen från HTTP-svaret
-    // HTTP-svaret består av: statusrad + headers + tom rad + kropp
-    // Vi letar efter "\r\n\r\n" som markerar slutet på headers
-    char* kropp = strstr(svar_buffer, "\r\n\r\n");
-    if (kropp) {
-        kropp += 4;  // Hoppa över "\r\n\r\n" (4 tecken)
-
-        // Flytta JSON-kroppen till början av bufferten
-        // Detta gör det enklare att parsa JSON utan att behöva hålla reda på offset
-        memmove(svar_buffer, kropp, strlen(kropp) + 1);  // +1 för null-terminator
-    }
-
-    // Returnera true om vi fick något svar (även om det kan vara ett felmeddelande)
-    return totalt_mottaget > 0;
-}
-
 /**
  * Hämtar aktuellt väder från OpenWeatherMap API
  *
@@ -131,19 +25,27 @@ bool hamta_aktuellt_vader(const char* stad, const char* landskod,
                           const char* api_nyckel, VaderData* resultat) {
     LOGG_INFO("Hämtar väder för %s, %s från OpenWeatherMap", stad, landskod);
 
+    // Staden kommer avkodad från klientens query-sträng och kodas om för
+    // URL:en ("Göteborg" -> "G%C3%B6teborg", blanksteg och '&' likaså)
+    char kodad_stad[3 * 64];
+    if (!query_koda(stad, kodad_stad, sizeof(kodad_stad))) {
+        LOGG_FEL("Stadens namn är för långt för URL:en");
+        return false;
+    }
+
     // Bygg API-URL med alla nödvändiga parametrar
     // q = query (stad,landskod), appid = API-nyckel, units = metriska enheter, lang = språk
     char url[512];
     snprintf(url, sizeof(url),
              "%s?q=%s,%s&appid=%s&units=metric&lang=sv",
              API_ENDPOINT,  // Basvägen, t.ex. "/data/2.5/weather"
-             stad,          // Stadens namn
+             kodad_stad,    // Stadens namn, procentkodat
              landskod,      // Landskod (ISO 3166)
              api_nyckel);   // Din API-nyckel från OpenWeatherMap
 
     // Skicka HTTP-förfrågan till OpenWeatherMap och ta emot JSON-svaret
     char svar[8192];  // Buffer för att lagra API-svaret (behöver vara tillräckligt stor för JSON)
-    if (!skicka_http_get(API_HOST, API_PORT, url, svar, sizeof(svar))) {
+    if (!http_klient_get(API_HOST, API_PORT, url, svar, sizeof(svar))) {
         LOGG_FEL("Kunde inte hämta väderdata från API");
         return false;
     }
@@ -251,18 +153,26 @@ int hamta_vader_prognos(const char* stad, const char* landskod,
 
     // Bygg API-URL för 5-dagarsprognosen
     // cnt=40 begär maximalt antal datapunkter (5 dagar * 8 per dag = 40)
+    char kodad_stad[3 * 64];  // Som för aktuellt väder
+    if (!query_koda(stad, kodad_stad, sizeof(kodad_stad))) {
+        LOGG_FEL("Stadens namn är för långt för URL:en");
+        return 0;  // Som vid andra fel
+    }
+
     char url[512];
     snprintf(url, sizeof(url),
              "%s?q=%s,%s&appid=%s&units=metric&lang=sv&cnt=40",
              API_FORECAST_ENDPOINT,  // Basvägen för prognoser, t.ex. "/data/2.5/forecast"
-             stad,
+             kodad_stad,
              landskod,
              api_nyckel);
 
     // Större buffer behövs för prognosdata eftersom JSON-svaret är mycket större
     // Prognos-JSON innehåller 40 objekt med väderdata istället för bara ett
-    char svar[16384];  // 16 KB buffer
-    if (!skicka_http_get(API_HOST, API_PORT, url, svar, sizeof(svar))) {
+    // Svaret läses nu tills det är komplett (inte tills bufferten är full),
+    // så bufferten måste rymma hela prognosen med 40 datapunkter
+    char svar[32768];  // 32 KB buffer
+    if (!http_klient_get(API_HOST, API_PORT, url, svar, sizeof(svar))) {
         LOGG_FEL("Kunde inte hämta prognos från API");
         return 0;  // Returnera 0 dagar vid fel
     }
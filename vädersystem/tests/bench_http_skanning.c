@@ -0,0 +1,139 @@
+// ============================================================================
+// MIKROBENCHMARK FÖR HTTP-SKANNING
+// ============================================================================
+// Mäter tid per anrop för inramning (slutet på headers), skanning av en
+// rad och hela parsningen, för varje SIMD-nivå som processorn klarar.
+// Inramningen jämförs också med strstr(), som servern använde tidigare.
+// Kompilera: gcc -O2 -Iinclude tests/bench_http_skanning.c src/loggning.c -o tests/bench_http_skanning
+// Kör: ./tests/bench_http_skanning [varv]
+
+#define _GNU_SOURCE
+#include "../src/http_skanning.c"
+#include "../src/http_server.c"
+#include "../src/http_query.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Kort request som från curl eller C++-klienten
+static const char KORT_REQUEST[] =
+    "GET /weather?city=Stockholm&country=SE HTTP/1.1\r\n"
+    "Host: localhost:8080\r\n"
+    "User-Agent: curl/8.5.0\r\n"
+    "Accept: */*\r\n"
+    "\r\n";
+
+// Request med en webbläsares typiska headers
+static const char LANG_REQUEST[] =
+    "GET /forecast?city=Gothenburg&country=SE&units=metric HTTP/1.1\r\n"
+    "Host: vader.example.se\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:128.0) Gecko/20100101 Firefox/128.0\r\n"
+    "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,*/*;q=0.8\r\n"
+    "Accept-Language: sv-SE,sv;q=0.8,en-US;q=0.5,en;q=0.3\r\n"
+    "Accept-Encoding: gzip, deflate, br, zstd\r\n"
+    "Referer: https://vader.example.se/stader/goteborg\r\n"
+    "Connection: keep-alive\r\n"
+    "Cookie: sessionid=4f1c2a9e8b7d6c5f4e3d2c1b0a998877; tema=morkt; senaste_stad=Gothenburg\r\n"
+    "Upgrade-Insecure-Requests: 1\r\n"
+    "Sec-Fetch-Dest: document\r\n"
+    "Sec-Fetch-Mode: navigate\r\n"
+    "Sec-Fetch-Site: same-origin\r\n"
+    "Priority: u=0, i\r\n"
+    "\r\n";
+
+static double nu_sekunder(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// Hindrar kompilatorn från att optimera bort anrop vars resultat inte används
+static volatile size_t summa;
+
+static size_t med_strstr(const char* data, size_t langd) {
+    (void)langd;
+    const char* slut = strstr(data, "\r\n\r\n");
+    return slut ? (size_t)(slut - data) : langd;
+}
+
+static size_t med_nivan(const char* data, size_t langd) {
+    return http_hitta_huvudslut(data, langd);
+}
+
+static size_t med_rad(const char* data, size_t langd) {
+    HttpRadSkanning rad;
+    http_skanna_rad(data, langd, &rad);
+    return rad.radslut + rad.kolon;
+}
+
+static size_t parsa(const char* data, size_t langd) {
+    HttpRequestVy request;
+    return parsa_http_request_vy(data, langd, &request) ? request.headers.langd : 0;
+}
+
+/**
+ * Kör funktionen varv gånger och returnerar nanosekunder per anrop
+ */
+static double mat(size_t (*funktion)(const char*, size_t), const char* data,
+                  size_t langd, long varv) {
+    // Uppvärmning
+    for (long i = 0; i < varv / 10; i++) {
+        summa += funktion(data, langd);
+    }
+    double start = nu_sekunder();
+    for (long i = 0; i < varv; i++) {
+        summa += funktion(data, langd);
+    }
+    return (nu_sekunder() - start) * 1e9 / (double)varv;
+}
+
+/**
+ * Skriver ett namn vänsterjusterat i en kolumn. printf räknar bytes, så
+ * "skalär" (ä är två bytes i UTF-8) skulle annars hamna snett.
+ */
+static void skriv_namn(const char* namn) {
+    int tecken = 0;
+    for (const char* p = namn; *p; p++) {
+        tecken += ((unsigned char)*p & 0xC0) != 0x80;  // Räkna inte fortsättningsbytes
+    }
+    printf("  %s%*s", namn, 10 - tecken, "");
+}
+
+static void mat_request(const char* namn, const char* request, long varv) {
+    size_t langd = strlen(request);
+    printf("\n%s (%zu bytes)\n", namn, langd);
+    skriv_namn("");
+    printf(" %12s %12s %12s\n", "inramning", "rad", "parsning");
+    skriv_namn("strstr");
+    printf(" %9.1f ns %12s %12s\n", mat(med_strstr, request, langd, varv), "-", "-");
+
+    const HttpSkanningNiva nivaer[] = {
+        HTTP_SKANNING_SKALAR, HTTP_SKANNING_SSE2, HTTP_SKANNING_AVX2
+    };
+    for (size_t i = 0; i < sizeof(nivaer) / sizeof(nivaer[0]); i++) {
+        skriv_namn(http_skanning_namn(nivaer[i]));
+        if (!satt_http_skanning(nivaer[i])) {
+            printf(" %12s\n", "(stöds ej)");
+            continue;
+        }
+        printf(" %9.1f ns %9.1f ns %9.1f ns\n", mat(med_nivan, request, langd, varv),
+               mat(med_rad, request, langd, varv),
+               mat(parsa, request, langd, varv));
+    }
+}
+
+int main(int argc, char* argv[]) {
+    long varv = argc > 1 ? atol(argv[1]) : 5000000;
+
+    // Ingen loggning från parsern under mätningen
+    initiera_loggning(LOG_NIVA_FEL);
+
+    printf("HTTP-skanning, %ld varv per mätning (bäst tillgänglig: %s)\n",
+           varv, http_skanning_namn(initiera_http_skanning()));
+    mat_request("Kort request", KORT_REQUEST, varv);
+    mat_request("Webbläsar-request", LANG_REQUEST, varv);
+
+    return summa == 0;  // Används så att summan inte optimeras bort
+}
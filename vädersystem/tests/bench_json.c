@@ -0,0 +1,173 @@
+// ============================================================================
+// MIKROBENCHMARK FÖR JSON-SKRIVAREN
+// ============================================================================
+// Mäter tid per body för /weather och /forecast med JSON-skrivaren och med
+// snprintf-versionen som servern använde tidigare, escapingen av strängar
+// (snprintf kopierar dem utan escaping) och storlek och tid för kompakt
+// format och ett urval av fält.
+// Kompilera: gcc -O2 -Iinclude tests/bench_json.c -o tests/bench_json
+// Kör: ./tests/bench_json [varv]
+
+#define _GNU_SOURCE
+#include "../src/json_skrivare.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static double nu_sekunder(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// Hindrar kompilatorn från att optimera bort anrop vars resultat inte används
+static volatile size_t summa;
+
+static VaderData vader;
+static VaderPrognos prognos;
+static char buffer[8192];
+
+// Den tidigare implementationen (utan escaping)
+#define SNPRINTF_FORMAT(indrag) \
+    indrag "{\n" \
+    indrag "  \"stad\": \"%s\",\n" \
+    indrag "  \"land\": \"%s\",\n" \
+    indrag "  \"temperatur\": %.1f,\n" \
+    indrag "  \"luftfuktighet\": %.0f,\n" \
+    indrag "  \"vindhastighet\": %.1f,\n" \
+    indrag "  \"lufttryck\": %.0f,\n" \
+    indrag "  \"beskrivning\": \"%s\",\n" \
+    indrag "  \"ikon_id\": \"%s\",\n" \
+    indrag "  \"tidsstampel\": %lld\n" \
+    indrag "}"
+
+#define SNPRINTF_ARGUMENT(d) (d)->stad, (d)->land, (d)->temperatur, (d)->luftfuktighet, \
+    (d)->vindhastighet, (d)->lufttryck, (d)->beskrivning, (d)->ikon_id, (long long)(d)->tidsstampel
+
+static size_t vader_snprintf(void) {
+    return (size_t)snprintf(buffer, sizeof(buffer), SNPRINTF_FORMAT(""), SNPRINTF_ARGUMENT(&vader));
+}
+
+static size_t prognos_snprintf(void) {
+    int pos = snprintf(buffer, sizeof(buffer), "{\n  \"antal_dagar\": %d,\n  \"dagar\": [\n",
+                       prognos.antal_dagar);
+    for (int i = 0; i < prognos.antal_dagar; i++) {
+        pos += snprintf(buffer + pos, sizeof(buffer) - (size_t)pos, SNPRINTF_FORMAT("    ") "%s\n",
+                        SNPRINTF_ARGUMENT(&prognos.dagar[i]), i < prognos.antal_dagar - 1 ? "," : "");
+    }
+    return (size_t)pos + (size_t)snprintf(buffer + pos, sizeof(buffer) - (size_t)pos, "  ]\n}");
+}
+
+static size_t vader_skrivare(void) {
+    return skapa_vader_json(&vader, NULL, buffer, sizeof(buffer));
+}
+
+static size_t prognos_skrivare(void) {
+    return skapa_prognos_json(&prognos, NULL, buffer, sizeof(buffer));
+}
+
+// ?format= och ?fields= för raderna med andra format
+static JsonFormat format;
+
+static size_t vader_format(void) {
+    return skapa_vader_json(&vader, &format, buffer, sizeof(buffer));
+}
+
+static size_t prognos_format(void) {
+    return skapa_prognos_json(&prognos, &format, buffer, sizeof(buffer));
+}
+
+// En text så lång som en beskrivning kan bli, med ett citattecken i
+// mitten, och 2 KB med ett citattecken per 500 bytes
+static char kort_text[128];
+static char lang_text[2048];
+static const char* text;
+
+static size_t strang_snprintf(void) {
+    return (size_t)snprintf(buffer, sizeof(buffer), "\"%s\"", text);
+}
+
+static size_t strang_skrivare(void) {
+    JsonSkrivare skrivare;
+    json_skrivare_fast(&skrivare, buffer, sizeof(buffer));
+    json_skriv_strang(&skrivare, text);
+    return json_avsluta(&skrivare);
+}
+
+/**
+ * Kör funktionen varv gånger och returnerar nanosekunder per anrop
+ */
+static double mat(size_t (*funktion)(void), long varv) {
+    // Uppvärmning
+    for (long i = 0; i < varv / 10; i++) {
+        summa += funktion();
+    }
+    double start = nu_sekunder();
+    for (long i = 0; i < varv; i++) {
+        summa += funktion();
+    }
+    return (nu_sekunder() - start) * 1e9 / (double)varv;
+}
+
+static void jamfor(const char* namn, size_t (*tidigare)(void), size_t (*skrivare)(void), long varv) {
+    size_t langd = skrivare();
+    double ns_tidigare = mat(tidigare, varv);
+    double ns_skrivare = mat(skrivare, varv);
+    printf("  %-22s %5zu bytes %9.1f ns %9.1f ns %6.1fx\n", namn, langd, ns_tidigare,
+           ns_skrivare, ns_tidigare / ns_skrivare);
+}
+
+static void mat_format(const char* namn, bool kompakt, uint32_t falt, long varv) {
+    format.kompakt = kompakt;
+    format.falt = falt;
+    size_t vader_langd = vader_format();
+    size_t prognos_langd = prognos_format();
+    printf("  %-22s %5zu bytes %9.1f ns %5zu bytes %9.1f ns\n", namn,
+           vader_langd, mat(vader_format, varv), prognos_langd, mat(prognos_format, varv));
+}
+
+int main(int argc, char* argv[]) {
+    long varv = argc > 1 ? atol(argv[1]) : 1000000;
+
+    strcpy(vader.stad, "Stockholm");
+    strcpy(vader.land, "SE");
+    vader.temperatur = 15.5f;
+    vader.luftfuktighet = 65.0f;
+    vader.vindhastighet = 3.2f;
+    vader.lufttryck = 1013.0f;
+    strcpy(vader.beskrivning, "lätt regn");
+    strcpy(vader.ikon_id, "10d");
+    vader.tidsstampel = 1760000000;
+
+    prognos.antal_dagar = 5;
+    for (int i = 0; i < 5; i++) {
+        prognos.dagar[i] = vader;
+        prognos.dagar[i].temperatur = 12.3f + (float)i * 1.7f;
+        prognos.dagar[i].tidsstampel += i * 86400;
+    }
+
+    memset(kort_text, 'a', sizeof(kort_text) - 1);
+    kort_text[64] = '"';
+    memset(lang_text, 'a', sizeof(lang_text) - 1);
+    for (size_t i = 250; i < sizeof(lang_text) - 1; i += 500) {
+        lang_text[i] = '"';
+    }
+
+    printf("JSON-serialisering, %ld varv per mätning\n\n", varv);
+    printf("  %-22s %11s %12s %12s %7s\n", "", "", "snprintf", "skrivare", "");
+    jamfor("/weather", vader_snprintf, vader_skrivare, varv);
+    jamfor("/forecast (5 dagar)", prognos_snprintf, prognos_skrivare, varv);
+    text = kort_text;
+    jamfor("sträng 127 bytes", strang_snprintf, strang_skrivare, varv);
+    text = lang_text;
+    jamfor("sträng 2 KB", strang_snprintf, strang_skrivare, varv);
+
+    printf("\n  %-22s %21s %21s\n", "Format (skrivaren)", "/weather", "/forecast");
+    mat_format("indraget", false, JSON_ALLA_FALT, varv);
+    mat_format("compact", true, JSON_ALLA_FALT, varv);
+    mat_format("compact, 2 fält", true, JSON_FALT_TEMPERATUR | JSON_FALT_LUFTTRYCK, varv);
+
+    return summa == 0;  // Används så att summan inte optimeras bort
+}
@@ -0,0 +1,208 @@
+// ============================================================================
+// LASTTEST FÖR VÄDERSERVERN
+// ============================================================================
+// Öppnar många samtidiga anslutningar mot servern och mäter genomströmning
+// (requests/s) samt latens (p50/p99). Använder själv epoll så att en enda
+// tråd kan driva hundratals anslutningar.
+// Kompilera: gcc -O2 -Iinclude tests/bench_last.c -o tests/bench_last
+// Kör: ./tests/bench_last [port] [samtidiga] [antal] [sökväg] [keepalive]
+// Exempel: ./tests/bench_last 8080 64 100000 "/weather?city=Stockholm&country=SE"
+// Bara 2xx-svar räknas som klara och ingår i genomströmning och latens.
+// Andra svar (t.ex. 429 från klientgränsen, som alla lokala klienter
+// delar) redovisas för sig - kör servern med --klientgrans=0.
+// Med keepalive=1 återanvänds varje anslutning för nästa request i stället
+// för en ny TCP-handskakning per request:
+//          ./tests/bench_last 8080 64 100000 "/weather?city=Stockholm&country=SE" 1
+// Är första argumentet en sökväg i stället för ett portnummer ansluter
+// testet till serverns Unix-socket (--unix=SÖKVÄG):
+//          ./tests/bench_last /tmp/vader.sock 64 100000
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <sys/un.h>
+
+typedef struct {
+    int fd;                  // Anslutningens socket
+    size_t skickat;          // Skickade bytes av aktuell request
+    size_t mottaget;         // Mottagna bytes av aktuellt svar
+    size_t forvantat;        // Total svarslängd (headers + Content-Length), 0 = okänd
+    double start;            // Tidpunkt då requesten påbörjades
+    char buffer[16384];      // Mottagningsbuffer
+} Klient;
+
+static double nu_sekunder(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static int jamfor_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Startar en ny anslutning och registrerar den i epoll
+static int starta_klient(Klient* k, int epoll_fd, const struct sockaddr* adress,
+                         socklen_t adress_langd) {
+    k->fd = socket(adress->sa_family, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (k->fd < 0) return -1;
+    if (adress->sa_family == AF_INET) {
+        int ja = 1;
+        setsockopt(k->fd, IPPROTO_TCP, TCP_NODELAY, &ja, sizeof(ja));
+    }
+    k->skickat = k->mottaget = k->forvantat = 0;
+    k->start = nu_sekunder();
+    if (connect(k->fd, adress, adress_langd) < 0 && errno != EINPROGRESS) {
+        close(k->fd);
+        return -1;
+    }
+    struct epoll_event h = { .events = EPOLLIN | EPOLLOUT | EPOLLET, .data.ptr = k };
+    return epoll_ctl(epoll_fd, EPOLL_CTL_ADD, k->fd, &h);
+}
+
+// Skickar (resten av) requesten utan att blockera
+static void skicka_request(Klient* k, const char* request, size_t request_langd) {
+    while (k->skickat < request_langd) {
+        ssize_t s = send(k->fd, request + k->skickat, request_langd - k->skickat, MSG_NOSIGNAL);
+        if (s <= 0) break;
+        k->skickat += (size_t)s;
+    }
+}
+
+// Räknar ut total svarslängd när hela headern har kommit
+static void berakna_forvantat(Klient* k) {
+    k->buffer[k->mottaget] = '\0';
+    char* slut = strstr(k->buffer, "\r\n\r\n");
+    if (!slut) return;
+    char* cl = strcasestr(k->buffer, "Content-Length:");
+    size_t kropp = cl ? (size_t)strtoul(cl + 15, NULL, 10) : 0;
+    k->forvantat = (size_t)(slut + 4 - k->buffer) + kropp;
+}
+
+// Ett komplett svar med statuskod 2xx ("HTTP/1.1 200 OK")
+static int ar_lyckat(const Klient* k) {
+    return k->mottaget >= 12 && strncmp(k->buffer, "HTTP/1.", 7) == 0 && k->buffer[9] == '2';
+}
+
+int main(int argc, char* argv[]) {
+    const char* mal = (argc > 1) ? argv[1] : "8080";
+    int samtidiga = (argc > 2) ? atoi(argv[2]) : 64;
+    long antal = (argc > 3) ? atol(argv[3]) : 10000;
+    const char* sokvag = (argc > 4) ? argv[4] : "/weather?city=Stockholm&country=SE";
+    int keepalive = (argc > 5) ? atoi(argv[5]) : 0;
+
+    char request[1024];
+    int request_langd = snprintf(request, sizeof(request),
+                                 "GET %s HTTP/1.1\r\nHost: localhost\r\n"
+                                 "Connection: %s\r\n\r\n", sokvag,
+                                 keepalive ? "keep-alive" : "close");
+
+    // Portnummer = TCP mot 127.0.0.1, annars sökväg till en Unix-socket
+    struct sockaddr_storage adress;
+    socklen_t adress_langd;
+    memset(&adress, 0, sizeof(adress));
+    if (strchr(mal, '/')) {
+        struct sockaddr_un* lokal = (struct sockaddr_un*)&adress;
+        if (strlen(mal) >= sizeof(lokal->sun_path)) {
+            fprintf(stderr, "För lång sökväg: %s\n", mal);
+            return 1;
+        }
+        lokal->sun_family = AF_UNIX;
+        strcpy(lokal->sun_path, mal);
+        adress_langd = sizeof(*lokal);
+    } else {
+        struct sockaddr_in* tcp = (struct sockaddr_in*)&adress;
+        tcp->sin_family = AF_INET;
+        tcp->sin_port = htons((uint16_t)atoi(mal));
+        inet_pton(AF_INET, "127.0.0.1", &tcp->sin_addr);
+        adress_langd = sizeof(*tcp);
+    }
+
+    int epoll_fd = epoll_create1(0);
+    Klient* klienter = calloc((size_t)samtidiga, sizeof(Klient));
+    double* latenser = malloc(sizeof(double) * (size_t)antal);
+    long startade = 0, klara = 0, fel = 0, ej_2xx = 0;
+
+    double start = nu_sekunder();
+    for (int i = 0; i < samtidiga && startade < antal; i++, startade++) {
+        if (starta_klient(&klienter[i], epoll_fd, (struct sockaddr*)&adress, adress_langd) < 0) fel++;
+    }
+
+    struct epoll_event handelser[256];
+    while (klara + fel + ej_2xx < startade) {
+        int n = epoll_wait(epoll_fd, handelser, 256, 5000);
+        if (n <= 0) { fprintf(stderr, "Timeout - servern svarar inte\n"); break; }
+        for (int i = 0; i < n; i++) {
+            Klient* k = handelser[i].data.ptr;
+            int fardig = 0;
+
+            // Skicka (resten av) requesten
+            skicka_request(k, request, (size_t)request_langd);
+
+            // Ta emot svaret
+            for (;;) {
+                ssize_t r = recv(k->fd, k->buffer + k->mottaget, sizeof(k->buffer) - 1 - k->mottaget, 0);
+                if (r > 0) {
+                    k->mottaget += (size_t)r;
+                    if (!k->forvantat) berakna_forvantat(k);
+                    if (k->forvantat && k->mottaget >= k->forvantat) { fardig = 1; break; }
+                } else if (r == 0) {
+                    fardig = k->mottaget > 0 ? 1 : -1;
+                    break;
+                } else {
+                    if (errno != EAGAIN) fardig = -1;
+                    break;
+                }
+            }
+
+            // Svar med annan status än 2xx räknas för sig, utan latens
+            int lyckat = fardig > 0 && ar_lyckat(k);
+            if (fardig > 0 && !lyckat) ej_2xx++;
+
+            if (fardig > 0 && keepalive && startade < antal &&
+                !strcasestr(k->buffer, "Connection: close")) {
+                // Återanvänd anslutningen: nästa request direkt på samma socket
+                if (lyckat) latenser[klara++] = nu_sekunder() - k->start;
+                startade++;
+                k->skickat = k->mottaget = k->forvantat = 0;
+                k->start = nu_sekunder();
+                skicka_request(k, request, (size_t)request_langd);
+            } else if (fardig != 0) {
+                close(k->fd);
+                if (lyckat) latenser[klara++] = nu_sekunder() - k->start;
+                else if (fardig < 0) fel++;
+                if (startade < antal) {
+                    startade++;
+                    if (starta_klient(k, epoll_fd, (struct sockaddr*)&adress, adress_langd) < 0) fel++;
+                }
+            }
+        }
+    }
+    double tid = nu_sekunder() - start;
+
+    qsort(latenser, (size_t)klara, sizeof(double), jamfor_double);
+    printf("Läge:         %s\n", keepalive ? "keep-alive" : "ny anslutning per request");
+    printf("Requests:     %ld klara (2xx), %ld annan status, %ld fel\n", klara, ej_2xx, fel);
+    printf("Tid:          %.3f s\n", tid);
+    printf("Genomströmning: %.0f req/s\n", (double)klara / tid);
+    if (klara > 0) {
+        printf("Latens p50:   %.3f ms\n", latenser[klara / 2] * 1000.0);
+        printf("Latens p99:   %.3f ms\n", latenser[(long)((double)klara * 0.99)] * 1000.0);
+    }
+
+    free(latenser);
+    free(klienter);
+    close(epoll_fd);
+    return fel > 0 || ej_2xx > 0 ? 1 : 0;
+}
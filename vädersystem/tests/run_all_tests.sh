@@ -29,13 +29,13 @@ echo "────────────────────────
 echo ""
 
 # Test 1: JSON Helper
-echo "  [1/2] Kompilerar test_json..."
+echo "  [1/14] Kompilerar test_json..."
 gcc -Wall -Wextra -I../include tests/test_json.c -o tests/test_json 2>&1 || {
     echo -e "${RED}✗ Kompilering misslyckades${NC}"
     exit 1
 }
 
-echo "  [1/2] Kör test_json..."
+echo "  [1/14] Kör test_json..."
 if ./tests/test_json; then
     echo -e "${GREEN}✓ JSON-tester godkända${NC}\n"
     ((PASSED_TESTS++))
@@ -45,13 +45,13 @@ fi
 ((TOTAL_TESTS++))
 
 # Test 2: HTTP Server
-echo "  [2/2] Kompilerar test_http..."
+echo "  [2/14] Kompilerar test_http..."
 gcc -Wall -Wextra -I../include tests/test_http.c -o tests/test_http 2>&1 || {
     echo -e "${RED}✗ Kompilering misslyckades${NC}"
     exit 1
 }
 
-echo "  [2/2] Kör test_http..."
+echo "  [2/14] Kör test_http..."
 if ./tests/test_http; then
     echo -e "${GREEN}✓ HTTP-tester godkända${NC}\n"
     ((PASSED_TESTS++))
@@ -60,6 +60,198 @@ else
 fi
 ((TOTAL_TESTS++))
 
+# Test 3: Samordnade hämtningar
+echo "  [3/14] Kompilerar test_samordning..."
+gcc -Wall -Wextra -I../include tests/test_samordning.c -o tests/test_samordning -lpthread 2>&1 || {
+    echo -e "${RED}✗ Kompilering misslyckades${NC}"
+    exit 1
+}
+
+echo "  [3/14] Kör test_samordning..."
+if ./tests/test_samordning; then
+    echo -e "${GREEN}✓ Samordningstester godkända${NC}\n"
+    ((PASSED_TESTS++))
+else
+    echo -e "${RED}✗ Samordningstester misslyckades${NC}\n"
+fi
+((TOTAL_TESTS++))
+
+# Test 4: HTTP-klientens inramning
+echo "  [4/14] Kompilerar test_http_klient..."
+gcc -Wall -Wextra -I../include tests/test_http_klient.c -o tests/test_http_klient -lpthread 2>&1 || {
+    echo -e "${RED}✗ Kompilering misslyckades${NC}"
+    exit 1
+}
+
+echo "  [4/14] Kör test_http_klient..."
+if ./tests/test_http_klient; then
+    echo -e "${GREEN}✓ HTTP-klienttester godkända${NC}\n"
+    ((PASSED_TESTS++))
+else
+    echo -e "${RED}✗ HTTP-klienttester misslyckades${NC}\n"
+fi
+((TOTAL_TESTS++))
+
+# Test 5: DNS-cache
+echo "  [5/14] Kompilerar test_dns_cache..."
+gcc -Wall -Wextra -I../include tests/test_dns_cache.c -o tests/test_dns_cache -lpthread 2>&1 || {
+    echo -e "${RED}✗ Kompilering misslyckades${NC}"
+    exit 1
+}
+
+echo "  [5/14] Kör test_dns_cache..."
+if ./tests/test_dns_cache; then
+    echo -e "${GREEN}✓ DNS-cachetester godkända${NC}\n"
+    ((PASSED_TESTS++))
+else
+    echo -e "${RED}✗ DNS-cachetester misslyckades${NC}\n"
+fi
+((TOTAL_TESTS++))
+
+# Test 6: Timerhjul
+echo "  [6/14] Kompilerar test_timerhjul..."
+gcc -Wall -Wextra -I../include tests/test_timerhjul.c -o tests/test_timerhjul 2>&1 || {
+    echo -e "${RED}✗ Kompilering misslyckades${NC}"
+    exit 1
+}
+
+echo "  [6/14] Kör test_timerhjul..."
+if ./tests/test_timerhjul; then
+    echo -e "${GREEN}✓ Timerhjulstester godkända${NC}\n"
+    ((PASSED_TESTS++))
+else
+    echo -e "${RED}✗ Timerhjulstester misslyckades${NC}\n"
+fi
+((TOTAL_TESTS++))
+
+# Test 7: Antagningskontroll
+echo "  [7/14] Kompilerar test_antagning..."
+gcc -Wall -Wextra -I../include tests/test_antagning.c -o tests/test_antagning -lpthread 2>&1 || {
+    echo -e "${RED}✗ Kompilering misslyckades${NC}"
+    exit 1
+}
+
+echo "  [7/14] Kör test_antagning..."
+if ./tests/test_antagning; then
+    echo -e "${GREEN}✓ Antagningstester godkända${NC}\n"
+    ((PASSED_TESTS++))
+else
+    echo -e "${RED}✗ Antagningstester misslyckades${NC}\n"
+fi
+((TOTAL_TESTS++))
+
+# Test 8: Klientgräns
+echo "  [8/14] Kompilerar test_klientgrans..."
+gcc -Wall -Wextra -I../include tests/test_klientgrans.c -o tests/test_klientgrans -lpthread 2>&1 || {
+    echo -e "${RED}✗ Kompilering misslyckades${NC}"
+    exit 1
+}
+
+echo "  [8/14] Kör test_klientgrans..."
+if ./tests/test_klientgrans; then
+    echo -e "${GREEN}✓ Klientgränstester godkända${NC}\n"
+    ((PASSED_TESTS++))
+else
+    echo -e "${RED}✗ Klientgränstester misslyckades${NC}\n"
+fi
+((TOTAL_TESTS++))
+
+# Test 9: Överlämning vid omstart
+echo "  [9/14] Kompilerar test_overlamning..."
+gcc -Wall -Wextra -I../include tests/test_overlamning.c -o tests/test_overlamning -lpthread 2>&1 || {
+    echo -e "${RED}✗ Kompilering misslyckades${NC}"
+    exit 1
+}
+
+echo "  [9/14] Kör test_overlamning..."
+if ./tests/test_overlamning; then
+    echo -e "${GREEN}✓ Överlämningstester godkända${NC}\n"
+    ((PASSED_TESTS++))
+else
+    echo -e "${RED}✗ Överlämningstester misslyckades${NC}\n"
+fi
+((TOTAL_TESTS++))
+
+# Test 10: SIMD-skanning av HTTP-headers
+echo "  [10/14] Kompilerar test_http_skanning..."
+gcc -Wall -Wextra -I../include tests/test_http_skanning.c -o tests/test_http_skanning 2>&1 || {
+    echo -e "${RED}✗ Kompilering misslyckades${NC}"
+    exit 1
+}
+
+echo "  [10/14] Kör test_http_skanning..."
+if ./tests/test_http_skanning; then
+    echo -e "${GREEN}✓ HTTP-skanningstester godkända${NC}\n"
+    ((PASSED_TESTS++))
+else
+    echo -e "${RED}✗ HTTP-skanningstester misslyckades${NC}\n"
+fi
+((TOTAL_TESTS++))
+
+# Test 11: Tolkning av query-strängar
+echo "  [11/14] Kompilerar test_http_query..."
+gcc -Wall -Wextra -I../include tests/test_http_query.c -o tests/test_http_query 2>&1 || {
+    echo -e "${RED}✗ Kompilering misslyckades${NC}"
+    exit 1
+}
+
+echo "  [11/14] Kör test_http_query..."
+if ./tests/test_http_query; then
+    echo -e "${GREEN}✓ Query-tester godkända${NC}\n"
+    ((PASSED_TESTS++))
+else
+    echo -e "${RED}✗ Query-tester misslyckades${NC}\n"
+fi
+((TOTAL_TESTS++))
+
+# Test 12: Rutt-register
+echo "  [12/14] Kompilerar test_rutter..."
+gcc -Wall -Wextra -I../include tests/test_rutter.c -o tests/test_rutter 2>&1 || {
+    echo -e "${RED}✗ Kompilering misslyckades${NC}"
+    exit 1
+}
+
+echo "  [12/14] Kör test_rutter..."
+if ./tests/test_rutter; then
+    echo -e "${GREEN}✓ Rutt-tester godkända${NC}\n"
+    ((PASSED_TESTS++))
+else
+    echo -e "${RED}✗ Rutt-tester misslyckades${NC}\n"
+fi
+((TOTAL_TESTS++))
+
+# Test 13: Komprimering
+echo "  [13/14] Kompilerar test_komprimering..."
+gcc -Wall -Wextra -I../include tests/test_komprimering.c -o tests/test_komprimering 2>&1 || {
+    echo -e "${RED}✗ Kompilering misslyckades${NC}"
+    exit 1
+}
+
+echo "  [13/14] Kör test_komprimering..."
+if ./tests/test_komprimering; then
+    echo -e "${GREEN}✓ Komprimeringstester godkända${NC}\n"
+    ((PASSED_TESTS++))
+else
+    echo -e "${RED}✗ Komprimeringstester misslyckades${NC}\n"
+fi
+((TOTAL_TESTS++))
+
+# Test 14: JSON-skrivare
+echo "  [14/14] Kompilerar test_json_skrivare..."
+gcc -Wall -Wextra -I../include tests/test_json_skrivare.c -o tests/test_json_skrivare 2>&1 || {
+    echo -e "${RED}✗ Kompilering misslyckades${NC}"
+    exit 1
+}
+
+echo "  [14/14] Kör test_json_skrivare..."
+if ./tests/test_json_skrivare; then
+    echo -e "${GREEN}✓ JSON-skrivartester godkända${NC}\n"
+    ((PASSED_TESTS++))
+else
+    echo -e "${RED}✗ JSON-skrivartester misslyckades${NC}\n"
+fi
+((TOTAL_TESTS++))
+
 # ============================================================================
 # INTEGRATIONSTESTER
 # ============================================================================
@@ -84,7 +276,7 @@ SERVER_PID=$!
 sleep 2  # Vänta på att servern startar
 
 # Test 3: Root endpoint
-echo "  [1/4] Testar GET /..."
+echo "  [1/5] Testar GET /..."
 RESPONSE=$(curl -s http://localhost:8081/ 2>&1)
 if echo "$RESPONSE" | grep -q "Vädersystem API"; then
     echo -e "${GREEN}✓ Root endpoint fungerar${NC}"
@@ -95,7 +287,7 @@ fi
 ((TOTAL_TESTS++))
 
 # Test 4: Weather endpoint (utan API kommer ge fel, men endpoint ska svara)
-echo "  [2/4] Testar GET /weather..."
+echo "  [2/5] Testar GET /weather..."
 HTTP_CODE=$(curl -s -o /dev/null -w "%{http_code}" "http://localhost:8081/weather?city=Stockholm&country=SE" 2>&1)
 if [ "$HTTP_CODE" = "200" ] || [ "$HTTP_CODE" = "500" ]; then
     echo -e "${GREEN}✓ Weather endpoint svarar${NC}"
@@ -106,7 +298,7 @@ fi
 ((TOTAL_TESTS++))
 
 # Test 5: Forecast endpoint
-echo "  [3/4] Testar GET /forecast..."
+echo "  [3/5] Testar GET /forecast..."
 HTTP_CODE=$(curl -s -o /dev/null -w "%{http_code}" "http://localhost:8081/forecast?city=Stockholm&country=SE" 2>&1)
 if [ "$HTTP_CODE" = "200" ] || [ "$HTTP_CODE" = "500" ]; then
     echo -e "${GREEN}✓ Forecast endpoint svarar${NC}"
@@ -117,7 +309,7 @@ fi
 ((TOTAL_TESTS++))
 
 # Test 6: 404 för ogiltig endpoint
-echo "  [4/4] Testar 404-hantering..."
+echo "  [4/5] Testar 404-hantering..."
 HTTP_CODE=$(curl -s -o /dev/null -w "%{http_code}" "http://localhost:8081/invalid" 2>&1)
 if [ "$HTTP_CODE" = "404" ]; then
     echo -e "${GREEN}✓ 404-hantering fungerar${NC}"
@@ -0,0 +1,170 @@
+// ============================================================================
+// ENHETSTESTER FÖR ANTAGNINGSKONTROLL
+// ============================================================================
+// Testar gränserna för ködjup, kötid och upstream-platser, samt att
+// trådpoolen mäter ködjup och kötid som kontrollen bygger på
+// Kompilera: gcc -I../include tests/test_antagning.c -o test_antagning -lpthread
+// Kör: ./test_antagning
+
+#define _POSIX_C_SOURCE 200809L  // För nanosleep
+#include "../src/antagning.c"
+#include "../src/arbetarpool.c"
+#include "../src/loggning.c"
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <stdbool.h>
+
+static int tester_totalt = 0;
+static int tester_godkanda = 0;
+
+#define RUN_TEST(test_func) do { \
+    printf("Kör %s...\n", #test_func); \
+    tester_totalt++; \
+    test_func(); \
+    tester_godkanda++; \
+    printf("  ✓ GODKÄND\n"); \
+} while(0)
+
+/**
+ * Sover ett antal millisekunder
+ *
+ * @param millisekunder - Hur länge
+ */
+static void sov_ms(long millisekunder) {
+    struct timespec vila = {millisekunder / 1000, (millisekunder % 1000) * 1000000};
+    nanosleep(&vila, NULL);
+}
+
+// Arbetsuppgift som väntar tills testet släpper den
+static atomic_bool slappt;
+
+static void vanta_pa_slapp(void* argument, char* scratch, size_t scratch_storlek) {
+    (void)scratch;
+    (void)scratch_storlek;
+    while (!atomic_load(&slappt)) {
+        sov_ms(1);
+    }
+    atomic_fetch_add((_Atomic int*)argument, 1);
+}
+
+// ============================================================================
+// TESTER
+// ============================================================================
+
+void test_kodjup() {
+    konfigurera_antagning(4, 0, 0);
+    AntagningsStatistik fore, efter;
+    hamta_antagnings_statistik(&fore);
+
+    assert(antagning_slapp_in(0, 0));
+    assert(antagning_slapp_in(3, 10000));  // Kötid avstängd
+    assert(!antagning_slapp_in(4, 0));
+    assert(!antagning_slapp_in(100, 0));
+
+    hamta_antagnings_statistik(&efter);
+    assert(efter.avvisade_ko == fore.avvisade_ko + 2);
+    assert(efter.avvisade_kotid == fore.avvisade_kotid);
+}
+
+void test_kotid() {
+    konfigurera_antagning(0, 500, 0);
+    AntagningsStatistik fore, efter;
+    hamta_antagnings_statistik(&fore);
+
+    assert(antagning_slapp_in(10, 499));
+    assert(!antagning_slapp_in(10, 500));
+    // Tom kö - ett gammalt mätvärde får inte stänga ute trafik
+    assert(antagning_slapp_in(0, 5000));
+    assert(antagning_slapp_in(100000, 0));  // Ködjup avstängt
+
+    hamta_antagnings_statistik(&efter);
+    assert(efter.avvisade_kotid == fore.avvisade_kotid + 1);
+    assert(efter.avvisade_ko == fore.avvisade_ko);
+}
+
+void test_upstream_platser() {
+    konfigurera_antagning(0, 0, 2);
+    AntagningsStatistik fore, mitt, efter;
+    hamta_antagnings_statistik(&fore);
+
+    assert(antagning_borja_upstream());
+    assert(antagning_borja_upstream());
+    assert(!antagning_borja_upstream());  // Reserverat för cacheträffar
+    hamta_antagnings_statistik(&mitt);
+    assert(mitt.upstream_pagaende == 2);
+    assert(mitt.avvisade_upstream == fore.avvisade_upstream + 1);
+
+    antagning_slapp_upstream();
+    assert(antagning_borja_upstream());  // En plats blev ledig
+    antagning_slapp_upstream();
+    antagning_slapp_upstream();
+
+    hamta_antagnings_statistik(&efter);
+    assert(efter.upstream_pagaende == 0);
+
+    // Utan gräns släpps allt igenom
+    konfigurera_antagning(0, 0, 0);
+    for (int i = 0; i < 100; i++) {
+        assert(antagning_borja_upstream());
+    }
+    for (int i = 0; i < 100; i++) {
+        antagning_slapp_upstream();
+    }
+}
+
+void test_arbetarpool_matning() {
+    ArbetarPool pool;
+    _Atomic int klara = 0;
+    atomic_store(&slappt, false);
+    assert(initiera_arbetarpool(&pool, 1, 16, 64));
+    assert(arbetarpool_kodjup(&pool) == 0);
+
+    // Den enda arbetaren fastnar på första uppgiften, resten blir kvar i kön
+    for (int i = 0; i < 5; i++) {
+        assert(lagg_till_uppgift(&pool, vanta_pa_slapp, &klara));
+    }
+    sov_ms(100);
+    assert(arbetarpool_kodjup(&pool) == 4);
+    assert(arbetarpool_kotid_ms(&pool) < 100);  // Första togs ut direkt
+
+    // Nästa uppgift tas ut först när den första släpps - efter ~100 ms i kön
+    atomic_store(&slappt, true);
+    while (atomic_load(&klara) < 5) {
+        sov_ms(1);
+    }
+    assert(arbetarpool_kodjup(&pool) == 0);
+    assert(arbetarpool_kotid_ms(&pool) >= 100);
+
+    stang_arbetarpool(&pool);
+}
+
+int main(void) {
+    printf("\n╔═══════════════════════════════════════════════════════╗\n");
+    printf("║       ENHETSTESTER FÖR ANTAGNINGSKONTROLL            ║\n");
+    printf("╚═══════════════════════════════════════════════════════╝\n\n");
+
+    aktuell_log_niva = LOG_NIVA_FEL;
+
+    RUN_TEST(test_kodjup);
+    RUN_TEST(test_kotid);
+    RUN_TEST(test_upstream_platser);
+    RUN_TEST(test_arbetarpool_matning);
+
+    // Visa resultat
+    printf("\n╔═══════════════════════════════════════════════════════╗\n");
+    printf("║                   TESTRESULTAT                       ║\n");
+    printf("╚═══════════════════════════════════════════════════════╝\n");
+    printf("  Totalt:        %d tester\n", tester_totalt);
+    printf("  Godkända:      %d tester\n", tester_godkanda);
+    printf("  Misslyckade:   %d tester\n", tester_totalt - tester_godkanda);
+
+    if (tester_godkanda == tester_totalt) {
+        printf("\n  ✓ ALLA TESTER GODKÄNDA!\n\n");
+        return 0;
+    } else {
+        printf("\n  ✗ VISSA TESTER MISSLYCKADES\n\n");
+        return 1;
+    }
+}
@@ -0,0 +1,249 @@
+// ============================================================================
+// ENHETSTESTER FÖR DNS-CACHEN
+// ============================================================================
+// Testar TTL, bakgrundsuppdatering och reserv till senast kända adress.
+// Uppslagningen görs mot en egen hosts-fil i stället för riktig DNS.
+// Kompilera: gcc -I../include tests/test_dns_cache.c -o test_dns_cache -lpthread
+// Kör: ./test_dns_cache
+
+#include "../src/dns_cache.c"
+#include "../src/loggning.c"
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <stdbool.h>
+
+static int tester_totalt = 0;
+static int tester_godkanda = 0;
+
+#define RUN_TEST(test_func) do { \
+    printf("Kör %s...\n", #test_func); \
+    tester_totalt++; \
+    test_func(); \
+    tester_godkanda++; \
+    printf("  ✓ GODKÄND\n"); \
+} while(0)
+
+// Testets hosts-fil, i samma format som /etc/hosts
+static char hosts_fil[64];
+
+/**
+ * Skriver om testets hosts-fil
+ *
+ * @param innehall - Filens nya innehåll
+ */
+static void skriv_hosts(const char* innehall) {
+    FILE* fil = fopen(hosts_fil, "w");
+    assert(fil);
+    fputs(innehall, fil);
+    fclose(fil);
+}
+
+/**
+ * Resolver som läser testets hosts-fil
+ *
+ * @param vard - Värdnamn
+ * @param adress - Här sparas adressen
+ * @return true om värden finns i filen
+ */
+static bool sla_upp_i_hosts(const char* vard, DnsAdress* adress) {
+    FILE* fil = fopen(hosts_fil, "r");
+    if (!fil) {
+        return false;
+    }
+    char ip[64], namn[128];
+    bool hittad = false;
+    while (!hittad && fscanf(fil, "%63s %127s", ip, namn) == 2) {
+        if (strcmp(namn, vard) != 0) {
+            continue;
+        }
+        memset(adress, 0, sizeof(*adress));
+        struct sockaddr_in* v4 = (struct sockaddr_in*)&adress->adress;
+        struct sockaddr_in6* v6 = (struct sockaddr_in6*)&adress->adress;
+        if (inet_pton(AF_INET, ip, &v4->sin_addr) == 1) {
+            v4->sin_family = AF_INET;
+            adress->langd = sizeof(*v4);
+            hittad = true;
+        } else if (inet_pton(AF_INET6, ip, &v6->sin6_addr) == 1) {
+            v6->sin6_family = AF_INET6;
+            adress->langd = sizeof(*v6);
+            hittad = true;
+        }
+    }
+    fclose(fil);
+    return hittad;
+}
+
+/**
+ * Slår upp en värd och returnerar IPv4-adressen som text
+ *
+ * @param vard - Värdnamn
+ * @param text - Här sparas adressen
+ * @return true om uppslagningen lyckades
+ */
+static bool sla_upp_text(const char* vard, char text[INET_ADDRSTRLEN]) {
+    DnsAdress adress;
+    if (!dns_sla_upp(vard, 80, &adress)) {
+        return false;
+    }
+    struct sockaddr_in* v4 = (struct sockaddr_in*)&adress.adress;
+    assert(v4->sin_family == AF_INET);
+    assert(ntohs(v4->sin_port) == 80);
+    inet_ntop(AF_INET, &v4->sin_addr, text, INET_ADDRSTRLEN);
+    return true;
+}
+
+/**
+ * Väntar tills värden slås upp till en viss adress (bakgrundstråden har uppdaterat)
+ *
+ * @param vard - Värdnamn
+ * @param forvantad - Adressen som väntas
+ * @return true om adressen dök upp inom två sekunder
+ */
+static bool vanta_pa_adress(const char* vard, const char* forvantad) {
+    char text[INET_ADDRSTRLEN];
+    for (int i = 0; i < 200; i++) {
+        if (sla_upp_text(vard, text) && strcmp(text, forvantad) == 0) {
+            return true;
+        }
+        struct timespec vila = {0, 10 * 1000 * 1000};
+        nanosleep(&vila, NULL);
+    }
+    return false;
+}
+
+// ============================================================================
+// TESTER
+// ============================================================================
+
+void test_cachad_uppslagning() {
+    skriv_hosts("127.0.0.1 api.test\n");
+    dns_cache_satt_ttl(300);
+    DnsStatistik fore, efter;
+    hamta_dns_statistik(&fore);
+
+    char text[INET_ADDRSTRLEN];
+    assert(sla_upp_text("api.test", text));
+    assert(strcmp(text, "127.0.0.1") == 0);
+
+    // Filen ändras men TTL:en har inte gått ut - samma adress, ingen ny uppslagning
+    skriv_hosts("127.0.0.2 api.test\n");
+    assert(sla_upp_text("api.test", text));
+    assert(strcmp(text, "127.0.0.1") == 0);
+
+    hamta_dns_statistik(&efter);
+    assert(efter.uppslagningar == fore.uppslagningar + 1);
+    assert(efter.traffar == fore.traffar + 1);
+
+    stang_dns_cache();
+}
+
+void test_gammal_post_uppdateras_i_bakgrunden() {
+    skriv_hosts("127.0.0.1 api.test\n");
+    dns_cache_satt_ttl(0);  // Varje användning gör posten gammal
+
+    char text[INET_ADDRSTRLEN];
+    assert(sla_upp_text("api.test", text));
+    assert(strcmp(text, "127.0.0.1") == 0);
+
+    // Den gamla adressen används direkt medan den nya slås upp i bakgrunden
+    skriv_hosts("127.0.0.2 api.test\n");
+    assert(sla_upp_text("api.test", text));
+    assert(vanta_pa_adress("api.test", "127.0.0.2"));
+
+    stang_dns_cache();
+}
+
+void test_senast_kanda_adress_vid_fel() {
+    skriv_hosts("127.0.0.3 api.test\n");
+    dns_cache_satt_ttl(0);
+    DnsStatistik fore, efter;
+
+    char text[INET_ADDRSTRLEN];
+    assert(sla_upp_text("api.test", text));
+    assert(strcmp(text, "127.0.0.3") == 0);
+
+    // Värden försvinner ur "DNS" - den senast kända adressen ska fortsätta gälla
+    skriv_hosts("127.0.0.9 annan.test\n");
+    hamta_dns_statistik(&fore);
+    for (int i = 0; i < 200; i++) {
+        assert(sla_upp_text("api.test", text));
+        assert(strcmp(text, "127.0.0.3") == 0);
+        hamta_dns_statistik(&efter);
+        if (efter.misslyckade > fore.misslyckade) {
+            break;
+        }
+        struct timespec vila = {0, 10 * 1000 * 1000};
+        nanosleep(&vila, NULL);
+    }
+    assert(efter.misslyckade > fore.misslyckade);
+    assert(sla_upp_text("api.test", text));
+    assert(strcmp(text, "127.0.0.3") == 0);
+
+    // En värd som aldrig gått att slå upp har ingen reserv
+    assert(!sla_upp_text("saknas.test", text));
+
+    stang_dns_cache();
+}
+
+void test_ipv6() {
+    skriv_hosts("::1 v6.test\n");
+    dns_cache_satt_ttl(300);
+
+    DnsAdress adress;
+    assert(dns_sla_upp("v6.test", 8443, &adress));
+    assert(adress.adress.ss_family == AF_INET6);
+    assert(adress.langd == sizeof(struct sockaddr_in6));
+    assert(ntohs(((struct sockaddr_in6*)&adress.adress)->sin6_port) == 8443);
+
+    stang_dns_cache();
+}
+
+void test_getaddrinfo() {
+    // Standardresolvern, med en IP-adress så att ingen riktig DNS behövs
+    dns_cache_satt_uppslagning(NULL);
+    dns_cache_satt_ttl(300);
+
+    char text[INET_ADDRSTRLEN];
+    assert(sla_upp_text("127.0.0.1", text));
+    assert(strcmp(text, "127.0.0.1") == 0);
+
+    stang_dns_cache();
+    dns_cache_satt_uppslagning(sla_upp_i_hosts);
+}
+
+int main(void) {
+    printf("\n╔═══════════════════════════════════════════════════════╗\n");
+    printf("║          ENHETSTESTER FÖR DNS-CACHE                  ║\n");
+    printf("╚═══════════════════════════════════════════════════════╝\n\n");
+
+    aktuell_log_niva = LOG_NIVA_FEL;  // Förväntade uppslagningsfel ska inte synas
+
+    snprintf(hosts_fil, sizeof(hosts_fil), "/tmp/test_dns_hosts_%d", (int)getpid());
+    dns_cache_satt_uppslagning(sla_upp_i_hosts);
+
+    RUN_TEST(test_cachad_uppslagning);
+    RUN_TEST(test_gammal_post_uppdateras_i_bakgrunden);
+    RUN_TEST(test_senast_kanda_adress_vid_fel);
+    RUN_TEST(test_ipv6);
+    RUN_TEST(test_getaddrinfo);
+
+    remove(hosts_fil);
+
+    // Visa resultat
+    printf("\n╔═══════════════════════════════════════════════════════╗\n");
+    printf("║                   TESTRESULTAT                       ║\n");
+    printf("╚═══════════════════════════════════════════════════════╝\n");
+    printf("  Totalt:        %d tester\n", tester_totalt);
+    printf("  Godkända:      %d tester\n", tester_godkanda);
+    printf("  Misslyckade:   %d tester\n", tester_totalt - tester_godkanda);
+
+    if (tester_godkanda == tester_totalt) {
+        printf("\n  ✓ ALLA TESTER GODKÄNDA!\n\n");
+        return 0;
+    } else {
+        printf("\n  ✗ VISSA TESTER MISSLYCKADES\n\n");
+        return 1;
+    }
+}
@@ -11,6 +11,8 @@
 #include <stdbool.h>
 
 #include "../src/http_server.c"
+#include "../src/http_skanning.c"
+#include "../src/http_query.c"
 
 static int tester_totalt = 0;
 static int tester_godkanda = 0;
@@ -90,6 +92,124 @@ void test_parsa_http_root() {
     assert(strcmp(request.sokvag, "/") == 0);
 }
 
+void test_parsa_http_keep_alive() {
+    HttpRequest request;
+
+    // HTTP/1.1 är persistent som standard
+    assert(parsa_http_request("GET / HTTP/1.1\r\nHost: localhost\r\n\r\n", &request));
+    assert(request.hall_vid_liv == true);
+
+    // ...om inte klienten ber om att stänga (skiftlägesokänsligt)
+    assert(parsa_http_request("GET / HTTP/1.1\r\nconnection: Close\r\n\r\n", &request));
+    assert(request.hall_vid_liv == false);
+
+    // HTTP/1.0 stänger som standard men kan be om keep-alive
+    assert(parsa_http_request("GET / HTTP/1.0\r\n\r\n", &request));
+    assert(request.hall_vid_liv == false);
+    assert(parsa_http_request("GET / HTTP/1.0\r\nConnection: keep-alive\r\n\r\n", &request));
+    assert(request.hall_vid_liv == true);
+}
+
+// ============================================================================
+// TESTER FÖR PARSA_HTTP_REQUEST_VY
+// ============================================================================
+
+void test_parsa_vy_pekar_in_i_bufferten() {
+    const char* rådata =
+        "GET /weather?city=Stockholm&country=SE HTTP/1.1\r\n"
+        "Host: localhost\r\n\r\n";
+
+    HttpRequestVy request;
+    assert(parsa_http_request_vy(rådata, strlen(rådata), &request));
+    assert(request.metod == HTTP_GET);
+    assert(http_vy_lika(request.metod_text, "GET"));
+    assert(http_vy_lika(request.sokvag, "/weather"));
+    assert(http_vy_lika(request.query, "city=Stockholm&country=SE"));
+    assert(http_vy_lika(request.version, "HTTP/1.1"));
+    assert(request.sokvag.data == rådata + 4);  // Ingen kopia
+    assert(request.body.langd == 0);
+    assert(request.hall_vid_liv);
+}
+
+void test_parsa_vy_lang_url() {
+    // Längre än de gamla fälten (sokvag[256], query[512]) - kortas inte av
+    char rådata[2048];
+    char stad[1200];
+    memset(stad, 'a', sizeof(stad) - 1);
+    stad[sizeof(stad) - 1] = '\0';
+    int langd = snprintf(rådata, sizeof(rådata),
+                         "GET /weather?city=%s&country=SE HTTP/1.1\r\n\r\n", stad);
+
+    HttpRequestVy request;
+    assert(parsa_http_request_vy(rådata, (size_t)langd, &request));
+    assert(request.query.langd == strlen("city=") + strlen(stad) + strlen("&country=SE"));
+
+    char varde[2048];
+    assert(hamta_query_parameter_vy(request.query, "city", varde, sizeof(varde)));
+    assert(strcmp(varde, stad) == 0);
+    assert(hamta_query_parameter_vy(request.query, "country", varde, sizeof(varde)));
+    assert(strcmp(varde, "SE") == 0);
+}
+
+void test_parsa_vy_utan_nollterminering() {
+    // Två pipelinade requests i samma buffer - bara den första parsas,
+    // och inget läses bortom dess längd
+    const char* forsta = "GET /weather?city=Oslo HTTP/1.1\r\nConnection: close\r\n\r\n";
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer), "%sGET /forecast?city=Bergen HTTP/1.1\r\n\r\n", forsta);
+
+    HttpRequestVy request;
+    assert(parsa_http_request_vy(buffer, strlen(forsta), &request));
+    assert(http_vy_lika(request.sokvag, "/weather"));
+    assert(http_vy_lika(request.query, "city=Oslo"));
+    assert(request.hall_vid_liv == false);
+    assert(request.body.langd == 0);
+
+    char varde[32];
+    assert(!hamta_query_parameter_vy(request.query, "country", varde, sizeof(varde)));
+
+    // Exakt så många bytes som requesten - utan nollterminator
+    size_t langd = strlen(forsta);
+    char* exakt = malloc(langd);
+    memcpy(exakt, forsta, langd);
+    assert(parsa_http_request_vy(exakt, langd, &request));
+    assert(hamta_query_parameter_vy(request.query, "city", varde, sizeof(varde)));
+    assert(strcmp(varde, "Oslo") == 0);
+    free(exakt);
+}
+
+void test_parsa_vy_headers_och_body() {
+    const char* rådata =
+        "POST /api HTTP/1.1\r\n"
+        "Host: localhost\r\n"
+        "accept-encoding:  gzip, br  \r\n"
+        "Content-Length: 11\r\n\r\n"
+        "{\"test\": 1}";
+
+    HttpRequestVy request;
+    assert(parsa_http_request_vy(rådata, strlen(rådata), &request));
+    assert(request.metod == HTTP_POST);
+    assert(http_vy_lika(request.body, "{\"test\": 1}"));
+
+    HttpVy varde;
+    assert(hamta_http_header(&request, "Accept-Encoding", &varde));
+    assert(http_vy_lika(varde, "gzip, br"));  // Utan omgivande blanksteg
+    assert(hamta_http_header(&request, "content-length", &varde));
+    assert(http_vy_lika(varde, "11"));
+    assert(!hamta_http_header(&request, "Cookie", &varde));
+
+    // Body räknas aldrig som headers
+    assert(!hamta_http_header(&request, "{\"test\"", &varde));
+}
+
+void test_parsa_vy_ogiltig() {
+    HttpRequestVy request;
+    assert(!parsa_http_request_vy("", 0, &request));
+    assert(!parsa_http_request_vy("GET\r\n\r\n", 7, &request));
+    assert(!parsa_http_request_vy("DELETE / HTTP/1.1\r\n\r\n", 21, &request));
+    assert(request.metod == HTTP_UNKNOWN);
+}
+
 // ============================================================================
 // TESTER FÖR HAMTA_QUERY_PARAMETER
 // ============================================================================
@@ -147,6 +267,25 @@ void test_hamta_query_parameter_med_mellanslag() {
     // Men för enkel implementation accepterar vi mellanslag
 }
 
+void test_hamta_query_parameter_helt_namn() {
+    // "xcity" och "cityx" får inte tas för "city"
+    const char* query = "xcity=Fel&cityx=Fel&city=Malmo";
+    char city[64];
+
+    assert(hamta_query_parameter(query, "city", city, sizeof(city)) == true);
+    assert(strcmp(city, "Malmo") == 0);
+    assert(hamta_query_parameter("xcity=Fel", "city", city, sizeof(city)) == false);
+}
+
+void test_hamta_query_parameter_avkodad() {
+    char city[64];
+
+    assert(hamta_query_parameter("city=G%C3%B6teborg", "city", city, sizeof(city)));
+    assert(strcmp(city, "G\xC3\xB6teborg") == 0);  // "Göteborg" i UTF-8
+    assert(hamta_query_parameter("c%69ty=New+York", "city", city, sizeof(city)));
+    assert(strcmp(city, "New York") == 0);
+}
+
 // ============================================================================
 // TESTER FÖR SKAPA_HTTP_RESPONSE
 // ============================================================================
@@ -194,6 +333,361 @@ void test_skapa_http_response_headers() {
     assert(strstr(buffer, "\r\n\r\n") != NULL);  // Header-body separator
 }
 
+void test_skapa_http_response_keep_alive() {
+    HttpSvar svar;
+    svar.hall_vid_liv = true;
+
+    skapa_http_svar(&svar, 200, "{}", 2);
+
+    assert(strstr(svar.huvud, "Connection: keep-alive") != NULL);
+    assert(strstr(svar.huvud, "Keep-Alive: timeout=") != NULL);
+    assert(strstr(svar.huvud, "Connection: close") == NULL);
+}
+
+void test_http_datum() {
+    char datum[HTTP_DATUM_LANGD + 1];
+
+    formatera_http_datum(784111777, datum);  // Exemplet i RFC 9110
+    assert(strcmp(datum, "Sun, 06 Nov 1994 08:49:37 GMT") == 0);
+    formatera_http_datum(0, datum);
+    assert(strcmp(datum, "Thu, 01 Jan 1970 00:00:00 GMT") == 0);
+    formatera_http_datum(951782400, datum);  // Skottdag
+    assert(strcmp(datum, "Tue, 29 Feb 2000 00:00:00 GMT") == 0);
+    formatera_http_datum(1735689599, datum);
+    assert(strcmp(datum, "Tue, 31 Dec 2024 23:59:59 GMT") == 0);
+    assert(strlen(datum) == HTTP_DATUM_LANGD);
+}
+
+void test_svarsmallar() {
+    HttpSvar svar;
+    svar.hall_vid_liv = false;
+
+    // Mallen ger statusrad, Date och Content-Length i ett stycke
+    skapa_http_svar(&svar, 431, "", 1234567890);
+    assert(strncmp(svar.huvud, "HTTP/1.1 431 Request Header Fields Too Large\r\n", 46) == 0);
+    assert(strstr(svar.huvud, "Content-Length: 1234567890\r\n\r\n") != NULL);
+    const char* datum = strstr(svar.huvud, "\r\nDate: ");
+    assert(datum != NULL && strstr(datum, " GMT\r\n") == datum + 8 + HTTP_DATUM_LANGD - 4);
+    assert(strlen(svar.huvud) == svar.huvud_langd);
+
+    skapa_http_svar(&svar, 200, "", 0);
+    assert(strstr(svar.huvud, "Content-Length: 0\r\n\r\n") != NULL);
+
+    // Statuskod utan mall
+    svar.hall_vid_liv = true;
+    skapa_http_svar(&svar, 299, "{}", 2);
+    assert(strncmp(svar.huvud, "HTTP/1.1 299 Unknown\r\n", 22) == 0);
+    assert(strstr(svar.huvud, "Connection: keep-alive") != NULL);
+    assert(strstr(svar.huvud, "Date: ") != NULL);
+    assert(strcmp(svar.huvud + svar.huvud_langd - 4, "\r\n\r\n") == 0);
+
+    // De förbyggda svaren får också Date
+    skapa_http_overlast(&svar);
+    assert(strncmp(svar.huvud, "HTTP/1.1 503 ", 13) == 0);
+    assert(strstr(svar.huvud, "Date: ") != NULL);
+    assert(strcmp(svar.huvud + svar.huvud_langd - 4, "\r\n\r\n") == 0);
+    assert(strlen(svar.huvud) == svar.huvud_langd);
+}
+
+void test_etag_matchar() {
+    const char* etag = "\"a1b2c3\"";
+    HttpRequestVy request;
+
+    const char* utan = "GET /weather HTTP/1.1\r\nHost: x\r\n\r\n";
+    assert(parsa_http_request_vy(utan, strlen(utan), &request));
+    assert(!http_etag_matchar(&request, etag));
+
+    const char* exakt = "GET / HTTP/1.1\r\nIf-None-Match: \"a1b2c3\"\r\n\r\n";
+    assert(parsa_http_request_vy(exakt, strlen(exakt), &request));
+    assert(http_etag_matchar(&request, etag));
+
+    // Lista med svag ETag och blanksteg
+    const char* lista = "GET / HTTP/1.1\r\nif-none-match: \"x\" ,  W/\"a1b2c3\" \r\n\r\n";
+    assert(parsa_http_request_vy(lista, strlen(lista), &request));
+    assert(http_etag_matchar(&request, etag));
+
+    const char* stjarna = "GET / HTTP/1.1\r\nIf-None-Match: *\r\n\r\n";
+    assert(parsa_http_request_vy(stjarna, strlen(stjarna), &request));
+    assert(http_etag_matchar(&request, etag));
+
+    // Prefix, utan citattecken eller annan ETag matchar inte
+    const char* fel = "GET / HTTP/1.1\r\nIf-None-Match: \"a1b2\", a1b2c3, \"a1b2c3d\"\r\n\r\n";
+    assert(parsa_http_request_vy(fel, strlen(fel), &request));
+    assert(!http_etag_matchar(&request, etag));
+}
+
+// Komprimering som väljs för en Accept-Encoding-header (NULL = ingen header)
+static Komprimering valj(const char* accept_encoding) {
+    char request[256];
+    snprintf(request, sizeof(request), "GET / HTTP/1.1\r\n%s%s%s\r\n",
+             accept_encoding ? "Accept-Encoding: " : "",
+             accept_encoding ? accept_encoding : "", accept_encoding ? "\r\n" : "");
+    HttpRequestVy vy;
+    assert(parsa_http_request_vy(request, strlen(request), &vy));
+    return http_valj_komprimering(&vy);
+}
+
+void test_valj_komprimering() {
+    assert(valj(NULL) == KOMPRIMERING_INGEN);
+    assert(valj("") == KOMPRIMERING_INGEN);
+    assert(valj("gzip") == KOMPRIMERING_GZIP);
+    assert(valj("deflate, gzip, br") == KOMPRIMERING_GZIP);       // gzip vid lika vikt
+    assert(valj("GZIP") == KOMPRIMERING_GZIP);
+    assert(valj("deflate") == KOMPRIMERING_DEFLATE);
+    assert(valj("br, identity") == KOMPRIMERING_INGEN);
+    assert(valj("gzip;q=0.5, deflate") == KOMPRIMERING_DEFLATE);  // Högst q vinner
+    assert(valj("gzip; q=0, deflate;q=0.001") == KOMPRIMERING_DEFLATE);
+    assert(valj("gzip;q=0.000, deflate;q=0") == KOMPRIMERING_INGEN);
+    assert(valj("*") == KOMPRIMERING_GZIP);
+    assert(valj("*;q=0") == KOMPRIMERING_INGEN);
+    assert(valj("gzip;q=0, *") == KOMPRIMERING_DEFLATE);          // * gäller bara det som inte nämns
+    assert(valj("x-gzip") == KOMPRIMERING_GZIP);
+    assert(valj("gzipx, deflatey") == KOMPRIMERING_INGEN);
+}
+
+void test_304_och_extra_headers() {
+    HttpSvar svar;
+    svar.hall_vid_liv = true;
+
+    // 304 har ingen body och får inte ange Content-Length: 0
+    skapa_http_svar(&svar, 304, "", 0);
+    assert(strncmp(svar.huvud, "HTTP/1.1 304 Not Modified\r\n", 27) == 0);
+    assert(strstr(svar.huvud, "Content-Length") == NULL);
+    assert(lagg_till_http_header(&svar, "ETag", "\"a1b2c3\""));
+    assert(lagg_till_http_header(&svar, "Cache-Control", "public, max-age=60"));
+    assert(strstr(svar.huvud, "\r\nETag: \"a1b2c3\"\r\nCache-Control: public, max-age=60\r\n\r\n") != NULL);
+    assert(strlen(svar.huvud) == svar.huvud_langd);
+    assert(svar.kropp_langd == 0);
+
+    // En header som inte får plats lämnar svaret orört
+    char lang[HTTP_HUVUD_STORLEK];
+    memset(lang, 'x', sizeof(lang) - 1);
+    lang[sizeof(lang) - 1] = '\0';
+    size_t fore = svar.huvud_langd;
+    assert(!lagg_till_http_header(&svar, "X-Lang", lang));
+    assert(svar.huvud_langd == fore);
+    assert(strcmp(svar.huvud + svar.huvud_langd - 4, "\r\n\r\n") == 0);
+}
+
+void test_http_svar_iovec() {
+    const char* kropp = "{\"a\": 1}";
+    HttpSvar svar;
+    svar.hall_vid_liv = false;
+    skapa_http_svar(&svar, 200, kropp, strlen(kropp));
+
+    // Bodyn refereras, den kopieras inte in efter headers
+    assert(svar.kropp == kropp);
+    assert(strstr(svar.huvud, "Content-Length: 8\r\n") != NULL);
+    assert(strcmp(svar.huvud + svar.huvud_langd - 4, "\r\n\r\n") == 0);
+
+    struct iovec iov[2];
+    assert(http_svar_iovec(&svar, 0, iov) == 2);
+    assert(iov[0].iov_base == svar.huvud && iov[0].iov_len == svar.huvud_langd);
+    assert(iov[1].iov_base == kropp && iov[1].iov_len == 8);
+
+    // Kort skrivning mitt i headers
+    assert(http_svar_iovec(&svar, 5, iov) == 2);
+    assert(iov[0].iov_base == svar.huvud + 5 && iov[0].iov_len == svar.huvud_langd - 5);
+
+    // Kort skrivning mitt i bodyn - bara resten av bodyn kvar
+    assert(http_svar_iovec(&svar, svar.huvud_langd + 3, iov) == 1);
+    assert(iov[0].iov_base == kropp + 3 && iov[0].iov_len == 5);
+
+    // Allt skickat
+    assert(http_svar_iovec(&svar, svar.huvud_langd + 8, iov) == 0);
+}
+
+// ============================================================================
+// TESTER FÖR HTTP_MOTTAGNING
+// ============================================================================
+
+// Matar in data i mottagningsbufferten som om den kom från recv()
+static bool ta_emot(HttpMottagning* mottagning, const char* data, size_t langd) {
+    while (langd > 0) {
+        size_t ledigt;
+        char* mal = http_mottagning_ledigt(mottagning, &ledigt);
+        if (!mal) {
+            return false;
+        }
+        size_t antal = langd < ledigt ? langd : ledigt;
+        memcpy(mal, data, antal);
+        http_mottagning_tillfor(mottagning, antal);
+        data += antal;
+        langd -= antal;
+    }
+    return true;
+}
+
+void test_mottagning_delad_request() {
+    const char* request = "GET /weather?city=Lund HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    HttpMottagning mottagning;
+    assert(initiera_http_mottagning(&mottagning));
+
+    // En byte i taget - den tomma raden delas mellan flera "segment"
+    size_t langd = strlen(request);
+    for (size_t i = 0; i < langd - 1; i++) {
+        assert(ta_emot(&mottagning, request + i, 1));
+        assert(hitta_http_request(&mottagning) == HTTP_RAM_OFULLSTANDIG);
+    }
+    assert(ta_emot(&mottagning, request + langd - 1, 1));
+    assert(hitta_http_request(&mottagning) == HTTP_RAM_KOMPLETT);
+    assert(mottagning.request_langd == langd);
+
+    stang_http_mottagning(&mottagning);
+}
+
+void test_mottagning_post_body() {
+    const char* headers = "POST /api HTTP/1.1\r\nContent-Length: 11\r\n\r\n";
+    HttpMottagning mottagning;
+    assert(initiera_http_mottagning(&mottagning));
+
+    assert(ta_emot(&mottagning, headers, strlen(headers)));
+    assert(hitta_http_request(&mottagning) == HTTP_RAM_OFULLSTANDIG);
+    assert(ta_emot(&mottagning, "{\"test\":", 8));
+    assert(hitta_http_request(&mottagning) == HTTP_RAM_OFULLSTANDIG);
+    assert(ta_emot(&mottagning, " 1}", 3));
+    assert(hitta_http_request(&mottagning) == HTTP_RAM_KOMPLETT);
+    assert(mottagning.request_langd == strlen(headers) + 11);
+
+    HttpRequest request;
+    assert(parsa_http_request(mottagning.data, &request));
+    assert(strcmp(request.body, "{\"test\": 1}") == 0);
+
+    stang_http_mottagning(&mottagning);
+}
+
+void test_mottagning_pipelining() {
+    const char* forsta = "POST /a HTTP/1.1\r\nContent-Length: 4\r\n\r\nabcd";
+    const char* andra = "GET /b HTTP/1.1\r\n\r\n";
+    HttpMottagning mottagning;
+    assert(initiera_http_mottagning(&mottagning));
+
+    assert(ta_emot(&mottagning, forsta, strlen(forsta)));
+    assert(ta_emot(&mottagning, andra, strlen(andra)));
+    assert(hitta_http_request(&mottagning) == HTTP_RAM_KOMPLETT);
+    assert(mottagning.request_langd == strlen(forsta));
+
+    http_mottagning_konsumera(&mottagning);
+    assert(hitta_http_request(&mottagning) == HTTP_RAM_KOMPLETT);
+    assert(strncmp(mottagning.data, "GET /b", 6) == 0);
+
+    http_mottagning_konsumera(&mottagning);
+    assert(mottagning.langd == 0);
+    assert(hitta_http_request(&mottagning) == HTTP_RAM_OFULLSTANDIG);
+
+    stang_http_mottagning(&mottagning);
+}
+
+void test_mottagning_vaxer() {
+    // En cookie som gör headers större än BUFFER_STORLEK
+    char request[3 * BUFFER_STORLEK];
+    int langd = snprintf(request, sizeof(request), "GET / HTTP/1.1\r\nCookie: ");
+    while (langd < 2 * BUFFER_STORLEK) {
+        request[langd++] = 'x';
+    }
+    langd += snprintf(request + langd, sizeof(request) - (size_t)langd, "\r\n\r\n");
+
+    HttpMottagning mottagning;
+    assert(initiera_http_mottagning(&mottagning));
+    assert(ta_emot(&mottagning, request, (size_t)langd));
+    assert(mottagning.kapacitet > BUFFER_STORLEK);
+    assert(hitta_http_request(&mottagning) == HTTP_RAM_KOMPLETT);
+
+    // Krymper tillbaka när requesten är besvarad
+    http_mottagning_konsumera(&mottagning);
+    assert(mottagning.kapacitet == BUFFER_STORLEK);
+
+    stang_http_mottagning(&mottagning);
+}
+
+void test_mottagning_for_stor() {
+    HttpMottagning mottagning;
+    HttpSvar svar;
+    char kropp[512];
+
+    // Headers utan slut fyller hela MAX_REQUEST_STORLEK -> 431
+    assert(initiera_http_mottagning(&mottagning));
+    assert(ta_emot(&mottagning, "GET / HTTP/1.1\r\nX: ", 20));
+    while (ta_emot(&mottagning, "yyyyyyyy", 8)) {
+    }
+    assert(mottagning.langd == MAX_REQUEST_STORLEK);
+    assert(hitta_http_request(&mottagning) == HTTP_RAM_FOR_STOR);
+    skapa_http_mottagningsfel(&svar, kropp, sizeof(kropp), &mottagning, HTTP_RAM_FOR_STOR);
+    assert(strstr(svar.huvud, "HTTP/1.1 431 ") != NULL);
+    assert(strstr(svar.huvud, "Connection: close") != NULL);
+    assert(!svar.hall_vid_liv);
+    stang_http_mottagning(&mottagning);
+
+    // För stor Content-Length upptäcks direkt efter headers -> 413
+    const char* stor = "POST / HTTP/1.1\r\nContent-Length: 99999999\r\n\r\n";
+    assert(initiera_http_mottagning(&mottagning));
+    assert(ta_emot(&mottagning, stor, strlen(stor)));
+    assert(hitta_http_request(&mottagning) == HTTP_RAM_FOR_STOR);
+    skapa_http_mottagningsfel(&svar, kropp, sizeof(kropp), &mottagning, HTTP_RAM_FOR_STOR);
+    assert(strstr(svar.huvud, "HTTP/1.1 413 ") != NULL);
+    stang_http_mottagning(&mottagning);
+}
+
+void test_mottagning_ogiltig_content_length() {
+    const char* request = "POST / HTTP/1.1\r\nContent-Length: -5\r\n\r\n";
+    HttpMottagning mottagning;
+    assert(initiera_http_mottagning(&mottagning));
+    assert(ta_emot(&mottagning, request, strlen(request)));
+    assert(hitta_http_request(&mottagning) == HTTP_RAM_FELAKTIG);
+    stang_http_mottagning(&mottagning);
+}
+
+void test_mottagning_motstridig_langd() {
+    HttpMottagning mottagning;
+    HttpSvar svar;
+    char kropp[512];
+
+    // Två olika Content-Length -> 400, oavsett vilken som kommer först
+    const char* motstridig = "POST / HTTP/1.1\r\nContent-Length: 4\r\n"
+                             "content-length: 40\r\n\r\nabcd";
+    assert(initiera_http_mottagning(&mottagning));
+    assert(ta_emot(&mottagning, motstridig, strlen(motstridig)));
+    assert(hitta_http_request(&mottagning) == HTTP_RAM_FELAKTIG);
+    skapa_http_mottagningsfel(&svar, kropp, sizeof(kropp), &mottagning, HTTP_RAM_FELAKTIG);
+    assert(strstr(svar.huvud, "HTTP/1.1 400 ") != NULL);
+    assert(!svar.hall_vid_liv);
+    stang_http_mottagning(&mottagning);
+
+    // Samma värde två gånger är entydigt
+    const char* dubbel = "POST / HTTP/1.1\r\nContent-Length: 4\r\nContent-Length: 4\r\n\r\nabcd";
+    assert(initiera_http_mottagning(&mottagning));
+    assert(ta_emot(&mottagning, dubbel, strlen(dubbel)));
+    assert(hitta_http_request(&mottagning) == HTTP_RAM_KOMPLETT);
+    assert(mottagning.request_langd == strlen(dubbel));
+    stang_http_mottagning(&mottagning);
+}
+
+void test_mottagning_transfer_encoding() {
+    // Chunkad body avkodas inte - den får inte tolkas som nästa request
+    const char* request = "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n"
+                          "4\r\nabcd\r\n0\r\n\r\n";
+    HttpMottagning mottagning;
+    HttpSvar svar;
+    char kropp[512];
+    assert(initiera_http_mottagning(&mottagning));
+    assert(ta_emot(&mottagning, request, strlen(request)));
+    assert(hitta_http_request(&mottagning) == HTTP_RAM_EJ_STODD);
+    assert(hitta_http_request(&mottagning) == HTTP_RAM_EJ_STODD);  // Reaktorn frågar igen
+    skapa_http_mottagningsfel(&svar, kropp, sizeof(kropp), &mottagning, HTTP_RAM_EJ_STODD);
+    assert(strstr(svar.huvud, "HTTP/1.1 501 Not Implemented") != NULL);
+    assert(strstr(svar.huvud, "Connection: close") != NULL);
+    assert(!svar.hall_vid_liv);
+    stang_http_mottagning(&mottagning);
+
+    // Även tillsammans med Content-Length (RFC 9112 6.3)
+    const char* med_langd = "POST / HTTP/1.1\r\nContent-Length: 4\r\n"
+                            "transfer-encoding: gzip, chunked\r\n\r\nabcd";
+    assert(initiera_http_mottagning(&mottagning));
+    assert(ta_emot(&mottagning, med_langd, strlen(med_langd)));
+    assert(hitta_http_request(&mottagning) == HTTP_RAM_EJ_STODD);
+    stang_http_mottagning(&mottagning);
+}
+
 // ============================================================================
 // HUVUDFUNKTION
 // ============================================================================
@@ -203,12 +697,25 @@ int main(void) {
     printf("║          ENHETSTESTER FÖR HTTP-SERVER               ║\n");
     printf("╚═══════════════════════════════════════════════════════╝\n\n");
 
+    // Parsa med samma SIMD-implementation som servern väljer
+    // (test_http_skanning jämför alla implementationer med varandra)
+    printf("HTTP-skanning: %s\n\n", http_skanning_namn(initiera_http_skanning()));
+    assert(initiera_http_svar());
+
     // Tester för parsa_http_request
     RUN_TEST(test_parsa_http_get_enkel);
     RUN_TEST(test_parsa_http_get_med_query);
     RUN_TEST(test_parsa_http_post);
     RUN_TEST(test_parsa_http_ogiltig);
     RUN_TEST(test_parsa_http_root);
+    RUN_TEST(test_parsa_http_keep_alive);
+
+    // Tester för parsa_http_request_vy
+    RUN_TEST(test_parsa_vy_pekar_in_i_bufferten);
+    RUN_TEST(test_parsa_vy_lang_url);
+    RUN_TEST(test_parsa_vy_utan_nollterminering);
+    RUN_TEST(test_parsa_vy_headers_och_body);
+    RUN_TEST(test_parsa_vy_ogiltig);
 
     // Tester för hamta_query_parameter
     RUN_TEST(test_hamta_query_parameter_enkel);
@@ -216,12 +723,31 @@ int main(void) {
     RUN_TEST(test_hamta_query_parameter_saknas);
     RUN_TEST(test_hamta_query_parameter_tom);
     RUN_TEST(test_hamta_query_parameter_med_mellanslag);
+    RUN_TEST(test_hamta_query_parameter_helt_namn);
+    RUN_TEST(test_hamta_query_parameter_avkodad);
 
     // Tester för skapa_http_response
     RUN_TEST(test_skapa_http_response_200);
     RUN_TEST(test_skapa_http_response_404);
     RUN_TEST(test_skapa_http_response_500);
     RUN_TEST(test_skapa_http_response_headers);
+    RUN_TEST(test_skapa_http_response_keep_alive);
+    RUN_TEST(test_http_datum);
+    RUN_TEST(test_svarsmallar);
+    RUN_TEST(test_etag_matchar);
+    RUN_TEST(test_304_och_extra_headers);
+    RUN_TEST(test_valj_komprimering);
+    RUN_TEST(test_http_svar_iovec);
+
+    // Tester för http_mottagning
+    RUN_TEST(test_mottagning_delad_request);
+    RUN_TEST(test_mottagning_post_body);
+    RUN_TEST(test_mottagning_pipelining);
+    RUN_TEST(test_mottagning_vaxer);
+    RUN_TEST(test_mottagning_for_stor);
+    RUN_TEST(test_mottagning_ogiltig_content_length);
+    RUN_TEST(test_mottagning_motstridig_langd);
+    RUN_TEST(test_mottagning_transfer_encoding);
 
     // Visa resultat
     printf("\n╔═══════════════════════════════════════════════════════╗\n");
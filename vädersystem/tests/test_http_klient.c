@@ -0,0 +1,152 @@
+// ============================================================================
+// ENHETSTESTER FÖR HTTP-KLIENTEN
+// ============================================================================
+// Testar inramning av upstream-svar (Content-Length och chunked)
+// Kompilera: gcc -I../include tests/test_http_klient.c -o test_http_klient -lpthread
+// Kör: ./test_http_klient
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <stdbool.h>
+
+#include "../src/http_klient.c"
+#include "../src/dns_cache.c"
+#include "../src/loggning.c"
+
+static int tester_totalt = 0;
+static int tester_godkanda = 0;
+
+#define RUN_TEST(test_func) do { \
+    printf("Kör %s...\n", #test_func); \
+    tester_totalt++; \
+    test_func(); \
+    tester_godkanda++; \
+    printf("  ✓ GODKÄND\n"); \
+} while(0)
+
+// ============================================================================
+// TESTER FÖR TOLKA_HTTP_SVAR
+// ============================================================================
+
+void test_content_length() {
+    const char* svar_data =
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Type: application/json\r\n"
+        "Content-Length: 13\r\n"
+        "\r\n"
+        "{\"name\":\"Ab\"}";
+    HttpKlientSvar svar;
+    size_t langd = strlen(svar_data);
+
+    assert(tolka_http_svar(svar_data, langd, &svar) == HTTP_SVAR_KOMPLETT);
+    assert(svar.statuskod == 200);
+    assert(svar.total_langd == langd);
+    assert(svar.huvud_langd == langd - 13);
+    assert(svar.kan_ateranvandas);
+    assert(!svar.chunkad);
+
+    // Bodyn saknar sista byten -> ofullständigt
+    assert(tolka_http_svar(svar_data, langd - 1, &svar) == HTTP_SVAR_OFULLSTANDIGT);
+    // Headers inte klara än
+    assert(tolka_http_svar(svar_data, 20, &svar) == HTTP_SVAR_OFULLSTANDIGT);
+}
+
+void test_chunkad() {
+    const char* svar_data =
+        "HTTP/1.1 200 OK\r\n"
+        "Transfer-Encoding: Chunked\r\n"
+        "\r\n"
+        "5\r\n{\"a\":\r\n"
+        "A;ext=1\r\n 123456789\r\n"
+        "1\r\n}\r\n"
+        "0\r\n"
+        "X-Trailer: ja\r\n"
+        "\r\n";
+    char buffer[256];
+    size_t langd = strlen(svar_data);
+    memcpy(buffer, svar_data, langd + 1);
+
+    HttpKlientSvar svar;
+    assert(tolka_http_svar(buffer, langd, &svar) == HTTP_SVAR_KOMPLETT);
+    assert(svar.chunkad);
+    assert(svar.total_langd == langd);
+
+    // Varje kortare prefix är ofullständigt - chunkgränser kan hamna var som helst
+    for (size_t i = 0; i < langd; i++) {
+        HttpKlientSvar delvis;
+        assert(tolka_http_svar(buffer, i, &delvis) == HTTP_SVAR_OFULLSTANDIGT);
+    }
+
+    size_t kropp_langd = avkoda_chunkad_kropp(buffer + svar.huvud_langd,
+                                              svar.total_langd - svar.huvud_langd);
+    assert(kropp_langd == 16);
+    assert(memcmp(buffer + svar.huvud_langd, "{\"a\": 123456789}", 16) == 0);
+}
+
+void test_stangning_och_utan_kropp() {
+    HttpKlientSvar svar;
+
+    // Connection: close - svaret är komplett men anslutningen får inte återanvändas
+    const char* stang = "HTTP/1.1 200 OK\r\nConnection: close\r\nContent-Length: 2\r\n\r\n{}";
+    assert(tolka_http_svar(stang, strlen(stang), &svar) == HTTP_SVAR_KOMPLETT);
+    assert(!svar.kan_ateranvandas);
+
+    // Utan längd slutar bodyn när servern stänger
+    const char* tills = "HTTP/1.0 200 OK\r\n\r\n{\"x\":1}";
+    assert(tolka_http_svar(tills, strlen(tills), &svar) == HTTP_SVAR_OFULLSTANDIGT);
+    assert(svar.tills_stangning);
+    assert(!svar.kan_ateranvandas);
+
+    // 204 har aldrig body
+    const char* tom = "HTTP/1.1 204 No Content\r\n\r\n";
+    assert(tolka_http_svar(tom, strlen(tom), &svar) == HTTP_SVAR_KOMPLETT);
+    assert(svar.total_langd == strlen(tom));
+    assert(svar.kan_ateranvandas);
+}
+
+void test_felaktiga_svar() {
+    HttpKlientSvar svar;
+
+    const char* ingen_http = "SSH-2.0-OpenSSH\r\n\r\n";
+    assert(tolka_http_svar(ingen_http, strlen(ingen_http), &svar) == HTTP_SVAR_FELAKTIGT);
+
+    const char* olika_langder =
+        "HTTP/1.1 200 OK\r\nContent-Length: 2\r\nContent-Length: 3\r\n\r\n{}";
+    assert(tolka_http_svar(olika_langder, strlen(olika_langder), &svar) == HTTP_SVAR_FELAKTIGT);
+
+    const char* trasig_chunk =
+        "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n2\r\n{}}\r\n0\r\n\r\n";
+    assert(tolka_http_svar(trasig_chunk, strlen(trasig_chunk), &svar) == HTTP_SVAR_FELAKTIGT);
+
+    const char* ej_hex =
+        "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\nzz\r\n";
+    assert(tolka_http_svar(ej_hex, strlen(ej_hex), &svar) == HTTP_SVAR_FELAKTIGT);
+}
+
+int main(void) {
+    printf("\n╔═══════════════════════════════════════════════════════╗\n");
+    printf("║          ENHETSTESTER FÖR HTTP-KLIENT                ║\n");
+    printf("╚═══════════════════════════════════════════════════════╝\n\n");
+
+    RUN_TEST(test_content_length);
+    RUN_TEST(test_chunkad);
+    RUN_TEST(test_stangning_och_utan_kropp);
+    RUN_TEST(test_felaktiga_svar);
+
+    // Visa resultat
+    printf("\n╔═══════════════════════════════════════════════════════╗\n");
+    printf("║                   TESTRESULTAT                       ║\n");
+    printf("╚═══════════════════════════════════════════════════════╝\n");
+    printf("  Totalt:        %d tester\n", tester_totalt);
+    printf("  Godkända:      %d tester\n", tester_godkanda);
+    printf("  Misslyckade:   %d tester\n", tester_totalt - tester_godkanda);
+
+    if (tester_godkanda == tester_totalt) {
+        printf("\n  ✓ ALLA TESTER GODKÄNDA!\n\n");
+        return 0;
+    } else {
+        printf("\n  ✗ VISSA TESTER MISSLYCKADES\n\n");
+        return 1;
+    }
+}
@@ -0,0 +1,190 @@
+// ============================================================================
+// ENHETSTESTER FÖR QUERY-TOLKNING
+// ============================================================================
+// Testar uppdelning, avkodning (%XX och '+'), uppslag i tabellen, gränser
+// och procentkodning för upstream-URL:er
+// Kompilera: gcc -I../include tests/test_http_query.c -o test_http_query
+// Kör: ./test_http_query
+
+#include "../src/http_query.c"
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <stdbool.h>
+
+static int tester_totalt = 0;
+static int tester_godkanda = 0;
+
+#define RUN_TEST(test_func) do { \
+    printf("Kör %s...\n", #test_func); \
+    tester_totalt++; \
+    test_func(); \
+    tester_godkanda++; \
+    printf("  ✓ GODKÄND\n"); \
+} while(0)
+
+// Vy över en nollterminerad sträng
+static HttpVy vy(const char* text) {
+    HttpVy v = { text, strlen(text) };
+    return v;
+}
+
+// ============================================================================
+// TESTER
+// ============================================================================
+
+void test_tolka_enkel() {
+    HttpQuery query;
+    assert(tolka_query(vy("city=Stockholm&country=SE"), &query));
+
+    assert(query.antal == 2);
+    assert(strcmp(query_varde(&query, "city"), "Stockholm") == 0);
+    assert(strcmp(query_varde(&query, "country"), "SE") == 0);
+    assert(query.parametrar[0].varde_langd == 9);
+    assert(query_varde(&query, "temp") == NULL);
+}
+
+void test_avkodning() {
+    HttpQuery query;
+    assert(tolka_query(vy("city=G%C3%B6teborg&b=G%c3%b6teborg&c=New+York&d=100%&e=%G1&f=%4"),
+                       &query));
+
+    assert(strcmp(query_varde(&query, "city"), "G\xC3\xB6teborg") == 0);  // "Göteborg"
+    assert(strcmp(query_varde(&query, "b"), "G\xC3\xB6teborg") == 0);     // Gemena hexsiffror
+    assert(strcmp(query_varde(&query, "c"), "New York") == 0);
+    // Ogiltiga %-sekvenser behålls som de är
+    assert(strcmp(query_varde(&query, "d"), "100%") == 0);
+    assert(strcmp(query_varde(&query, "e"), "%G1") == 0);
+    assert(strcmp(query_varde(&query, "f"), "%4") == 0);
+
+    // Namnen avkodas också
+    assert(tolka_query(vy("c%69ty=Lund"), &query));
+    assert(strcmp(query_varde(&query, "city"), "Lund") == 0);
+}
+
+void test_helt_namn_och_dubbletter() {
+    HttpQuery query;
+    assert(tolka_query(vy("xcity=Fel&cityx=Fel&city=Malmo&city=Andra"), &query));
+
+    assert(query.antal == 4);
+    assert(strcmp(query_varde(&query, "city"), "Malmo") == 0);  // Första gäller
+    assert(strcmp(query_varde(&query, "xcity"), "Fel") == 0);
+    assert(query_varde(&query, "cit") == NULL);
+}
+
+void test_tomma_delar() {
+    HttpQuery query;
+    assert(tolka_query(vy("&a=1&&flagga&b=&"), &query));
+
+    assert(query.antal == 3);
+    assert(strcmp(query_varde(&query, "a"), "1") == 0);
+    assert(strcmp(query_varde(&query, "flagga"), "") == 0);
+    assert(strcmp(query_varde(&query, "b"), "") == 0);
+
+    assert(tolka_query(vy(""), &query));
+    assert(query.antal == 0);
+    assert(query_varde(&query, "a") == NULL);
+
+    HttpVy ingen = { NULL, 0 };
+    assert(tolka_query(ingen, &query));
+    assert(query.antal == 0);
+}
+
+void test_granser() {
+    HttpQuery query;
+
+    // %00 skulle korta av strängen
+    assert(!tolka_query(vy("city=Sto%00ckholm"), &query));
+
+    // Exakt MAX_QUERY_PARAMETRAR går bra, en till gör det inte
+    char text[MAX_QUERY_STORLEK * 2];
+    size_t pos = 0;
+    for (int i = 0; i < MAX_QUERY_PARAMETRAR; i++) {
+        pos += (size_t)snprintf(text + pos, sizeof(text) - pos, "%sp%d=%d", i ? "&" : "", i, i);
+    }
+    assert(tolka_query(vy(text), &query));
+    assert(query.antal == MAX_QUERY_PARAMETRAR);
+    for (int i = 0; i < MAX_QUERY_PARAMETRAR; i++) {
+        char namn[16], varde[16];
+        snprintf(namn, sizeof(namn), "p%d", i);
+        snprintf(varde, sizeof(varde), "%d", i);
+        assert(strcmp(query_varde(&query, namn), varde) == 0);
+    }
+    // Tomma delar efter en full tabell räknas inte
+    snprintf(text + pos, sizeof(text) - pos, "&&");
+    assert(tolka_query(vy(text), &query));
+    assert(strcmp(query_varde(&query, "p15"), "15") == 0);
+    snprintf(text + pos, sizeof(text) - pos, "&extra=1");
+    assert(!tolka_query(vy(text), &query));
+
+    // Längsta tillåtna: parametrar utan '=' behöver mest plats
+    size_t max_langd = MAX_QUERY_STORLEK - MAX_QUERY_PARAMETRAR - 1;
+    memset(text, 'a', max_langd);
+    for (int i = 1; i < MAX_QUERY_PARAMETRAR; i++) {
+        text[i * 2 - 1] = '&';  // "a&a&...&aaaa..."
+    }
+    text[max_langd] = '\0';
+    assert(tolka_query(vy(text), &query));
+    assert(query.antal == MAX_QUERY_PARAMETRAR);
+    text[max_langd] = 'a';
+    text[max_langd + 1] = '\0';
+    assert(!tolka_query(vy(text), &query));
+}
+
+void test_kopiera_avkortar() {
+    HttpQuery query;
+    assert(tolka_query(vy("city=Stockholm"), &query));
+
+    char kort[4];
+    assert(query_kopiera(&query, "city", kort, sizeof(kort)));
+    assert(strcmp(kort, "Sto") == 0);
+    assert(!query_kopiera(&query, "country", kort, sizeof(kort)));
+}
+
+void test_koda() {
+    char kodad[64], avkodad[64];
+
+    assert(query_koda("G\xC3\xB6teborg", kodad, sizeof(kodad)));
+    assert(strcmp(kodad, "G%C3%B6teborg") == 0);
+    assert(query_koda("New York&appid=x", kodad, sizeof(kodad)));
+    assert(strcmp(kodad, "New%20York%26appid%3Dx") == 0);
+
+    // Avkodning ger tillbaka originalet
+    query_avkoda(vy(kodad), avkodad, sizeof(avkodad));
+    assert(strcmp(avkodad, "New York&appid=x") == 0);
+
+    // För liten buffer
+    assert(!query_koda("\xC3\xB6", kodad, 6));
+    assert(query_koda("\xC3\xB6", kodad, 7));
+}
+
+int main(void) {
+    printf("\n╔═══════════════════════════════════════════════════════╗\n");
+    printf("║          ENHETSTESTER FÖR QUERY-TOLKNING             ║\n");
+    printf("╚═══════════════════════════════════════════════════════╝\n\n");
+
+    RUN_TEST(test_tolka_enkel);
+    RUN_TEST(test_avkodning);
+    RUN_TEST(test_helt_namn_och_dubbletter);
+    RUN_TEST(test_tomma_delar);
+    RUN_TEST(test_granser);
+    RUN_TEST(test_kopiera_avkortar);
+    RUN_TEST(test_koda);
+
+    // Visa resultat
+    printf("\n╔═══════════════════════════════════════════════════════╗\n");
+    printf("║                   TESTRESULTAT                       ║\n");
+    printf("╚═══════════════════════════════════════════════════════╝\n");
+    printf("  Totalt:        %d tester\n", tester_totalt);
+    printf("  Godkända:      %d tester\n", tester_godkanda);
+    printf("  Misslyckade:   %d tester\n", tester_totalt - tester_godkanda);
+
+    if (tester_godkanda == tester_totalt) {
+        printf("\n  ✓ ALLA TESTER GODKÄNDA!\n\n");
+        return 0;
+    } else {
+        printf("\n  ✗ VISSA TESTER MISSLYCKADES\n\n");
+        return 1;
+    }
+}
@@ -0,0 +1,205 @@
+// ============================================================================
+// ENHETSTESTER FÖR HTTP-SKANNING (SIMD)
+// ============================================================================
+// Jämför varje implementation som processorn klarar (skalär, SSE2, AVX2)
+// med en enkel referens, tecken för tecken: slumpade rader, träffar på
+// blockgränser och data utan radslut
+// Kompilera: gcc -I../include tests/test_http_skanning.c -o test_http_skanning
+// Kör: ./test_http_skanning
+
+#include "../src/http_skanning.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <stdbool.h>
+
+static int tester_totalt = 0;
+static int tester_godkanda = 0;
+
+#define RUN_TEST(test_func) do { \
+    printf("Kör %s...\n", #test_func); \
+    tester_totalt++; \
+    test_func(); \
+    tester_godkanda++; \
+    printf("  ✓ GODKÄND\n"); \
+} while(0)
+
+static const HttpSkanningNiva ALLA_NIVAER[] = {
+    HTTP_SKANNING_SKALAR, HTTP_SKANNING_SSE2, HTTP_SKANNING_AVX2
+};
+#define ANTAL_NIVAER ((int)(sizeof(ALLA_NIVAER) / sizeof(ALLA_NIVAER[0])))
+
+// ============================================================================
+// REFERENS
+// ============================================================================
+
+static size_t referens_huvudslut(const char* data, size_t langd) {
+    for (size_t i = 0; i + 4 <= langd; i++) {
+        if (memcmp(data + i, "\r\n\r\n", 4) == 0) {
+            return i;
+        }
+    }
+    return langd;
+}
+
+static void referens_rad(const char* data, size_t langd, HttpRadSkanning* rad) {
+    size_t radslut = langd;
+    for (size_t i = 0; i < langd; i++) {
+        if (data[i] == '\n') {
+            radslut = i;
+            break;
+        }
+    }
+    rad->radslut = radslut;
+    rad->mellanslag[0] = rad->mellanslag[1] = rad->fragetecken = rad->kolon = radslut;
+    int blanksteg = 0;
+    for (size_t i = 0; i < radslut; i++) {
+        if (data[i] == ' ' && blanksteg < 2) rad->mellanslag[blanksteg++] = i;
+        if (data[i] == '?' && rad->fragetecken == radslut) rad->fragetecken = i;
+        if (data[i] == ':' && rad->kolon == radslut) rad->kolon = i;
+    }
+}
+
+/**
+ * Kör båda funktionerna med alla nivåer och jämför med referensen. Datan
+ * kopieras till en exakt stor allokering så att läsning utanför märks
+ * (med -fsanitize=address).
+ *
+ * @return Antal nivåer som testades
+ */
+static int jamfor_alla(const char* kalla, size_t langd) {
+    char* data = malloc(langd ? langd : 1);
+    memcpy(data, kalla, langd);
+
+    HttpRadSkanning forvantat;
+    referens_rad(data, langd, &forvantat);
+    size_t forvantat_slut = referens_huvudslut(data, langd);
+
+    int testade = 0;
+    for (int n = 0; n < ANTAL_NIVAER; n++) {
+        if (!satt_http_skanning(ALLA_NIVAER[n])) {
+            continue;  // Processorn saknar stöd
+        }
+        testade++;
+
+        HttpRadSkanning rad;
+        http_skanna_rad(data, langd, &rad);
+        assert(rad.radslut == forvantat.radslut);
+        assert(rad.mellanslag[0] == forvantat.mellanslag[0]);
+        assert(rad.mellanslag[1] == forvantat.mellanslag[1]);
+        assert(rad.fragetecken == forvantat.fragetecken);
+        assert(rad.kolon == forvantat.kolon);
+        assert(http_hitta_huvudslut(data, langd) == forvantat_slut);
+    }
+    free(data);
+    return testade;
+}
+
+// ============================================================================
+// TESTER
+// ============================================================================
+
+void test_vanliga_rader() {
+    const char* rader[] = {
+        "GET /weather?city=Stockholm&country=SE HTTP/1.1\r\nHost: x\r\n\r\n",
+        "Host: localhost:8080\r\n",
+        "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko)\r\n",
+        "GET / HTTP/1.0\r\n\r\n",
+        "\r\n\r\n",
+        "",
+        "utan radslut och utan kolon",
+    };
+    for (size_t i = 0; i < sizeof(rader) / sizeof(rader[0]); i++) {
+        assert(jamfor_alla(rader[i], strlen(rader[i])) >= 1);
+    }
+}
+
+void test_blockgranser() {
+    // "\r\n\r\n" och strukturtecken på varje position runt 16- och
+    // 32-bytesgränserna, i data av olika längd
+    char data[100];
+    for (size_t langd = 1; langd <= sizeof(data); langd++) {
+        for (size_t pos = 0; pos + 4 <= langd; pos++) {
+            memset(data, 'a', langd);
+            memcpy(data + pos, "\r\n\r\n", 4);
+            jamfor_alla(data, langd);
+        }
+        for (size_t pos = 0; pos < langd; pos++) {
+            memset(data, 'a', langd);
+            data[pos] = ':';
+            if (pos + 3 < langd) data[pos + 3] = ' ';
+            if (pos + 7 < langd) data[pos + 7] = '?';
+            if (pos + 9 < langd) data[pos + 9] = '\n';
+            jamfor_alla(data, langd);
+        }
+    }
+}
+
+void test_delvis_huvudslut() {
+    // Början på "\r\n\r\n" i slutet av ett block utan att resten följer
+    char data[80];
+    for (size_t pos = 0; pos < 40; pos++) {
+        memset(data, 'b', sizeof(data));
+        memcpy(data + pos, "\r\n\r", 3);
+        jamfor_alla(data, sizeof(data));
+        memcpy(data + 60, "\r\n\r\n", 4);
+        jamfor_alla(data, sizeof(data));
+    }
+}
+
+void test_slumpade_rader() {
+    // Få olika tecken så att strukturtecknen blir täta
+    const char alfabet[] = "ab \r\n?:";
+    srand(12345);
+    char data[300];
+    for (int varv = 0; varv < 20000; varv++) {
+        size_t langd = (size_t)(rand() % (int)sizeof(data));
+        for (size_t i = 0; i < langd; i++) {
+            data[i] = alfabet[rand() % (int)(sizeof(alfabet) - 1)];
+        }
+        jamfor_alla(data, langd);
+    }
+}
+
+void test_initiering_valjer_bast() {
+    HttpSkanningNiva niva = initiera_http_skanning();
+    assert(niva == http_skanning_niva());
+    // Ingen nivå över den valda ska stödas
+    for (int n = 0; n < ANTAL_NIVAER; n++) {
+        if (ALLA_NIVAER[n] > niva) {
+            assert(!satt_http_skanning(ALLA_NIVAER[n]));
+        }
+    }
+    assert(http_skanning_niva() == niva);
+    printf("  Vald implementation: %s\n", http_skanning_namn(niva));
+}
+
+int main(void) {
+    printf("\n╔═══════════════════════════════════════════════════════╗\n");
+    printf("║          ENHETSTESTER FÖR HTTP-SKANNING              ║\n");
+    printf("╚═══════════════════════════════════════════════════════╝\n\n");
+
+    RUN_TEST(test_vanliga_rader);
+    RUN_TEST(test_blockgranser);
+    RUN_TEST(test_delvis_huvudslut);
+    RUN_TEST(test_slumpade_rader);
+    RUN_TEST(test_initiering_valjer_bast);
+
+    // Visa resultat
+    printf("\n╔═══════════════════════════════════════════════════════╗\n");
+    printf("║                   TESTRESULTAT                       ║\n");
+    printf("╚═══════════════════════════════════════════════════════╝\n");
+    printf("  Totalt:        %d tester\n", tester_totalt);
+    printf("  Godkända:      %d tester\n", tester_godkanda);
+    printf("  Misslyckade:   %d tester\n", tester_totalt - tester_godkanda);
+
+    if (tester_godkanda == tester_totalt) {
+        printf("\n  ✓ ALLA TESTER GODKÄNDA!\n\n");
+        return 0;
+    } else {
+        printf("\n  ✗ VISSA TESTER MISSLYCKADES\n\n");
+        return 1;
+    }
+}
@@ -0,0 +1,356 @@
+// ============================================================================
+// ENHETSTESTER FÖR JSON-SKRIVAREN
+// ============================================================================
+// Testar att decimaltal avrundas som printf, att strängar escapas, att
+// storleken räknas exakt när utdatan inte får plats, att väder- och
+// prognosbodies blir byte för byte desamma som från snprintf-versionen och
+// kompakt format och urval av fält
+// Kompilera: gcc -I../include tests/test_json_skrivare.c -o test_json_skrivare
+// Kör: ./test_json_skrivare
+
+#include "../src/json_skrivare.c"
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <stdbool.h>
+
+static int tester_totalt = 0;
+static int tester_godkanda = 0;
+
+#define RUN_TEST(test_func) do { \
+    printf("Kör %s...\n", #test_func); \
+    tester_totalt++; \
+    test_func(); \
+    tester_godkanda++; \
+    printf("  ✓ GODKÄND\n"); \
+} while(0)
+
+// ============================================================================
+// HJÄLPFUNKTIONER
+// ============================================================================
+
+// Väderobjekt som den tidigare snprintf-versionen skrev det
+#define REFERENS_FORMAT(indrag) \
+    indrag "{\n" \
+    indrag "  \"stad\": \"%s\",\n" \
+    indrag "  \"land\": \"%s\",\n" \
+    indrag "  \"temperatur\": %.1f,\n" \
+    indrag "  \"luftfuktighet\": %.0f,\n" \
+    indrag "  \"vindhastighet\": %.1f,\n" \
+    indrag "  \"lufttryck\": %.0f,\n" \
+    indrag "  \"beskrivning\": \"%s\",\n" \
+    indrag "  \"ikon_id\": \"%s\",\n" \
+    indrag "  \"tidsstampel\": %lld\n" \
+    indrag "}"
+
+#define REFERENS_ARGUMENT(d) (d)->stad, (d)->land, (d)->temperatur, (d)->luftfuktighet, \
+    (d)->vindhastighet, (d)->lufttryck, (d)->beskrivning, (d)->ikon_id, (long long)(d)->tidsstampel
+
+static VaderData exempeldata(void) {
+    VaderData data = {0};
+    strcpy(data.stad, "Stockholm");
+    strcpy(data.land, "SE");
+    data.temperatur = 15.5f;
+    data.luftfuktighet = 65.0f;
+    data.vindhastighet = 3.25f;
+    data.lufttryck = 1013.0f;
+    strcpy(data.beskrivning, "lätt regn");
+    strcpy(data.ikon_id, "10d");
+    data.tidsstampel = 1234567890;
+    return data;
+}
+
+static size_t skriv_decimal_text(double varde, int decimaler, char* buffer, size_t storlek) {
+    JsonSkrivare skrivare;
+    json_skrivare_fast(&skrivare, buffer, storlek);
+    json_skriv_decimal(&skrivare, varde, decimaler);
+    return json_avsluta(&skrivare);
+}
+
+static void kontrollera_decimal(double varde, int decimaler) {
+    char forvantat[400], faktiskt[400];
+    snprintf(forvantat, sizeof(forvantat), "%.*f", decimaler, varde);
+    skriv_decimal_text(varde, decimaler, faktiskt, sizeof(faktiskt));
+    if (strcmp(forvantat, faktiskt) != 0) {
+        printf("  %.17g med %d decimaler: väntade %s, fick %s\n", varde, decimaler,
+               forvantat, faktiskt);
+        assert(0);
+    }
+}
+
+// ============================================================================
+// TESTER
+// ============================================================================
+
+void test_decimaler_som_printf() {
+    // Mittpunkter, värden strax under och över dem, negativa och noll
+    const double varden[] = {
+        0.0, -0.0, 0.05, 0.15, 0.25, 0.35, 0.45, 0.5, 1.5, 2.5, -2.5, -0.04,
+        -0.05, 15.5, 3.25, 9.95, 99.95, 1013.0, 1013.5, 1014.5, 0.049999999999999996,
+        123456.789, 4503599627370495.5, 1e15, 1e20, -1e30, 3.4028234663852886e38, 1e-300
+    };
+    for (size_t i = 0; i < sizeof(varden) / sizeof(varden[0]); i++) {
+        for (int d = 0; d <= 9; d++) {
+            kontrollera_decimal(varden[i], d);
+        }
+    }
+
+    // Slumpade float-värden i vädrets storleksordning (samma som i VaderData)
+    uint32_t slump = 12345;
+    for (int i = 0; i < 200000; i++) {
+        slump = slump * 1103515245u + 12345u;
+        float varde = (float)((int32_t)slump) / 65536.0f / 16.0f;
+        kontrollera_decimal(varde, i % 3);
+    }
+    // Alla tiondelar, som är vanligast från API:et
+    for (int i = -1000; i <= 1000; i++) {
+        kontrollera_decimal((float)i / 10.0f, 1);
+        kontrollera_decimal((float)i / 10.0f + 0.05f, 1);
+    }
+
+    // Ogiltiga tal blir null i stället för nan/inf
+    char text[16];
+    skriv_decimal_text(0.0 / 0.0, 1, text, sizeof(text));
+    assert(strcmp(text, "null") == 0);
+    skriv_decimal_text(-1.0 / 0.0, 1, text, sizeof(text));
+    assert(strcmp(text, "null") == 0);
+}
+
+void test_heltal() {
+    char text[32];
+    JsonSkrivare skrivare;
+    const int64_t varden[] = { 0, 7, -7, 1234567890, INT64_MAX, INT64_MIN };
+    for (size_t i = 0; i < sizeof(varden) / sizeof(varden[0]); i++) {
+        char forvantat[32];
+        snprintf(forvantat, sizeof(forvantat), "%lld", (long long)varden[i]);
+        json_skrivare_fast(&skrivare, text, sizeof(text));
+        json_skriv_heltal(&skrivare, varden[i]);
+        json_avsluta(&skrivare);
+        assert(strcmp(text, forvantat) == 0);
+    }
+}
+
+void test_escaping() {
+    char text[256];
+    JsonSkrivare skrivare;
+
+    json_skrivare_fast(&skrivare, text, sizeof(text));
+    json_skriv_strang(&skrivare, "säger \"hej\"\\ \n\t\r\b\f\x01\x1f slut");
+    json_avsluta(&skrivare);
+    assert(strcmp(text, "\"säger \\\"hej\\\"\\\\ \\n\\t\\r\\b\\f\\u0001\\u001f slut\"") == 0);
+
+    // Specialtecken på varje position i och efter ett SIMD-block
+    for (size_t pos = 0; pos < 40; pos++) {
+        char indata[41];
+        memset(indata, 'a', 40);
+        indata[40] = '\0';
+        indata[pos] = '"';
+        json_skrivare_fast(&skrivare, text, sizeof(text));
+        json_skriv_strang(&skrivare, indata);
+        size_t langd = json_avsluta(&skrivare);
+        assert(langd == 40 + 3);
+        assert(text[1 + pos] == '\\' && text[2 + pos] == '"');
+    }
+
+    // UTF-8 (bytes från 0x80) escapas inte
+    json_skrivare_fast(&skrivare, text, sizeof(text));
+    json_skriv_strang(&skrivare, "Göteborg åäö snöfall och dimma i kväll");
+    json_avsluta(&skrivare);
+    assert(strcmp(text, "\"Göteborg åäö snöfall och dimma i kväll\"") == 0);
+}
+
+void test_exakt_storlek() {
+    VaderData data = exempeldata();
+    strcpy(data.beskrivning, "\"citat\" och \\ bakstreck\n");
+    char full[1024];
+    size_t langd = skapa_vader_json(&data, NULL, full, sizeof(full));
+    assert(langd > 0);
+
+    // Varje för liten buffert ger 0 men räknar ut exakt storlek, och
+    // skriver aldrig förbi bufferten
+    for (size_t storlek = 0; storlek <= langd; storlek++) {
+        char buffer[1024 + 1];
+        memset(buffer, 'X', sizeof(buffer));
+        JsonSkrivare skrivare;
+        json_skrivare_fast(&skrivare, storlek ? buffer : NULL, storlek);
+        skriv_vader_objekt(&skrivare, &data, &STANDARDFORMAT, "", 0);
+        json_avsluta(&skrivare);
+        assert(!json_skrivare_ok(&skrivare));
+        assert(skrivare.behov == langd);
+        assert(skrivare.langd < storlek || storlek == 0);
+        assert(buffer[storlek] == 'X');
+        if (storlek > 0) {
+            assert(memcmp(buffer, full, skrivare.langd) == 0);
+        }
+        assert(skapa_vader_json(&data, NULL, buffer, storlek) == 0);
+    }
+    char buffer[1024];
+    assert(skapa_vader_json(&data, NULL, buffer, langd + 1) == langd);
+    assert(strcmp(buffer, full) == 0);
+}
+
+void test_vaxande_buffert() {
+    JsonSkrivare skrivare;
+    assert(json_skrivare_vaxande(&skrivare, 8));
+    for (int i = 0; i < 1000; i++) {
+        json_skriv_strang(&skrivare, "rad\n");
+        SKRIV_LITERAL(&skrivare, ",");
+    }
+    size_t langd = json_avsluta(&skrivare);
+    assert(json_skrivare_ok(&skrivare));
+    assert(langd == 1000 * 8);
+    assert(strlen(skrivare.data) == langd);
+    assert(memcmp(skrivare.data, "\"rad\\n\",\"rad\\n\",", 16) == 0);
+    json_skrivare_frigor(&skrivare);
+    assert(skrivare.data == NULL);
+}
+
+void test_vader_som_tidigare() {
+    VaderData data = exempeldata();
+    char forvantat[1024], faktiskt[1024];
+    int forvantad_langd = snprintf(forvantat, sizeof(forvantat), REFERENS_FORMAT(""),
+                                   REFERENS_ARGUMENT(&data));
+    size_t langd = skapa_vader_json(&data, NULL, faktiskt, sizeof(faktiskt));
+    assert(langd == (size_t)forvantad_langd);
+    assert(strcmp(faktiskt, forvantat) == 0);
+
+    // Citattecken i beskrivningen gav tidigare ogiltig JSON
+    strcpy(data.beskrivning, "\"moln\"");
+    skapa_vader_json(&data, NULL, faktiskt, sizeof(faktiskt));
+    assert(strstr(faktiskt, "\"beskrivning\": \"\\\"moln\\\"\",\n") != NULL);
+}
+
+void test_prognos_som_tidigare() {
+    VaderPrognos prognos = {0};
+    prognos.antal_dagar = 3;
+    for (int i = 0; i < 3; i++) {
+        prognos.dagar[i] = exempeldata();
+        prognos.dagar[i].temperatur = -2.25f + (float)i * 4.5f;
+        prognos.dagar[i].tidsstampel += i * 86400;
+    }
+
+    char forvantat[4096], faktiskt[4096];
+    int pos = snprintf(forvantat, sizeof(forvantat),
+                       "{\n  \"antal_dagar\": %d,\n  \"dagar\": [\n", prognos.antal_dagar);
+    for (int i = 0; i < 3; i++) {
+        pos += snprintf(forvantat + pos, sizeof(forvantat) - (size_t)pos,
+                        REFERENS_FORMAT("    ") "%s\n", REFERENS_ARGUMENT(&prognos.dagar[i]),
+                        i < 2 ? "," : "");
+    }
+    pos += snprintf(forvantat + pos, sizeof(forvantat) - (size_t)pos, "  ]\n}");
+
+    size_t langd = skapa_prognos_json(&prognos, NULL, faktiskt, sizeof(faktiskt));
+    assert(langd == (size_t)pos);
+    assert(strcmp(faktiskt, forvantat) == 0);
+
+    // Tom prognos, och ett antal från en trasig cachefil
+    prognos.antal_dagar = 0;
+    skapa_prognos_json(&prognos, NULL, faktiskt, sizeof(faktiskt));
+    assert(strcmp(faktiskt, "{\n  \"antal_dagar\": 0,\n  \"dagar\": [\n  ]\n}") == 0);
+    prognos.antal_dagar = 1000;
+    assert(skapa_prognos_json(&prognos, NULL, faktiskt, sizeof(faktiskt)) > 0);
+    assert(strstr(faktiskt, "\"antal_dagar\": 5,") != NULL);
+}
+
+void test_tolka_falt() {
+    uint32_t falt = 0;
+    assert(json_tolka_falt("temperatur,lufttryck", &falt));
+    assert(falt == (JSON_FALT_TEMPERATUR | JSON_FALT_LUFTTRYCK));
+    assert(json_tolka_falt("tidsstampel,stad,", &falt));
+    assert(falt == (JSON_FALT_STAD | JSON_FALT_TIDSSTAMPEL));
+    assert(json_tolka_falt("stad,land,temperatur,luftfuktighet,vindhastighet,lufttryck,"
+                           "beskrivning,ikon_id,tidsstampel", &falt));
+    assert(falt == JSON_ALLA_FALT);
+
+    // Okända namn, prefix och tomma listor nekas
+    assert(!json_tolka_falt("temperatur,regn", &falt));
+    assert(!json_tolka_falt("temp", &falt));
+    assert(!json_tolka_falt("temperaturer", &falt));
+    assert(!json_tolka_falt("", &falt));
+    assert(!json_tolka_falt(",,", &falt));
+
+    JsonFormat format = { false, JSON_ALLA_FALT };
+    assert(json_format_ar_standard(&format));
+    format.kompakt = true;
+    assert(!json_format_ar_standard(&format));
+    format.kompakt = false;
+    format.falt = JSON_FALT_STAD;
+    assert(!json_format_ar_standard(&format));
+}
+
+void test_kompakt_och_urval() {
+    VaderData data = exempeldata();
+    char json[1024];
+    JsonFormat format = { true, JSON_ALLA_FALT };
+
+    size_t langd = skapa_vader_json(&data, &format, json, sizeof(json));
+    const char* forvantat =
+        "{\"stad\":\"Stockholm\",\"land\":\"SE\",\"temperatur\":15.5,\"luftfuktighet\":65,"
+        "\"vindhastighet\":3.2,\"lufttryck\":1013,\"beskrivning\":\"lätt regn\","
+        "\"ikon_id\":\"10d\",\"tidsstampel\":1234567890}";
+    assert(strcmp(json, forvantat) == 0);
+    assert(langd == strlen(forvantat));
+
+    // Urval: fälten skrivs i standardordning oavsett ordning i listan
+    assert(json_tolka_falt("lufttryck,temperatur", &format.falt));
+    skapa_vader_json(&data, &format, json, sizeof(json));
+    assert(strcmp(json, "{\"temperatur\":15.5,\"lufttryck\":1013}") == 0);
+
+    format.kompakt = false;
+    skapa_vader_json(&data, &format, json, sizeof(json));
+    assert(strcmp(json, "{\n  \"temperatur\": 15.5,\n  \"lufttryck\": 1013\n}") == 0);
+
+    // Prognos: urvalet gäller varje dag
+    VaderPrognos prognos = {0};
+    prognos.antal_dagar = 2;
+    prognos.dagar[0] = data;
+    prognos.dagar[1] = data;
+    prognos.dagar[1].temperatur = -3.0f;
+    format.kompakt = true;
+    format.falt = JSON_FALT_TEMPERATUR;
+    skapa_prognos_json(&prognos, &format, json, sizeof(json));
+    assert(strcmp(json, "{\"antal_dagar\":2,\"dagar\":[{\"temperatur\":15.5},"
+                        "{\"temperatur\":-3.0}]}") == 0);
+    format.kompakt = false;
+    skapa_prognos_json(&prognos, &format, json, sizeof(json));
+    assert(strcmp(json, "{\n  \"antal_dagar\": 2,\n  \"dagar\": [\n"
+                        "    {\n      \"temperatur\": 15.5\n    },\n"
+                        "    {\n      \"temperatur\": -3.0\n    }\n  ]\n}") == 0);
+    prognos.antal_dagar = 0;
+    format.kompakt = true;
+    skapa_prognos_json(&prognos, &format, json, sizeof(json));
+    assert(strcmp(json, "{\"antal_dagar\":0,\"dagar\":[]}") == 0);
+}
+
+int main(void) {
+    printf("\n╔═══════════════════════════════════════════════════════╗\n");
+    printf("║          ENHETSTESTER FÖR JSON-SKRIVAREN             ║\n");
+    printf("╚═══════════════════════════════════════════════════════╝\n\n");
+
+    RUN_TEST(test_decimaler_som_printf);
+    RUN_TEST(test_heltal);
+    RUN_TEST(test_escaping);
+    RUN_TEST(test_exakt_storlek);
+    RUN_TEST(test_vaxande_buffert);
+    RUN_TEST(test_vader_som_tidigare);
+    RUN_TEST(test_prognos_som_tidigare);
+    RUN_TEST(test_tolka_falt);
+    RUN_TEST(test_kompakt_och_urval);
+
+    // Visa resultat
+    printf("\n╔═══════════════════════════════════════════════════════╗\n");
+    printf("║                   TESTRESULTAT                       ║\n");
+    printf("╚═══════════════════════════════════════════════════════╝\n");
+    printf("  Totalt:        %d tester\n", tester_totalt);
+    printf("  Godkända:      %d tester\n", tester_godkanda);
+    printf("  Misslyckade:   %d tester\n", tester_totalt - tester_godkanda);
+
+    if (tester_godkanda == tester_totalt) {
+        printf("\n  ✓ ALLA TESTER GODKÄNDA!\n\n");
+        return 0;
+    } else {
+        printf("\n  ✗ VISSA TESTER MISSLYCKADES\n\n");
+        return 1;
+    }
+}
@@ -0,0 +1,235 @@
+// ============================================================================
+// ENHETSTESTER FÖR KLIENTGRÄNSEN
+// ============================================================================
+// Testar token bucket per klient-IP: skur, påfyllning, separata adresser,
+// Unix-klienter utan gräns, full tabell, att en adress hittar sin egen
+// plats innan den tar över en annans och samtidiga uttag från flera trådar
+// Kompilera: gcc -I../include tests/test_klientgrans.c -o test_klientgrans -lpthread
+// Kör: ./test_klientgrans
+
+#include "../src/klientgrans.c"
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+static int tester_totalt = 0;
+static int tester_godkanda = 0;
+
+#define RUN_TEST(test_func) do { \
+    printf("Kör %s...\n", #test_func); \
+    tester_totalt++; \
+    test_func(); \
+    tester_godkanda++; \
+    printf("  ✓ GODKÄND\n"); \
+} while(0)
+
+#define ANTAL_TRADAR 8
+
+/**
+ * Sover ett antal millisekunder
+ *
+ * @param millisekunder - Hur länge
+ */
+static void sov_ms(long millisekunder) {
+    struct timespec vila = {millisekunder / 1000, (millisekunder % 1000) * 1000000};
+    nanosleep(&vila, NULL);
+}
+
+/**
+ * Räknar hur många av antal requests som släpps igenom
+ *
+ * @param ip - Klientens adress
+ * @param antal - Antal försök
+ * @return Antal tillåtna
+ */
+static int rakna_tillatna(uint32_t ip, int antal) {
+    int tillatna = 0;
+    for (int i = 0; i < antal; i++) {
+        if (klientgrans_tillat(ip)) {
+            tillatna++;
+        }
+    }
+    return tillatna;
+}
+
+// ============================================================================
+// TESTER
+// ============================================================================
+
+void test_skur_och_pafyllning() {
+    konfigurera_klientgrans(100, 10);
+
+    // Hela skuren direkt, sedan stopp
+    assert(rakna_tillatna(0x0100007f, 15) == 10);
+    assert(!klientgrans_tillat(0x0100007f));
+
+    // 100 per sekund = ett token per 10 ms
+    sov_ms(55);
+    int tillatna = rakna_tillatna(0x0100007f, 20);
+    assert(tillatna >= 4 && tillatna <= 7);
+
+    // Aldrig mer än skuren, hur länge klienten än varit tyst
+    sov_ms(300);
+    assert(rakna_tillatna(0x0100007f, 50) == 10);
+}
+
+void test_adresser_ar_separata() {
+    konfigurera_klientgrans(1, 3);
+
+    assert(rakna_tillatna(0x0a000001, 5) == 3);
+    assert(rakna_tillatna(0x0a000002, 5) == 3);  // Egen hink
+    assert(!klientgrans_tillat(0x0a000001));
+
+    KlientGransStatistik statistik[4];
+    int antal = hamta_klientgrans_statistik(statistik, 4);
+    assert(antal == 2);
+    // Flest requests först: 0x0a000001 har gjort sex
+    assert(statistik[0].ip == 0x0a000001);
+    assert(statistik[0].tillatna == 3 && statistik[0].begransade == 3);
+    assert(statistik[1].ip == 0x0a000002);
+    assert(statistik[1].tillatna == 3 && statistik[1].begransade == 2);
+}
+
+void test_avstangd() {
+    konfigurera_klientgrans(0, 1);
+    assert(rakna_tillatna(0x0100007f, 1000) == 1000);
+
+    KlientGransStatistik statistik[1];
+    assert(hamta_klientgrans_statistik(statistik, 1) == 0);  // Inget sparas
+}
+
+void test_unix_klienter() {
+    // Klienter via Unix-socketen har ip 0 och begränsas inte - och tar
+    // inga tokens från 127.0.0.1
+    konfigurera_klientgrans(1, 3);
+    assert(rakna_tillatna(0, 400) == 400);
+    assert(rakna_tillatna(0x0100007f, 5) == 3);
+
+    KlientGransStatistik statistik[2];
+    assert(hamta_klientgrans_statistik(statistik, 2) == 1);
+    assert(statistik[0].ip == 0x0100007f);
+}
+
+void test_full_tabell() {
+    // Långsam påfyllning - ingen hink hinner bli full och kan tas över
+    konfigurera_klientgrans(1, 2);
+    int totalt = KLIENTGRANS_SKARVOR * KLIENTGRANS_PLATSER;
+    for (int i = 0; i < 2 * totalt; i++) {
+        klientgrans_tillat((uint32_t)i + 1);
+        klientgrans_tillat((uint32_t)i + 1);
+    }
+    // Adresser utan plats släpps igenom och räknas
+    assert(klientgrans_utan_plats() > 0);
+
+    // Med snabb påfyllning (ett token per ms) är alla hinkar fulla igen
+    // efter en kort paus, och nya adresser tar över platserna. Bara ett
+    // fåtal nya adresser - en plats som just tagits över är tom resten av
+    // millisekunden och kan inte tas igen.
+    konfigurera_klientgrans(1000, 1);
+    for (int i = 0; i < totalt; i++) {
+        klientgrans_tillat((uint32_t)i + 1);
+    }
+    sov_ms(5);
+    unsigned long long fore = klientgrans_utan_plats();
+    for (int i = 0; i < 64; i++) {
+        assert(klientgrans_tillat((uint32_t)(totalt + i) + 1));
+    }
+    assert(klientgrans_utan_plats() == fore);
+}
+
+void test_egen_plats_fore_overtagande() {
+    // Två adresser med samma startplats: den första får startplatsen och
+    // den andra platsen efter
+    uint32_t forsta = 0;
+    uint32_t andra = 0;
+    for (uint32_t a = 1; !andra; a++) {
+        size_t start_a;
+        KlientPlats* skarva_a = hitta_skarva((uint64_t)a | ((uint64_t)1 << 32), &start_a);
+        for (uint32_t b = 1; b < a; b++) {
+            size_t start_b;
+            KlientPlats* skarva_b = hitta_skarva((uint64_t)b | ((uint64_t)1 << 32), &start_b);
+            if (skarva_a == skarva_b &&
+                start_a % KLIENTGRANS_PLATSER == start_b % KLIENTGRANS_PLATSER) {
+                forsta = b;
+                andra = a;
+                break;
+            }
+        }
+    }
+
+    // Ett token per ms och skur 1000: den första adressens hink är full
+    // igen efter några ms, den andras tar en sekund att fylla
+    konfigurera_klientgrans(1000, 1000);
+    assert(klientgrans_tillat(forsta));
+    assert(rakna_tillatna(andra, 1000) == 1000);
+    sov_ms(5);
+
+    // Den andra adressen ska hitta sin egen tomma hink, inte ta över den
+    // första adressens fulla plats och få en ny skur
+    assert(rakna_tillatna(andra, 100) < 50);
+}
+
+// Antal tillåtna requests per tråd i test_samtidiga_uttag
+static int tillatna_per_trad[ANTAL_TRADAR];
+
+static void* ta_tokens(void* argument) {
+    int index = (int)(intptr_t)argument;
+    tillatna_per_trad[index] = rakna_tillatna(0xc0a80001, 10000);
+    return NULL;
+}
+
+void test_samtidiga_uttag() {
+    // En token per sekund, skur 5000 - trådarna ska tillsammans få exakt
+    // skuren (plus högst någon påfyllning under testet)
+    konfigurera_klientgrans(1, 5000);
+    uint64_t start = monoton_ms();
+    pthread_t tradar[ANTAL_TRADAR];
+    for (int i = 0; i < ANTAL_TRADAR; i++) {
+        pthread_create(&tradar[i], NULL, ta_tokens, (void*)(intptr_t)i);
+    }
+    int summa = 0;
+    for (int i = 0; i < ANTAL_TRADAR; i++) {
+        pthread_join(tradar[i], NULL);
+        summa += tillatna_per_trad[i];
+    }
+    int pafyllt = (int)((monoton_ms() - start) / 1000) + 1;
+    assert(summa >= 5000 && summa <= 5000 + pafyllt);
+
+    KlientGransStatistik statistik[1];
+    assert(hamta_klientgrans_statistik(statistik, 1) == 1);
+    assert(statistik[0].tillatna == (unsigned long long)summa);
+    assert(statistik[0].tillatna + statistik[0].begransade == ANTAL_TRADAR * 10000ull);
+}
+
+int main(void) {
+    printf("\n╔═══════════════════════════════════════════════════════╗\n");
+    printf("║          ENHETSTESTER FÖR KLIENTGRÄNS                ║\n");
+    printf("╚═══════════════════════════════════════════════════════╝\n\n");
+
+    RUN_TEST(test_skur_och_pafyllning);
+    RUN_TEST(test_adresser_ar_separata);
+    RUN_TEST(test_avstangd);
+    RUN_TEST(test_unix_klienter);
+    RUN_TEST(test_full_tabell);
+    RUN_TEST(test_egen_plats_fore_overtagande);
+    RUN_TEST(test_samtidiga_uttag);
+
+    // Visa resultat
+    printf("\n╔═══════════════════════════════════════════════════════╗\n");
+    printf("║                   TESTRESULTAT                       ║\n");
+    printf("╚═══════════════════════════════════════════════════════╝\n");
+    printf("  Totalt:        %d tester\n", tester_totalt);
+    printf("  Godkända:      %d tester\n", tester_godkanda);
+    printf("  Misslyckade:   %d tester\n", tester_totalt - tester_godkanda);
+
+    if (tester_godkanda == tester_totalt) {
+        printf("\n  ✓ ALLA TESTER GODKÄNDA!\n\n");
+        return 0;
+    } else {
+        printf("\n  ✗ VISSA TESTER MISSLYCKADES\n\n");
+        return 1;
+    }
+}
@@ -0,0 +1,219 @@
+// ============================================================================
+// ENHETSTESTER FÖR KOMPRIMERING
+// ============================================================================
+// Testar kontrollsummorna, att deflate-strömmen packas upp till originalet
+// (med en liten referensavkodare för fasta Huffman-koder) och gzip- och
+// zlib-förpackningen
+// Kompilera: gcc -I../include tests/test_komprimering.c -o test_komprimering
+// Kör: ./test_komprimering
+
+#include "../src/komprimering.c"
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <stdbool.h>
+
+static int tester_totalt = 0;
+static int tester_godkanda = 0;
+
+#define RUN_TEST(test_func) do { \
+    printf("Kör %s...\n", #test_func); \
+    tester_totalt++; \
+    test_func(); \
+    tester_godkanda++; \
+    printf("  ✓ GODKÄND\n"); \
+} while(0)
+
+// ============================================================================
+// REFERENSAVKODARE (bara block med fasta koder, som kodaren skriver)
+// ============================================================================
+
+typedef struct {
+    const uint8_t* data;
+    size_t langd;
+    size_t bit;
+} BitLasare;
+
+static uint32_t las_bitar(BitLasare* l, int antal) {
+    uint32_t v = 0;
+    for (int i = 0; i < antal; i++, l->bit++) {
+        assert(l->bit / 8 < l->langd);
+        v |= (uint32_t)((l->data[l->bit / 8] >> (l->bit % 8)) & 1) << i;
+    }
+    return v;
+}
+
+// Huffman-koder läses med mest signifikanta biten först
+static uint32_t las_kod(BitLasare* l, int antal, uint32_t kod) {
+    for (int i = 0; i < antal; i++) {
+        kod = (kod << 1) | las_bitar(l, 1);
+    }
+    return kod;
+}
+
+static int las_symbol(BitLasare* l) {
+    uint32_t kod = las_kod(l, 7, 0);
+    if (kod <= 23) return 256 + (int)kod;
+    kod = las_kod(l, 1, kod);
+    if (kod >= 0x30 && kod <= 0xBF) return (int)(kod - 0x30);
+    if (kod >= 0xC0 && kod <= 0xC7) return 280 + (int)(kod - 0xC0);
+    kod = las_kod(l, 1, kod);
+    assert(kod >= 0x190 && kod <= 0x1FF);
+    return 144 + (int)(kod - 0x190);
+}
+
+static size_t packa_upp(const uint8_t* strom, size_t langd, uint8_t* ut, size_t ut_storlek) {
+    BitLasare l = { strom, langd, 0 };
+    assert(las_bitar(&l, 1) == 1);   // BFINAL
+    assert(las_bitar(&l, 2) == 1);   // Fasta koder
+    size_t n = 0;
+    for (;;) {
+        int symbol = las_symbol(&l);
+        if (symbol < 256) {
+            assert(n < ut_storlek);
+            ut[n++] = (uint8_t)symbol;
+        } else if (symbol == 256) {
+            break;
+        } else {
+            int kod = symbol - 257;
+            size_t matchning = LANGD_BAS[kod] + las_bitar(&l, LANGD_EXTRA[kod]);
+            int avstand_kod = (int)las_kod(&l, 5, 0);
+            size_t avstand = AVSTAND_BAS[avstand_kod] + las_bitar(&l, AVSTAND_EXTRA[avstand_kod]);
+            assert(avstand <= n && n + matchning <= ut_storlek);
+            for (size_t i = 0; i < matchning; i++, n++) {
+                ut[n] = ut[n - avstand];
+            }
+        }
+    }
+    assert((l.bit + 7) / 8 == langd);  // Inga bytes efter blockets slut
+    return n;
+}
+
+// Komprimerar och packar upp, och kontrollerar att originalet kommer tillbaka
+static size_t rundtur(const uint8_t* data, size_t langd) {
+    static uint8_t strom[DEFLATE_MAX_STORLEK(70000)];
+    static uint8_t tillbaka[70000];
+    size_t strom_langd = deflate_komprimera(data, langd, strom, DEFLATE_MAX_STORLEK(langd));
+    assert(strom_langd > 0 && strom_langd <= DEFLATE_MAX_STORLEK(langd));
+    assert(packa_upp(strom, strom_langd, tillbaka, sizeof(tillbaka)) == langd);
+    assert(memcmp(tillbaka, data, langd) == 0);
+    return strom_langd;
+}
+
+// ============================================================================
+// TESTER
+// ============================================================================
+
+void test_kontrollsummor() {
+    assert(berakna_crc32(0, "123456789", 9) == 0xCBF43926u);
+    assert(berakna_crc32(0, "", 0) == 0);
+    assert(berakna_adler32(1, "Wikipedia", 9) == 0x11E60398u);
+    assert(berakna_adler32(1, "", 0) == 1);
+
+    // I delar ger samma resultat
+    assert(berakna_crc32(berakna_crc32(0, "12345", 5), "6789", 4) == 0xCBF43926u);
+}
+
+void test_rundtur() {
+    static uint8_t data[65536];
+
+    rundtur((const uint8_t*)"", 0);
+    rundtur((const uint8_t*)"x", 1);
+
+    // Upprepningar: avstånd 1 och matchningar längre än 258
+    memset(data, 'a', 1000);
+    assert(rundtur(data, 1000) < 20);
+
+    // JSON som i ett svar
+    const char* json = "{\n  \"stad\": \"Stockholm\",\n  \"land\": \"SE\",\n"
+                       "  \"temperatur\": 12.5,\n  \"beskrivning\": \"mulet\",\n"
+                       "  \"stad\": \"Stockholm\",\n  \"land\": \"SE\"\n}";
+    assert(rundtur((const uint8_t*)json, strlen(json)) < strlen(json));
+
+    // Slumpdata (går inte att komprimera) och avstånd över hela fönstret
+    uint32_t x = 12345;
+    for (size_t i = 0; i < sizeof(data); i++) {
+        x = x * 1103515245u + 12345u;
+        data[i] = (uint8_t)(x >> 16);
+    }
+    rundtur(data, sizeof(data));
+    memcpy(data + 40000, data, 300);   // Samma 300 bytes 40000 bytes bort (utanför fönstret)
+    memcpy(data + 60000, data + 30000, 300);
+    rundtur(data, sizeof(data));
+
+    // För liten buffer
+    uint8_t liten[4];
+    assert(deflate_komprimera(data, 100, liten, sizeof(liten)) == 0);
+}
+
+void test_packa() {
+    const char* json = "{\"a\": \"aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa\"}";
+    size_t langd = strlen(json);
+    uint8_t buffer[256];
+    KomprimeradPost post;
+    assert(komprimera_post(json, langd, 42, &post, buffer + KOMPRIMERING_HUVUD_RESERV,
+                           sizeof(buffer) - KOMPRIMERING_HUVUD_RESERV - KOMPRIMERING_SVANS_RESERV));
+    assert(post.tidsstampel == 42 && post.langd == langd);
+
+    uint8_t strom[128];
+    memcpy(strom, buffer + KOMPRIMERING_HUVUD_RESERV, post.deflate_langd);
+
+    // gzip: huvud, strömmen, CRC-32 och längd little-endian
+    size_t gzip_langd;
+    const uint8_t* gzip = komprimering_packa(KOMPRIMERING_GZIP, &post, buffer, &gzip_langd);
+    assert(gzip == buffer && gzip_langd == 10 + post.deflate_langd + 8);
+    assert(gzip[0] == 0x1F && gzip[1] == 0x8B && gzip[2] == 8);
+    assert(memcmp(gzip + 10, strom, post.deflate_langd) == 0);
+    const uint8_t* svans = gzip + 10 + post.deflate_langd;
+    assert((uint32_t)(svans[0] | svans[1] << 8 | svans[2] << 16 | (uint32_t)svans[3] << 24) ==
+           berakna_crc32(0, json, langd));
+    assert(svans[4] == langd && svans[5] == 0);
+
+    // zlib: två bytes huvud direkt före strömmen, Adler-32 big-endian
+    size_t zlib_langd;
+    const uint8_t* zlib = komprimering_packa(KOMPRIMERING_DEFLATE, &post, buffer, &zlib_langd);
+    assert(zlib == buffer + KOMPRIMERING_HUVUD_RESERV - 2 && zlib_langd == 2 + post.deflate_langd + 4);
+    assert(((zlib[0] << 8) | zlib[1]) % 31 == 0 && (zlib[0] & 0x0F) == 8);
+    assert(memcmp(zlib + 2, strom, post.deflate_langd) == 0);
+    svans = zlib + 2 + post.deflate_langd;
+    assert((uint32_t)((uint32_t)svans[0] << 24 | svans[1] << 16 | svans[2] << 8 | svans[3]) ==
+           berakna_adler32(1, json, langd));
+
+    assert(strcmp(komprimering_namn(KOMPRIMERING_GZIP), "gzip") == 0);
+    assert(strcmp(komprimering_namn(KOMPRIMERING_DEFLATE), "deflate") == 0);
+}
+
+void test_sparar_inte_plats() {
+    // En kort body blir inte mindre med huvud och svans - skickas som den är
+    uint8_t ut[64];
+    KomprimeradPost post;
+    assert(!komprimera_post("{\"a\": 1}", 8, 1, &post, ut, sizeof(ut)));
+}
+
+int main(void) {
+    printf("\n╔═══════════════════════════════════════════════════════╗\n");
+    printf("║           ENHETSTESTER FÖR KOMPRIMERING              ║\n");
+    printf("╚═══════════════════════════════════════════════════════╝\n\n");
+
+    RUN_TEST(test_kontrollsummor);
+    RUN_TEST(test_rundtur);
+    RUN_TEST(test_packa);
+    RUN_TEST(test_sparar_inte_plats);
+
+    // Visa resultat
+    printf("\n╔═══════════════════════════════════════════════════════╗\n");
+    printf("║                   TESTRESULTAT                       ║\n");
+    printf("╚═══════════════════════════════════════════════════════╝\n");
+    printf("  Totalt:        %d tester\n", tester_totalt);
+    printf("  Godkända:      %d tester\n", tester_godkanda);
+    printf("  Misslyckade:   %d tester\n", tester_totalt - tester_godkanda);
+
+    if (tester_godkanda == tester_totalt) {
+        printf("\n  ✓ ALLA TESTER GODKÄNDA!\n\n");
+        return 0;
+    } else {
+        printf("\n  ✗ VISSA TESTER MISSLYCKADES\n\n");
+        return 1;
+    }
+}
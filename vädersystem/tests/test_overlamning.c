@@ -0,0 +1,229 @@
+// ============================================================================
+// ENHETSTESTER FÖR ÖVERLÄMNING AV LYSSNANDE SOCKETS
+// ============================================================================
+// Testar omstart utan avbrott inom en process: överlämning via Unix-socket,
+// att socketen lever vidare när "gamla processen" stänger sin kopia, fel
+// port, nekad överlämning under avstängning och att en lokal Unix-socket
+// följer med
+// Kompilera: gcc -I../include tests/test_overlamning.c -o test_overlamning -lpthread
+// Kör: ./test_overlamning
+
+#include "../src/overlamning.c"
+#include "../src/tcp_server.c"
+#include "../src/loggning.c"
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <time.h>
+
+static int tester_totalt = 0;
+static int tester_godkanda = 0;
+
+#define RUN_TEST(test_func) do { \
+    printf("Kör %s...\n", #test_func); \
+    tester_totalt++; \
+    test_func(); \
+    tester_godkanda++; \
+    printf("  ✓ GODKÄND\n"); \
+} while(0)
+
+#define SOKVAG "/tmp/test_overlamning.sock"
+#define LOKAL_SOKVAG "/tmp/test_overlamning_lokal.sock"
+
+// Sätts av SIGTERM, som överlämningstråden skickar till huvudtråden
+static volatile bool kors = true;
+
+static void signal_hanterare(int signal) {
+    (void)signal;
+    kors = false;
+}
+
+/**
+ * Väntar högst en sekund på att SIGTERM ska ha kommit
+ *
+ * @return true om kors har blivit false
+ */
+static bool vanta_pa_stopp(void) {
+    struct timespec vila = {0, 10 * 1000000};
+    for (int i = 0; i < 100 && kors; i++) {
+        nanosleep(&vila, NULL);
+    }
+    return !kors;
+}
+
+/**
+ * Startar en server på en ledig port
+ *
+ * @param server - Servern som startas
+ * @return Porten som kärnan valde
+ */
+static int starta_pa_ledig_port(TcpServer* server) {
+    assert(initiera_tcp_server(server, 0) == 0);
+    struct sockaddr_in adress;
+    socklen_t langd = sizeof(adress);
+    assert(getsockname(server->lyssnar_socket, (struct sockaddr*)&adress, &langd) == 0);
+    return ntohs(adress.sin_port);
+}
+
+/**
+ * Ansluter till porten och kontrollerar att servern kan acceptera
+ *
+ * @param server - Servern som ska ta emot anslutningen
+ * @param port - Porten
+ */
+static void ansluter_till(TcpServer* server, int port) {
+    int klient = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in adress;
+    memset(&adress, 0, sizeof(adress));
+    adress.sin_family = AF_INET;
+    adress.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    adress.sin_port = htons((uint16_t)port);
+    assert(connect(klient, (struct sockaddr*)&adress, sizeof(adress)) == 0);
+
+    uint32_t klient_ip = 0;
+    socket_t accepterad = acceptera_klient(server, &klient_ip);
+    assert(accepterad != OGILTIG_SOCKET);
+    assert(klient_ip == htonl(INADDR_LOOPBACK));
+    close(accepterad);
+    close(klient);
+}
+
+// ============================================================================
+// TESTER
+// ============================================================================
+
+void test_ingen_gammal_process() {
+    unlink(SOKVAG);
+    TcpServer servrar[2];
+    assert(ta_over_lyssnare(SOKVAG, 8080, servrar, 2) == 0);
+}
+
+void test_overlamning() {
+    TcpServer gammal;
+    int port = starta_pa_ledig_port(&gammal);
+    kors = true;
+    assert(starta_overlamning(SOKVAG, &gammal, 1, &kors));
+
+    TcpServer ny[2];
+    assert(ta_over_lyssnare(SOKVAG, port, ny, 2) == 1);
+    assert(ny[0].port == port);
+    assert(ny[0].lyssnar_socket != gammal.lyssnar_socket);
+    assert(vanta_pa_stopp());  // Gamla "processen" ska dränera
+
+    // Gamla processen stänger sin kopia - socketen lever vidare i den nya
+    stang_overlamning();
+    stang_tcp_server(&gammal);
+    ansluter_till(&ny[0], port);
+
+    // Sökvägen tillhör nu den nya processen och får inte tas bort
+    assert(access(SOKVAG, F_OK) == 0);
+    unlink(SOKVAG);
+    stang_tcp_server(&ny[0]);
+}
+
+void test_fel_port() {
+    TcpServer gammal;
+    int port = starta_pa_ledig_port(&gammal);
+    kors = true;
+    assert(starta_overlamning(SOKVAG, &gammal, 1, &kors));
+
+    // Ny process som vill ha en annan port tar inte över något
+    TcpServer ny[1];
+    assert(ta_over_lyssnare(SOKVAG, port + 1, ny, 1) == 0);
+    assert(kors);  // Ingen SIGTERM
+    ansluter_till(&gammal, port);
+
+    // Utan överlämning städar processen bort sin sökväg
+    stang_overlamning();
+    assert(access(SOKVAG, F_OK) != 0);
+    stang_tcp_server(&gammal);
+}
+
+void test_nekad_under_avstangning() {
+    TcpServer gammal;
+    int port = starta_pa_ledig_port(&gammal);
+    kors = false;  // Dräneringen har redan börjat
+    assert(starta_overlamning(SOKVAG, &gammal, 1, &kors));
+
+    TcpServer ny[1];
+    assert(ta_over_lyssnare(SOKVAG, port, ny, 1) == 0);
+
+    stang_overlamning();
+    stang_tcp_server(&gammal);
+}
+
+void test_unix_socket_foljer_med() {
+    TcpServer gammal[2];
+    int port = starta_pa_ledig_port(&gammal[0]);
+    assert(initiera_unix_server(&gammal[1], LOKAL_SOKVAG) == 0);
+    assert(gammal[1].familj == AF_UNIX);
+    kors = true;
+    assert(starta_overlamning(SOKVAG, gammal, 2, &kors));
+
+    // Unix-socketen kontrolleras inte mot porten
+    TcpServer ny[2];
+    assert(ta_over_lyssnare(SOKVAG, port, ny, 2) == 2);
+    assert(vanta_pa_stopp());
+    assert(ny[0].familj == AF_INET && ny[0].port == port);
+    assert(ny[1].familj == AF_UNIX);
+    assert(strcmp(ny[1].sokvag, LOKAL_SOKVAG) == 0);
+
+    // Gamla processen stänger - filen och socketen finns kvar
+    stang_overlamning();
+    stang_tcp_server(&gammal[0]);
+    stang_tcp_server(&gammal[1]);
+    assert(access(LOKAL_SOKVAG, F_OK) == 0);
+
+    int klient = socket(AF_UNIX, SOCK_STREAM, 0);
+    struct sockaddr_un adress;
+    memset(&adress, 0, sizeof(adress));
+    adress.sun_family = AF_UNIX;
+    strcpy(adress.sun_path, LOKAL_SOKVAG);
+    assert(connect(klient, (struct sockaddr*)&adress, sizeof(adress)) == 0);
+
+    // Lokala klienter har ingen adress (0, som klientgränsen inte begränsar)
+    uint32_t klient_ip = htonl(INADDR_LOOPBACK);
+    socket_t accepterad = acceptera_klient(&ny[1], &klient_ip);
+    assert(accepterad != OGILTIG_SOCKET);
+    assert(klient_ip == 0);
+    close(accepterad);
+    close(klient);
+
+    unlink(SOKVAG);
+    unlink(LOKAL_SOKVAG);
+    stang_tcp_server(&ny[0]);
+    stang_tcp_server(&ny[1]);
+}
+
+int main(void) {
+    printf("\n╔═══════════════════════════════════════════════════════╗\n");
+    printf("║          ENHETSTESTER FÖR ÖVERLÄMNING                ║\n");
+    printf("╚═══════════════════════════════════════════════════════╝\n\n");
+
+    aktuell_log_niva = LOG_NIVA_FEL;  // Bara fel - överlämningen loggar annars varje steg
+    signal(SIGTERM, signal_hanterare);
+
+    RUN_TEST(test_ingen_gammal_process);
+    RUN_TEST(test_overlamning);
+    RUN_TEST(test_fel_port);
+    RUN_TEST(test_nekad_under_avstangning);
+    RUN_TEST(test_unix_socket_foljer_med);
+
+    // Visa resultat
+    printf("\n╔═══════════════════════════════════════════════════════╗\n");
+    printf("║                   TESTRESULTAT                       ║\n");
+    printf("╚═══════════════════════════════════════════════════════╝\n");
+    printf("  Totalt:        %d tester\n", tester_totalt);
+    printf("  Godkända:      %d tester\n", tester_godkanda);
+    printf("  Misslyckade:   %d tester\n", tester_totalt - tester_godkanda);
+
+    if (tester_godkanda == tester_totalt) {
+        printf("\n  ✓ ALLA TESTER GODKÄNDA!\n\n");
+        return 0;
+    } else {
+        printf("\n  ✗ VISSA TESTER MISSLYCKADES\n\n");
+        return 1;
+    }
+}
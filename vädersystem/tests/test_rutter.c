@@ -0,0 +1,179 @@
+// ============================================================================
+// ENHETSTESTER FÖR RUTT-REGISTRET
+// ============================================================================
+// Testar den perfekta hashtabellen över (metod, sökväg), felfall när den
+// byggs och kontrollen av obligatoriska parametrar
+// Kompilera: gcc -I../include tests/test_rutter.c -o test_rutter
+// Kör: ./test_rutter
+
+#include "../src/rutter.c"
+#include "../src/http_query.c"
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <stdbool.h>
+
+static int tester_totalt = 0;
+static int tester_godkanda = 0;
+
+#define RUN_TEST(test_func) do { \
+    printf("Kör %s...\n", #test_func); \
+    tester_totalt++; \
+    test_func(); \
+    tester_godkanda++; \
+    printf("  ✓ GODKÄND\n"); \
+} while(0)
+
+// Vy över en nollterminerad sträng
+static HttpVy vy(const char* text) {
+    HttpVy v = { text, strlen(text) };
+    return v;
+}
+
+static void hanterare_a(const RuttAnrop* anrop) { (void)anrop; }
+static void hanterare_b(const RuttAnrop* anrop) { (void)anrop; }
+
+static const Rutt RUTTER[] = {
+    { HTTP_GET, "/", hanterare_a, { NULL }, NULL, NULL, "Rot" },
+    { HTTP_GET, "/weather", hanterare_b, { "city" }, NULL, NULL, "Väder" },
+    { HTTP_GET, "/forecast", hanterare_b, { "city", "country" }, NULL, NULL, "Prognos" },
+    { HTTP_POST, "/weather", hanterare_a, { NULL }, NULL, NULL, "Samma sökväg, annan metod" },
+    { HTTP_GET, "/statistik", hanterare_a, { NULL }, NULL, NULL, "Statistik" },
+    { HTTP_GET, "/statistik/klienter", hanterare_a, { NULL }, NULL, NULL, "Klienter" },
+};
+#define ANTAL_RUTTER ((int)(sizeof(RUTTER) / sizeof(RUTTER[0])))
+
+// ============================================================================
+// TESTER
+// ============================================================================
+
+void test_uppslag() {
+    RuttTabell tabell;
+    assert(bygg_ruttabell(&tabell, RUTTER, ANTAL_RUTTER));
+
+    for (int i = 0; i < ANTAL_RUTTER; i++) {
+        assert(hitta_rutt(&tabell, RUTTER[i].metod, vy(RUTTER[i].sokvag)) == &RUTTER[i]);
+    }
+    assert(hitta_rutt(&tabell, HTTP_POST, vy("/weather"))->hanterare == hanterare_a);
+
+    // Sökvägen i en vy behöver inte vara nollterminerad
+    HttpVy del = { "/weather?city=Lund", 8 };
+    assert(hitta_rutt(&tabell, HTTP_GET, del) == &RUTTER[1]);
+}
+
+void test_missar() {
+    RuttTabell tabell;
+    assert(bygg_ruttabell(&tabell, RUTTER, ANTAL_RUTTER));
+
+    assert(hitta_rutt(&tabell, HTTP_POST, vy("/forecast")) == NULL);
+    assert(hitta_rutt(&tabell, HTTP_UNKNOWN, vy("/")) == NULL);
+    assert(hitta_rutt(&tabell, HTTP_GET, vy("/weather/")) == NULL);
+    assert(hitta_rutt(&tabell, HTTP_GET, vy("/Weather")) == NULL);
+    assert(hitta_rutt(&tabell, HTTP_GET, vy("/statistik/")) == NULL);
+    assert(hitta_rutt(&tabell, HTTP_GET, vy("")) == NULL);
+
+    // Ingen av alla prefix till en rutt träffar fel rutt
+    const char* sokvag = "/statistik/klienter";
+    for (size_t n = 0; n < strlen(sokvag); n++) {
+        HttpVy prefix = { sokvag, n };
+        const Rutt* rutt = hitta_rutt(&tabell, HTTP_GET, prefix);
+        assert(rutt == NULL || (strlen(rutt->sokvag) == n &&
+                                memcmp(rutt->sokvag, sokvag, n) == 0));
+    }
+}
+
+void test_ogiltiga_tabeller() {
+    RuttTabell tabell;
+
+    // Samma metod och sökväg två gånger
+    Rutt dubbletter[] = { RUTTER[0], RUTTER[1], RUTTER[1] };
+    assert(!bygg_ruttabell(&tabell, dubbletter, 3));
+
+    // För många rutter
+    static Rutt manga[MAX_RUTTER + 1];
+    static char sokvagar[MAX_RUTTER + 1][16];
+    for (int i = 0; i <= MAX_RUTTER; i++) {
+        snprintf(sokvagar[i], sizeof(sokvagar[i]), "/rutt%d", i);
+        manga[i] = RUTTER[0];
+        manga[i].sokvag = sokvagar[i];
+    }
+    assert(!bygg_ruttabell(&tabell, manga, MAX_RUTTER + 1));
+    assert(!bygg_ruttabell(&tabell, manga, -1));
+
+    // En tom tabell går att bygga och hittar ingenting
+    assert(bygg_ruttabell(&tabell, manga, 0));
+    assert(hitta_rutt(&tabell, HTTP_GET, vy("/")) == NULL);
+}
+
+void test_full_tabell() {
+    static Rutt rutter[MAX_RUTTER];
+    static char sokvagar[MAX_RUTTER][16];
+    for (int i = 0; i < MAX_RUTTER; i++) {
+        snprintf(sokvagar[i], sizeof(sokvagar[i]), "/rutt%d", i);
+        rutter[i] = RUTTER[0];
+        rutter[i].sokvag = sokvagar[i];
+    }
+
+    RuttTabell tabell;
+    assert(bygg_ruttabell(&tabell, rutter, MAX_RUTTER));
+    for (int i = 0; i < MAX_RUTTER; i++) {
+        assert(hitta_rutt(&tabell, HTTP_GET, vy(sokvagar[i])) == &rutter[i]);
+    }
+    assert(hitta_rutt(&tabell, HTTP_GET, vy("/rutt32")) == NULL);
+
+    // Samma rutter ger samma startvärde
+    RuttTabell igen;
+    assert(bygg_ruttabell(&igen, rutter, MAX_RUTTER));
+    assert(igen.fro == tabell.fro);
+    assert(memcmp(igen.platser, tabell.platser, sizeof(tabell.platser)) == 0);
+}
+
+void test_saknad_parameter() {
+    HttpQuery query;
+
+    assert(tolka_query(vy("country=SE"), &query));
+    assert(saknad_parameter(&RUTTER[0], &query) == NULL);
+    assert(strcmp(saknad_parameter(&RUTTER[1], &query), "city") == 0);
+
+    assert(tolka_query(vy("city=Lund"), &query));
+    assert(saknad_parameter(&RUTTER[1], &query) == NULL);
+    assert(strcmp(saknad_parameter(&RUTTER[2], &query), "country") == 0);
+
+    // En parameter utan värde räknas som saknad
+    assert(tolka_query(vy("city=Lund&country="), &query));
+    assert(strcmp(saknad_parameter(&RUTTER[2], &query), "country") == 0);
+    assert(tolka_query(vy("city&country=SE"), &query));
+    assert(strcmp(saknad_parameter(&RUTTER[1], &query), "city") == 0);
+
+    assert(strcmp(http_metod_namn(HTTP_GET), "GET") == 0);
+    assert(strcmp(http_metod_namn(HTTP_POST), "POST") == 0);
+}
+
+int main(void) {
+    printf("\n╔═══════════════════════════════════════════════════════╗\n");
+    printf("║          ENHETSTESTER FÖR RUTT-REGISTRET             ║\n");
+    printf("╚═══════════════════════════════════════════════════════╝\n\n");
+
+    RUN_TEST(test_uppslag);
+    RUN_TEST(test_missar);
+    RUN_TEST(test_ogiltiga_tabeller);
+    RUN_TEST(test_full_tabell);
+    RUN_TEST(test_saknad_parameter);
+
+    // Visa resultat
+    printf("\n╔═══════════════════════════════════════════════════════╗\n");
+    printf("║                   TESTRESULTAT                       ║\n");
+    printf("╚═══════════════════════════════════════════════════════╝\n");
+    printf("  Totalt:        %d tester\n", tester_totalt);
+    printf("  Godkända:      %d tester\n", tester_godkanda);
+    printf("  Misslyckade:   %d tester\n", tester_totalt - tester_godkanda);
+
+    if (tester_godkanda == tester_totalt) {
+        printf("\n  ✓ ALLA TESTER GODKÄNDA!\n\n");
+        return 0;
+    } else {
+        printf("\n  ✗ VISSA TESTER MISSLYCKADES\n\n");
+        return 1;
+    }
+}
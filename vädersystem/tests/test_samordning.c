@@ -0,0 +1,187 @@
+// ============================================================================
+// ENHETSTESTER FÖR SAMORDNADE HÄMTNINGAR
+// ============================================================================
+// Testar att samtidiga hämtningar av samma nyckel slås ihop till en
+// Kompilera: gcc -I../include tests/test_samordning.c -o test_samordning -lpthread
+// Kör: ./test_samordning
+
+#define _POSIX_C_SOURCE 200809L  // För pthread_barrier och nanosleep
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "../src/samordning.c"
+#include "../src/loggning.c"
+
+static int tester_totalt = 0;
+static int tester_godkanda = 0;
+
+#define RUN_TEST(test_func) do { \
+    printf("Kör %s...\n", #test_func); \
+    tester_totalt++; \
+    test_func(); \
+    tester_godkanda++; \
+    printf("  ✓ GODKÄND\n"); \
+} while(0)
+
+#define ANTAL_TRADAR 8
+
+// Antal gånger den långsamma "upstream-hämtningen" faktiskt kördes
+static _Atomic int antal_anrop = 0;
+
+// Låtsas-hämtning: tar 200 ms och skriver stadens namn som resultat.
+// kontext != NULL betyder att hämtningen ska misslyckas.
+static bool langsam_hamtning(const char* stad, const char* landskod,
+                             void* resultat, void* kontext) {
+    atomic_fetch_add(&antal_anrop, 1);
+    struct timespec vila = {0, 200 * 1000 * 1000};
+    nanosleep(&vila, NULL);
+    snprintf((char*)resultat, 32, "%s,%s", stad, landskod);
+    return kontext == NULL;
+}
+
+// Argument och resultat för en testtråd
+typedef struct {
+    pthread_barrier_t* start;
+    const char* stad;
+    void* kontext;
+    char resultat[32];
+    bool lyckades;
+} TradArgument;
+
+static void* hamta_i_trad(void* argument) {
+    TradArgument* arg = (TradArgument*)argument;
+    pthread_barrier_wait(arg->start);  // Alla trådar missar "cachen" samtidigt
+    arg->lyckades = samordnad_hamtning("vader", arg->stad, "SE", arg->resultat,
+                                       sizeof(arg->resultat), langsam_hamtning,
+                                       arg->kontext);
+    return NULL;
+}
+
+// Startar ANTAL_TRADAR trådar; varannan hämtar stader[1] om den finns
+static void kor_samtidigt(TradArgument* argument, const char* stader[2], void* kontext) {
+    pthread_t tradar[ANTAL_TRADAR];
+    pthread_barrier_t start;
+    pthread_barrier_init(&start, NULL, ANTAL_TRADAR);
+
+    for (int i = 0; i < ANTAL_TRADAR; i++) {
+        argument[i].start = &start;
+        argument[i].stad = (stader[1] && i % 2) ? stader[1] : stader[0];
+        argument[i].kontext = kontext;
+        argument[i].resultat[0] = '\0';
+        pthread_create(&tradar[i], NULL, hamta_i_trad, &argument[i]);
+    }
+    for (int i = 0; i < ANTAL_TRADAR; i++) {
+        pthread_join(tradar[i], NULL);
+    }
+    pthread_barrier_destroy(&start);
+}
+
+// ============================================================================
+// TESTER
+// ============================================================================
+
+void test_ensam_hamtning() {
+    char resultat[32];
+    SamordningsStatistik fore, efter;
+    hamta_samordnings_statistik(&fore);
+    antal_anrop = 0;
+
+    assert(samordnad_hamtning("vader", "Lund", "SE", resultat, sizeof(resultat),
+                              langsam_hamtning, NULL));
+    assert(strcmp(resultat, "Lund,SE") == 0);
+    assert(antal_anrop == 1);
+
+    hamta_samordnings_statistik(&efter);
+    assert(efter.hamtningar == fore.hamtningar + 1);
+    assert(efter.samordnade == fore.samordnade);
+    assert(efter.pagaende == 0);
+}
+
+void test_samtidiga_slas_ihop() {
+    TradArgument argument[ANTAL_TRADAR];
+    const char* stader[2] = {"Stockholm", NULL};
+    SamordningsStatistik fore, efter;
+    hamta_samordnings_statistik(&fore);
+    antal_anrop = 0;
+
+    kor_samtidigt(argument, stader, NULL);
+
+    // En enda upstream-hämtning, alla fick samma resultat
+    assert(antal_anrop == 1);
+    for (int i = 0; i < ANTAL_TRADAR; i++) {
+        assert(argument[i].lyckades);
+        assert(strcmp(argument[i].resultat, "Stockholm,SE") == 0);
+    }
+
+    hamta_samordnings_statistik(&efter);
+    assert(efter.hamtningar == fore.hamtningar + 1);
+    assert(efter.samordnade == fore.samordnade + ANTAL_TRADAR - 1);
+}
+
+void test_olika_nycklar_hamtas_var_for_sig() {
+    TradArgument argument[ANTAL_TRADAR];
+    const char* stader[2] = {"Malmo", "Umea"};
+    antal_anrop = 0;
+
+    kor_samtidigt(argument, stader, NULL);
+
+    // En hämtning per stad, och ingen fick den andra stadens resultat
+    assert(antal_anrop == 2);
+    for (int i = 0; i < ANTAL_TRADAR; i++) {
+        assert(argument[i].lyckades);
+        assert(strncmp(argument[i].resultat, argument[i].stad, strlen(argument[i].stad)) == 0);
+    }
+}
+
+void test_misslyckad_hamtning_delas() {
+    TradArgument argument[ANTAL_TRADAR];
+    const char* stader[2] = {"Kiruna", NULL};
+    int misslyckas = 1;
+    antal_anrop = 0;
+
+    kor_samtidigt(argument, stader, &misslyckas);
+
+    assert(antal_anrop == 1);
+    for (int i = 0; i < ANTAL_TRADAR; i++) {
+        assert(!argument[i].lyckades);
+    }
+
+    // Posten är borta - nästa anrop gör en ny hämtning
+    char resultat[32];
+    assert(samordnad_hamtning("vader", "Kiruna", "SE", resultat, sizeof(resultat),
+                              langsam_hamtning, NULL));
+    assert(antal_anrop == 2);
+}
+
+int main(void) {
+    printf("\n╔═══════════════════════════════════════════════════════╗\n");
+    printf("║        ENHETSTESTER FÖR SAMORDNADE HÄMTNINGAR        ║\n");
+    printf("╚═══════════════════════════════════════════════════════╝\n\n");
+
+    aktuell_log_niva = LOG_NIVA_FEL;  // Ingen debug-loggning under testerna
+
+    RUN_TEST(test_ensam_hamtning);
+    RUN_TEST(test_samtidiga_slas_ihop);
+    RUN_TEST(test_olika_nycklar_hamtas_var_for_sig);
+    RUN_TEST(test_misslyckad_hamtning_delas);
+
+    // Visa resultat
+    printf("\n╔═══════════════════════════════════════════════════════╗\n");
+    printf("║                   TESTRESULTAT                       ║\n");
+    printf("╚═══════════════════════════════════════════════════════╝\n");
+    printf("  Totalt:        %d tester\n", tester_totalt);
+    printf("  Godkända:      %d tester\n", tester_godkanda);
+    printf("  Misslyckade:   %d tester\n", tester_totalt - tester_godkanda);
+
+    if (tester_godkanda == tester_totalt) {
+        printf("\n  ✓ ALLA TESTER GODKÄNDA!\n\n");
+        return 0;
+    } else {
+        printf("\n  ✗ VISSA TESTER MISSLYCKADES\n\n");
+        return 1;
+    }
+}
@@ -0,0 +1,338 @@
+// ============================================================================
+// ENHETSTESTER FÖR TIMERHJULET
+// ============================================================================
+// Testar att timers löper ut i rätt ordning och aldrig för tidigt, att de
+// kan stoppas och flyttas, och att långa tidsgränser flyttas ned mellan
+// nivåerna. Tiden styrs av testet - ingen riktig klocka används.
+// Kompilera: gcc -I../include tests/test_timerhjul.c -o test_timerhjul
+// Kör: ./test_timerhjul
+
+#include "../src/timerhjul.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <stdbool.h>
+
+static int tester_totalt = 0;
+static int tester_godkanda = 0;
+
+#define RUN_TEST(test_func) do { \
+    printf("Kör %s...\n", #test_func); \
+    tester_totalt++; \
+    test_func(); \
+    tester_godkanda++; \
+    printf("  ✓ GODKÄND\n"); \
+} while(0)
+
+// Tidpunkt då testets timers startar (godtycklig, inte jämnt delbar med ett varv)
+#define START_MS 1234567ULL
+
+// En timer som minns när den löpte ut
+typedef struct {
+    Timer timer;
+    uint64_t utlopt_ms;                           // 0 = har inte löpt ut
+    int ordning;                                  // Löpnummer bland alla som löpt ut
+} TestTimer;
+
+static uint64_t aktuell_tid;                      // Tiden som skickas till kor_timerhjul
+static int antal_utlopta;
+
+static void registrera(Timer* timer, void* data) {
+    (void)timer;
+    TestTimer* test = data;
+    test->utlopt_ms = aktuell_tid;
+    test->ordning = ++antal_utlopta;
+}
+
+/**
+ * Stegar hjulet fram en millisekund i taget
+ *
+ * @param hjul - Hjulet
+ * @param till_ms - Tiden att stega fram till
+ */
+static void stega_till(TimerHjul* hjul, uint64_t till_ms) {
+    while (aktuell_tid < till_ms) {
+        aktuell_tid++;
+        kor_timerhjul(hjul, aktuell_tid);
+    }
+}
+
+/**
+ * Startar ett nytt hjul och nollställer testets tid
+ *
+ * @param hjul - Hjulet
+ */
+static void nytt_hjul(TimerHjul* hjul) {
+    aktuell_tid = START_MS;
+    antal_utlopta = 0;
+    initiera_timerhjul(hjul, aktuell_tid);
+}
+
+// ============================================================================
+// TESTER
+// ============================================================================
+
+void test_ordning_och_aldrig_for_tidigt() {
+    TimerHjul hjul;
+    nytt_hjul(&hjul);
+
+    // Startas i omvänd ordning, ska löpa ut kortast först
+    uint64_t vantan[] = {500, 250, 100, 33, 10, 1};
+    int antal = (int)(sizeof(vantan) / sizeof(vantan[0]));
+    TestTimer timers[6];
+    for (int i = 0; i < antal; i++) {
+        memset(&timers[i], 0, sizeof(timers[i]));
+        initiera_timer(&timers[i].timer, registrera, &timers[i]);
+        starta_timer(&hjul, &timers[i].timer, START_MS + vantan[i]);
+        assert(timer_aktiv(&timers[i].timer));
+    }
+    assert(hjul.antal == 6);
+
+    stega_till(&hjul, START_MS + 600);
+
+    for (int i = 0; i < antal; i++) {
+        uint64_t utgang = START_MS + vantan[i];
+        assert(!timer_aktiv(&timers[i].timer));
+        assert(timers[i].utlopt_ms >= utgang);                      // Aldrig för tidigt
+        assert(timers[i].utlopt_ms < utgang + TIMERHJUL_TICK_MS);   // Högst ett tick för sent
+        assert(timers[i].ordning == antal - i);
+    }
+    assert(hjul.antal == 0);
+}
+
+void test_stoppa_och_flytta() {
+    TimerHjul hjul;
+    nytt_hjul(&hjul);
+
+    TestTimer stoppad = {0}, flyttad = {0};
+    initiera_timer(&stoppad.timer, registrera, &stoppad);
+    initiera_timer(&flyttad.timer, registrera, &flyttad);
+
+    starta_timer(&hjul, &stoppad.timer, START_MS + 100);
+    starta_timer(&hjul, &flyttad.timer, START_MS + 100);
+    stoppa_timer(&hjul, &stoppad.timer);
+    stoppa_timer(&hjul, &stoppad.timer);  // Att stoppa två gånger är ofarligt
+    assert(!timer_aktiv(&stoppad.timer));
+
+    // Ny aktivitet flyttar tidsgränsen framåt - räknas inte som en ny timer
+    starta_timer(&hjul, &flyttad.timer, START_MS + 5000);
+    assert(hjul.antal == 1);
+
+    stega_till(&hjul, START_MS + 4990);
+    assert(stoppad.utlopt_ms == 0);
+    assert(flyttad.utlopt_ms == 0);
+
+    stega_till(&hjul, START_MS + 5010);
+    assert(stoppad.utlopt_ms == 0);
+    assert(flyttad.utlopt_ms >= START_MS + 5000);
+    assert(hjul.antal == 0);
+}
+
+void test_langa_tidsgranser_flyttas_ned() {
+    TimerHjul hjul;
+    nytt_hjul(&hjul);
+
+    // En per nivå, plus en utanför hjulets räckvidd (ca 46 timmar)
+    uint64_t vantan[] = {
+        300,                          // Nivå 0
+        30 * 1000,                    // Nivå 1
+        10 * 60 * 1000,               // Nivå 2
+        5 * 3600 * 1000ULL,           // Nivå 3
+        50 * 3600 * 1000ULL,          // Utanför hjulet
+    };
+    int antal = (int)(sizeof(vantan) / sizeof(vantan[0]));
+    TestTimer timers[5];
+    for (int i = 0; i < antal; i++) {
+        memset(&timers[i], 0, sizeof(timers[i]));
+        initiera_timer(&timers[i].timer, registrera, &timers[i]);
+        starta_timer(&hjul, &timers[i].timer, START_MS + vantan[i]);
+    }
+
+    // Stega ett tick i taget så att varje nedflyttning sker
+    for (int i = 0; i < antal; i++) {
+        uint64_t utgang = START_MS + vantan[i];
+        while (aktuell_tid + TIMERHJUL_TICK_MS < utgang) {
+            aktuell_tid += TIMERHJUL_TICK_MS;
+            kor_timerhjul(&hjul, aktuell_tid);
+        }
+        assert(timers[i].utlopt_ms == 0);
+        stega_till(&hjul, utgang + TIMERHJUL_TICK_MS);
+        assert(timers[i].utlopt_ms >= utgang);
+        assert(timers[i].utlopt_ms < utgang + TIMERHJUL_TICK_MS);
+    }
+    assert(hjul.antal == 0);
+}
+
+void test_hopp_i_tiden() {
+    TimerHjul hjul;
+    nytt_hjul(&hjul);
+
+    // Reaktorn kan sova länge (eller bli sen) - allt som passerats ska köras
+    TestTimer timers[3];
+    uint64_t vantan[] = {50, 20 * 1000, 3 * 60 * 1000};
+    for (int i = 0; i < 3; i++) {
+        memset(&timers[i], 0, sizeof(timers[i]));
+        initiera_timer(&timers[i].timer, registrera, &timers[i]);
+        starta_timer(&hjul, &timers[i].timer, START_MS + vantan[i]);
+    }
+
+    aktuell_tid = START_MS + 60 * 1000;
+    assert(kor_timerhjul(&hjul, aktuell_tid) == 2);
+    assert(timers[0].ordning == 1 && timers[1].ordning == 2);
+    assert(timers[2].utlopt_ms == 0);
+
+    aktuell_tid = START_MS + 4 * 60 * 1000;
+    assert(kor_timerhjul(&hjul, aktuell_tid) == 1);
+    assert(hjul.antal == 0);
+
+    // Tomt hjul hoppar direkt fram; en timer som startas efteråt fungerar som vanligt
+    aktuell_tid += 10 * 3600 * 1000ULL;
+    assert(kor_timerhjul(&hjul, aktuell_tid) == 0);
+    TestTimer sen = {0};
+    initiera_timer(&sen.timer, registrera, &sen);
+    starta_timer(&hjul, &sen.timer, aktuell_tid + 100);
+    uint64_t utgang = aktuell_tid + 100;
+    stega_till(&hjul, utgang + TIMERHJUL_TICK_MS);
+    assert(sen.utlopt_ms >= utgang && sen.utlopt_ms < utgang + TIMERHJUL_TICK_MS);
+}
+
+// Funktion som stoppar en annan timer och startar om sig själv en gång
+static TimerHjul* aterkoppling_hjul;
+static Timer* aterkoppling_offer;
+static int aterkoppling_anrop;
+
+static void stoppa_annan(Timer* timer, void* data) {
+    (void)data;
+    aterkoppling_anrop++;
+    stoppa_timer(aterkoppling_hjul, aterkoppling_offer);
+    if (aterkoppling_anrop == 1) {
+        starta_timer(aterkoppling_hjul, timer, aktuell_tid + 100);
+    }
+}
+
+void test_funktion_stoppar_annan_timer() {
+    TimerHjul hjul;
+    nytt_hjul(&hjul);
+    aterkoppling_hjul = &hjul;
+    aterkoppling_anrop = 0;
+
+    // Båda i samma fack - offret får inte köras efter att ha stoppats
+    Timer stoppare;
+    TestTimer offer = {0};
+    initiera_timer(&stoppare, stoppa_annan, NULL);
+    initiera_timer(&offer.timer, registrera, &offer);
+    aterkoppling_offer = &offer.timer;
+    starta_timer(&hjul, &offer.timer, START_MS + 40);
+    starta_timer(&hjul, &stoppare, START_MS + 40);
+
+    stega_till(&hjul, START_MS + 100);
+    assert(aterkoppling_anrop == 1);
+    assert(offer.utlopt_ms == 0);
+    assert(timer_aktiv(&stoppare));  // Startades om inifrån funktionen
+
+    stega_till(&hjul, START_MS + 200);
+    assert(aterkoppling_anrop == 2);
+    assert(hjul.antal == 0);
+}
+
+void test_vantetid() {
+    TimerHjul hjul;
+    nytt_hjul(&hjul);
+
+    assert(timerhjul_vantetid(&hjul, aktuell_tid, 1000) == 1000);
+
+    TestTimer kort = {0}, lang = {0};
+    initiera_timer(&kort.timer, registrera, &kort);
+    initiera_timer(&lang.timer, registrera, &lang);
+    starta_timer(&hjul, &kort.timer, START_MS + 200);
+    starta_timer(&hjul, &lang.timer, START_MS + 60 * 1000);
+
+    // Väntan får aldrig gå förbi nästa utgång (avrundad uppåt till helt tick)
+    int vantan = timerhjul_vantetid(&hjul, aktuell_tid, 1000);
+    assert(vantan > 0 && vantan <= 200 + TIMERHJUL_TICK_MS);
+    assert(timerhjul_vantetid(&hjul, aktuell_tid, 50) == 50);
+
+    // Sov så länge som föreslås tills allt löpt ut - inget ska missas
+    int varv = 0;
+    while (hjul.antal > 0) {
+        vantan = timerhjul_vantetid(&hjul, aktuell_tid, 1000);
+        aktuell_tid += (uint64_t)(vantan > 0 ? vantan : 1);
+        kor_timerhjul(&hjul, aktuell_tid);
+        assert(++varv < 1000);
+    }
+    assert(kort.utlopt_ms >= START_MS + 200 && kort.utlopt_ms < START_MS + 200 + TIMERHJUL_TICK_MS);
+    assert(lang.utlopt_ms >= START_MS + 60 * 1000 && lang.utlopt_ms < START_MS + 60 * 1000 + TIMERHJUL_TICK_MS);
+
+    // En timer som redan löpt ut körs senast vid nästa tick
+    starta_timer(&hjul, &kort.timer, aktuell_tid - 5);
+    vantan = timerhjul_vantetid(&hjul, aktuell_tid, 1000);
+    assert(vantan <= TIMERHJUL_TICK_MS);
+    aktuell_tid += (uint64_t)vantan;
+    assert(kor_timerhjul(&hjul, aktuell_tid) == 1);
+}
+
+void test_manga_timers() {
+    TimerHjul hjul;
+    nytt_hjul(&hjul);
+
+    // Som många samtidiga anslutningar: var tredje stoppas, resten löper ut
+    enum { ANTAL = 100000 };
+    TestTimer* timers = calloc(ANTAL, sizeof(TestTimer));
+    assert(timers);
+    srand(42);
+    for (int i = 0; i < ANTAL; i++) {
+        initiera_timer(&timers[i].timer, registrera, &timers[i]);
+        starta_timer(&hjul, &timers[i].timer, START_MS + 1 + (uint64_t)(rand() % (120 * 1000)));
+    }
+    for (int i = 0; i < ANTAL; i += 3) {
+        stoppa_timer(&hjul, &timers[i].timer);
+    }
+    assert(hjul.antal == ANTAL - (ANTAL + 2) / 3);
+
+    int korda = 0;
+    while (hjul.antal > 0) {
+        aktuell_tid += TIMERHJUL_TICK_MS;
+        korda += kor_timerhjul(&hjul, aktuell_tid);
+    }
+    assert(korda == ANTAL - (ANTAL + 2) / 3);
+    for (int i = 0; i < ANTAL; i++) {
+        assert((i % 3 == 0) == (timers[i].utlopt_ms == 0));
+        if (i % 3 != 0) {
+            uint64_t utgang = (timers[i].timer.utgang) * TIMERHJUL_TICK_MS;
+            assert(timers[i].utlopt_ms >= utgang);
+        }
+    }
+    free(timers);
+}
+
+int main(void) {
+    printf("\n╔═══════════════════════════════════════════════════════╗\n");
+    printf("║          ENHETSTESTER FÖR TIMERHJUL                  ║\n");
+    printf("╚═══════════════════════════════════════════════════════╝\n\n");
+
+    RUN_TEST(test_ordning_och_aldrig_for_tidigt);
+    RUN_TEST(test_stoppa_och_flytta);
+    RUN_TEST(test_langa_tidsgranser_flyttas_ned);
+    RUN_TEST(test_hopp_i_tiden);
+    RUN_TEST(test_funktion_stoppar_annan_timer);
+    RUN_TEST(test_vantetid);
+    RUN_TEST(test_manga_timers);
+
+    // Visa resultat
+    printf("\n╔═══════════════════════════════════════════════════════╗\n");
+    printf("║                   TESTRESULTAT                       ║\n");
+    printf("╚═══════════════════════════════════════════════════════╝\n");
+    printf("  Totalt:        %d tester\n", tester_totalt);
+    printf("  Godkända:      %d tester\n", tester_godkanda);
+    printf("  Misslyckade:   %d tester\n", tester_totalt - tester_godkanda);
+
+    if (tester_godkanda == tester_totalt) {
+        printf("\n  ✓ ALLA TESTER GODKÄNDA!\n\n");
+        return 0;
+    } else {
+        printf("\n  ✗ VISSA TESTER MISSLYCKADES\n\n");
+        return 1;
+    }
+}